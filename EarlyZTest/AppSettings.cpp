@@ -48,6 +48,44 @@ const UAVWriteModes UAVWriteModesValues[uint32(UAVWriteModes::NumValues)] =
     UAVWriteModes::ROV,
 };
 
+const char* SceneModesLabels[uint32(SceneModes::NumValues)] =
+{
+    "TwoTriangles",
+    "StressLayers",
+};
+
+const SceneModes SceneModesValues[uint32(SceneModes::NumValues)] =
+{
+    SceneModes::TwoTriangles,
+    SceneModes::StressLayers,
+};
+
+const char* StressPrimitivesLabels[uint32(StressPrimitives::NumValues)] =
+{
+    "Triangles",
+    "Quads",
+};
+
+const StressPrimitives StressPrimitivesValues[uint32(StressPrimitives::NumValues)] =
+{
+    StressPrimitives::Triangles,
+    StressPrimitives::Quads,
+};
+
+const char* DepthOrdersLabels[uint32(DepthOrders::NumValues)] =
+{
+    "FrontToBack",
+    "BackToFront",
+    "RandomOrder",
+};
+
+const DepthOrders DepthOrdersValues[uint32(DepthOrders::NumValues)] =
+{
+    DepthOrders::FrontToBack,
+    DepthOrders::BackToFront,
+    DepthOrders::RandomOrder,
+};
+
 namespace AppSettings
 {
     static SettingsContainer Settings;
@@ -60,6 +98,12 @@ namespace AppSettings
     BoolSetting ForceEarlyZ;
     BoolSetting ClearDepthToZero;
     BoolSetting BarrierBetweenDraws;
+    SceneModesSetting SceneMode;
+    StressPrimitivesSetting PrimitiveType;
+    DepthOrdersSetting DepthOrder;
+    IntSetting NumLayers;
+    FloatSetting LayerCoverage;
+    IntSetting InstancesPerDraw;
     BoolSetting EnableVSync;
 
     ConstantBuffer CBuffer;
@@ -68,16 +112,18 @@ namespace AppSettings
     void Initialize()
     {
 
-        Settings.Initialize(2);
+        Settings.Initialize(3);
 
         Settings.AddGroup("Test Config", true);
 
+        Settings.AddGroup("Scene", true);
+
         Settings.AddGroup("Debug", false);
 
         EnableDepthWrites.Initialize("EnableDepthWrites", "Test Config", "Enable Depth Writes", "enables or disables depth writes in the depth/stencil state of the PSO (depth testing is always enabled)", false);
         Settings.AddSetting(&EnableDepthWrites);
 
-        ReverseTriangleOrder.Initialize("ReverseTriangleOrder", "Test Config", "Reverse Triangle Order", "if disabled, the two triangles are drawn back-to-front. If enabled, the triangles are drawn front-to-back", false);
+        ReverseTriangleOrder.Initialize("ReverseTriangleOrder", "Test Config", "Reverse Triangle Order", "if enabled, the triangles/layers are drawn in the opposite order from what the scene specifies", false);
         Settings.AddSetting(&ReverseTriangleOrder);
 
         DiscardMode.Initialize("DiscardMode", "Test Config", "Discard Mode", "controls whether discard is present in the pixel shader, and how it's used", DiscardModes::NoDiscard, 3, DiscardModesLabels);
@@ -95,9 +141,27 @@ namespace AppSettings
         ClearDepthToZero.Initialize("ClearDepthToZero", "Test Config", "Clear Depth To Zero", "clears the depth buffer to 0.0 instead of 1.0 before drawing the triangles, causing all drawn pixels to fail the depth test", false);
         Settings.AddSetting(&ClearDepthToZero);
 
-        BarrierBetweenDraws.Initialize("BarrierBetweenDraws", "Test Config", "Barrier Between Draws", "issues a global memory barrier between the two triangle draws to force a stall + flush", false);
+        BarrierBetweenDraws.Initialize("BarrierBetweenDraws", "Test Config", "Barrier Between Draws", "issues a global memory barrier between each of the draws to force a stall + flush", false);
         Settings.AddSetting(&BarrierBetweenDraws);
 
+        SceneMode.Initialize("SceneMode", "Scene", "Scene Mode", "draws either the original pair of overlapping triangles, or a configurable stack of layers for stress-testing depth rejection", SceneModes::TwoTriangles, 2, SceneModesLabels);
+        Settings.AddSetting(&SceneMode);
+
+        PrimitiveType.Initialize("PrimitiveType", "Scene", "Primitive Type", "the type of primitive used for each layer of the stress scene", StressPrimitives::Quads, 2, StressPrimitivesLabels);
+        Settings.AddSetting(&PrimitiveType);
+
+        DepthOrder.Initialize("DepthOrder", "Scene", "Depth Order", "the order in which the layers of the stress scene are drawn, relative to their depth", DepthOrders::BackToFront, 3, DepthOrdersLabels);
+        Settings.AddSetting(&DepthOrder);
+
+        NumLayers.Initialize("NumLayers", "Scene", "Num Layers", "the number of layers in the stress scene", 16, 1, 4096);
+        Settings.AddSetting(&NumLayers);
+
+        LayerCoverage.Initialize("LayerCoverage", "Scene", "Layer Coverage", "the fraction of the viewport covered by each layer of the stress scene", 0.5000f, 0.0100f, 1.0000f, 0.0100f, ConversionMode::None, 1.0000f);
+        Settings.AddSetting(&LayerCoverage);
+
+        InstancesPerDraw.Initialize("InstancesPerDraw", "Scene", "Instances Per Draw", "the number of layers drawn by each instanced draw call", 1, 1, 4096);
+        Settings.AddSetting(&InstancesPerDraw);
+
         EnableVSync.Initialize("EnableVSync", "Debug", "Enable VSync", "Enables or disables vertical sync during Present", true);
         Settings.AddSetting(&EnableVSync);
 
@@ -143,6 +207,14 @@ namespace AppSettings
         opts.Add("ForceEarlyZ_", ForceEarlyZ.Value());
     }
 
+    void GetShaderPermutationOptions(List<ShaderPermutationOption>& options)
+    {
+        options.Add({ "DiscardMode_", 0, 3, int32(DiscardMode.Value()) });
+        options.Add({ "DepthExportMode_", 0, 4, int32(DepthExportMode.Value()) });
+        options.Add({ "UAVWriteMode_", 0, 3, int32(UAVWriteMode.Value()) });
+        options.Add({ "ForceEarlyZ_", 0, 2, int32(ForceEarlyZ.Value()) });
+    }
+
     bool ShaderCompileOptionsChanged()
     {
         bool changed = false;
@@ -20,6 +20,25 @@ enum UAVWriteModes
     ROV,
 }
 
+enum SceneModes
+{
+    TwoTriangles,
+    StressLayers,
+}
+
+enum StressPrimitives
+{
+    Triangles,
+    Quads,
+}
+
+enum DepthOrders
+{
+    FrontToBack,
+    BackToFront,
+    RandomOrder,
+}
+
 public class Settings
 {
     [ExpandGroup(true)]
@@ -28,7 +47,7 @@ public class Settings
         [HelpText("enables or disables depth writes in the depth/stencil state of the PSO (depth testing is always enabled)")]
         bool EnableDepthWrites = false;
 
-        [HelpText("if disabled, the two triangles are drawn back-to-front. If enabled, the triangles are drawn front-to-back")]
+        [HelpText("if enabled, the triangles/layers are drawn in the opposite order from what the scene specifies")]
         bool ReverseTriangleOrder = false;
 
         [HelpText("controls whether discard is present in the pixel shader, and how it's used")]
@@ -50,10 +69,44 @@ public class Settings
         [HelpText("clears the depth buffer to 0.0 instead of 1.0 before drawing the triangles, causing all drawn pixels to fail the depth test")]
         bool ClearDepthToZero = false;
 
-        [HelpText("issues a global memory barrier between the two triangle draws to force a stall + flush")]
+        [HelpText("issues a global memory barrier between each of the draws to force a stall + flush")]
         bool BarrierBetweenDraws = false;
     }
 
+    [ExpandGroup(true)]
+    public class Scene
+    {
+        [HelpText("draws either the original pair of overlapping triangles, or a configurable stack of layers for stress-testing depth rejection")]
+        [UseAsShaderConstant(false)]
+        SceneModes SceneMode = SceneModes.TwoTriangles;
+
+        [HelpText("the type of primitive used for each layer of the stress scene")]
+        [UseAsShaderConstant(false)]
+        StressPrimitives PrimitiveType = StressPrimitives.Quads;
+
+        [HelpText("the order in which the layers of the stress scene are drawn, relative to their depth")]
+        [UseAsShaderConstant(false)]
+        DepthOrders DepthOrder = DepthOrders.BackToFront;
+
+        [HelpText("the number of layers in the stress scene")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(4096)]
+        int NumLayers = 16;
+
+        [HelpText("the fraction of the viewport covered by each layer of the stress scene")]
+        [UseAsShaderConstant(false)]
+        [MinValue(0.01f)]
+        [MaxValue(1.0f)]
+        float LayerCoverage = 0.5f;
+
+        [HelpText("the number of layers drawn by each instanced draw call")]
+        [UseAsShaderConstant(false)]
+        [MinValue(1)]
+        [MaxValue(4096)]
+        int InstancesPerDraw = 1;
+    }
+
     [ExpandGroup(false)]
     public class Debug
     {
@@ -52,6 +52,49 @@ extern const UAVWriteModes UAVWriteModesValues[uint32(UAVWriteModes::NumValues)]
 
 typedef EnumSettingT<UAVWriteModes> UAVWriteModesSetting;
 
+enum class SceneModes
+{
+    TwoTriangles = 0,
+    StressLayers = 1,
+
+    NumValues
+};
+
+extern const char* SceneModesLabels[uint32(SceneModes::NumValues)];
+
+extern const SceneModes SceneModesValues[uint32(SceneModes::NumValues)];
+
+typedef EnumSettingT<SceneModes> SceneModesSetting;
+
+enum class StressPrimitives
+{
+    Triangles = 0,
+    Quads = 1,
+
+    NumValues
+};
+
+extern const char* StressPrimitivesLabels[uint32(StressPrimitives::NumValues)];
+
+extern const StressPrimitives StressPrimitivesValues[uint32(StressPrimitives::NumValues)];
+
+typedef EnumSettingT<StressPrimitives> StressPrimitivesSetting;
+
+enum class DepthOrders
+{
+    FrontToBack = 0,
+    BackToFront = 1,
+    RandomOrder = 2,
+
+    NumValues
+};
+
+extern const char* DepthOrdersLabels[uint32(DepthOrders::NumValues)];
+
+extern const DepthOrders DepthOrdersValues[uint32(DepthOrders::NumValues)];
+
+typedef EnumSettingT<DepthOrders> DepthOrdersSetting;
+
 namespace AppSettings
 {
 
@@ -63,6 +106,12 @@ namespace AppSettings
     extern BoolSetting ForceEarlyZ;
     extern BoolSetting ClearDepthToZero;
     extern BoolSetting BarrierBetweenDraws;
+    extern SceneModesSetting SceneMode;
+    extern StressPrimitivesSetting PrimitiveType;
+    extern DepthOrdersSetting DepthOrder;
+    extern IntSetting NumLayers;
+    extern FloatSetting LayerCoverage;
+    extern IntSetting InstancesPerDraw;
     extern BoolSetting EnableVSync;
 
     struct AppSettingsCBuffer
@@ -83,6 +132,7 @@ namespace AppSettings
     void BindCBufferGfx(ID3D12GraphicsCommandList* cmdList, uint32 rootParameter);
     void BindCBufferCompute(ID3D12GraphicsCommandList* cmdList, uint32 rootParameter);
     void GetShaderCompileOptions(CompileOptions& opts);
+    void GetShaderPermutationOptions(List<ShaderPermutationOption>& options);
     bool ShaderCompileOptionsChanged();
 };
 
@@ -69,3 +69,32 @@ enum UAVWriteModes
 #define StandardUAV_ 1
 #define ROV_ 2
 
+enum SceneModes
+{
+    TwoTriangles = 0,
+    StressLayers = 1,
+};
+
+#define TwoTriangles_ 0
+#define StressLayers_ 1
+
+enum StressPrimitives
+{
+    Triangles = 0,
+    Quads = 1,
+};
+
+#define Triangles_ 0
+#define Quads_ 1
+
+enum DepthOrders
+{
+    FrontToBack = 0,
+    BackToFront = 1,
+    RandomOrder = 2,
+};
+
+#define FrontToBack_ 0
+#define BackToFront_ 1
+#define RandomOrder_ 2
+
@@ -0,0 +1,225 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Utility.h>
+#include <FileIO.h>
+#include <Timer.h>
+
+#include "EarlyZBenchmark.h"
+
+using namespace SampleFramework12;
+
+// == NullEarlyZBackend ===========================================================================
+
+void NullEarlyZBackend::ApplyConfig(const EarlyZConfig& config_)
+{
+    config = config_;
+}
+
+EarlyZFrameSample NullEarlyZBackend::RenderFrame()
+{
+    Timer timer;
+    const EarlyZPrediction prediction = PredictEarlyZ(config, width, height);
+    timer.Update();
+
+    // The prediction is only made for the timing, there's nothing to measure its invocations against
+    EarlyZFrameSample sample;
+    sample.PSInvocations = 0;
+    sample.GPUTime = timer.ElapsedMillisecondsD();
+    sample.CPUTime = sample.GPUTime;
+    return sample;
+}
+
+// == EarlyZBenchmark =============================================================================
+
+EarlyZBenchmark::~EarlyZBenchmark()
+{
+    configs.Shutdown();
+    results.Shutdown();
+    samples.Shutdown();
+}
+
+void EarlyZBenchmark::Init(const EarlyZBenchmarkSettings& settings_)
+{
+    settings = settings_;
+    settings.NumFrames = Max(settings.NumFrames, 1u);
+
+    configs.RemoveAll();
+    results.RemoveAll();
+    samples.RemoveAll();
+    currConfig = 0;
+    currFrame = 0;
+    dryRun = false;
+
+    EarlyZConfig::ForEach([&](const EarlyZConfig& config)
+    {
+        configs.Add(config);
+    }, settings.Scene);
+
+    results.Reserve(configs.Count());
+    samples.Reserve(settings.NumFrames);
+}
+
+bool EarlyZBenchmark::AddFrame(const EarlyZFrameSample& sample)
+{
+    if(Finished())
+        return false;
+
+    // Skip the warmup frames, which can include shader compilation and stats from the previous config
+    ++currFrame;
+    if(currFrame <= settings.WarmupFrames)
+        return false;
+
+    samples.Add(sample);
+    if(samples.Count() < settings.NumFrames)
+        return false;
+
+    FinishConfig();
+
+    return true;
+}
+
+void EarlyZBenchmark::FinishConfig()
+{
+    EarlyZBenchmarkResult& result = results.Add();
+    result.Config = configs[currConfig];
+    result.Prediction = PredictEarlyZ(result.Config, settings.Width, settings.Height);
+    result.NumFrames = uint32(samples.Count());
+
+    result.MinPSInvocations = UINT64_MAX;
+    result.MinGPUTime = DBL_MAX;
+    for(uint64 i = 0; i < samples.Count(); ++i)
+    {
+        const EarlyZFrameSample& sample = samples[i];
+        result.MinPSInvocations = Min(result.MinPSInvocations, sample.PSInvocations);
+        result.MaxPSInvocations = Max(result.MaxPSInvocations, sample.PSInvocations);
+        result.AvgPSInvocations += double(sample.PSInvocations);
+        result.MinGPUTime = Min(result.MinGPUTime, sample.GPUTime);
+        result.MaxGPUTime = Max(result.MaxGPUTime, sample.GPUTime);
+        result.AvgGPUTime += sample.GPUTime;
+        result.AvgCPUTime += sample.CPUTime;
+    }
+
+    const double numSamples = double(samples.Count());
+    result.AvgPSInvocations /= numSamples;
+    result.AvgGPUTime /= numSamples;
+    result.AvgCPUTime /= numSamples;
+
+    samples.RemoveAll();
+    currFrame = 0;
+    ++currConfig;
+}
+
+void EarlyZBenchmark::Run(EarlyZBenchmarkBackend& backend)
+{
+    dryRun = backend.MeasuresPSInvocations() == false;
+
+    while(Finished() == false)
+    {
+        backend.ApplyConfig(CurrentConfig());
+        while(AddFrame(backend.RenderFrame()) == false)
+            ;
+    }
+}
+
+void EarlyZBenchmark::WriteCSV(const wchar* filePath) const
+{
+    std::string csv = "DiscardMode,DepthExportMode,UAVWriteMode,ForceEarlyZ,EnableDepthWrites,ReverseTriangleOrder,"
+                      "ClearDepthToZero,BarrierBetweenDraws,PredictedPath,PredictedPSInvocations,MinPSInvocations,"
+                      "MaxPSInvocations,AvgPSInvocations,PSInvocationDelta,PredictedShadingOverdraw,MinGPUTime,MaxGPUTime,"
+                      "AvgGPUTime,AvgCPUTime,NumFrames,SceneMode,PrimitiveType,DepthOrder,NumLayers,LayerCoverage,InstancesPerDraw\n";
+
+    for(uint64 i = 0; i < results.Count(); ++i)
+    {
+        const EarlyZBenchmarkResult& result = results[i];
+        const EarlyZConfig& config = result.Config;
+        const OverdrawSceneSettings& scene = config.Scene;
+        // A dry run leaves the measured invocation columns empty, since nothing was measured
+        const std::string measuredInvocations = dryRun ? std::string(",,,") :
+                                                MakeString("%llu,%llu,%.2f,%.2f", result.MinPSInvocations, result.MaxPSInvocations, result.AvgPSInvocations,
+                                                           result.AvgPSInvocations - double(result.Prediction.PSInvocations));
+        csv += MakeString("%s,%s,%s,%u,%u,%u,%u,%u,%s,%llu,%s,%.4f,%.4f,%.4f,%.4f,%.4f,%u,",
+                          DiscardModesLabels[uint32(config.DiscardMode)], DepthExportModesLabels[uint32(config.DepthExportMode)],
+                          UAVWriteModesLabels[uint32(config.UAVWriteMode)], uint32(config.ForceEarlyZ), uint32(config.EnableDepthWrites),
+                          uint32(config.ReverseTriangleOrder), uint32(config.ClearDepthToZero), uint32(config.BarrierBetweenDraws),
+                          EarlyZPathLabels[uint32(result.Prediction.DepthPath)], result.Prediction.PSInvocations,
+                          measuredInvocations.c_str(), result.Prediction.ShadingOverdraw,
+                          result.MinGPUTime, result.MaxGPUTime, result.AvgGPUTime, result.AvgCPUTime, result.NumFrames);
+        csv += MakeString("%s,%s,%s,%u,%.4f,%u\n", SceneModesLabels[uint32(scene.Mode)], StressPrimitivesLabels[uint32(scene.PrimitiveType)],
+                          DepthOrdersLabels[uint32(scene.DepthOrder)], scene.NumLayers, scene.LayerCoverage, scene.InstancesPerDraw);
+    }
+
+    WriteStringAsFile(filePath, csv);
+}
+
+void EarlyZBenchmark::WriteJSON(const wchar* filePath) const
+{
+    const OverdrawSceneSettings& scene = settings.Scene;
+    std::string json = MakeString("{\n  \"dryRun\": %s,\n  \"warmupFrames\": %u,\n  \"numFrames\": %u,\n  \"width\": %u,\n  \"height\": %u,\n",
+                                  dryRun ? "true" : "false", settings.WarmupFrames, settings.NumFrames, settings.Width, settings.Height);
+    json += MakeString("  \"scene\": { \"mode\": \"%s\", \"primitiveType\": \"%s\", \"depthOrder\": \"%s\", \"numLayers\": %u, "
+                       "\"layerCoverage\": %.4f, \"instancesPerDraw\": %u },\n  \"results\": [",
+                       SceneModesLabels[uint32(scene.Mode)], StressPrimitivesLabels[uint32(scene.PrimitiveType)],
+                       DepthOrdersLabels[uint32(scene.DepthOrder)], scene.NumLayers, scene.LayerCoverage, scene.InstancesPerDraw);
+
+    for(uint64 i = 0; i < results.Count(); ++i)
+    {
+        const EarlyZBenchmarkResult& result = results[i];
+        const EarlyZConfig& config = result.Config;
+        const EarlyZPrediction& prediction = result.Prediction;
+
+        json += i > 0 ? ",\n    {" : "\n    {";
+        json += MakeString("\"discardMode\": \"%s\", \"depthExportMode\": \"%s\", \"uavWriteMode\": \"%s\", ",
+                           DiscardModesLabels[uint32(config.DiscardMode)], DepthExportModesLabels[uint32(config.DepthExportMode)],
+                           UAVWriteModesLabels[uint32(config.UAVWriteMode)]);
+        json += MakeString("\"forceEarlyZ\": %s, \"enableDepthWrites\": %s, \"reverseTriangleOrder\": %s, \"clearDepthToZero\": %s, \"barrierBetweenDraws\": %s, ",
+                           config.ForceEarlyZ ? "true" : "false", config.EnableDepthWrites ? "true" : "false",
+                           config.ReverseTriangleOrder ? "true" : "false", config.ClearDepthToZero ? "true" : "false",
+                           config.BarrierBetweenDraws ? "true" : "false");
+        json += MakeString("\"predicted\": { \"path\": \"%s\", \"psInvocations\": %llu, \"earlyDepthTests\": %llu, \"lateDepthTests\": %llu, "
+                           "\"depthTestsPassed\": %llu, \"discardedPixels\": %llu, \"rasterOverdraw\": %.4f, \"shadingOverdraw\": %.4f }, ",
+                           EarlyZPathLabels[uint32(prediction.DepthPath)], prediction.PSInvocations, prediction.EarlyDepthTests,
+                           prediction.LateDepthTests, prediction.DepthTestsPassed, prediction.DiscardedPixels,
+                           prediction.RasterOverdraw, prediction.ShadingOverdraw);
+        json += MakeString("\"measured\": { \"numFrames\": %u, ", result.NumFrames);
+        if(dryRun == false)
+            json += MakeString("\"minPSInvocations\": %llu, \"maxPSInvocations\": %llu, \"avgPSInvocations\": %.2f, ",
+                               result.MinPSInvocations, result.MaxPSInvocations, result.AvgPSInvocations);
+        json += MakeString("\"minGPUTime\": %.4f, \"maxGPUTime\": %.4f, \"avgGPUTime\": %.4f, \"avgCPUTime\": %.4f }}",
+                           result.MinGPUTime, result.MaxGPUTime, result.AvgGPUTime, result.AvgCPUTime);
+    }
+
+    json += "\n  ]\n}\n";
+
+    WriteStringAsFile(filePath, json);
+}
+
+void EarlyZBenchmark::WriteReports(const wchar* basePath) const
+{
+    const std::wstring path = basePath;
+    WriteCSV((path + L".csv").c_str());
+    WriteJSON((path + L".json").c_str());
+
+    if(dryRun)
+    {
+        WriteLog(L"Wrote predictor-only dry run results for %llu configurations to %ls.csv/.json (PS invocations weren't measured)",
+                 results.Count(), basePath);
+        return;
+    }
+
+    uint64 numMismatches = 0;
+    for(uint64 i = 0; i < results.Count(); ++i)
+        numMismatches += results[i].MinPSInvocations != results[i].Prediction.PSInvocations || results[i].MaxPSInvocations != results[i].Prediction.PSInvocations;
+
+    WriteLog(L"Wrote benchmark results for %llu configurations to %ls.csv/.json (%llu differ from the predicted PS invocations)",
+             results.Count(), basePath, numMismatches);
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <Containers.h>
+
+#include "EarlyZPredictor.h"
+
+using namespace SampleFramework12;
+
+struct EarlyZBenchmarkSettings
+{
+    uint32 WarmupFrames = 8;
+    uint32 NumFrames = 32;
+
+    // Resolution used for the predicted results
+    uint32 Width = 1280;
+    uint32 Height = 720;
+
+    // Every configuration in the sweep draws the same scene
+    OverdrawSceneSettings Scene;
+};
+
+// The stats for a single frame. Everything is in milliseconds apart from PSInvocations.
+struct EarlyZFrameSample
+{
+    uint64 PSInvocations = 0;
+    double GPUTime = 0.0;
+    double CPUTime = 0.0;
+};
+
+struct EarlyZBenchmarkResult
+{
+    EarlyZConfig Config;
+    EarlyZPrediction Prediction;
+
+    uint32 NumFrames = 0;
+    uint64 MinPSInvocations = 0;
+    uint64 MaxPSInvocations = 0;
+    double AvgPSInvocations = 0.0;
+    double MinGPUTime = 0.0;
+    double MaxGPUTime = 0.0;
+    double AvgGPUTime = 0.0;
+    double AvgCPUTime = 0.0;
+};
+
+// Something that can render frames for the sweep on demand
+class EarlyZBenchmarkBackend
+{
+
+public:
+
+    virtual ~EarlyZBenchmarkBackend() { }
+
+    virtual void ApplyConfig(const EarlyZConfig& config) = 0;
+    virtual EarlyZFrameSample RenderFrame() = 0;
+
+    // False if the backend doesn't actually render anything, in which case there are no PS
+    // invocation counts to compare against the predictions
+    virtual bool MeasuresPSInvocations() const { return true; }
+};
+
+// Stand-in backend that doesn't need a GPU, for a predictor-only dry run of the sweep. Nothing
+// gets measured: it only runs the predictor, and reports the time that took as the GPU time.
+class NullEarlyZBackend : public EarlyZBenchmarkBackend
+{
+
+public:
+
+    NullEarlyZBackend(uint32 width_, uint32 height_) : width(width_), height(height_) { }
+
+    virtual void ApplyConfig(const EarlyZConfig& config) override;
+    virtual EarlyZFrameSample RenderFrame() override;
+    virtual bool MeasuresPSInvocations() const override { return false; }
+
+protected:
+
+    uint32 width = 0;
+    uint32 height = 0;
+    EarlyZConfig config;
+};
+
+// Steps through every combination of settings, recording stats for a fixed number of frames
+// after letting each one warm up. The app calls AddFrame() once per frame with whatever stats
+// it read back, and applies CurrentConfig() whenever it changes.
+class EarlyZBenchmark
+{
+
+public:
+
+    ~EarlyZBenchmark();
+
+    void Init(const EarlyZBenchmarkSettings& settings);
+
+    bool Finished() const { return currConfig >= configs.Count(); }
+    uint64 NumConfigs() const { return configs.Count(); }
+    uint64 CurrentConfigIdx() const { return currConfig; }
+    const EarlyZConfig& CurrentConfig() const { return configs[currConfig]; }
+    const List<EarlyZBenchmarkResult>& Results() const { return results; }
+
+    // True if the results came from a backend that doesn't measure PS invocations, in which case
+    // the reports leave out the measured invocations and their difference from the predictions
+    bool DryRun() const { return dryRun; }
+
+    // Returns true if the benchmark moved on to the next config
+    bool AddFrame(const EarlyZFrameSample& sample);
+
+    // Runs the whole sweep by rendering frames from the backend
+    void Run(EarlyZBenchmarkBackend& backend);
+
+    void WriteCSV(const wchar* filePath) const;
+    void WriteJSON(const wchar* filePath) const;
+
+    // Writes both reports, adding .csv and .json to the path
+    void WriteReports(const wchar* basePath) const;
+
+protected:
+
+    void FinishConfig();
+
+    EarlyZBenchmarkSettings settings;
+    List<EarlyZConfig> configs;
+    List<EarlyZBenchmarkResult> results;
+    List<EarlyZFrameSample> samples;
+    uint64 currConfig = 0;
+    uint32 currFrame = 0;
+    bool dryRun = false;
+};
\ No newline at end of file
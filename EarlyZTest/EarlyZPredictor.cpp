@@ -0,0 +1,391 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Utility.h>
+#include <Jobs.h>
+#include <Timer.h>
+
+#include "EarlyZPredictor.h"
+
+#include <bit>
+
+using namespace SampleFramework12;
+
+const char* EarlyZPathLabels[uint32(EarlyZPath::NumValues)] =
+{
+    "EarlyZ",
+    "EarlyTestLateWrite",
+    "LateZ",
+};
+
+// Tiles are a multiple of the 4-wide SIMD groups, and of the 32x32 discard checkerboard so that a
+// group never straddles two checker cells
+static const uint32 TileSize = 64;
+
+// The stress scene places its layers at arbitrary positions, so snap them with the same 8 bits of
+// sub-pixel precision that D3D uses
+static const int64 SubPixelBits = 8;
+static const int64 SubPixelScale = int64(1) << SubPixelBits;
+
+struct RasterTriangle
+{
+    int64 X[3] = { };
+    int64 Y[3] = { };
+    float Depth = 1.0f;
+    uint32 LayerIndex = 0;
+
+    // Pixel bounds, as [min, max)
+    int64 MinX = 0;
+    int64 MinY = 0;
+    int64 MaxX = 0;
+    int64 MaxY = 0;
+};
+
+static int64 FloorDiv(int64 n, int64 d)
+{
+    Assert_(d > 0);
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+static int64 CeilDiv(int64 n, int64 d)
+{
+    Assert_(d > 0);
+    return n >= 0 ? (n + d - 1) / d : -((-n) / d);
+}
+
+static uint32 CountBits(uint32 mask)
+{
+    return uint32(std::popcount(mask));
+}
+
+// Replicates VSMain for one triangle of a primitive, and snaps the result to the viewport
+static RasterTriangle SetupTriangle(const OverdrawPrimitive& primitive, uint32 triIdx, uint32 width, uint32 height)
+{
+    RasterTriangle tri;
+    tri.LayerIndex = primitive.LayerIndex;
+    tri.Depth = primitive.Depth;
+
+    for(uint32 i = 0; i < 3; ++i)
+    {
+        const Float2 position = primitive.Positions[OverdrawVertexCorner(triIdx, i)];
+        const double screenX = (position.x * 0.5 + 0.5) * width;
+        const double screenY = (0.5 - position.y * 0.5) * height;
+        tri.X[i] = int64(std::round(screenX * SubPixelScale));
+        tri.Y[i] = int64(std::round(screenY * SubPixelScale));
+    }
+
+    // The PSO doesn't cull, so flip clockwise triangles around so that the inside of every edge
+    // is on the positive side
+    const int64 area = (tri.X[1] - tri.X[0]) * (tri.Y[2] - tri.Y[0]) - (tri.Y[1] - tri.Y[0]) * (tri.X[2] - tri.X[0]);
+    if(area < 0)
+    {
+        Swap(tri.X[1], tri.X[2]);
+        Swap(tri.Y[1], tri.Y[2]);
+    }
+    else if(area == 0)
+        return tri;
+
+    const int64 minX = Min(tri.X[0], Min(tri.X[1], tri.X[2]));
+    const int64 minY = Min(tri.Y[0], Min(tri.Y[1], tri.Y[2]));
+    const int64 maxX = Max(tri.X[0], Max(tri.X[1], tri.X[2]));
+    const int64 maxY = Max(tri.Y[0], Max(tri.Y[1], tri.Y[2]));
+    tri.MinX = Max<int64>(FloorDiv(minX, SubPixelScale), 0);
+    tri.MinY = Max<int64>(FloorDiv(minY, SubPixelScale), 0);
+    tri.MaxX = Min<int64>(FloorDiv(maxX, SubPixelScale) + 1, width);
+    tri.MaxY = Min<int64>(FloorDiv(maxY, SubPixelScale) + 1, height);
+
+    return tri;
+}
+
+// Narrows [spanStart, spanEnd) down to the pixels in the row whose centers are inside of the
+// edge, using the D3D top-left rule for centers that are exactly on the edge
+static void ClipSpanToEdge(int64 x0, int64 y0, int64 x1, int64 y1, int64 rowCenterY, int64& spanStart, int64& spanEnd)
+{
+    // E(px, py) = dx * (py - y0) + a * (px - x0), which is positive on the inside. (a, dx) is the
+    // inward-facing normal, which tells us whether it's a left edge or a top edge.
+    const int64 a = y0 - y1;
+    const int64 dx = x1 - x0;
+    const bool topLeft = a > 0 || (a == 0 && dx > 0);
+
+    // With pixel centers at px = x * SubPixelScale + SubPixelScale / 2, the pixel is inside
+    // when step * x + c > 0
+    const int64 c = dx * (rowCenterY - y0) + a * (SubPixelScale / 2 - x0) + (topLeft ? 1 : 0);
+    const int64 step = a * SubPixelScale;
+
+    if(step > 0)
+        spanStart = Max(spanStart, FloorDiv(-c, step) + 1);
+    else if(step < 0)
+        spanEnd = Min(spanEnd, CeilDiv(c, -step));
+    else if(c <= 0)
+        spanEnd = spanStart;
+}
+
+static void AddCounts(EarlyZPrediction& total, const EarlyZPrediction& counts)
+{
+    total.CoveredPixels += counts.CoveredPixels;
+    total.RasterizedPixels += counts.RasterizedPixels;
+    total.PSInvocations += counts.PSInvocations;
+    total.EarlyDepthTests += counts.EarlyDepthTests;
+    total.LateDepthTests += counts.LateDepthTests;
+    total.DepthTestsPassed += counts.DepthTestsPassed;
+    total.DiscardedPixels += counts.DiscardedPixels;
+    total.ColorWrites += counts.ColorWrites;
+    total.DepthWrites += counts.DepthWrites;
+}
+
+// Runs all of the triangles over a single tile, in submission order. Pixels only ever depend on
+// earlier triangles at the same location, so tiles can be processed completely independently.
+static void RasterizeTile(const EarlyZConfig& config, EarlyZPath path, const RasterTriangle* triangles, uint64 numTriangles,
+                          int64 tileX, int64 tileY, uint32 width, uint32 height, EarlyZPrediction& counts)
+{
+    alignas(16) float depthBuffer[TileSize * TileSize];
+    uint64 coveredRows[TileSize] = { };
+
+    const float clearDepth = config.ClearDepthToZero ? 0.0f : 1.0f;
+    for(uint32 i = 0; i < TileSize * TileSize; ++i)
+        depthBuffer[i] = clearDepth;
+
+    const int64 tileEndX = Min<int64>(tileX + TileSize, width);
+    const int64 tileEndY = Min<int64>(tileY + TileSize, height);
+
+    const bool hasCheckerDiscard = config.DiscardMode == DiscardModes::DiscardChecker;
+    const bool hasUAV = config.UAVWriteMode != UAVWriteModes::NoUAV;
+
+    for(uint64 triIdx = 0; triIdx < numTriangles; ++triIdx)
+    {
+        const RasterTriangle& tri = triangles[triIdx];
+        if(tri.MinX >= tileEndX || tri.MaxX <= tileX || tri.MinY >= tileEndY || tri.MaxY <= tileY)
+            continue;
+
+        const XMVECTOR triDepth = XMVectorReplicate(tri.Depth);
+
+        const int64 startY = Max(tileY, tri.MinY);
+        const int64 endY = Min(tileEndY, tri.MaxY);
+        for(int64 y = startY; y < endY; ++y)
+        {
+            int64 spanStart = Max(tileX, tri.MinX);
+            int64 spanEnd = Min(tileEndX, tri.MaxX);
+
+            const int64 rowCenterY = y * SubPixelScale + SubPixelScale / 2;
+            ClipSpanToEdge(tri.X[0], tri.Y[0], tri.X[1], tri.Y[1], rowCenterY, spanStart, spanEnd);
+            ClipSpanToEdge(tri.X[1], tri.Y[1], tri.X[2], tri.Y[2], rowCenterY, spanStart, spanEnd);
+            ClipSpanToEdge(tri.X[2], tri.Y[2], tri.X[0], tri.Y[0], rowCenterY, spanStart, spanEnd);
+            if(spanStart >= spanEnd)
+                continue;
+
+            const int64 localY = y - tileY;
+            const uint64 spanBits = (spanEnd - spanStart) == 64 ? ~uint64(0) : ((uint64(1) << (spanEnd - spanStart)) - 1);
+            coveredRows[localY] |= spanBits << (spanStart - tileX);
+
+            for(int64 groupX = spanStart & ~int64(3); groupX < spanEnd; groupX += 4)
+            {
+                uint32 coverage = 0;
+                for(int64 lane = 0; lane < 4; ++lane)
+                    coverage |= (groupX + lane >= spanStart && groupX + lane < spanEnd) ? (1 << lane) : 0;
+
+                // The checker cells are 32 pixels wide, so the whole group either discards or doesn't
+                const bool discardGroup = hasCheckerDiscard && ((((groupX >> 5) ^ (y >> 5)) & 1) == (tri.LayerIndex & 1));
+                const uint32 keepMask = discardGroup ? 0 : 0xF;
+
+                float* groupDepth = &depthBuffer[localY * TileSize + (groupX - tileX)];
+                const XMVECTOR currDepth = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(groupDepth));
+                const uint32 passMask = uint32(_mm_movemask_ps(XMVectorLessOrEqual(triDepth, currDepth))) & coverage;
+
+                uint32 psMask = 0;
+                uint32 depthWriteMask = 0;
+                uint32 colorWriteMask = 0;
+                if(path == EarlyZPath::EarlyZ)
+                {
+                    // [earlydepthstencil] writes depth even for pixels that get discarded
+                    counts.EarlyDepthTests += CountBits(coverage);
+                    counts.DepthTestsPassed += CountBits(passMask);
+                    psMask = passMask;
+                    depthWriteMask = config.ForceEarlyZ ? passMask : (passMask & keepMask);
+                    colorWriteMask = passMask & keepMask;
+                }
+                else if(path == EarlyZPath::EarlyTestLateWrite)
+                {
+                    // Failing the early test guarantees failing the late one, and the pixels that
+                    // pass will pass again since the same pixel can't have been written in between
+                    const uint32 lateMask = passMask & keepMask;
+                    counts.EarlyDepthTests += CountBits(coverage);
+                    counts.LateDepthTests += CountBits(lateMask);
+                    counts.DepthTestsPassed += CountBits(lateMask);
+                    psMask = passMask;
+                    depthWriteMask = lateMask;
+                    colorWriteMask = lateMask;
+                }
+                else
+                {
+                    // UAV writes happen in the shader, so they don't care about the depth test
+                    const uint32 survivingMask = coverage & keepMask;
+                    const uint32 lateMask = passMask & keepMask;
+                    counts.LateDepthTests += CountBits(survivingMask);
+                    counts.DepthTestsPassed += CountBits(lateMask);
+                    psMask = coverage;
+                    depthWriteMask = lateMask;
+                    colorWriteMask = hasUAV ? survivingMask : lateMask;
+                }
+
+                counts.RasterizedPixels += CountBits(coverage);
+                counts.PSInvocations += CountBits(psMask);
+                counts.DiscardedPixels += CountBits(psMask & ~keepMask);
+                counts.ColorWrites += CountBits(colorWriteMask);
+
+                if(config.EnableDepthWrites && depthWriteMask != 0)
+                {
+                    const XMVECTOR selectMask = XMVectorSelectControl(depthWriteMask & 0x1, (depthWriteMask >> 1) & 0x1,
+                                                                      (depthWriteMask >> 2) & 0x1, (depthWriteMask >> 3) & 0x1);
+                    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(groupDepth), XMVectorSelect(currDepth, triDepth, selectMask));
+                    counts.DepthWrites += CountBits(depthWriteMask);
+                }
+            }
+        }
+    }
+
+    for(uint32 i = 0; i < TileSize; ++i)
+        counts.CoveredPixels += uint64(std::popcount(coveredRows[i]));
+}
+
+EarlyZConfig EarlyZConfig::FromAppSettings()
+{
+    EarlyZConfig config;
+    config.DiscardMode = AppSettings::DiscardMode;
+    config.DepthExportMode = AppSettings::DepthExportMode;
+    config.UAVWriteMode = AppSettings::UAVWriteMode;
+    config.ForceEarlyZ = AppSettings::ForceEarlyZ;
+    config.EnableDepthWrites = AppSettings::EnableDepthWrites;
+    config.ReverseTriangleOrder = AppSettings::ReverseTriangleOrder;
+    config.ClearDepthToZero = AppSettings::ClearDepthToZero;
+    config.BarrierBetweenDraws = AppSettings::BarrierBetweenDraws;
+    config.Scene = OverdrawSceneSettings::FromAppSettings();
+    return config;
+}
+
+std::string EarlyZConfig::Description() const
+{
+    return MakeString("%s, %s, %s, ForceEarlyZ=%u, DepthWrites=%u, Reverse=%u, ClearToZero=%u, Barrier=%u, Scene=(%s)",
+                      DiscardModesLabels[uint32(DiscardMode)], DepthExportModesLabels[uint32(DepthExportMode)],
+                      UAVWriteModesLabels[uint32(UAVWriteMode)], uint32(ForceEarlyZ), uint32(EnableDepthWrites),
+                      uint32(ReverseTriangleOrder), uint32(ClearDepthToZero), uint32(BarrierBetweenDraws),
+                      Scene.Description().c_str());
+}
+
+EarlyZPath DetermineEarlyZPath(const EarlyZConfig& config)
+{
+    // [earlydepthstencil] always runs the depth test and write before the shader. Any depth
+    // that the shader exports is ignored.
+    if(config.ForceEarlyZ)
+        return EarlyZPath::EarlyZ;
+
+    // UAV writes are side effects, so the shader has to run for every pixel that passes
+    // rasterization before the depth test can be done
+    if(config.UAVWriteMode != UAVWriteModes::NoUAV)
+        return EarlyZPath::LateZ;
+
+    if(config.DepthExportMode == DepthExportModes::ArbitraryDepth)
+        return EarlyZPath::LateZ;
+
+    // The PSO tests with LESS_EQUAL, so the early test can only reject pixels if the shader
+    // promises not to move them closer (SV_DepthGreaterEqual, the "opposing" mode). With
+    // SV_DepthLessEqual a pixel that fails with the interpolated depth could still pass.
+    if(config.DepthExportMode == DepthExportModes::ConservativeDepthMatching)
+        return EarlyZPath::LateZ;
+    if(config.DepthExportMode == DepthExportModes::ConservativeDepthOpposing)
+        return EarlyZPath::EarlyTestLateWrite;
+
+    // The compiler can't prove that DiscardNever never discards, so both modes need to hold off
+    // on writing depth until the shader is done
+    if(config.DiscardMode != DiscardModes::NoDiscard && config.EnableDepthWrites)
+        return EarlyZPath::EarlyTestLateWrite;
+
+    return EarlyZPath::EarlyZ;
+}
+
+EarlyZPrediction PredictEarlyZ(const EarlyZConfig& config, uint32 width, uint32 height, uint32 maxThreads)
+{
+    EarlyZPrediction prediction;
+    prediction.DepthPath = DetermineEarlyZPath(config);
+    if(width == 0 || height == 0)
+        return prediction;
+
+    OverdrawScene scene;
+    scene.Generate(config.Scene, config.ReverseTriangleOrder);
+
+    // Instances within a draw are rasterized in order, so the primitive order is the submission order
+    const List<OverdrawPrimitive>& primitives = scene.Primitives();
+    const uint32 trisPerPrimitive = scene.TrianglesPerPrimitive();
+    Array<RasterTriangle> triangles(primitives.Count() * trisPerPrimitive);
+    for(uint64 primIdx = 0; primIdx < primitives.Count(); ++primIdx)
+    {
+        for(uint32 triIdx = 0; triIdx < trisPerPrimitive; ++triIdx)
+            triangles[primIdx * trisPerPrimitive + triIdx] = SetupTriangle(primitives[primIdx], triIdx, width, height);
+    }
+
+    const uint32 numTilesX = (width + TileSize - 1) / TileSize;
+    const uint32 numTilesY = (height + TileSize - 1) / TileSize;
+    Array<EarlyZPrediction> tileCounts(numTilesX * numTilesY);
+
+    Jobs::ParallelFor(tileCounts.Size(), [&](uint64 tileIdx)
+    {
+        const int64 tileX = int64(tileIdx % numTilesX) * TileSize;
+        const int64 tileY = int64(tileIdx / numTilesX) * TileSize;
+        RasterizeTile(config, prediction.DepthPath, triangles.Data(), triangles.Size(), tileX, tileY, width, height, tileCounts[tileIdx]);
+    }, maxThreads);
+
+    for(uint64 tileIdx = 0; tileIdx < tileCounts.Size(); ++tileIdx)
+        AddCounts(prediction, tileCounts[tileIdx]);
+
+    if(prediction.CoveredPixels > 0)
+    {
+        prediction.RasterOverdraw = double(prediction.RasterizedPixels) / double(prediction.CoveredPixels);
+        prediction.ShadingOverdraw = double(prediction.PSInvocations) / double(prediction.CoveredPixels);
+    }
+
+    return prediction;
+}
+
+void PredictAllEarlyZConfigs(uint32 width, uint32 height, const OverdrawSceneSettings& scene,
+                             List<EarlyZConfig>& configs, List<EarlyZPrediction>& predictions)
+{
+    configs.RemoveAll();
+    predictions.RemoveAll();
+
+    EarlyZConfig::ForEach([&](const EarlyZConfig& config)
+    {
+        configs.Add(config);
+        predictions.Add(PredictEarlyZ(config, width, height));
+    }, scene);
+}
+
+void LogEarlyZPredictions(uint32 width, uint32 height, const OverdrawSceneSettings& scene)
+{
+    Timer timer;
+
+    List<EarlyZConfig> configs;
+    List<EarlyZPrediction> predictions;
+    PredictAllEarlyZConfigs(width, height, scene, configs, predictions);
+
+    timer.Update();
+
+    WriteLog("Predicted Early-Z results for %llu configurations at %ux%u (%.2fms)", configs.Count(), width, height, timer.ElapsedMillisecondsD());
+    for(uint64 i = 0; i < configs.Count(); ++i)
+    {
+        const EarlyZPrediction& prediction = predictions[i];
+        WriteLog("  %s: %s, %llu PS invocations, %llu early tests, %llu late tests, %llu passed, %.2fx overdraw",
+                 configs[i].Description().c_str(), EarlyZPathLabels[uint32(prediction.DepthPath)], prediction.PSInvocations,
+                 prediction.EarlyDepthTests, prediction.LateDepthTests, prediction.DepthTestsPassed, prediction.ShadingOverdraw);
+    }
+
+    configs.Shutdown();
+    predictions.Shutdown();
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <Containers.h>
+
+#include "AppSettings.h"
+#include "OverdrawScene.h"
+
+using namespace SampleFramework12;
+
+// CPU reference for the test scene, which replays the draws from OverdrawScene through a tiled
+// rasterizer and predicts what the depth test and pixel shader should be doing for a particular
+// combination of settings. It doesn't touch D3D12, so it can run on machines without a GPU.
+
+struct EarlyZConfig
+{
+    DiscardModes DiscardMode = DiscardModes::NoDiscard;
+    DepthExportModes DepthExportMode = DepthExportModes::NoDepthExport;
+    UAVWriteModes UAVWriteMode = UAVWriteModes::NoUAV;
+    bool ForceEarlyZ = false;
+    bool EnableDepthWrites = false;
+    bool ReverseTriangleOrder = false;
+    bool ClearDepthToZero = false;
+    bool BarrierBetweenDraws = false;      // doesn't affect the predicted results
+    OverdrawSceneSettings Scene;
+
+    bool operator==(const EarlyZConfig& other) const = default;
+
+    static EarlyZConfig FromAppSettings();
+
+    // Calls func(config) for every possible combination of settings, using the same scene for all of them
+    template<typename TFunc> static void ForEach(const TFunc& func, const OverdrawSceneSettings& scene = OverdrawSceneSettings());
+
+    std::string Description() const;
+};
+
+enum class EarlyZPath
+{
+    EarlyZ = 0,             // depth test + write before the pixel shader
+    EarlyTestLateWrite,     // depth test before the pixel shader to reject, write after it
+    LateZ,                  // depth test + write after the pixel shader
+
+    NumValues
+};
+
+extern const char* EarlyZPathLabels[uint32(EarlyZPath::NumValues)];
+
+struct EarlyZPrediction
+{
+    EarlyZPath DepthPath = EarlyZPath::EarlyZ;
+
+    uint64 CoveredPixels = 0;       // pixels covered by at least one triangle
+    uint64 RasterizedPixels = 0;    // pixels covered by each draw, summed
+    uint64 PSInvocations = 0;
+    uint64 EarlyDepthTests = 0;
+    uint64 LateDepthTests = 0;
+    uint64 DepthTestsPassed = 0;
+    uint64 DiscardedPixels = 0;
+    uint64 ColorWrites = 0;         // render target or UAV writes
+    uint64 DepthWrites = 0;
+
+    double RasterOverdraw = 0.0;    // RasterizedPixels / CoveredPixels
+    double ShadingOverdraw = 0.0;   // PSInvocations / CoveredPixels
+};
+
+EarlyZPath DetermineEarlyZPath(const EarlyZConfig& config);
+
+EarlyZPrediction PredictEarlyZ(const EarlyZConfig& config, uint32 width, uint32 height, uint32 maxThreads = 0);
+
+// Predicts every combination of settings at the given resolution, and logs the results
+void PredictAllEarlyZConfigs(uint32 width, uint32 height, const OverdrawSceneSettings& scene,
+                             List<EarlyZConfig>& configs, List<EarlyZPrediction>& predictions);
+void LogEarlyZPredictions(uint32 width, uint32 height, const OverdrawSceneSettings& scene = OverdrawSceneSettings());
+
+template<typename TFunc> void EarlyZConfig::ForEach(const TFunc& func, const OverdrawSceneSettings& scene)
+{
+    for(uint32 discardMode = 0; discardMode < uint32(DiscardModes::NumValues); ++discardMode)
+    {
+        for(uint32 depthExportMode = 0; depthExportMode < uint32(DepthExportModes::NumValues); ++depthExportMode)
+        {
+            for(uint32 uavWriteMode = 0; uavWriteMode < uint32(UAVWriteModes::NumValues); ++uavWriteMode)
+            {
+                for(uint32 flags = 0; flags < 32; ++flags)
+                {
+                    EarlyZConfig config;
+                    config.DiscardMode = DiscardModes(discardMode);
+                    config.DepthExportMode = DepthExportModes(depthExportMode);
+                    config.UAVWriteMode = UAVWriteModes(uavWriteMode);
+                    config.ForceEarlyZ = (flags & 0x1) != 0;
+                    config.EnableDepthWrites = (flags & 0x2) != 0;
+                    config.ReverseTriangleOrder = (flags & 0x4) != 0;
+                    config.ClearDepthToZero = (flags & 0x8) != 0;
+                    config.BarrierBetweenDraws = (flags & 0x10) != 0;
+                    config.Scene = scene;
+                    func(config);
+                }
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -63,6 +63,8 @@ void EarlyZTest::AfterReset()
 
 void EarlyZTest::Initialize()
 {
+    psoManager.Initialize();
+
     testVS = CompileFromFile(L"EarlyZTest.hlsl", "VSMain", ShaderType::Vertex);
     testPS = CompileFromFile(L"EarlyZTest.hlsl", "PSMain", ShaderType::Pixel);
 
@@ -77,6 +79,13 @@ void EarlyZTest::Initialize()
         queryReadbackBuffers[i].Initialize(sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS));
         queryReadbackBuffers[i].Resource->SetName(L"Query Readback Buffer");
     }
+
+    if(benchmarkMode)
+    {
+        benchmark.Init(BenchmarkSettings(swapChain.Width(), swapChain.Height(), OverdrawSceneSettings::FromAppSettings()));
+        Profiler::GlobalProfiler.SetAlwaysEnableGPUProfiling(true);
+        WriteLog("Running the benchmark for %llu configurations", benchmark.NumConfigs());
+    }
 }
 
 void EarlyZTest::Shutdown()
@@ -86,42 +95,73 @@ void EarlyZTest::Shutdown()
     DX12::Release(queryHeap);
     for (ReadbackBuffer& buffer : queryReadbackBuffers)
         buffer.Shutdown();
+
+    testPSO.Release();
+    testDepthWritePSO.Release();
+    psoManager.Shutdown();
 }
 
 void EarlyZTest::CreatePSOs()
 {
+    // These get created on the job threads, and Render() keeps using the previous PSOs until they're done
     {
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-        psoDesc.pRootSignature = DX12::UniversalRootSignature;
-        psoDesc.VS = testVS.ByteCode();
-        psoDesc.PS = testPS.ByteCode();
-        psoDesc.RasterizerState = DX12::GetRasterizerState(RasterizerState::NoCull);
-        psoDesc.BlendState = DX12::GetBlendState(BlendState::Disabled);
-        psoDesc.DepthStencilState = DX12::GetDepthState(DepthState::Enabled);
-        psoDesc.SampleMask = UINT_MAX;
-        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-        psoDesc.NumRenderTargets = 1;
-        psoDesc.RTVFormats[0] = mainTarget.Format();
-        psoDesc.DSVFormat = depthBuffer.DSVFormat;
-        psoDesc.SampleDesc.Count = 1;
-        psoDesc.SampleDesc.Quality = 0;
-        DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&testPSO)));
-
-        psoDesc.DepthStencilState = DX12::GetDepthState(DepthState::WritesEnabled);
-        DXCall(DX12::Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&testDepthWritePSO)));
+        GraphicsPSODesc psoDesc;
+        psoDesc.VS = testVS;
+        psoDesc.PS = testPS;
+        psoDesc.Desc.pRootSignature = DX12::UniversalRootSignature;
+        psoDesc.Desc.RasterizerState = DX12::GetRasterizerState(RasterizerState::NoCull);
+        psoDesc.Desc.BlendState = DX12::GetBlendState(BlendState::Disabled);
+        psoDesc.Desc.DepthStencilState = DX12::GetDepthState(DepthState::Enabled);
+        psoDesc.Desc.SampleMask = UINT_MAX;
+        psoDesc.Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        psoDesc.Desc.NumRenderTargets = 1;
+        psoDesc.Desc.RTVFormats[0] = mainTarget.Format();
+        psoDesc.Desc.DSVFormat = depthBuffer.DSVFormat;
+        psoDesc.Desc.SampleDesc.Count = 1;
+        psoDesc.Desc.SampleDesc.Quality = 0;
+        testPSO.Request(psoManager, psoDesc);
+
+        psoDesc.Desc.DepthStencilState = DX12::GetDepthState(DepthState::WritesEnabled);
+        testDepthWritePSO.Request(psoManager, psoDesc);
     }
 }
 
 void EarlyZTest::DestroyPSOs()
 {
-    DX12::DeferredRelease(testPSO);
-    DX12::DeferredRelease(testDepthWritePSO);
+    // The managed PSOs hang on to their current state until the replacements are ready
 }
 
 void EarlyZTest::Update(const Timer& timer)
 {
     CPUProfileBlock cpuProfileBlock("Update");
 
+    if(benchmarkMode && benchmark.Finished() == false)
+    {
+        // Override the UI settings with the current benchmark configuration. Changing the shader
+        // options will trigger a recompile before we render the frame.
+        const EarlyZConfig& config = benchmark.CurrentConfig();
+        AppSettings::DiscardMode.SetValue(config.DiscardMode);
+        AppSettings::DepthExportMode.SetValue(config.DepthExportMode);
+        AppSettings::UAVWriteMode.SetValue(config.UAVWriteMode);
+        AppSettings::ForceEarlyZ.SetValue(config.ForceEarlyZ);
+        AppSettings::EnableDepthWrites.SetValue(config.EnableDepthWrites);
+        AppSettings::ReverseTriangleOrder.SetValue(config.ReverseTriangleOrder);
+        AppSettings::ClearDepthToZero.SetValue(config.ClearDepthToZero);
+        AppSettings::BarrierBetweenDraws.SetValue(config.BarrierBetweenDraws);
+        AppSettings::EnableVSync.SetValue(false);
+    }
+
+    // Re-generate the scene if any of its settings changed
+    const OverdrawSceneSettings currSceneSettings = OverdrawSceneSettings::FromAppSettings();
+    const bool reverseOrder = AppSettings::ReverseTriangleOrder ? true : false;
+    if(sceneGenerated == false || currSceneSettings != sceneSettings || reverseOrder != sceneReversed)
+    {
+        sceneSettings = currSceneSettings;
+        sceneReversed = reverseOrder;
+        sceneGenerated = true;
+        scene.Generate(sceneSettings, sceneReversed);
+    }
+
     // Toggle VSYNC
     swapChain.SetVSYNCEnabled(AppSettings::EnableVSync ? true : false);
 }
@@ -162,42 +202,55 @@ void EarlyZTest::Render(const Timer& timer)
 
     DX12::SetViewport(cmdList, swapChain.Width(), swapChain.Height());
 
-    cmdList->SetPipelineState(AppSettings::EnableDepthWrites ? testDepthWritePSO : testPSO);
+    // The benchmark needs to measure the current shader permutation, not whatever was there before
+    ManagedPSO& pso = AppSettings::EnableDepthWrites ? testDepthWritePSO : testPSO;
+    if(benchmarkMode)
+        pso.Wait();
+
+    cmdList->SetPipelineState(pso.GetOrWait());
     cmdList->SetGraphicsRootSignature(DX12::UniversalRootSignature);
     cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
     AppSettings::BindCBufferGfx(cmdList, URS_AppSettings);
 
+    // Upload the scene every frame, it's small enough that it's not worth keeping a persistent buffer around
+    const List<OverdrawPrimitive>& primitives = scene.Primitives();
+    TempBuffer primitiveBuffer = DX12::TempStructuredBuffer(primitives.Count(), sizeof(OverdrawPrimitive));
+    memcpy(primitiveBuffer.CPUAddress, primitives.Data(), primitives.Count() * sizeof(OverdrawPrimitive));
+
     TestConstants testConstants =
     {
         .OutputTexture = useUAV ? mainTarget.UAV : InvalidDescriptorIndex,
-        .DrawIndex = 0,
+        .PrimitiveBuffer = primitiveBuffer.DescriptorIndex,
+        .FirstPrimitive = 0,
     };
-    DX12::BindTempConstantBuffer(cmdList, testConstants, URS_ConstantBuffers + 0, CmdListMode::Graphics);
 
     cmdList->BeginQuery(queryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0);
 
-    cmdList->DrawInstanced(3, 1, 0, 0);
-
-    if (AppSettings::BarrierBetweenDraws)
+    const List<OverdrawDraw>& draws = scene.Draws();
+    for(uint64 drawIdx = 0; drawIdx < draws.Count(); ++drawIdx)
     {
-        BarrierBatchBuilder barrierBuilder;
-        D3D12_GLOBAL_BARRIER globalBarrier =
+        if (drawIdx > 0 && AppSettings::BarrierBetweenDraws)
         {
-            .SyncBefore = D3D12_BARRIER_SYNC_ALL,
-            .SyncAfter = D3D12_BARRIER_SYNC_ALL,
-            .AccessBefore = D3D12_BARRIER_ACCESS_COMMON,
-            .AccessAfter = D3D12_BARRIER_ACCESS_COMMON,
-        };
-        barrierBuilder.Add(globalBarrier);
-        DX12::Barrier(cmdList, barrierBuilder.Build());
+            BarrierBatchBuilder barrierBuilder;
+            D3D12_GLOBAL_BARRIER globalBarrier =
+            {
+                .SyncBefore = D3D12_BARRIER_SYNC_ALL,
+                .SyncAfter = D3D12_BARRIER_SYNC_ALL,
+                .AccessBefore = D3D12_BARRIER_ACCESS_COMMON,
+                .AccessAfter = D3D12_BARRIER_ACCESS_COMMON,
+            };
+            barrierBuilder.Add(globalBarrier);
+            DX12::Barrier(cmdList, barrierBuilder.Build());
+        }
+
+        const OverdrawDraw& draw = draws[drawIdx];
+        testConstants.FirstPrimitive = draw.FirstPrimitive;
+        DX12::BindTempConstantBuffer(cmdList, testConstants, URS_ConstantBuffers + 0, CmdListMode::Graphics);
+
+        cmdList->DrawInstanced(draw.VertexCount, draw.InstanceCount, 0, 0);
     }
 
-    testConstants.DrawIndex = 1;
-    DX12::BindTempConstantBuffer(cmdList, testConstants, URS_ConstantBuffers + 0, CmdListMode::Graphics);
-
-    cmdList->DrawInstanced(3, 1, 0, 0);
-
     cmdList->EndQuery(queryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0);
     cmdList->ResolveQueryData(queryHeap, D3D12_QUERY_TYPE_PIPELINE_STATISTICS, 0, 1, queryReadbackBuffers[DX12::CurrFrameIdx].Resource, 0);
 
@@ -225,7 +278,33 @@ void EarlyZTest::Render(const Timer& timer)
 
     const D3D12_QUERY_DATA_PIPELINE_STATISTICS* pipelineStats = queryReadbackBuffers[DX12::CurrFrameIdx].Map<D3D12_QUERY_DATA_PIPELINE_STATISTICS>();
 
-    std::string statsString = MakeString("Num PS Invocations: %llu", pipelineStats->PSInvocations);
+    // Compare against what the CPU reference rasterizer expects for the current settings
+    const EarlyZConfig currConfig = EarlyZConfig::FromAppSettings();
+    if(currConfig != predictedConfig || predictedWidth != swapChain.Width() || predictedHeight != swapChain.Height())
+    {
+        predictedConfig = currConfig;
+        predictedWidth = swapChain.Width();
+        predictedHeight = swapChain.Height();
+        prediction = PredictEarlyZ(predictedConfig, predictedWidth, predictedHeight);
+    }
+
+    if(benchmarkMode && benchmark.Finished() == false)
+    {
+        // The query results and profiler timings are from a previous frame, which is fine since the
+        // warmup frames cover the latency after switching to a new configuration
+        EarlyZFrameSample sample;
+        sample.PSInvocations = pipelineStats->PSInvocations;
+        sample.GPUTime = Profiler::GlobalProfiler.GPUProfileTiming("Render Total");
+        sample.CPUTime = Profiler::GlobalProfiler.CPUProfileTiming("Render");
+        if(benchmark.AddFrame(sample) && benchmark.Finished())
+        {
+            benchmark.WriteReports(BenchmarkReportPath().c_str());
+            Exit();
+        }
+    }
+
+    std::string statsString = MakeString("Num PS Invocations: %llu (Predicted: %llu, %s)", pipelineStats->PSInvocations,
+                                         prediction.PSInvocations, EarlyZPathLabels[uint32(prediction.DepthPath)]);
     Float2 textSize = ToFloat2(ImGui::CalcTextSize(statsString.c_str()));
     Float2 windowSize = textSize * 1.05f;
 
@@ -243,8 +322,39 @@ void EarlyZTest::Render(const Timer& timer)
     ImGui::End();
 }
 
+EarlyZBenchmarkSettings EarlyZTest::BenchmarkSettings(uint32 width, uint32 height, const OverdrawSceneSettings& benchmarkScene) const
+{
+    EarlyZBenchmarkSettings settings;
+    settings.WarmupFrames = Max(benchmarkWarmupFrames, uint32(DX12::RenderLatency) + 1);
+    settings.NumFrames = benchmarkFrames;
+    settings.Width = width;
+    settings.Height = height;
+    settings.Scene = benchmarkScene;
+    return settings;
+}
+
+std::wstring EarlyZTest::BenchmarkReportPath() const
+{
+    return benchmarkReportPath.length() > 0 ? benchmarkReportPath : std::wstring(L"EarlyZBenchmark");
+}
+
+int32 EarlyZTest::RunHeadless()
+{
+    // No device here, so the sweep is a predictor-only dry run that just exercises the CPU reference
+    // rasterizer and the reports. The settings haven't been initialized either, so the scene is
+    // always the default one.
+    benchmark.Init(BenchmarkSettings(swapChain.Width(), swapChain.Height(), OverdrawSceneSettings()));
+    WriteLog("Running a predictor-only dry run of the benchmark for %llu configurations", benchmark.NumConfigs());
+
+    NullEarlyZBackend backend(swapChain.Width(), swapChain.Height());
+    benchmark.Run(backend);
+    benchmark.WriteReports(BenchmarkReportPath().c_str());
+
+    return 0;
+}
+
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow)
 {
     EarlyZTest app(lpCmdLine);
-    app.Run();
+    return app.Run();
 }
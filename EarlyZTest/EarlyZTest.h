@@ -14,7 +14,11 @@
 
 #include <App.h>
 #include <Graphics/GraphicsTypes.h>
+#include <Graphics/PSOManager.h>
 #include "AppSettings.h"
+#include "EarlyZPredictor.h"
+#include "OverdrawScene.h"
+#include "EarlyZBenchmark.h"
 
 using namespace SampleFramework12;
 
@@ -25,8 +29,9 @@ protected:
 
     CompiledShaderPtr testVS;
     CompiledShaderPtr testPS;
-    ID3D12PipelineState* testPSO = nullptr;
-    ID3D12PipelineState* testDepthWritePSO = nullptr;
+    PSOManager psoManager;
+    ManagedPSO testPSO;
+    ManagedPSO testDepthWritePSO;
 
     RenderTexture mainTarget;
     DepthBuffer depthBuffer;
@@ -34,6 +39,18 @@ protected:
     ID3D12QueryHeap* queryHeap = nullptr;
     ReadbackBuffer queryReadbackBuffers[DX12::RenderLatency];
 
+    OverdrawScene scene;
+    OverdrawSceneSettings sceneSettings;
+    bool sceneReversed = false;
+    bool sceneGenerated = false;
+
+    EarlyZConfig predictedConfig;
+    EarlyZPrediction prediction;
+    uint32 predictedWidth = 0;
+    uint32 predictedHeight = 0;
+
+    EarlyZBenchmark benchmark;
+
     virtual void Initialize() override;
     virtual void Shutdown() override;
 
@@ -46,6 +63,11 @@ protected:
     virtual void CreatePSOs() override;
     virtual void DestroyPSOs() override;
 
+    virtual int32 RunHeadless() override;
+
+    EarlyZBenchmarkSettings BenchmarkSettings(uint32 width, uint32 height, const OverdrawSceneSettings& benchmarkScene) const;
+    std::wstring BenchmarkReportPath() const;
+
 public:
 
     EarlyZTest(const wchar* cmdLine);
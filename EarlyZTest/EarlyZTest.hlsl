@@ -8,30 +8,22 @@ struct VSOutput
 {
     centroid float4 Position : SV_Position;
     float4 Color : COLOR;
-    uint TriIndex : TRIINDEX;
+    uint LayerIndex : LAYERINDEX;
 };
 
-VSOutput VSMain(in uint vertexIndex : SV_VertexID)
+VSOutput VSMain(in uint vertexIndex : SV_VertexID, in uint instanceIndex : SV_InstanceID)
 {
-    uint triangleIndex = CB.DrawIndex;
-    if (AppSettings.ReverseTriangleOrder)
-        triangleIndex = (triangleIndex + 1) % 2;
+    StructuredBuffer<OverdrawPrimitive> primitiveBuffer = ResourceDescriptorHeap[CB.PrimitiveBuffer];
+    OverdrawPrimitive primitive = primitiveBuffer[CB.FirstPrimitive + instanceIndex];
 
-    float4 position = float4(-0.5f, -0.5f, 1.0f, 1.0f);
-    if (vertexIndex == 1)
-        position.xy = float2(0.0f, 0.75f);
-    else if(vertexIndex == 2)
-        position.xy = float2(0.5f, -0.5f);
-    if (triangleIndex == 1)
-    {
-        position.y *= -1.0f;
-        position.z = 0.5f;
-    }
+    // Quads are drawn as 6 vertices, with the second triangle re-using 2 of the corners
+    static const uint QuadCorners[6] = { 0, 1, 2, 2, 1, 3 };
+    uint corner = QuadCorners[vertexIndex];
 
     VSOutput output;
-    output.Position = position;
-    output.Color = triangleIndex == 1 ? float4(0.1f, 0.9f, 0.1f, 1.0f) : float4(0.9f, 0.1f, 0.1f, 1.0f);
-    output.TriIndex = triangleIndex;
+    output.Position = float4(primitive.Positions[corner], primitive.Depth, 1.0f);
+    output.Color = primitive.Color;
+    output.LayerIndex = primitive.LayerIndex;
     return output;
 }
 
@@ -64,7 +56,7 @@ PSOutput PSMain(in VSOutput vsOutput)
 {
 #if DiscardMode_ == DiscardChecker_
     uint2 checker = (uint2(vsOutput.Position.xy) / 32) % 2;
-    if ((checker.x ^ checker.y) == vsOutput.TriIndex)
+    if ((checker.x ^ checker.y) == (vsOutput.LayerIndex & 1))
         discard;
 #elif DiscardMode_ == DiscardNever_
     if (vsOutput.Color.x < 0.0f)
@@ -0,0 +1,219 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Utility.h>
+#include <SF12_Math.h>
+
+#include "OverdrawScene.h"
+
+using namespace SampleFramework12;
+
+static const Float4 BackLayerColor = Float4(0.9f, 0.1f, 0.1f, 1.0f);
+static const Float4 FrontLayerColor = Float4(0.1f, 0.9f, 0.1f, 1.0f);
+
+// Layer 0 is at the far plane, and each layer after that is closer to the camera
+static float LayerDepth(uint32 layerIdx, uint32 numLayers)
+{
+    return 1.0f - float(layerIdx) / float(numLayers);
+}
+
+static Float4 LayerColor(uint32 layerIdx, uint32 numLayers)
+{
+    return numLayers > 1 ? Lerp(BackLayerColor, FrontLayerColor, float(layerIdx) / float(numLayers - 1)) : BackLayerColor;
+}
+
+OverdrawSceneSettings OverdrawSceneSettings::FromAppSettings()
+{
+    OverdrawSceneSettings settings;
+    settings.Mode = AppSettings::SceneMode;
+    settings.PrimitiveType = AppSettings::PrimitiveType;
+    settings.DepthOrder = AppSettings::DepthOrder;
+    settings.NumLayers = uint32(AppSettings::NumLayers.Value());
+    settings.LayerCoverage = AppSettings::LayerCoverage.Value();
+    settings.InstancesPerDraw = uint32(AppSettings::InstancesPerDraw.Value());
+    return settings;
+}
+
+std::string OverdrawSceneSettings::Description() const
+{
+    if(Mode == SceneModes::TwoTriangles)
+        return SceneModesLabels[uint32(Mode)];
+
+    return MakeString("%s, %s, %s, %u layers, %.0f%% coverage, %u per draw", SceneModesLabels[uint32(Mode)],
+                      StressPrimitivesLabels[uint32(PrimitiveType)], DepthOrdersLabels[uint32(DepthOrder)],
+                      NumLayers, LayerCoverage * 100.0f, InstancesPerDraw);
+}
+
+OverdrawScene::~OverdrawScene()
+{
+    primitives.Shutdown();
+    draws.Shutdown();
+}
+
+void OverdrawScene::Generate(const OverdrawSceneSettings& settings, bool reverseOrder)
+{
+    primitives.RemoveAll();
+    draws.RemoveAll();
+
+    uint32 instancesPerDraw = 1;
+    if(settings.Mode == SceneModes::TwoTriangles)
+    {
+        // The original test: a triangle at the far plane, followed by an upside-down one in front of it
+        verticesPerPrimitive = 3;
+        for(uint32 layerIdx = 0; layerIdx < 2; ++layerIdx)
+        {
+            OverdrawPrimitive& primitive = primitives.Add();
+            primitive.Positions[0] = Float2(-0.5f, -0.5f);
+            primitive.Positions[1] = Float2(0.0f, 0.75f);
+            primitive.Positions[2] = Float2(0.5f, -0.5f);
+            primitive.Positions[3] = Float2(0.0f, 0.0f);
+            if(layerIdx == 1)
+            {
+                for(uint32 i = 0; i < 3; ++i)
+                    primitive.Positions[i].y *= -1.0f;
+            }
+
+            primitive.Depth = LayerDepth(layerIdx, 2);
+            primitive.Color = LayerColor(layerIdx, 2);
+            primitive.LayerIndex = layerIdx;
+        }
+    }
+    else
+    {
+        const bool quads = settings.PrimitiveType == StressPrimitives::Quads;
+        const uint32 numLayers = Max(settings.NumLayers, 1u);
+        const float coverage = Saturate(settings.LayerCoverage);
+        verticesPerPrimitive = quads ? 6 : 3;
+        instancesPerDraw = Max(settings.InstancesPerDraw, 1u);
+
+        // Triangles are the lower-left half of their bounding box, so they need twice the area to
+        // cover the same number of pixels as a quad. Past 50% coverage they start getting clipped.
+        const float boxSize = Min(std::sqrt(quads ? coverage : coverage * 2.0f), 1.0f) * 2.0f;
+        const float placementRange = 2.0f - boxSize;
+
+        // Fixed seed, so that the GPU and the predictor both see the same scene every time
+        Random rng;
+        for(uint32 layerIdx = 0; layerIdx < numLayers; ++layerIdx)
+        {
+            const Float2 boxMin = Float2(-1.0f, -1.0f) + rng.RandomFloat2() * placementRange;
+            const Float2 boxMax = boxMin + boxSize;
+
+            OverdrawPrimitive& primitive = primitives.Add();
+            primitive.Positions[0] = Float2(boxMin.x, boxMin.y);
+            primitive.Positions[1] = Float2(boxMin.x, boxMax.y);
+            primitive.Positions[2] = Float2(boxMax.x, boxMin.y);
+            primitive.Positions[3] = Float2(boxMax.x, boxMax.y);
+            primitive.Depth = LayerDepth(layerIdx, numLayers);
+            primitive.Color = LayerColor(layerIdx, numLayers);
+            primitive.LayerIndex = layerIdx;
+        }
+
+        // The layers were generated back-to-front
+        if(settings.DepthOrder == DepthOrders::FrontToBack)
+        {
+            for(uint32 i = 0; i < numLayers / 2; ++i)
+                Swap(primitives[i], primitives[numLayers - 1 - i]);
+        }
+        else if(settings.DepthOrder == DepthOrders::RandomOrder)
+        {
+            for(uint32 i = numLayers - 1; i > 0; --i)
+                Swap(primitives[i], primitives[rng.RandomUint() % (i + 1)]);
+        }
+    }
+
+    const uint32 numPrimitives = uint32(primitives.Count());
+    if(reverseOrder)
+    {
+        for(uint32 i = 0; i < numPrimitives / 2; ++i)
+            Swap(primitives[i], primitives[numPrimitives - 1 - i]);
+    }
+
+    for(uint32 firstPrimitive = 0; firstPrimitive < numPrimitives; firstPrimitive += instancesPerDraw)
+    {
+        OverdrawDraw& draw = draws.Add();
+        draw.VertexCount = verticesPerPrimitive;
+        draw.InstanceCount = Min(instancesPerDraw, numPrimitives - firstPrimitive);
+        draw.FirstPrimitive = firstPrimitive;
+    }
+}
+
+std::string OverdrawScene::Validate(const OverdrawSceneSettings& settings, bool reverseOrder) const
+{
+    const bool twoTriangles = settings.Mode == SceneModes::TwoTriangles;
+    const uint32 numLayers = twoTriangles ? 2 : Max(settings.NumLayers, 1u);
+    const uint32 instancesPerDraw = twoTriangles ? 1 : Max(settings.InstancesPerDraw, 1u);
+    const bool quads = twoTriangles == false && settings.PrimitiveType == StressPrimitives::Quads;
+
+    if(primitives.Count() != numLayers)
+        return MakeString("expected %u primitives, got %llu", numLayers, primitives.Count());
+    if(verticesPerPrimitive != (quads ? 6u : 3u))
+        return MakeString("expected %u vertices per primitive, got %u", quads ? 6 : 3, verticesPerPrimitive);
+
+    // The draws need to cover every primitive exactly once, in order
+    uint32 nextPrimitive = 0;
+    for(uint64 drawIdx = 0; drawIdx < draws.Count(); ++drawIdx)
+    {
+        const OverdrawDraw& draw = draws[drawIdx];
+        if(draw.FirstPrimitive != nextPrimitive)
+            return MakeString("draw %llu starts at primitive %u instead of %u", drawIdx, draw.FirstPrimitive, nextPrimitive);
+        if(draw.InstanceCount == 0 || draw.InstanceCount > instancesPerDraw)
+            return MakeString("draw %llu has %u instances, the limit is %u", drawIdx, draw.InstanceCount, instancesPerDraw);
+        if(draw.VertexCount != verticesPerPrimitive)
+            return MakeString("draw %llu has %u vertices instead of %u", drawIdx, draw.VertexCount, verticesPerPrimitive);
+        nextPrimitive += draw.InstanceCount;
+    }
+
+    if(nextPrimitive != numLayers)
+        return MakeString("the draws cover %u primitives instead of %u", nextPrimitive, numLayers);
+
+    const uint64 expectedDraws = (numLayers + instancesPerDraw - 1) / instancesPerDraw;
+    if(draws.Count() != expectedDraws)
+        return MakeString("expected %llu draws, got %llu", expectedDraws, draws.Count());
+
+    Array<bool> seenLayers(numLayers, false);
+    for(uint32 drawOrder = 0; drawOrder < numLayers; ++drawOrder)
+    {
+        const OverdrawPrimitive& primitive = primitives[drawOrder];
+        const uint32 layerIdx = primitive.LayerIndex;
+        if(layerIdx >= numLayers || seenLayers[layerIdx])
+            return MakeString("layer %u is invalid or was drawn more than once", layerIdx);
+        seenLayers[layerIdx] = true;
+
+        if(primitive.Depth != LayerDepth(layerIdx, numLayers))
+            return MakeString("layer %u has depth %f instead of %f", layerIdx, float(primitive.Depth), LayerDepth(layerIdx, numLayers));
+
+        // Un-reverse the draw order, and check it against what was asked for
+        const uint32 expectedOrder = reverseOrder ? numLayers - 1 - drawOrder : drawOrder;
+        const DepthOrders depthOrder = twoTriangles ? DepthOrders::BackToFront : settings.DepthOrder;
+        if(depthOrder == DepthOrders::BackToFront && layerIdx != expectedOrder)
+            return MakeString("layer %u was drawn out of back-to-front order", layerIdx);
+        if(depthOrder == DepthOrders::FrontToBack && layerIdx != numLayers - 1 - expectedOrder)
+            return MakeString("layer %u was drawn out of front-to-back order", layerIdx);
+
+        if(twoTriangles)
+            continue;
+
+        // Make sure the layer covers the right fraction of the viewport, as long as it wasn't clipped
+        const Float2 boxMin = primitive.Positions[0];
+        const Float2 boxMax = primitive.Positions[3];
+        if(boxMin.x < -1.0001f || boxMin.y < -1.0001f || boxMax.x > 1.0001f || boxMax.y > 1.0001f)
+            return MakeString("layer %u extends past the viewport", layerIdx);
+
+        const float expectedCoverage = quads ? Saturate(settings.LayerCoverage) : Min(Saturate(settings.LayerCoverage), 0.5f);
+        const float boxArea = (boxMax.x - boxMin.x) * (boxMax.y - boxMin.y) * 0.25f;
+        const float layerCoverage = quads ? boxArea : boxArea * 0.5f;
+        if(std::abs(layerCoverage - expectedCoverage) > 0.001f)
+            return MakeString("layer %u covers %.4f of the viewport instead of %.4f", layerIdx, layerCoverage, expectedCoverage);
+    }
+
+    return std::string();
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+#include <Containers.h>
+
+#include "AppSettings.h"
+#include "SharedTypes.h"
+
+using namespace SampleFramework12;
+
+// Generates the layered geometry that the test draws, along with the list of draws to submit.
+// Everything here is plain CPU data so that the same scene can be fed to the GPU and to the
+// reference rasterizer in EarlyZPredictor, and checked without a device.
+
+struct OverdrawSceneSettings
+{
+    SceneModes Mode = SceneModes::TwoTriangles;
+    StressPrimitives PrimitiveType = StressPrimitives::Quads;
+    DepthOrders DepthOrder = DepthOrders::BackToFront;
+    uint32 NumLayers = 16;
+    float LayerCoverage = 0.5f;         // fraction of the viewport covered by each layer
+    uint32 InstancesPerDraw = 1;
+
+    bool operator==(const OverdrawSceneSettings& other) const = default;
+
+    static OverdrawSceneSettings FromAppSettings();
+
+    std::string Description() const;
+};
+
+struct OverdrawDraw
+{
+    uint32 VertexCount = 0;
+    uint32 InstanceCount = 0;
+    uint32 FirstPrimitive = 0;
+};
+
+class OverdrawScene
+{
+
+public:
+
+    ~OverdrawScene();
+
+    // Primitives end up in the order that they're drawn, which is reversed if reverseOrder is set
+    void Generate(const OverdrawSceneSettings& settings, bool reverseOrder);
+
+    const List<OverdrawPrimitive>& Primitives() const { return primitives; }
+    const List<OverdrawDraw>& Draws() const { return draws; }
+    uint32 NumLayers() const { return uint32(primitives.Count()); }
+    uint32 VerticesPerPrimitive() const { return verticesPerPrimitive; }
+    uint32 TrianglesPerPrimitive() const { return verticesPerPrimitive / 3; }
+
+    // Checks that the draws cover every primitive exactly once and that the depth ordering is
+    // what the settings asked for. Returns an empty string on success.
+    std::string Validate(const OverdrawSceneSettings& settings, bool reverseOrder) const;
+
+protected:
+
+    List<OverdrawPrimitive> primitives;
+    List<OverdrawDraw> draws;
+    uint32 verticesPerPrimitive = 3;
+};
+
+// Corners of triangle 'triIdx' of a primitive, matching the vertex order used by VSMain
+inline uint32 OverdrawVertexCorner(uint32 triIdx, uint32 vertexIdx)
+{
+    static const uint32 Corners[2][3] = { { 0, 1, 2 }, { 2, 1, 3 } };
+    return Corners[triIdx][vertexIdx];
+}
\ No newline at end of file
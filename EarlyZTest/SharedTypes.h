@@ -17,8 +17,17 @@
 #endif
 
 
+struct OverdrawPrimitive
+{
+    ShaderFloat4 Color;
+    ShaderFloat2 Positions[4];      // clip-space XY, triangles only use the first 3
+    ShaderFloat Depth;
+    ShaderUint LayerIndex;
+};
+
 struct TestConstants
 {
     DescriptorIndex OutputTexture;
-    ShaderBool DrawIndex;
+    DescriptorIndex PrimitiveBuffer;
+    ShaderUint FirstPrimitive;
 };
\ No newline at end of file
@@ -0,0 +1,16 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include <PCH.h>
+
+// Generates and validates a spread of scene settings, logging any failures
+bool TestOverdrawScene();
\ No newline at end of file
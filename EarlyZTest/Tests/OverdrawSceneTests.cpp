@@ -0,0 +1,73 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Utility.h>
+
+#include "EarlyZTests.h"
+#include "..\\OverdrawScene.h"
+
+using namespace SampleFramework12;
+
+bool TestOverdrawScene()
+{
+    const uint32 layerCounts[] = { 1, 2, 7, 64, 1000 };
+    const float coverages[] = { 0.01f, 0.25f, 0.5f, 1.0f };
+    const uint32 instanceCounts[] = { 1, 3, 64, 4096 };
+
+    OverdrawScene scene;
+    uint64 numTests = 0;
+    uint64 numFailures = 0;
+    auto runTest = [&](const OverdrawSceneSettings& settings, bool reverseOrder)
+    {
+        scene.Generate(settings, reverseOrder);
+        const std::string error = scene.Validate(settings, reverseOrder);
+        if(error.length() > 0)
+        {
+            WriteLog("Overdraw scene test failed for %s (reverse=%u): %s", settings.Description().c_str(), uint32(reverseOrder), error.c_str());
+            ++numFailures;
+        }
+        ++numTests;
+    };
+
+    for(uint32 reverseOrder = 0; reverseOrder < 2; ++reverseOrder)
+    {
+        runTest(OverdrawSceneSettings(), reverseOrder != 0);
+
+        OverdrawSceneSettings settings;
+        settings.Mode = SceneModes::StressLayers;
+        for(uint32 primitiveType = 0; primitiveType < uint32(StressPrimitives::NumValues); ++primitiveType)
+        {
+            settings.PrimitiveType = StressPrimitives(primitiveType);
+            for(uint32 depthOrder = 0; depthOrder < uint32(DepthOrders::NumValues); ++depthOrder)
+            {
+                settings.DepthOrder = DepthOrders(depthOrder);
+                for(uint32 numLayers : layerCounts)
+                {
+                    settings.NumLayers = numLayers;
+                    for(float coverage : coverages)
+                    {
+                        settings.LayerCoverage = coverage;
+                        for(uint32 instancesPerDraw : instanceCounts)
+                        {
+                            settings.InstancesPerDraw = instancesPerDraw;
+                            runTest(settings, reverseOrder != 0);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    WriteLog("Overdraw scene self-test: %llu of %llu passed", numTests - numFailures, numTests);
+
+    return numFailures == 0;
+}
\ No newline at end of file
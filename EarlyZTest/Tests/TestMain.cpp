@@ -0,0 +1,87 @@
+//=================================================================================================
+//
+//  D3D12 Memory Pool Performance Test
+//  by MJP
+//  https://therealmjp.github.io/
+//
+//  All code and content licensed under the MIT license
+//
+//=================================================================================================
+
+#include <PCH.h>
+
+#include <Jobs.h>
+#include <AsyncIO.h>
+#include <Exceptions.h>
+#include <Utility.h>
+#include <Graphics/Model.h>
+#include <Graphics/Profiler.h>
+#include <Tests/Tests.h>
+
+#include "EarlyZTests.h"
+
+using namespace SampleFramework12;
+
+// Runs the self-tests and benchmarks for the framework and the Early-Z scene. None of them need a
+// window or a D3D12 device. Detailed results go to the debug output, and a line per test goes to
+// stdout. Returns non-zero if anything failed.
+int main()
+{
+    struct TestEntry
+    {
+        const char* Name;
+        bool (*Run)();
+    };
+
+    static const TestEntry tests[] =
+    {
+        { "OverdrawScene", []() { return TestOverdrawScene(); } },
+        { "ShaderPrecompiler", []() { return TestShaderPrecompiler(); } },
+        { "ShaderCacheArchive", []() { return TestShaderCacheArchive(); } },
+        { "PSOManager", []() { return TestPSOManager(); } },
+        { "RingAllocator", []() { return TestRingAllocator(); } },
+        { "DescriptorContention", []() { return BenchmarkDescriptorContention(); } },
+        { "Profiler", []() { return TestProfiler(); } },
+        { "CompressedSerialization", []() { return TestCompressedSerialization(); } },
+        { "FileSerialization", []() { return TestFileSerialization(); } },
+        { "AsyncIO", []() { return TestAsyncIO(); } },
+        { "CubemapProjection", []() { return TestCubemapProjection(); } },
+        { "SGBatchSolve", []() { return TestSGBatchSolve(); } },
+        { "SkyLUT", []() { return TestSkyLUT(); } },
+        { "ModelSerializers", []() { return BenchmarkModelSerializers(4); } },
+        { "ModelCacheLoading", []() { return BenchmarkModelCacheLoading(nullptr, 4); } },
+        { "ModelImportScaling", []() { return BenchmarkModelImportScaling(ModelLoadSettings()); } },
+        { "TextureCache", []() { return BenchmarkTextureCache(3); } },
+        { "TextureDecoding", []() { return BenchmarkTextureDecoding(64); } },
+    };
+
+    Jobs::Initialize();
+    AsyncIO::Initialize();
+    Profiler::SetThreadName("Main Thread");
+
+    uint32 numFailures = 0;
+    for(const TestEntry& test : tests)
+    {
+        bool passed = false;
+        try
+        {
+            passed = test.Run();
+        }
+        catch(SampleFramework12::Exception exception)
+        {
+            printf("%s: %ls\n", test.Name, exception.GetMessage().c_str());
+        }
+
+        printf("%s %s\n", test.Name, passed ? "passed" : "FAILED");
+        if(passed == false)
+            ++numFailures;
+    }
+
+    AsyncIO::Shutdown();
+    Jobs::Shutdown();
+
+    const uint32 numTests = uint32(ArraySize_(tests));
+    printf("%u of %u tests passed\n", numTests - numFailures, numTests);
+
+    return numFailures == 0 ? 0 : 1;
+}
\ No newline at end of file
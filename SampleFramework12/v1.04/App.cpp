@@ -14,12 +14,15 @@
 #include "Graphics\\Profiler.h"
 #include "Graphics\\Spectrum.h"
 #include "Graphics\\ShaderDebug.h"
+#include "Graphics\\ShaderCompilation.h"
 #include "SF12_Math.h"
 #include "FileIO.h"
 #include "Settings.h"
 #include "ImGuiHelper.h"
 #include "ImGui/imgui.h"
 #include "Input.h"
+#include "Jobs.h"
+#include "AsyncIO.h"
 
 // AppSettings framework
 namespace AppSettings
@@ -66,6 +69,29 @@ App::~App()
 
 int32 App::Run()
 {
+    if(headless)
+    {
+        try
+        {
+            Jobs::Initialize(numJobThreads);
+            AsyncIO::Initialize();
+            Profiler::SetThreadName("Main Thread");
+
+            returnCode = RunHeadless();
+        }
+        catch(SampleFramework12::Exception exception)
+        {
+            exception.ShowErrorMessage();
+            returnCode = -1;
+        }
+
+        // This needs to happen on the error path too, so that the I/O and job threads get shut down
+        AsyncIO::Shutdown();
+        Jobs::Shutdown();
+
+        return returnCode;
+    }
+
     try
     {
 
@@ -146,6 +172,12 @@ void App::BeforeFlush()
 {
 }
 
+int32 App::RunHeadless()
+{
+    WriteLog(L"%ls doesn't support running headless", applicationName.c_str());
+    return -1;
+}
+
 void App::ParseCommandLine(const wchar* cmdLine)
 {
     if(cmdLine == nullptr)
@@ -172,16 +204,41 @@ void App::ParseCommandLine(const wchar* cmdLine)
     cxxopts::Options options("App", "");
     options.allow_unrecognised_options();
     options.add_options()
-         ("a,adapter", "GPU adapter index", cxxopts::value<int32>());
+         ("a,adapter", "GPU adapter index", cxxopts::value<int32>())
+         ("j,jobthreads", "Number of job system threads (0 for all hardware threads)", cxxopts::value<int32>())
+         ("benchmark", "Run the automated benchmark and exit when it finishes")
+         ("headless", "Run a predictor-only dry run of the benchmark without creating a window or a D3D12 device")
+         ("warmupframes", "Number of frames to skip before recording benchmark results", cxxopts::value<int32>())
+         ("benchmarkframes", "Number of frames to record for each benchmark configuration", cxxopts::value<int32>())
+         ("report", "Path for the benchmark reports, without an extension", cxxopts::value<std::string>());
 
     cxxopts::ParseResult parseResult = options.parse(argc, argv);
 
     if(parseResult.count("adapter"))
         adapterIdx = parseResult["adapter"].as<int32>();
+
+    if(parseResult.count("jobthreads"))
+        numJobThreads = uint32(Max(parseResult["jobthreads"].as<int32>(), 0));
+
+    headless = parseResult.count("headless") > 0;
+    benchmarkMode = headless || parseResult.count("benchmark") > 0;
+
+    if(parseResult.count("warmupframes"))
+        benchmarkWarmupFrames = uint32(Max(parseResult["warmupframes"].as<int32>(), 0));
+
+    if(parseResult.count("benchmarkframes"))
+        benchmarkFrames = uint32(Max(parseResult["benchmarkframes"].as<int32>(), 1));
+
+    if(parseResult.count("report"))
+        benchmarkReportPath = AnsiToWString(parseResult["report"].as<std::string>().c_str());
 }
 
 void App::Initialize_Internal()
 {
+    Jobs::Initialize(numJobThreads);
+    AsyncIO::Initialize();
+    Profiler::SetThreadName("Main Thread");
+
     DX12::Initialize(minFeatureLevel, adapterIdx);
 
     window.SetClientArea(swapChain.Width(), swapChain.Height());
@@ -206,6 +263,10 @@ void App::Initialize_Internal()
     AppSettings::Initialize();
 
     Initialize();
+
+    // Everything that the app needs has been compiled by now, so fill in the rest of the cache
+    // in the background
+    PrecompileShaderPermutations();
 }
 
 void App::Shutdown_Internal()
@@ -226,6 +287,9 @@ void App::Shutdown_Internal()
     Shutdown();
 
     DX12::Shutdown();
+
+    AsyncIO::Shutdown();
+    Jobs::Shutdown();
 }
 
 void App::Update_Internal()
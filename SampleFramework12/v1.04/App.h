@@ -46,6 +46,9 @@ protected:
 
     virtual void BeforeFlush();
 
+    // Called instead of the normal window/device loop when running with --headless
+    virtual int32 RunHeadless();
+
     void Exit();
     void CalculateFPS();
 
@@ -70,6 +73,14 @@ protected:
     int32 returnCode = 0;
     D3D_FEATURE_LEVEL minFeatureLevel = D3D_FEATURE_LEVEL_12_1;
     uint32 adapterIdx = 0;
+    uint32 numJobThreads = 0;
+
+    // Command line options for apps that support an automated benchmark mode
+    bool benchmarkMode = false;
+    bool headless = false;
+    uint32 benchmarkWarmupFrames = 8;
+    uint32 benchmarkFrames = 32;
+    std::wstring benchmarkReportPath;
 
     Float4x4 appViewMatrix;
 
@@ -0,0 +1,427 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "AsyncIO.h"
+#include "Exceptions.h"
+#include "FileIO.h"
+#include "SF12_Math.h"
+#include "Utility.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+struct AsyncIORequest;
+
+struct AsyncReadOp
+{
+    OVERLAPPED Overlapped = { };    // must be first, so that a completion can be turned back into the op
+    AsyncIORequest* Request = nullptr;
+    uint8* Dst = nullptr;
+    uint32 Size = 0;
+};
+
+struct AsyncIORequest
+{
+    HANDLE FileHandle = INVALID_HANDLE_VALUE;
+    uint64 FileSize = 0;
+    HANDLE DoneEvent = nullptr;
+    AsyncIOCallback Callback;
+    Array<AsyncReadOp> Ops;
+    uint64 NextOp = 0;                  // only touched by the I/O thread
+    uint64 NumOpsRemaining = 0;         // only touched by the I/O thread
+    bool Failed = false;
+    std::atomic<uint32> Status = { uint32(AsyncIOStatus::Pending) };
+    std::atomic<uint32> RefCount = { 2 };     // the AsyncRead, and the service
+};
+
+static void ReleaseRequest(AsyncIORequest* request)
+{
+    if(request->RefCount.fetch_sub(1) > 1)
+        return;
+
+    CloseHandle(request->DoneEvent);
+    delete request;
+}
+
+// == AsyncRead ===================================================================================
+
+AsyncRead::~AsyncRead()
+{
+    Release();
+}
+
+AsyncRead::AsyncRead(AsyncRead&& other)
+{
+    request = other.request;
+    other.request = nullptr;
+}
+
+AsyncRead& AsyncRead::operator=(AsyncRead&& other)
+{
+    if(&other == this)
+        return *this;
+
+    Release();
+    request = other.request;
+    other.request = nullptr;
+
+    return *this;
+}
+
+bool AsyncRead::IsComplete() const
+{
+    return Status() != AsyncIOStatus::Pending;
+}
+
+AsyncIOStatus AsyncRead::Status() const
+{
+    Assert_(request != nullptr);
+    return AsyncIOStatus(request->Status.load());
+}
+
+AsyncIOStatus AsyncRead::Wait()
+{
+    Assert_(request != nullptr);
+    if(IsComplete() == false)
+        WaitForSingleObject(request->DoneEvent, INFINITE);
+
+    return Status();
+}
+
+void AsyncRead::Release()
+{
+    if(request == nullptr)
+        return;
+
+    Wait();
+    ReleaseRequest(request);
+    request = nullptr;
+}
+
+// == AsyncIO =====================================================================================
+
+namespace AsyncIO
+{
+
+static const ULONG_PTR ReadKey = 0;
+static const ULONG_PTR WakeKey = 1;
+static const ULONG_PTR ShutdownKey = 2;
+
+static HANDLE completionPort = nullptr;
+static HANDLE ioThread = nullptr;
+
+// Requests that haven't been picked up by the I/O thread yet. The stats share the lock.
+static SRWLOCK lock = SRWLOCK_INIT;
+static List<AsyncIORequest*> submitQueue;
+static AsyncIOStats stats;
+
+static void CompleteRequest(AsyncIORequest* request)
+{
+    if(request->FileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(request->FileHandle);
+        request->FileHandle = INVALID_HANDLE_VALUE;
+    }
+
+    const AsyncIOStatus status = request->Failed ? AsyncIOStatus::Failed : AsyncIOStatus::Succeeded;
+
+    AcquireSRWLockExclusive(&lock);
+    stats.NumRequests += 1;
+    stats.NumFailed += request->Failed ? 1 : 0;
+    ReleaseSRWLockExclusive(&lock);
+
+    // The callback runs before the request is marked as complete, so that anything it does is
+    // visible to whoever was waiting on it
+    if(request->Callback)
+        request->Callback(status);
+    request->Callback = nullptr;
+
+    request->Status.store(uint32(status));
+    SetEvent(request->DoneEvent);
+    ReleaseRequest(request);
+}
+
+static void FinishOp(AsyncIORequest* request)
+{
+    Assert_(request->NumOpsRemaining > 0);
+    request->NumOpsRemaining -= 1;
+    if(request->NumOpsRemaining == 0 && request->NextOp == request->Ops.Size())
+        CompleteRequest(request);
+}
+
+static void CountRead(uint64 numBytes, uint64 numInFlight)
+{
+    AcquireSRWLockExclusive(&lock);
+    stats.NumReads += 1;
+    stats.BytesRead += numBytes;
+    stats.MaxReadsInFlight = Max(stats.MaxReadsInFlight, numInFlight);
+    ReleaseSRWLockExclusive(&lock);
+}
+
+static DWORD WINAPI IOThreadProc(void*)
+{
+    // Requests are issued in order, and a request is dropped from the front of this list once all
+    // of its reads have been issued
+    List<AsyncIORequest*> issueQueue;
+    uint64 numInFlight = 0;
+    bool shuttingDown = false;
+
+    while(true)
+    {
+        AcquireSRWLockExclusive(&lock);
+        issueQueue.Append(submitQueue.Data(), submitQueue.Count());
+        submitQueue.RemoveAll();
+        ReleaseSRWLockExclusive(&lock);
+
+        while(numInFlight < MaxReadsInFlight && issueQueue.Count() > 0)
+        {
+            AsyncIORequest* request = issueQueue[0];
+            if(request->Ops.Size() == 0)
+            {
+                issueQueue.Remove(0);
+                CompleteRequest(request);
+                continue;
+            }
+
+            // The request has to be out of the queue before its last op can complete it
+            AsyncReadOp& op = request->Ops[request->NextOp++];
+            if(request->NextOp == request->Ops.Size())
+                issueQueue.Remove(0);
+
+            if(request->Failed)
+            {
+                // Don't bother with the rest of a request that's already failed
+                FinishOp(request);
+                continue;
+            }
+
+            // A completion packet gets queued even if the read finishes right away
+            if(::ReadFile(request->FileHandle, op.Dst, op.Size, nullptr, &op.Overlapped) || GetLastError() == ERROR_IO_PENDING)
+            {
+                numInFlight += 1;
+                CountRead(op.Size, numInFlight);
+            }
+            else
+            {
+                request->Failed = true;
+                FinishOp(request);
+            }
+        }
+
+        if(shuttingDown && numInFlight == 0 && issueQueue.Count() == 0)
+            break;
+
+        DWORD numBytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = nullptr;
+        const BOOL succeeded = GetQueuedCompletionStatus(completionPort, &numBytes, &key, &overlapped, INFINITE);
+        if(overlapped == nullptr)
+        {
+            if(key == ShutdownKey)
+                shuttingDown = true;
+            continue;
+        }
+
+        AsyncReadOp* op = reinterpret_cast<AsyncReadOp*>(overlapped);
+        Assert_(numInFlight > 0);
+        numInFlight -= 1;
+
+        // A short read means that the file got smaller after the request was made
+        if(succeeded == false || numBytes != op->Size)
+            op->Request->Failed = true;
+        FinishOp(op->Request);
+    }
+
+    issueQueue.Shutdown();
+
+    return 0;
+}
+
+void Initialize()
+{
+    Assert_(completionPort == nullptr);
+
+    completionPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if(completionPort == nullptr)
+        throw Win32Exception(GetLastError(), L"Failed to create the I/O completion port");
+
+    ioThread = CreateThread(nullptr, 0, IOThreadProc, nullptr, 0, nullptr);
+    if(ioThread == nullptr)
+    {
+        const DWORD errorCode = GetLastError();
+        CloseHandle(completionPort);
+        completionPort = nullptr;
+        throw Win32Exception(errorCode, L"Failed to create the async I/O thread");
+    }
+}
+
+void Shutdown()
+{
+    if(completionPort == nullptr)
+        return;
+
+    Win32Call(PostQueuedCompletionStatus(completionPort, 0, ShutdownKey, nullptr));
+    WaitForSingleObject(ioThread, INFINITE);
+
+    CloseHandle(ioThread);
+    CloseHandle(completionPort);
+    ioThread = nullptr;
+    completionPort = nullptr;
+
+    Assert_(submitQueue.Count() == 0);
+    submitQueue.Shutdown();
+}
+
+bool Initialized()
+{
+    return completionPort != nullptr;
+}
+
+static AsyncIORequest* CreateRequest(const wchar* filePath, AsyncIOCallback&& callback)
+{
+    AsyncIORequest* request = new AsyncIORequest();
+    request->Callback = std::move(callback);
+
+    request->DoneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if(request->DoneEvent == nullptr)
+    {
+        delete request;
+        throw Win32Exception(GetLastError(), L"Failed to create an event for an async read");
+    }
+
+    const DWORD flags = FILE_ATTRIBUTE_NORMAL | (Initialized() ? FILE_FLAG_OVERLAPPED : 0);
+    request->FileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+
+    LARGE_INTEGER fileSize = { };
+    if(request->FileHandle == INVALID_HANDLE_VALUE || GetFileSizeEx(request->FileHandle, &fileSize) == false)
+        request->Failed = true;
+    else if(Initialized() && CreateIoCompletionPort(request->FileHandle, completionPort, ReadKey, 0) == nullptr)
+        request->Failed = true;
+
+    request->FileSize = request->Failed ? 0 : uint64(fileSize.QuadPart);
+
+    return request;
+}
+
+static void AddReads(AsyncIORequest* request, const AsyncReadRange* ranges, uint64 numRanges)
+{
+    if(request->Failed)
+        return;
+
+    uint64 numOps = 0;
+    for(uint64 rangeIdx = 0; rangeIdx < numRanges; ++rangeIdx)
+    {
+        const AsyncReadRange& range = ranges[rangeIdx];
+        if(range.FileOffset > request->FileSize || range.Size > request->FileSize - range.FileOffset ||
+           (range.Size > 0 && range.Dst == nullptr))
+        {
+            request->Failed = true;
+            return;
+        }
+
+        numOps += (range.Size + MaxReadSize - 1) / MaxReadSize;
+    }
+
+    request->Ops.Init(numOps);
+    request->NumOpsRemaining = numOps;
+
+    uint64 opIdx = 0;
+    for(uint64 rangeIdx = 0; rangeIdx < numRanges; ++rangeIdx)
+    {
+        const AsyncReadRange& range = ranges[rangeIdx];
+        for(uint64 readStart = 0; readStart < range.Size; readStart += MaxReadSize)
+        {
+            const uint64 fileOffset = range.FileOffset + readStart;
+
+            AsyncReadOp& op = request->Ops[opIdx++];
+            op.Overlapped.Offset = DWORD(fileOffset & 0xFFFFFFFF);
+            op.Overlapped.OffsetHigh = DWORD(fileOffset >> 32);
+            op.Request = request;
+            op.Dst = reinterpret_cast<uint8*>(range.Dst) + readStart;
+            op.Size = uint32(Min(MaxReadSize, range.Size - readStart));
+        }
+    }
+
+    Assert_(opIdx == numOps);
+}
+
+static AsyncRead Submit(AsyncIORequest* request)
+{
+    if(Initialized() == false)
+    {
+        // Without the I/O thread the reads just happen here, on a regular file handle
+        for(AsyncReadOp& op : request->Ops)
+        {
+            if(request->Failed)
+                break;
+
+            DWORD numBytes = 0;
+            if(::ReadFile(request->FileHandle, op.Dst, op.Size, &numBytes, &op.Overlapped) == false || numBytes != op.Size)
+                request->Failed = true;
+            CountRead(op.Size, 1);
+        }
+
+        request->NextOp = request->Ops.Size();
+        request->NumOpsRemaining = 0;
+        CompleteRequest(request);
+
+        return AsyncRead(request);
+    }
+
+    AcquireSRWLockExclusive(&lock);
+    submitQueue.Add(request);
+    ReleaseSRWLockExclusive(&lock);
+
+    Win32Call(PostQueuedCompletionStatus(completionPort, 0, WakeKey, nullptr));
+
+    return AsyncRead(request);
+}
+
+AsyncRead ReadFile(const wchar* filePath, Array<uint8>& data, AsyncIOCallback callback)
+{
+    AsyncIORequest* request = CreateRequest(filePath, std::move(callback));
+    if(request->Failed == false)
+    {
+        data.Init(request->FileSize);
+
+        AsyncReadRange range;
+        range.Size = request->FileSize;
+        range.Dst = data.Data();
+        AddReads(request, &range, 1);
+    }
+
+    return Submit(request);
+}
+
+AsyncRead ReadRanges(const wchar* filePath, const AsyncReadRange* ranges, uint64 numRanges, AsyncIOCallback callback)
+{
+    Assert_(ranges != nullptr || numRanges == 0);
+
+    AsyncIORequest* request = CreateRequest(filePath, std::move(callback));
+    AddReads(request, ranges, numRanges);
+
+    return Submit(request);
+}
+
+AsyncIOStats Stats()
+{
+    AcquireSRWLockShared(&lock);
+    AsyncIOStats result = stats;
+    ReleaseSRWLockShared(&lock);
+
+    return result;
+}
+
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers.h"
+
+#include <functional>
+
+namespace SampleFramework12
+{
+
+enum class AsyncIOStatus : uint32
+{
+    Pending = 0,
+    Succeeded,
+    Failed,
+};
+
+// One piece of a scatter-gather read, into memory that the caller has already allocated
+struct AsyncReadRange
+{
+    uint64 FileOffset = 0;
+    uint64 Size = 0;
+    void* Dst = nullptr;
+};
+
+// Called once every read in a request has finished. This runs on the I/O thread, so it should
+// only do a small amount of work (or kick off a Job) and it must not throw.
+typedef std::function<void(AsyncIOStatus status)> AsyncIOCallback;
+
+struct AsyncIOStats
+{
+    uint64 NumRequests = 0;
+    uint64 NumFailed = 0;
+    uint64 NumReads = 0;
+    uint64 BytesRead = 0;
+    uint64 MaxReadsInFlight = 0;
+};
+
+struct AsyncIORequest;
+
+// The caller's side of a request, which works like a future. The destructor waits for the request
+// to finish, so that the destination memory can't be freed while it's still being written to.
+class AsyncRead
+{
+
+public:
+
+    AsyncRead() { }
+    explicit AsyncRead(AsyncIORequest* request_) : request(request_) { }
+    ~AsyncRead();
+
+    AsyncRead(AsyncRead&& other);
+    AsyncRead& operator=(AsyncRead&& other);
+
+    AsyncRead(const AsyncRead&) = delete;
+    AsyncRead& operator=(const AsyncRead&) = delete;
+
+    bool Valid() const { return request != nullptr; }
+    bool IsComplete() const;
+    AsyncIOStatus Status() const;
+
+    AsyncIOStatus Wait();
+
+    // Waits for the request to finish, and lets go of it
+    void Release();
+
+protected:
+
+    AsyncIORequest* request = nullptr;
+};
+
+// Overlapped file reads that get issued and completed on a dedicated I/O thread through an I/O
+// completion port. Requests are queued in the order that they were made, and only a limited
+// number of reads are kept in flight at once. Reads bigger than MaxReadSize are split up.
+//
+// If the service isn't initialized, requests are read synchronously on the calling thread.
+namespace AsyncIO
+{
+    static const uint64 MaxReadsInFlight = 32;
+    static const uint64 MaxReadSize = 16 * 1024 * 1024;
+
+    void Initialize();
+    void Shutdown();    // waits for all outstanding requests
+
+    bool Initialized();
+
+    // Reads an entire file into data, which is resized to fit the file
+    AsyncRead ReadFile(const wchar* filePath, Array<uint8>& data, AsyncIOCallback callback = nullptr);
+
+    // Reads multiple ranges of a file. Requests that include a range past the end of the file fail.
+    AsyncRead ReadRanges(const wchar* filePath, const AsyncReadRange* ranges, uint64 numRanges, AsyncIOCallback callback = nullptr);
+
+    AsyncIOStats Stats();
+}
+
+}
\ No newline at end of file
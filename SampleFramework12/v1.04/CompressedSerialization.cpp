@@ -0,0 +1,288 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "CompressedSerialization.h"
+#include "FileIO.h"
+#include "Jobs.h"
+#include "MurmurHash.h"
+#include "Utility.h"
+
+#include <compressapi.h>
+
+namespace SampleFramework12
+{
+
+static const uint64 CompressedFileMagic = 0x5A504D4331464653ULL;     // "SFF1CMPZ"
+static const uint64 CompressedFileVersion = 1;
+
+// XPRESS is the LZ77 codec from the Windows compression API, which decompresses at memory-ish
+// speeds. The raw mode skips the API's own framing, since chunk sizes are in the chunk table.
+static const DWORD CompressionAlgorithm = COMPRESS_ALGORITHM_XPRESS | COMPRESS_RAW;
+
+enum class ChunkCodec : uint32
+{
+    Raw = 0,
+    Xpress = 1,
+};
+
+struct CompressedFileHeader
+{
+    uint64 Magic = 0;
+    uint64 Version = 0;
+    uint64 ContentVersion = 0;
+    uint64 UncompressedSize = 0;
+    uint64 NumChunks = 0;
+    Hash ChunkTableChecksum;
+};
+
+struct CompressedChunk
+{
+    uint64 FileOffset = 0;
+    uint64 DataOffset = 0;      // where the chunk goes in the uncompressed stream
+    uint32 StoredSize = 0;
+    uint32 Size = 0;
+    ChunkCodec Codec = ChunkCodec::Raw;
+    uint32 Padding = 0;
+    Hash Checksum;              // of the stored bytes, so that corruption is caught before decompressing
+};
+
+// == CompressedWriteSerializer ===================================================================
+
+CompressedWriteSerializer::CompressedWriteSerializer(const wchar* path, uint64 contentVersion_, uint64 chunkSize_)
+    : filePath(path), contentVersion(contentVersion_), chunkSize(chunkSize_), stream(data)
+{
+    Assert_(chunkSize > 0 && chunkSize <= MaxChunkSize);
+}
+
+void CompressedWriteSerializer::Close()
+{
+    if(closed)
+        return;
+    closed = true;
+
+    const uint8* srcData = data.Data();
+    const uint64 srcSize = stream.Offset();
+
+    // Split the stream at the breaks around bulk data first, and then into pieces of at most chunkSize
+    List<CompressedChunk> chunks;
+    uint64 chunkStart = 0;
+    for(uint64 breakIdx = 0; breakIdx <= chunkBreaks.Count(); ++breakIdx)
+    {
+        const uint64 breakOffset = breakIdx < chunkBreaks.Count() ? chunkBreaks[breakIdx] : srcSize;
+        while(chunkStart < breakOffset)
+        {
+            CompressedChunk& chunk = chunks.Add();
+            chunk.DataOffset = chunkStart;
+            chunk.Size = uint32(Min(chunkSize, breakOffset - chunkStart));
+            chunkStart += chunk.Size;
+        }
+    }
+
+    // A chunk only gets compressed if that makes it smaller, which means that the compressed data
+    // always fits in the chunk's own range of the scratch buffer
+    Array<uint8> compressed(srcSize);
+    std::atomic<bool> failed = false;
+    Jobs::ParallelForRange(chunks.Count(), 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        COMPRESSOR_HANDLE compressor = nullptr;
+        if(CreateCompressor(CompressionAlgorithm, nullptr, &compressor) == FALSE)
+        {
+            failed = true;
+            return;
+        }
+
+        for(uint64 chunkIdx = start; chunkIdx < end; ++chunkIdx)
+        {
+            CompressedChunk& chunk = chunks[chunkIdx];
+            uint8* dst = compressed.Data() + chunk.DataOffset;
+
+            SIZE_T compressedSize = 0;
+            if(Compress(compressor, srcData + chunk.DataOffset, chunk.Size, dst, chunk.Size - 1, &compressedSize))
+            {
+                chunk.Codec = ChunkCodec::Xpress;
+                chunk.StoredSize = uint32(compressedSize);
+                chunk.Checksum = GenerateHash(dst, int32(compressedSize));
+            }
+            else if(GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+            {
+                chunk.Codec = ChunkCodec::Raw;
+                chunk.StoredSize = chunk.Size;
+                chunk.Checksum = GenerateHash(srcData + chunk.DataOffset, int32(chunk.Size));
+            }
+            else
+            {
+                failed = true;
+            }
+        }
+
+        CloseCompressor(compressor);
+    });
+
+    if(failed)
+        throw Exception(MakeString(L"Failed to compress the data for '%ls'", filePath.c_str()));
+
+    CompressedFileHeader header;
+    header.Magic = CompressedFileMagic;
+    header.Version = CompressedFileVersion;
+    header.ContentVersion = contentVersion;
+    header.UncompressedSize = srcSize;
+    header.NumChunks = chunks.Count();
+
+    stats = CompressedFileStats();
+    stats.UncompressedSize = srcSize;
+    stats.NumChunks = chunks.Count();
+
+    uint64 fileOffset = sizeof(CompressedFileHeader) + chunks.Count() * sizeof(CompressedChunk);
+    for(CompressedChunk& chunk : chunks)
+    {
+        chunk.FileOffset = fileOffset;
+        fileOffset += chunk.StoredSize;
+        stats.StoredSize += chunk.StoredSize;
+        stats.NumRawChunks += chunk.Codec == ChunkCodec::Raw ? 1 : 0;
+    }
+
+    const uint64 chunkTableSize = chunks.Count() * sizeof(CompressedChunk);
+    if(chunkTableSize > 0)
+        header.ChunkTableChecksum = GenerateHash(chunks.Data(), int32(chunkTableSize));
+
+    // Write to a temporary file first, so that a failed write can't leave a partial file behind
+    const std::wstring tempPath = filePath + L".tmp";
+    try
+    {
+        File file(tempPath.c_str(), FileOpenMode::Write);
+        file.Write(header);
+        if(chunkTableSize > 0)
+            file.Write(chunkTableSize, chunks.Data());
+
+        for(const CompressedChunk& chunk : chunks)
+        {
+            const uint8* storedData = chunk.Codec == ChunkCodec::Raw ? srcData : compressed.Data();
+            file.Write(chunk.StoredSize, storedData + chunk.DataOffset);
+        }
+    }
+    catch(...)
+    {
+        DeleteFile(tempPath.c_str());
+        throw;
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING));
+
+    chunks.Shutdown();
+    chunkBreaks.Shutdown();
+    data.Shutdown();
+}
+
+// == CompressedReadSerializer ====================================================================
+
+CompressedReadSerializer::CompressedReadSerializer(const wchar* path, uint64 contentVersion) : stream(nullptr, 0)
+{
+    MemoryMappedFile file(path);
+    const uint8* fileData = file.Data();
+    const uint64 fileSize = file.Size();
+
+    auto invalidFile = [path](const wchar* reason)
+    {
+        return Exception(MakeString(L"Compressed file '%ls' %ls", path, reason));
+    };
+
+    CompressedFileHeader header;
+    if(fileSize < sizeof(CompressedFileHeader))
+        throw invalidFile(L"is truncated");
+
+    memcpy(&header, fileData, sizeof(CompressedFileHeader));
+    if(header.Magic != CompressedFileMagic || header.Version != CompressedFileVersion)
+        throw invalidFile(L"isn't a compressed file, or was written by an older version of the framework");
+
+    if(header.ContentVersion != contentVersion)
+        throw invalidFile(L"is out of date");
+
+    const uint64 chunkTableOffset = sizeof(CompressedFileHeader);
+    if(header.NumChunks > (fileSize - chunkTableOffset) / sizeof(CompressedChunk))
+        throw invalidFile(L"is truncated");
+
+    const uint64 chunkTableSize = header.NumChunks * sizeof(CompressedChunk);
+    Array<CompressedChunk> chunks(header.NumChunks);
+    if(chunkTableSize > 0)
+    {
+        memcpy(chunks.Data(), fileData + chunkTableOffset, chunkTableSize);
+        if(GenerateHash(chunks.Data(), int32(chunkTableSize)) != header.ChunkTableChecksum)
+            throw invalidFile(L"has a corrupted chunk table");
+    }
+
+    // The chunks need to cover the whole stream in order, and have all of their data in the file
+    uint64 dataOffset = 0;
+    for(const CompressedChunk& chunk : chunks)
+    {
+        bool valid = chunk.DataOffset == dataOffset && chunk.StoredSize <= chunk.Size;
+        valid = valid && (chunk.Codec == ChunkCodec::Xpress || (chunk.Codec == ChunkCodec::Raw && chunk.StoredSize == chunk.Size));
+        valid = valid && chunk.FileOffset <= fileSize && chunk.StoredSize <= fileSize - chunk.FileOffset;
+        if(valid == false)
+            throw invalidFile(L"is truncated or has a corrupted chunk table");
+
+        dataOffset += chunk.Size;
+    }
+
+    if(dataOffset != header.UncompressedSize)
+        throw invalidFile(L"has a corrupted chunk table");
+
+    data.Init(header.UncompressedSize);
+    std::atomic<uint64> numCorrupted = 0;
+    Jobs::ParallelForRange(chunks.Size(), 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        DECOMPRESSOR_HANDLE decompressor = nullptr;
+        if(CreateDecompressor(CompressionAlgorithm, nullptr, &decompressor) == FALSE)
+        {
+            numCorrupted += end - start;
+            return;
+        }
+
+        for(uint64 chunkIdx = start; chunkIdx < end; ++chunkIdx)
+        {
+            const CompressedChunk& chunk = chunks[chunkIdx];
+            const uint8* storedData = fileData + chunk.FileOffset;
+            uint8* dst = data.Data() + chunk.DataOffset;
+
+            if(GenerateHash(storedData, int32(chunk.StoredSize)) != chunk.Checksum)
+            {
+                numCorrupted += 1;
+                continue;
+            }
+
+            if(chunk.Codec == ChunkCodec::Raw)
+            {
+                memcpy(dst, storedData, chunk.Size);
+                continue;
+            }
+
+            SIZE_T decompressedSize = 0;
+            if(Decompress(decompressor, storedData, chunk.StoredSize, dst, chunk.Size, &decompressedSize) == FALSE || decompressedSize != chunk.Size)
+                numCorrupted += 1;
+        }
+
+        CloseDecompressor(decompressor);
+    });
+
+    if(numCorrupted > 0)
+        throw invalidFile(MakeString(L"has %llu corrupted chunks", numCorrupted.load()).c_str());
+
+    stats.UncompressedSize = header.UncompressedSize;
+    stats.NumChunks = chunks.Size();
+    for(const CompressedChunk& chunk : chunks)
+    {
+        stats.StoredSize += chunk.StoredSize;
+        stats.NumRawChunks += chunk.Codec == ChunkCodec::Raw ? 1 : 0;
+    }
+
+    stream = MemoryReadSerializer(data);
+}
+
+}
\ No newline at end of file
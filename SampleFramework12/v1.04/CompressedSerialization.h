@@ -0,0 +1,146 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers.h"
+#include "Serialization.h"
+
+namespace SampleFramework12
+{
+
+struct CompressedFileStats
+{
+    uint64 UncompressedSize = 0;
+    uint64 StoredSize = 0;      // chunk data only, not counting the header and chunk table
+    uint64 NumChunks = 0;
+    uint64 NumRawChunks = 0;    // chunks that didn't get any smaller, and are stored as-is
+};
+
+// Writes a chunked container file where every chunk is compressed separately and has its own
+// checksum, so that the chunks can be verified and decompressed independently on the job threads.
+// Everything gets collected in memory first, and is compressed and written out by Close(). The
+// file is written under a temporary name and renamed once it's complete, and a serializer that's
+// destroyed without being closed (for instance during unwinding) discards its data.
+//
+// Bulk data that's at least BulkChunkThreshold bytes is given chunks of its own, so that large
+// arrays don't share a chunk with the small items around them. The content version is stored in
+// the header, and reading the file back with any other version fails.
+class CompressedWriteSerializer
+{
+
+private:
+
+    std::wstring filePath;
+    uint64 contentVersion = 0;
+    uint64 chunkSize = 0;
+    Array<uint8> data;
+    MemoryWriteSerializer stream;
+    List<uint64> chunkBreaks;
+    CompressedFileStats stats;
+    bool closed = false;
+
+    void BreakChunk()
+    {
+        const uint64 offset = stream.Offset();
+        if(offset > 0 && (chunkBreaks.Count() == 0 || chunkBreaks.LastElement() != offset))
+            chunkBreaks.Add(offset);
+    }
+
+public:
+
+    static const uint64 DefaultChunkSize = 256 * 1024;
+    static const uint64 MaxChunkSize = 64 * 1024 * 1024;
+    static const uint64 BulkChunkThreshold = 64 * 1024;
+
+    CompressedWriteSerializer(const wchar* path, uint64 contentVersion, uint64 chunkSize = DefaultChunkSize);
+
+    CompressedWriteSerializer(const CompressedWriteSerializer&) = delete;
+    CompressedWriteSerializer& operator=(const CompressedWriteSerializer&) = delete;
+
+    template<typename T> void SerializeItem(const T& item)
+    {
+        stream.SerializeItem(item);
+    }
+
+    void SerializeData(uint64 size, const void* src)
+    {
+        if(size < BulkChunkThreshold)
+        {
+            stream.SerializeData(size, src);
+            return;
+        }
+
+        BreakChunk();
+        stream.SerializeData(size, src);
+        BreakChunk();
+    }
+
+    void Close();
+
+    const CompressedFileStats& Stats() const { return stats; }
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+};
+
+// Reads a file written by CompressedWriteSerializer. The file is mapped, and all of its chunks are
+// checked and decompressed up-front on the job threads. A file that's truncated, corrupted, or
+// has a different content version causes an Exception to be thrown from the constructor.
+class CompressedReadSerializer
+{
+
+private:
+
+    Array<uint8> data;
+    MemoryReadSerializer stream;
+    CompressedFileStats stats;
+
+public:
+
+    CompressedReadSerializer(const wchar* path, uint64 contentVersion);
+
+    CompressedReadSerializer(const CompressedReadSerializer&) = delete;
+    CompressedReadSerializer& operator=(const CompressedReadSerializer&) = delete;
+
+    template<typename T> void SerializeItem(T& item)
+    {
+        stream.SerializeItem(item);
+    }
+
+    void SerializeData(uint64 size, void* dst)
+    {
+        stream.SerializeData(size, dst);
+    }
+
+    const CompressedFileStats& Stats() const { return stats; }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Convenience functions for compressed file serialization
+template<typename T>
+void SerializeFromCompressedFile(const wchar* filePath, uint64 contentVersion, T& item)
+{
+    CompressedReadSerializer serializer(filePath, contentVersion);
+    SerializeItem(serializer, item);
+}
+
+template<typename T>
+void SerializeToCompressedFile(const wchar* filePath, uint64 contentVersion, T& item)
+{
+    CompressedWriteSerializer serializer(filePath, contentVersion);
+    SerializeItem(serializer, item);
+    serializer.Close();
+}
+
+}
\ No newline at end of file
@@ -128,7 +128,8 @@ public:
         }
 
         T* newData = new T[numElements];
-        for(uint64 i = 0; i < size; ++i)
+        const uint64 numToCopy = size < numElements ? size : numElements;
+        for(uint64 i = 0; i < numToCopy; ++i)
             newData[i] = data[i];
 
         Shutdown();
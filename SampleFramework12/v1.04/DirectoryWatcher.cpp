@@ -0,0 +1,273 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "DirectoryWatcher.h"
+#include "Exceptions.h"
+#include "Utility.h"
+
+namespace SampleFramework12
+{
+
+struct DirectoryWatcher::WatchedDirectory
+{
+    std::wstring Path;
+    HANDLE DirHandle = INVALID_HANDLE_VALUE;
+    OVERLAPPED Overlapped = { };
+    HANDLE FirstReadIssued = nullptr;   // signaled once the watcher thread has tried to start listening
+    bool ReadPending = false;
+    bool ReadFailed = false;
+
+    // ReadDirectoryChangesW needs a DWORD-aligned buffer
+    DWORD Buffer[4096] = { };
+};
+
+static const DWORD NotifyFilter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    Shutdown();
+}
+
+std::wstring DirectoryWatcher::FullDirectoryPath(const wchar* dirPath)
+{
+    wchar fullPath[1024] = { };
+    GetFullPathName(dirPath[0] != 0 ? dirPath : L".", ArraySize_(fullPath), fullPath, nullptr);
+
+    std::wstring path = fullPath;
+    while(path.length() > 0 && (path.back() == L'\\' || path.back() == L'/'))
+        path.pop_back();
+
+    return path;
+}
+
+bool DirectoryWatcher::IsWatching(const wchar* dirPath) const
+{
+    AcquireSRWLockShared(&lock);
+
+    bool watching = false;
+    for(const WatchedDirectory* dir : directories)
+        watching = watching || dir->Path == dirPath;
+
+    ReleaseSRWLockShared(&lock);
+
+    return watching;
+}
+
+bool DirectoryWatcher::Watch(const wchar* dirPath)
+{
+    if(IsWatching(dirPath))
+        return true;
+
+    if(directories.Count() >= MaxDirectories)
+        return false;
+
+    HANDLE dirHandle = CreateFile(dirPath, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if(dirHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    if(thread == nullptr)
+    {
+        wakeEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        Win32Call(wakeEvent != nullptr);
+        thread = CreateThread(nullptr, 0, ThreadProc, this, 0, nullptr);
+        Win32Call(thread != nullptr);
+    }
+
+    WatchedDirectory* dir = new WatchedDirectory();
+    dir->Path = dirPath;
+    dir->DirHandle = dirHandle;
+    dir->Overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    Win32Call(dir->Overlapped.hEvent != nullptr);
+    dir->FirstReadIssued = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    Win32Call(dir->FirstReadIssued != nullptr);
+
+    AcquireSRWLockExclusive(&lock);
+    directories.Add(dir);
+    ReleaseSRWLockExclusive(&lock);
+
+    // The read has to be issued from the watcher thread, since the I/O gets cancelled if the
+    // thread that started it exits. Wait for it, so that a directory that can't be listened to
+    // gets reported now instead of silently never producing any changes.
+    SetEvent(wakeEvent);
+    WaitForSingleObject(dir->FirstReadIssued, INFINITE);
+
+    if(dir->ReadFailed == false)
+        return true;
+
+    // The watcher thread never waits on a directory that failed, so it's safe to get rid of
+    AcquireSRWLockExclusive(&lock);
+    for(uint64 i = 0; i < directories.Count(); ++i)
+    {
+        if(directories[i] == dir)
+        {
+            directories.Remove(i);
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&lock);
+
+    CloseHandle(dir->DirHandle);
+    CloseHandle(dir->Overlapped.hEvent);
+    CloseHandle(dir->FirstReadIssued);
+    delete dir;
+
+    return false;
+}
+
+void DirectoryWatcher::Shutdown()
+{
+    if(thread != nullptr)
+    {
+        shuttingDown = true;
+        SetEvent(wakeEvent);
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        CloseHandle(wakeEvent);
+        thread = nullptr;
+        wakeEvent = nullptr;
+        shuttingDown = false;
+    }
+
+    for(WatchedDirectory* dir : directories)
+    {
+        CloseHandle(dir->DirHandle);
+        CloseHandle(dir->Overlapped.hEvent);
+        CloseHandle(dir->FirstReadIssued);
+        delete dir;
+    }
+
+    directories.Shutdown();
+    pendingChanges.Shutdown();
+    failed = false;
+}
+
+bool DirectoryWatcher::GetChanges(List<DirectoryChange>& changes, uint64 debounceMS)
+{
+    AcquireSRWLockExclusive(&lock);
+
+    const bool ready = pendingChanges.Count() > 0 && GetTickCount64() - lastChangeTime >= debounceMS;
+    if(ready)
+    {
+        for(const DirectoryChange& change : pendingChanges)
+            changes.Add(change);
+        pendingChanges.RemoveAll();
+    }
+
+    ReleaseSRWLockExclusive(&lock);
+
+    return ready;
+}
+
+DWORD WINAPI DirectoryWatcher::ThreadProc(void* context)
+{
+    reinterpret_cast<DirectoryWatcher*>(context)->WatchThread();
+    return 0;
+}
+
+bool DirectoryWatcher::IssueRead(WatchedDirectory& dir)
+{
+    ResetEvent(dir.Overlapped.hEvent);
+    dir.ReadPending = ReadDirectoryChangesW(dir.DirHandle, dir.Buffer, sizeof(dir.Buffer), FALSE, NotifyFilter,
+                                            nullptr, &dir.Overlapped, nullptr) != FALSE;
+    dir.ReadFailed = dir.ReadPending == false;
+    return dir.ReadPending;
+}
+
+void DirectoryWatcher::WatchThread()
+{
+    WatchedDirectory* waitDirs[MaxDirectories] = { };
+    HANDLE waitHandles[MaxDirectories + 1] = { };
+
+    while(shuttingDown == false)
+    {
+        // Start listening on any directories that were added since the last time around
+        AcquireSRWLockShared(&lock);
+
+        uint64 numWaitDirs = 0;
+        for(WatchedDirectory* dir : directories)
+        {
+            if(dir->ReadFailed)
+                continue;
+
+            const bool firstRead = WaitForSingleObject(dir->FirstReadIssued, 0) != WAIT_OBJECT_0;
+            if(dir->ReadPending || IssueRead(*dir))
+                waitDirs[numWaitDirs++] = dir;
+            else if(firstRead == false)
+                failed = true;
+
+            if(firstRead)
+                SetEvent(dir->FirstReadIssued);
+        }
+
+        ReleaseSRWLockShared(&lock);
+
+        waitHandles[0] = wakeEvent;
+        for(uint64 i = 0; i < numWaitDirs; ++i)
+            waitHandles[i + 1] = waitDirs[i]->Overlapped.hEvent;
+
+        const DWORD waitResult = WaitForMultipleObjects(DWORD(numWaitDirs + 1), waitHandles, FALSE, INFINITE);
+        if(waitResult <= WAIT_OBJECT_0 || waitResult > WAIT_OBJECT_0 + numWaitDirs)
+            continue;
+
+        WatchedDirectory& dir = *waitDirs[waitResult - WAIT_OBJECT_0 - 1];
+        dir.ReadPending = false;
+
+        DWORD numBytes = 0;
+        const bool succeeded = GetOverlappedResult(dir.DirHandle, &dir.Overlapped, &numBytes, FALSE) != FALSE;
+
+        AcquireSRWLockExclusive(&lock);
+
+        if(succeeded == false || numBytes == 0)
+        {
+            // The buffer overflowed, so we don't know what changed
+            DirectoryChange& change = pendingChanges.Add();
+            change.Directory = dir.Path;
+        }
+        else
+        {
+            const uint8* notifyData = reinterpret_cast<const uint8*>(dir.Buffer);
+            while(true)
+            {
+                const FILE_NOTIFY_INFORMATION& info = *reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(notifyData);
+                DirectoryChange& change = pendingChanges.Add();
+                change.Directory = dir.Path;
+                change.FileName = std::wstring(info.FileName, info.FileNameLength / sizeof(wchar));
+
+                if(info.NextEntryOffset == 0)
+                    break;
+                notifyData += info.NextEntryOffset;
+            }
+        }
+
+        lastChangeTime = GetTickCount64();
+
+        ReleaseSRWLockExclusive(&lock);
+    }
+
+    // Outstanding reads need to be cancelled by the thread that started them
+    AcquireSRWLockShared(&lock);
+
+    for(WatchedDirectory* dir : directories)
+    {
+        if(dir->ReadPending)
+        {
+            CancelIo(dir->DirHandle);
+            DWORD numBytes = 0;
+            GetOverlappedResult(dir->DirHandle, &dir->Overlapped, &numBytes, TRUE);
+            dir->ReadPending = false;
+        }
+    }
+
+    ReleaseSRWLockShared(&lock);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+
+#include "Containers.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+struct DirectoryChange
+{
+    std::wstring Directory;     // the full path that was passed to Watch()
+    std::wstring FileName;      // empty if too many things changed at once to keep track of
+};
+
+// Gets notified by the OS when files are modified inside of a set of directories, using
+// ReadDirectoryChangesW on a background thread. Sub-directories aren't watched.
+class DirectoryWatcher
+{
+
+public:
+
+    static const uint64 MaxDirectories = MAXIMUM_WAIT_OBJECTS - 1;
+
+    DirectoryWatcher() { }
+    ~DirectoryWatcher();
+
+    // Returns false if the directory can't be watched, for instance because the watcher is
+    // full or because it's on a file system that doesn't support notifications. This waits for
+    // the watcher thread to start listening, so that failing to do so can be reported here.
+    bool Watch(const wchar* dirPath);
+    bool IsWatching(const wchar* dirPath) const;
+    void Shutdown();
+
+    // Returns true if listening for changes failed for a directory after it was being watched,
+    // which means that changes to it can be missed from then on
+    bool Failed() const { return failed; }
+
+    // Hands over the changes since the last call, but only once no new changes have come in for
+    // debounceMS. This avoids reacting to editors that save a file in multiple steps.
+    bool GetChanges(List<DirectoryChange>& changes, uint64 debounceMS);
+
+    static std::wstring FullDirectoryPath(const wchar* dirPath);
+
+    DirectoryWatcher(const DirectoryWatcher&) = delete;
+    DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+protected:
+
+    struct WatchedDirectory;
+
+    static DWORD WINAPI ThreadProc(void* context);
+    void WatchThread();
+    bool IssueRead(WatchedDirectory& dir);
+
+    List<WatchedDirectory*> directories;
+    List<DirectoryChange> pendingChanges;
+    uint64 lastChangeTime = 0;
+
+    HANDLE thread = nullptr;
+    HANDLE wakeEvent = nullptr;
+    std::atomic<bool> shuttingDown = false;
+    std::atomic<bool> failed = false;
+    mutable SRWLOCK lock = SRWLOCK_INIT;
+};
+
+}
\ No newline at end of file
@@ -140,6 +140,16 @@ uint64 GetFileTimestamp(const wchar* filePath)
     return attributes.ftLastWriteTime.dwLowDateTime | (uint64(attributes.ftLastWriteTime.dwHighDateTime) << 32);
 }
 
+// Gets the size of the file without opening it
+uint64 GetFileSizeInBytes(const wchar* filePath)
+{
+    Assert_(filePath);
+
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    Win32Call(GetFileAttributesEx(filePath, GetFileExInfoStandard, &attributes));
+    return attributes.nFileSizeLow | (uint64(attributes.nFileSizeHigh) << 32);
+}
+
 // Returns the contents of a file as a string
 std::string ReadFileAsString(const wchar* filePath)
 {
@@ -211,6 +221,15 @@ void File::Open(const wchar* filePath, FileOpenMode openMode_)
             throw Win32Exception(GetLastError(), errPrefix.c_str());
         }
     }
+    else if(openMode == FileOpenMode::Append)
+    {
+        fileHandle = CreateFile(filePath, FILE_APPEND_DATA, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if(fileHandle == INVALID_HANDLE_VALUE)
+        {
+            std::wstring errPrefix = std::wstring(L"Failed to open file ") + filePath + L":\n";
+            throw Win32Exception(GetLastError(), errPrefix.c_str());
+        }
+    }
     else
     {
         // If the exists, delete it
@@ -251,7 +270,7 @@ void File::Read(uint64 size, void* data) const
 void File::Write(uint64 size, const void* data) const
 {
     Assert_(fileHandle != INVALID_HANDLE_VALUE);
-    Assert_(openMode == FileOpenMode::Write);
+    Assert_(openMode == FileOpenMode::Write || openMode == FileOpenMode::Append);
 
     DWORD bytesWritten = 0;
     Win32Call(WriteFile(fileHandle, data, static_cast<DWORD>(size), &bytesWritten, NULL));
@@ -267,4 +286,75 @@ uint64 File::Size() const
     return fileSize.QuadPart;
 }
 
+// == MemoryMappedFile ============================================================================
+
+MemoryMappedFile::MemoryMappedFile()
+{
+}
+
+MemoryMappedFile::MemoryMappedFile(const wchar* filePath)
+{
+    Open(filePath);
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+    Close();
+}
+
+void MemoryMappedFile::Open(const wchar* filePath)
+{
+    Assert_(fileHandle == INVALID_HANDLE_VALUE);
+    Assert_(FileExists(filePath));
+
+    std::wstring errPrefix = std::wstring(L"Failed to map file ") + filePath + L":\n";
+
+    fileHandle = CreateFile(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(fileHandle == INVALID_HANDLE_VALUE)
+        throw Win32Exception(GetLastError(), errPrefix.c_str());
+
+    LARGE_INTEGER fileSize;
+    Win32Call(GetFileSizeEx(fileHandle, &fileSize));
+    size = fileSize.QuadPart;
+
+    // CreateFileMapping fails on zero-length files
+    if(size == 0)
+    {
+        Close();
+        throw Exception(errPrefix + L"the file is empty");
+    }
+
+    mappingHandle = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mappingHandle == nullptr)
+    {
+        DWORD errorCode = GetLastError();
+        Close();
+        throw Win32Exception(errorCode, errPrefix.c_str());
+    }
+
+    data = reinterpret_cast<const uint8*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(data == nullptr)
+    {
+        DWORD errorCode = GetLastError();
+        Close();
+        throw Win32Exception(errorCode, errPrefix.c_str());
+    }
+}
+
+void MemoryMappedFile::Close()
+{
+    if(data != nullptr)
+        Win32Call(UnmapViewOfFile(data));
+    data = nullptr;
+    size = 0;
+
+    if(mappingHandle != nullptr)
+        Win32Call(CloseHandle(mappingHandle));
+    mappingHandle = nullptr;
+
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        Win32Call(CloseHandle(fileHandle));
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
 }
\ No newline at end of file
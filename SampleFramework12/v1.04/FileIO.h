@@ -30,6 +30,7 @@ std::wstring GetFileExtension(const wchar* filePath);
 std::string ResolveFilePath(const char* filePath);
 std::wstring ResolveFilePath(const wchar* filePath);
 uint64 GetFileTimestamp(const wchar* filePath);
+uint64 GetFileSizeInBytes(const wchar* filePath);
 
 std::string ReadFileAsString(const wchar* filePath);
 void WriteStringAsFile(const wchar* filePath, const std::string& data);
@@ -41,6 +42,7 @@ enum class FileOpenMode
 {
     Read = 0,
     Write = 1,
+    Append = 2,     // creates the file if it doesn't exist, and adds all writes to the end
 };
 
 class File
@@ -73,6 +75,37 @@ public:
     uint64 Size() const;
 };
 
+// Read-only view of an entire file that's mapped into the address space of the process
+class MemoryMappedFile
+{
+
+private:
+
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+    const uint8* data = nullptr;
+    uint64 size = 0;
+
+public:
+
+    // Lifetime
+    MemoryMappedFile();
+    explicit MemoryMappedFile(const wchar* filePath);
+    ~MemoryMappedFile();
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    // Explicit Open and close
+    void Open(const wchar* filePath);
+    void Close();
+
+    // Accessors
+    bool IsOpen() const { return data != nullptr; }
+    const uint8* Data() const { return data; }
+    uint64 Size() const { return size; }
+};
+
 // == File ========================================================================================
 
 template<typename T> void File::Read(T& data) const
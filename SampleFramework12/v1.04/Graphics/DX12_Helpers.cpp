@@ -843,6 +843,9 @@ void SetViewport(ID3D12GraphicsCommandList* cmdList, uint64 width, uint64 height
     cmdList->RSSetScissorRects(1, &scissorRect);
 }
 
+// {6C1F2E0B-93A4-4B7D-8E25-D4F0A1B7C935}
+static const GUID RootSignatureHashGUID = { 0x6c1f2e0b, 0x93a4, 0x4b7d, { 0x8e, 0x25, 0xd4, 0xf0, 0xa1, 0xb7, 0xc9, 0x35 } };
+
 void CreateRootSignature(ID3D12RootSignature** rootSignature, const D3D12_ROOT_SIGNATURE_DESC1& desc)
 {
     D3D12_VERSIONED_ROOT_SIGNATURE_DESC versionedDesc = { };
@@ -864,6 +867,26 @@ void CreateRootSignature(ID3D12RootSignature** rootSignature, const D3D12_ROOT_S
     }
 
     DXCall(DX12::Device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(rootSignature)));
+
+    // Tag it with a hash of the blob, so that PSO hashes don't depend on the root signature's address
+    const Hash blobHash = GenerateHash(signature->GetBufferPointer(), int32(signature->GetBufferSize()));
+    DXCall((*rootSignature)->SetPrivateData(RootSignatureHashGUID, sizeof(Hash), &blobHash));
+}
+
+Hash RootSignatureHash(ID3D12RootSignature* rootSignature)
+{
+    Hash blobHash;
+    if(rootSignature == nullptr)
+        return blobHash;
+
+    // Root signatures that didn't come from CreateRootSignature() don't have the tag, so fall back to
+    // the address. That keeps different root signatures from sharing a PSO hash, although the hash
+    // won't be stable across runs.
+    UINT dataSize = sizeof(Hash);
+    if(FAILED(rootSignature->GetPrivateData(RootSignatureHashGUID, &dataSize, &blobHash)) || dataSize != sizeof(Hash))
+        return GenerateHash(&rootSignature, sizeof(rootSignature));
+
+    return blobHash;
 }
 
 uint32 DispatchSize(uint64 numElements, uint64 groupSize)
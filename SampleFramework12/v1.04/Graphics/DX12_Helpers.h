@@ -13,6 +13,7 @@
 #include "../SF12_Assert.h"
 #include "DX12.h"
 #include "Utility.h"
+#include "../MurmurHash.h"
 #include "../Shaders/ShaderShared.h"
 
 namespace SampleFramework12
@@ -224,6 +225,7 @@ D3D12_STATIC_SAMPLER_DESC ConvertToStaticSampler(const D3D12_SAMPLER_DESC& sampl
 // Convenience functions
 void SetViewport(ID3D12GraphicsCommandList* cmdList, uint64 width, uint64 height, float zMin = 0.0f, float zMax = 1.0f);
 void CreateRootSignature(ID3D12RootSignature** rootSignature, const D3D12_ROOT_SIGNATURE_DESC1& desc);
+Hash RootSignatureHash(ID3D12RootSignature* rootSignature);     // hash of the serialized blob, or of the address if it didn't come from CreateRootSignature()
 uint32 DispatchSize(uint64 numElements, uint64 groupSize);
 
 // Resource binding
@@ -12,6 +12,10 @@
 #include "DX12_Upload.h"
 #include "DX12.h"
 #include "GraphicsTypes.h"
+#include "Profiler.h"
+#include "RingAllocator.h"
+#include "../Containers.h"
+#include "../Timer.h"
 
 namespace SampleFramework12
 {
@@ -90,22 +94,59 @@ struct UploadQueue
     }
 };
 
+// One UPLOAD buffer that submissions get sub-allocated from
+struct UploadRing
+{
+    ID3D12Resource* Buffer = nullptr;
+    uint8* CPUAddr = nullptr;
+    RingAllocator Allocator;
+
+    void Init(uint64 size)
+    {
+        D3D12_RESOURCE_DESC1 resourceDesc = { };
+        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        resourceDesc.Width = size;
+        resourceDesc.Height = 1;
+        resourceDesc.DepthOrArraySize = 1;
+        resourceDesc.MipLevels = 1;
+        resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+        resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+        resourceDesc.SampleDesc.Count = 1;
+        resourceDesc.SampleDesc.Quality = 0;
+        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        resourceDesc.Alignment = 0;
+
+        DXCall(Device->CreateCommittedResource3(DX12::GetUploadHeapProps(), D3D12_HEAP_FLAG_NONE, &resourceDesc,
+                                                D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&Buffer)));
+        Buffer->SetName(L"Upload Ring Buffer");
+
+        D3D12_RANGE readRange = { };
+        DXCall(Buffer->Map(0, &readRange, reinterpret_cast<void**>(&CPUAddr)));
+
+        Allocator.Init(size);
+    }
+
+    void Shutdown()
+    {
+        Release(Buffer);
+        CPUAddr = nullptr;
+    }
+};
+
 // A single submission that goes through the upload ring buffer
 struct UploadSubmission
 {
     ID3D12CommandAllocator* CmdAllocator = nullptr;
     ID3D12GraphicsCommandList5* CmdList = nullptr;
-    uint64 Offset = 0;
-    uint64 Size = 0;
+    UploadRing* Ring = nullptr;
+    RingAllocation Allocation;
     uint64 FenceValue = 0;
-    uint64 Padding = 0;
 
     void Reset()
     {
-        Offset = 0;
-        Size = 0;
+        Ring = nullptr;
+        Allocation = RingAllocation();
         FenceValue = 0;
-        Padding = 0;
     }
 };
 
@@ -117,14 +158,22 @@ struct UploadRingBuffer
     uint64 SubmissionStart = 0;
     uint64 SubmissionUsed = 0;
 
-    // CPU-writable UPLOAD buffer
-    uint64 BufferSize = 64 * 1024 * 1024;
-    ID3D12Resource* Buffer = nullptr;
-    uint8* BufferCPUAddr = nullptr;
+    // When the current ring is full, a bigger one takes over instead of waiting on the GPU. The old
+    // rings stick around until the submissions that were allocated from them have finished. Once
+    // usage has stayed low for a while, a smaller ring takes over in the same way.
+    static const uint64 InitialRingSize = 64 * 1024 * 1024;
+    static const uint64 MaxRingSize = 512 * 1024 * 1024;
+    static const uint64 ShrinkCheckFrames = 120;
+    List<UploadRing*> Rings;
+    uint64 PeakBytesUsed = 0;
+    uint64 FramesSinceShrinkCheck = 0;
 
-    // For using the UPLOAD buffer as a ring buffer
-    uint64 BufferStart = 0;
-    uint64 BufferUsed = 0;
+    UploadRingStats Stats;
+
+    // Wrap/padding totals from rings that were already released
+    uint64 RetiredWraps = 0;
+    uint64 RetiredPaddingBytes = 0;
+    uint64 RetiredHighWaterBytes = 0;
 
     // Thread safety
     SRWLOCK Lock = SRWLOCK_INIT;
@@ -132,6 +181,12 @@ struct UploadRingBuffer
     // The queue for submitting on
     UploadQueue* submitQueue = nullptr;
 
+    UploadRing& CurrentRing()
+    {
+        Assert_(Rings.Count() > 0);
+        return *Rings[Rings.Count() - 1];
+    }
+
     void Init(UploadQueue* queue)
     {
         Assert_(queue != nullptr);
@@ -146,42 +201,118 @@ struct UploadRingBuffer
             submission.CmdList->SetName(L"Upload Command List");
         }
 
-        Resize(BufferSize);
+        Stats = UploadRingStats();
+        AddRing(InitialRingSize);
     }
 
     void Shutdown()
     {
-        Release(Buffer);
+        for(UploadRing* ring : Rings)
+        {
+            ring->Shutdown();
+            delete ring;
+        }
+        Rings.Shutdown();
+
         for(uint64 i = 0; i < MaxSubmissions; ++i) {
             Release(Submissions[i].CmdAllocator);
             Release(Submissions[i].CmdList);
         }
     }
 
-    void Resize(uint64 newBufferSize)
+    void AddRing(uint64 size)
     {
-        Release(Buffer);
+        // The current ring can go right away if nothing is using it
+        if(Rings.Count() > 0 && CurrentRing().Allocator.Empty())
+            RetireRing(Rings.Count() - 1);
 
-        BufferSize = newBufferSize;
+        UploadRing* ring = new UploadRing();
+        ring->Init(size);
+        Rings.Add(ring);
 
-        D3D12_RESOURCE_DESC1 resourceDesc = { };
-        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-        resourceDesc.Width = BufferSize;
-        resourceDesc.Height = 1;
-        resourceDesc.DepthOrArraySize = 1;
-        resourceDesc.MipLevels = 1;
-        resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-        resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-        resourceDesc.SampleDesc.Count = 1;
-        resourceDesc.SampleDesc.Quality = 0;
-        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        resourceDesc.Alignment = 0;
+        Stats.RingSize = size;
 
-        DXCall(Device->CreateCommittedResource3(DX12::GetUploadHeapProps(), D3D12_HEAP_FLAG_NONE, &resourceDesc,
-                                                D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&Buffer)));
+        PeakBytesUsed = 0;
+        FramesSinceShrinkCheck = 0;
+    }
 
-        D3D12_RANGE readRange = { };
-        DXCall(Buffer->Map(0, &readRange, reinterpret_cast<void**>(&BufferCPUAddr)));
+    // Swaps in a bigger ring instead of waiting on the GPU, unless we've hit the size limit. Uploads
+    // that are bigger than the ring always get a new one that's big enough.
+    UploadSubmission* GrowAndAllocSubmission(uint64 size)
+    {
+        if(SubmissionUsed == MaxSubmissions)
+            return nullptr;
+
+        const uint64 newSize = RingAllocator::GrowSize(CurrentRing().Allocator.Size(), size, MaxRingSize);
+        if(newSize == 0)
+            return nullptr;
+
+        AddRing(newSize);
+        Stats.NumGrows += 1;
+
+        return AllocSubmission(size);
+    }
+
+    // Called once per frame. If the peak usage since the last check would have fit in a smaller
+    // ring, swap one in so that a one-off burst doesn't keep a huge ring around forever.
+    void ShrinkIfQuiet()
+    {
+        FramesSinceShrinkCheck += 1;
+        if(FramesSinceShrinkCheck < ShrinkCheckFrames)
+            return;
+
+        const uint64 newSize = RingAllocator::ShrinkSize(CurrentRing().Allocator.Size(), PeakBytesUsed, InitialRingSize);
+        if(newSize > 0)
+        {
+            AddRing(newSize);
+            Stats.NumShrinks += 1;
+        }
+
+        PeakBytesUsed = 0;
+        FramesSinceShrinkCheck = 0;
+    }
+
+    void UpdateStats()
+    {
+        Stats.NumWraps = 0;
+        Stats.WrapPaddingBytes = 0;
+        Stats.HighWaterBytesUsed = 0;
+        for(const UploadRing* ring : Rings)
+        {
+            Stats.NumWraps += ring->Allocator.Stats().NumWraps;
+            Stats.WrapPaddingBytes += ring->Allocator.Stats().PaddingBytes;
+            Stats.HighWaterBytesUsed = Max(Stats.HighWaterBytesUsed, ring->Allocator.Stats().HighWaterBytesUsed);
+        }
+
+        Stats.NumWraps += RetiredWraps;
+        Stats.WrapPaddingBytes += RetiredPaddingBytes;
+        Stats.HighWaterBytesUsed = Max(Stats.HighWaterBytesUsed, RetiredHighWaterBytes);
+    }
+
+    // Everything that used the ring has finished on the GPU, so there's no need for a deferred release
+    void RetireRing(uint64 ringIdx)
+    {
+        UploadRing* ring = Rings[ringIdx];
+        Assert_(ring->Allocator.Empty());
+
+        RetiredWraps += ring->Allocator.Stats().NumWraps;
+        RetiredPaddingBytes += ring->Allocator.Stats().PaddingBytes;
+        RetiredHighWaterBytes = Max(RetiredHighWaterBytes, ring->Allocator.Stats().HighWaterBytesUsed);
+
+        ring->Shutdown();
+        delete ring;
+        Rings.Remove(ringIdx);
+    }
+
+    void ReleaseDrainedRings()
+    {
+        for(uint64 i = 0; i + 1 < Rings.Count(); )
+        {
+            if(Rings[i]->Allocator.Empty())
+                RetireRing(i);
+            else
+                ++i;
+        }
     }
 
     void ClearPendingUploads(uint64 waitCount)
@@ -192,8 +323,7 @@ struct UploadRingBuffer
         {
             const uint64 idx = (start + i) % MaxSubmissions;
             UploadSubmission& submission = Submissions[idx];
-            Assert_(submission.Size > 0);
-            Assert_(BufferUsed >= submission.Size);
+            Assert_(submission.Ring != nullptr);
 
             // If the submission hasn't been sent to the GPU yet we can't wait for it
             if(submission.FenceValue == uint64(-1))
@@ -208,25 +338,20 @@ struct UploadRingBuffer
             {
                 SubmissionStart = (SubmissionStart + 1) % MaxSubmissions;
                 SubmissionUsed -= 1;
-                BufferStart = (BufferStart + submission.Padding) % BufferSize;
-                Assert_(submission.Offset == BufferStart);
-                Assert_(BufferStart + submission.Size <= BufferSize);
-                BufferStart = (BufferStart + submission.Size) % BufferSize;
-                BufferUsed -= (submission.Size + submission.Padding);
+                submission.Ring->Allocator.Free(submission.Allocation);
                 submission.Reset();
-
-                if(BufferUsed == 0)
-                    BufferStart = 0;
             }
             else
             {
                 // We don't want to retire our submissions out of allocation order, because
-                // the ring buffer logic above will move the tail position forward (we don't
-                // allow holes in the ring buffer). Submitting out-of-order should still be
+                // the ring buffer logic in RingAllocator will move the tail position forward (we
+                // don't allow holes in the ring buffer). Submitting out-of-order should still be
                 // ok though as long as we retire in-order.
                 break;
             }
         }
+
+        ReleaseDrainedRings();
     }
 
     void Flush()
@@ -245,6 +370,8 @@ struct UploadRingBuffer
         if(TryAcquireSRWLockExclusive(&Lock))
         {
             ClearPendingUploads(0);
+            ShrinkIfQuiet();
+            UpdateStats();
 
             ReleaseSRWLockExclusive(&Lock);
         }
@@ -257,72 +384,52 @@ struct UploadRingBuffer
             return nullptr;
 
         const uint64 submissionIdx = (SubmissionStart + SubmissionUsed) % MaxSubmissions;
-        Assert_(Submissions[submissionIdx].Size == 0);
+        Assert_(Submissions[submissionIdx].Ring == nullptr);
 
-        Assert_(BufferUsed <= BufferSize);
-        if(size > (BufferSize - BufferUsed))
-            return nullptr;
-
-        const uint64 start = BufferStart;
-        const uint64 end = BufferStart + BufferUsed;
-        uint64 allocOffset = uint64(-1);
-        uint64 padding = 0;
-        if(end < BufferSize)
-        {
-            const uint64 endAmt = BufferSize - end;
-            if(endAmt >= size)
-            {
-                allocOffset = end;
-            }
-            else if(start >= size)
-            {
-                // Wrap around to the beginning
-                allocOffset = 0;
-                BufferUsed += endAmt;
-                padding = endAmt;
-            }
-        }
-        else
-        {
-            const uint64 wrappedEnd = end % BufferSize;
-            if((start - wrappedEnd) >= size)
-                allocOffset = wrappedEnd;
-        }
-
-        if(allocOffset == uint64(-1))
+        UploadRing& ring = CurrentRing();
+        RingAllocation allocation;
+        if(ring.Allocator.Allocate(size, allocation) == false)
             return nullptr;
 
         SubmissionUsed += 1;
-        BufferUsed += size;
+        PeakBytesUsed = Max(PeakBytesUsed, ring.Allocator.Used());
 
         UploadSubmission* submission = &Submissions[submissionIdx];
-        submission->Offset = allocOffset;
-        submission->Size = size;
+        submission->Ring = &ring;
+        submission->Allocation = allocation;
         submission->FenceValue = uint64(-1);
-        submission->Padding = padding;
 
         return submission;
     }
 
-    UploadContext Begin(uint64 size)
+    UploadSubmission* WaitForSubmission(uint64 size)
     {
-        Assert_(Device != nullptr);
-
-        Assert_(size > 0);
-        size = AlignTo(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        // Shows up in the profiler's CPU timings, so that stalls aren't hidden inside other blocks
+        CPUProfileBlock profileBlock("Upload Ring Stall");
+        Timer stallTimer;
 
-        if(size > BufferSize)
+        UploadSubmission* submission = nullptr;
+        while(submission == nullptr)
         {
-            // Resize the ring buffer so that it's big enough
-            AcquireSRWLockExclusive(&Lock);
+            ClearPendingUploads(1);
+            submission = AllocSubmission(size);
+            if(submission == nullptr)
+                submission = GrowAndAllocSubmission(size);
+        }
 
-            while(SubmissionUsed > 0)
-                ClearPendingUploads(uint64(-1));
+        stallTimer.Update();
+        Stats.NumStalls += 1;
+        Stats.StallTimeMS += stallTimer.ElapsedMillisecondsD();
 
-            Resize(size);
+        return submission;
+    }
 
-            ReleaseSRWLockExclusive(&Lock);
-        }
+    UploadContext Begin(uint64 size)
+    {
+        Assert_(Device != nullptr);
+
+        Assert_(size > 0);
+        size = AlignTo(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
         UploadSubmission* submission = nullptr;
 
@@ -332,11 +439,12 @@ struct UploadRingBuffer
             ClearPendingUploads(0);
 
             submission = AllocSubmission(size);
-            while(submission == nullptr)
-            {
-                ClearPendingUploads(1);
-                submission = AllocSubmission(size);
-            }
+            if(submission == nullptr)
+                submission = GrowAndAllocSubmission(size);
+            if(submission == nullptr)
+                submission = WaitForSubmission(size);
+
+            Stats.NumUploads += 1;
 
             ReleaseSRWLockExclusive(&Lock);
         }
@@ -346,9 +454,9 @@ struct UploadRingBuffer
 
         UploadContext context;
         context.CmdList = submission->CmdList;
-        context.Resource = Buffer;
-        context.CPUAddress = BufferCPUAddr + submission->Offset;
-        context.ResourceOffset = submission->Offset;
+        context.Resource = submission->Ring->Buffer;
+        context.CPUAddress = submission->Ring->CPUAddr + submission->Allocation.Offset;
+        context.ResourceOffset = submission->Allocation.Offset;
         context.Submission = submission;
 
         return context;
@@ -366,17 +474,180 @@ struct UploadRingBuffer
 
         context = UploadContext();
     }
+
+    UploadRingStats GetStats()
+    {
+        AcquireSRWLockExclusive(&Lock);
+        UpdateStats();
+        const UploadRingStats stats = Stats;
+        ReleaseSRWLockExclusive(&Lock);
+
+        return stats;
+    }
 };
 
 static UploadQueue uploadQueue;
 static UploadRingBuffer uploadRingBuffer;
 
-// Per-frame temporary upload buffer resources
-static const uint64 TempBufferSize = 16 * 1024 * 1024;
-static ID3D12Resource* TempFrameBuffers[RenderLatency] = { };
-static uint8* TempFrameCPUMem[RenderLatency] = { };
-static uint64 TempFrameGPUMem[RenderLatency] = { };
-static int64 TempFrameUsed = 0;
+// Big buffer uploads get split up, so that they don't force the ring to grow or have to wait for
+// the whole ring to drain
+static const uint64 MaxUploadChunkSize = UploadRingBuffer::InitialRingSize / 4;
+
+// Per-frame temporary upload buffer memory. Each frame slot owns a chain of pages that grows
+// on demand, and threads sub-allocate out of chunks that they grab from the current page so
+// that they're not all hammering the same atomic for every allocation.
+static const uint64 TempPageSize = 16 * 1024 * 1024;
+static const uint64 TempChunkSize = 64 * 1024;
+static const uint64 TempChunkAlignment = 256;
+static const uint64 MaxTempPages = 64;
+
+struct TempBufferPage
+{
+    ID3D12Resource* Resource = nullptr;
+    uint8* CPUAddress = nullptr;
+    uint64 GPUAddress = 0;
+    uint64 Size = 0;
+    volatile int64 Used = 0;
+};
+
+struct TempFrameMemory
+{
+    TempBufferPage* Pages[MaxTempPages] = { };
+    volatile int64 NumPages = 0;
+    volatile int64 CurrPage = 0;
+    volatile int64 BytesUsed = 0;
+};
+
+// Each thread's current chunk, which is only valid for the CPU frame that it was grabbed in
+struct TempBufferArena
+{
+    uint64 FrameNumber = uint64(-1);
+    TempBufferPage* Page = nullptr;
+    uint64 Offset = 0;
+    uint64 End = 0;
+};
+
+static TempFrameMemory TempFrames[RenderLatency];
+static SRWLOCK TempPageLock = SRWLOCK_INIT;
+static thread_local TempBufferArena TempArena;
+static TempBufferStats TempStats;
+
+static TempBufferPage* CreateTempPage(uint64 size)
+{
+    D3D12_RESOURCE_DESC1 resourceDesc = { };
+    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    resourceDesc.Width = size;
+    resourceDesc.Height = 1;
+    resourceDesc.DepthOrArraySize = 1;
+    resourceDesc.MipLevels = 1;
+    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+    resourceDesc.SampleDesc.Count = 1;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    resourceDesc.Alignment = 0;
+
+    TempBufferPage* page = new TempBufferPage();
+    page->Size = size;
+
+    DXCall(Device->CreateCommittedResource3(DX12::GetUploadHeapProps(), D3D12_HEAP_FLAG_NONE, &resourceDesc,
+                                            D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&page->Resource)));
+    page->Resource->SetName(L"Temp Buffer Page");
+
+    D3D12_RANGE readRange = { };
+    DXCall(page->Resource->Map(0, &readRange, reinterpret_cast<void**>(&page->CPUAddress)));
+    page->GPUAddress = page->Resource->GetGPUVirtualAddress();
+
+    return page;
+}
+
+// Bumps the page's offset by exactly the aligned size, failing if there's not enough room left
+static bool TryAllocateFromPage(TempBufferPage& page, uint64 size, uint64 alignment, uint64& offset)
+{
+    int64 used = page.Used;
+    while(true)
+    {
+        const uint64 alignedOffset = alignment > 0 ? AlignTo(uint64(used), alignment) : uint64(used);
+        if(alignedOffset + size > page.Size)
+            return false;
+
+        const int64 prevUsed = InterlockedCompareExchange64(&page.Used, int64(alignedOffset + size), used);
+        if(prevUsed == used)
+        {
+            offset = alignedOffset;
+            return true;
+        }
+
+        used = prevUsed;
+    }
+}
+
+static TempBufferPage* AllocateFromFrame(TempFrameMemory& frame, uint64 size, uint64 alignment, uint64& offset)
+{
+    while(true)
+    {
+        const int64 pageIdx = frame.CurrPage;
+        TempBufferPage* page = frame.Pages[pageIdx];
+        if(TryAllocateFromPage(*page, size, alignment, offset))
+            return page;
+
+        // The current page is full, so move on to the next one in the chain. We make a new page
+        // if we're at the end of the chain, making sure that it's big enough for this allocation.
+        AcquireSRWLockExclusive(&TempPageLock);
+
+        if(frame.CurrPage == pageIdx)
+        {
+            const int64 nextPageIdx = pageIdx + 1;
+            if(nextPageIdx == frame.NumPages)
+            {
+                if(frame.NumPages >= int64(MaxTempPages))
+                {
+                    ReleaseSRWLockExclusive(&TempPageLock);
+                    throw Exception(MakeString(L"Exceeded the maximum of %llu temp buffer pages for a single frame", MaxTempPages));
+                }
+
+                const uint64 pageSize = AlignTo(Max(size + alignment, TempPageSize), TempPageSize);
+                frame.Pages[nextPageIdx] = CreateTempPage(pageSize);
+                frame.NumPages = nextPageIdx + 1;
+            }
+
+            frame.CurrPage = nextPageIdx;
+        }
+
+        ReleaseSRWLockExclusive(&TempPageLock);
+    }
+}
+
+static void ResetTempFrame(TempFrameMemory& frame)
+{
+    for(int64 i = 0; i < frame.NumPages; ++i)
+        frame.Pages[i]->Used = 0;
+    frame.CurrPage = 0;
+    frame.BytesUsed = 0;
+}
+
+static void UpdateTempStats(const TempFrameMemory& frame)
+{
+    uint64 reserved = 0;
+    for(int64 i = 0; i <= frame.CurrPage; ++i)
+        reserved += frame.Pages[i]->Used;
+
+    TempStats.FrameBytesUsed = frame.BytesUsed;
+    TempStats.FrameBytesReserved = reserved;
+    TempStats.HighWaterBytesUsed = Max(TempStats.HighWaterBytesUsed, TempStats.FrameBytesUsed);
+    TempStats.HighWaterBytesReserved = Max(TempStats.HighWaterBytesReserved, reserved);
+
+    TempStats.NumPages = 0;
+    TempStats.TotalPageBytes = 0;
+    for(uint64 frameIdx = 0; frameIdx < RenderLatency; ++frameIdx)
+    {
+        for(int64 i = 0; i < TempFrames[frameIdx].NumPages; ++i)
+        {
+            TempStats.NumPages += 1;
+            TempStats.TotalPageBytes += TempFrames[frameIdx].Pages[i]->Size;
+        }
+    }
+}
 
 // Resources for doing fast uploads while generating render commands
 struct FastUpload
@@ -463,28 +734,15 @@ void Initialize_Upload()
     fastUploader.Init();
 
     // Temporary buffer memory that swaps every frame
-    D3D12_RESOURCE_DESC1 resourceDesc = { };
-    resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-    resourceDesc.Width = uint32(TempBufferSize);
-    resourceDesc.Height = 1;
-    resourceDesc.DepthOrArraySize = 1;
-    resourceDesc.MipLevels = 1;
-    resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
-    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-    resourceDesc.SampleDesc.Count = 1;
-    resourceDesc.SampleDesc.Quality = 0;
-    resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-    resourceDesc.Alignment = 0;
-
     for(uint64 i = 0; i < RenderLatency; ++i)
     {
-        DXCall(Device->CreateCommittedResource3(DX12::GetUploadHeapProps(), D3D12_HEAP_FLAG_NONE, &resourceDesc,
-                                                D3D12_BARRIER_LAYOUT_UNDEFINED, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&TempFrameBuffers[i])));
-
-        D3D12_RANGE readRange = { };
-        DXCall(TempFrameBuffers[i]->Map(0, &readRange, reinterpret_cast<void**>(&TempFrameCPUMem[i])));
-        TempFrameGPUMem[i] = TempFrameBuffers[i]->GetGPUVirtualAddress();
+        TempFrames[i].Pages[0] = CreateTempPage(TempPageSize);
+        TempFrames[i].NumPages = 1;
+        ResetTempFrame(TempFrames[i]);
     }
+
+    TempStats = TempBufferStats();
+    UpdateTempStats(TempFrames[0]);
 }
 
 void Shutdown_Upload()
@@ -494,8 +752,20 @@ void Shutdown_Upload()
     fastUploader.Shutdown();
     fastUploadQueue.Shutdown();
 
-    for(uint64 i = 0; i < ArraySize_(TempFrameBuffers); ++i)
-        Release(TempFrameBuffers[i]);
+    for(uint64 frameIdx = 0; frameIdx < RenderLatency; ++frameIdx)
+    {
+        TempFrameMemory& frame = TempFrames[frameIdx];
+        for(int64 i = 0; i < frame.NumPages; ++i)
+        {
+            Release(frame.Pages[i]->Resource);
+            delete frame.Pages[i];
+            frame.Pages[i] = nullptr;
+        }
+
+        frame.NumPages = 0;
+        frame.CurrPage = 0;
+        frame.BytesUsed = 0;
+    }
 }
 
 void EndFrame_Upload()
@@ -509,7 +779,11 @@ void EndFrame_Upload()
     uploadQueue.SyncDependentQueue(GfxQueue);
     fastUploadQueue.SyncDependentQueue(GfxQueue);
 
-    TempFrameUsed = 0;
+    // Record the temp memory usage for the frame that just finished recording, and then reset the
+    // pages for the next frame. The GPU might still be reading from those, but we won't write to
+    // them until after DX12::EndFrame has waited on the fence.
+    UpdateTempStats(TempFrames[CurrFrameIdx]);
+    ResetTempFrame(TempFrames[(CurrFrameIdx + 1) % RenderLatency]);
 }
 
 void Flush_Upload()
@@ -529,23 +803,91 @@ void ResourceUploadEnd(UploadContext& context, bool syncOnGraphicsQueue)
     uploadRingBuffer.End(context, syncOnGraphicsQueue);
 }
 
+void UploadBufferData(ID3D12Resource* dstBuffer, uint64 dstOffset, const void* data, uint64 size, bool syncOnGraphicsQueue)
+{
+    Assert_(dstBuffer != nullptr);
+    Assert_(data != nullptr);
+    Assert_(size > 0);
+
+    const uint8* srcData = reinterpret_cast<const uint8*>(data);
+    for(uint64 chunkStart = 0; chunkStart < size; chunkStart += MaxUploadChunkSize)
+    {
+        const uint64 chunkSize = Min(MaxUploadChunkSize, size - chunkStart);
+
+        UploadContext uploadContext = uploadRingBuffer.Begin(chunkSize);
+        memcpy(uploadContext.CPUAddress, srcData + chunkStart, chunkSize);
+        uploadContext.CmdList->CopyBufferRegion(dstBuffer, dstOffset + chunkStart, uploadContext.Resource, uploadContext.ResourceOffset, chunkSize);
+        uploadRingBuffer.End(uploadContext, syncOnGraphicsQueue);
+    }
+
+    if(size > MaxUploadChunkSize)
+    {
+        AcquireSRWLockExclusive(&uploadRingBuffer.Lock);
+        uploadRingBuffer.Stats.NumChunkedUploads += 1;
+        ReleaseSRWLockExclusive(&uploadRingBuffer.Lock);
+    }
+}
+
+UploadRingStats GetUploadRingStats()
+{
+    return uploadRingBuffer.GetStats();
+}
+
 MapResult AcquireTempBufferMem(uint64 size, uint64 alignment)
 {
-    uint64 allocSize = size + alignment;
-    uint64 offset = InterlockedAdd64(&TempFrameUsed, allocSize) - allocSize;
-    if(alignment > 0)
-        offset = AlignTo(offset, alignment);
-    Assert_(offset + size <= TempBufferSize);
+    TempFrameMemory& frame = TempFrames[CurrFrameIdx];
+    TempBufferArena& arena = TempArena;
+    if(arena.FrameNumber != CurrentCPUFrame)
+    {
+        arena = TempBufferArena();
+        arena.FrameNumber = CurrentCPUFrame;
+    }
+
+    TempBufferPage* page = nullptr;
+    uint64 offset = 0;
+
+    const uint64 arenaOffset = alignment > 0 ? AlignTo(arena.Offset, alignment) : arena.Offset;
+    if(arena.Page != nullptr && arenaOffset + size <= arena.End)
+    {
+        // Fast path: pack it into this thread's chunk
+        page = arena.Page;
+        offset = arenaOffset;
+        arena.Offset = offset + size;
+    }
+    else if(size + alignment > TempChunkSize / 4)
+    {
+        // Big allocations go straight to the page so that they don't waste most of a chunk
+        page = AllocateFromFrame(frame, size, alignment, offset);
+    }
+    else
+    {
+        // Grab a new chunk for this thread, and abandon whatever was left in the old one
+        uint64 chunkOffset = 0;
+        page = AllocateFromFrame(frame, TempChunkSize, TempChunkAlignment, chunkOffset);
+        arena.Page = page;
+        arena.End = chunkOffset + TempChunkSize;
+
+        offset = alignment > 0 ? AlignTo(chunkOffset, alignment) : chunkOffset;
+        arena.Offset = offset + size;
+        Assert_(arena.Offset <= arena.End);
+    }
+
+    InterlockedAdd64(&frame.BytesUsed, int64(size));
 
     MapResult result;
-    result.CPUAddress = TempFrameCPUMem[CurrFrameIdx] + offset;
-    result.GPUAddress = TempFrameGPUMem[CurrFrameIdx] + offset;
+    result.CPUAddress = page->CPUAddress + offset;
+    result.GPUAddress = page->GPUAddress + offset;
     result.ResourceOffset = offset;
-    result.Resource = TempFrameBuffers[CurrFrameIdx];
+    result.Resource = page->Resource;
 
     return result;
 }
 
+TempBufferStats GetTempBufferStats()
+{
+    return TempStats;
+}
+
 void QueueFastUpload(ID3D12Resource* srcBuffer, uint64 srcOffset, ID3D12Resource* dstBuffer, uint64 dstOffset, uint64 copySize)
 {
     FastUpload upload = { .SrcBuffer = srcBuffer, .SrcOffset = srcOffset, .DstBuffer = dstBuffer, .DstOffset = dstOffset, .CopySize = copySize };
@@ -31,6 +31,36 @@ struct UploadContext
     void* Submission = nullptr;
 };
 
+// Usage of the per-frame temporary buffer memory, as of the last completed frame. "Used" is the
+// total size that was requested, while "reserved" also includes alignment padding and the unused
+// tails of per-thread chunks.
+struct TempBufferStats
+{
+    uint64 FrameBytesUsed = 0;
+    uint64 FrameBytesReserved = 0;
+    uint64 HighWaterBytesUsed = 0;
+    uint64 HighWaterBytesReserved = 0;
+    uint64 NumPages = 0;
+    uint64 TotalPageBytes = 0;
+};
+
+// Stats for the ring buffer that resource uploads go through. A stall is an upload that had to wait
+// for the GPU, either because all of the submissions were in flight or because the ring couldn't
+// grow any further. Wrapping around skips the end of the ring, which is counted as padding.
+struct UploadRingStats
+{
+    uint64 NumUploads = 0;
+    uint64 NumChunkedUploads = 0;
+    uint64 NumStalls = 0;
+    double StallTimeMS = 0.0;
+    uint64 NumGrows = 0;
+    uint64 NumShrinks = 0;
+    uint64 RingSize = 0;
+    uint64 NumWraps = 0;
+    uint64 WrapPaddingBytes = 0;
+    uint64 HighWaterBytesUsed = 0;
+};
+
 struct ReadbackBuffer;
 struct Texture;
 
@@ -48,8 +78,13 @@ void Flush_Upload();
 UploadContext ResourceUploadBegin(uint64 size);
 void ResourceUploadEnd(UploadContext& context, bool syncOnGraphicsQueue = true);
 
+// Copies data into a buffer, split across multiple submissions if it's large
+void UploadBufferData(ID3D12Resource* dstBuffer, uint64 dstOffset, const void* data, uint64 size, bool syncOnGraphicsQueue = true);
+UploadRingStats GetUploadRingStats();
+
 // Temporary CPU-writable buffer memory
 MapResult AcquireTempBufferMem(uint64 size, uint64 alignment);
+TempBufferStats GetTempBufferStats();
 
 // Fast in-frame upload path through the copy queue
 void QueueFastUpload(ID3D12Resource* srcBuffer, uint64 srcOffset, ID3D12Resource* dstBuffer, uint64 dstOffset, uint64 copySize);
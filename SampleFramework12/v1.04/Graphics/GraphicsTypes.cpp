@@ -35,6 +35,142 @@ static const D3D12_BARRIER_LAYOUT UnorderedAcccessQueueLayouts[] =
 StaticAssert_(ArraySize_(UnorderedAcccessQueueLayouts) == NumQueueVisibilities);
 
 
+// == PersistentDescriptorAllocator ===============================================================
+
+// Where the current thread's next search starts. Threads start out spread across the heap based on
+// their ID, so that they don't all CAS the same word, and then carry on from wherever their last
+// allocation left off. It's shared across allocators, but it's only a hint so that doesn't matter.
+static thread_local uint32 DescriptorSearchStart = GetCurrentThreadId() * 2654435761u;
+
+void PersistentDescriptorAllocator::Init(uint32 numIndices)
+{
+    Shutdown();
+
+    NumIndices = numIndices;
+    FreeBits.Init((numIndices + 63) / 64);
+    for(uint64 i = 0; i < FreeBits.Size(); ++i)
+        FreeBits[i].Bits = -1;
+
+    // Make sure that the bits past the end of the last word never get handed out
+    if(numIndices % 64 != 0)
+        FreeBits[FreeBits.Size() - 1].Bits = int64((1ull << (numIndices % 64)) - 1);
+}
+
+void PersistentDescriptorAllocator::Shutdown()
+{
+    Assert_(NumAllocated == 0);
+    FreeBits.Shutdown();
+    NumIndices = 0;
+}
+
+uint32 PersistentDescriptorAllocator::Allocate()
+{
+    uint32 index = uint32(-1);
+    AllocateBulk(&index, 1);
+    return index;
+}
+
+bool PersistentDescriptorAllocator::Reserve(uint32 index)
+{
+    if(index >= NumIndices)
+        return false;
+
+    const uint64 bit = 1ull << (index % 64);
+    const uint64 prevBits = uint64(InterlockedAnd64(&FreeBits[index / 64].Bits, ~int64(bit)));
+    if((prevBits & bit) == 0)
+        return false;
+
+    InterlockedIncrement64(&NumAllocated);
+    return true;
+}
+
+void PersistentDescriptorAllocator::Free(uint32 index)
+{
+    FreeBulk(&index, 1);
+}
+
+uint32 PersistentDescriptorAllocator::AllocateBulk(uint32* indices, uint32 count)
+{
+    Assert_(indices != nullptr);
+
+    const uint32 numWords = uint32(FreeBits.Size());
+    if(numWords == 0 || count == 0)
+        return 0;
+
+    // Start searching from wherever this thread's last allocation left off, which keeps us from
+    // repeatedly scanning over the full words at the start of the heap
+    const uint32 startWord = DescriptorSearchStart % numWords;
+
+    uint32 numAllocated = 0;
+    for(uint32 i = 0; i < numWords && numAllocated < count; ++i)
+    {
+        const uint32 wordIdx = (startWord + i) % numWords;
+        volatile int64* word = &FreeBits[wordIdx].Bits;
+
+        uint64 currBits = uint64(*word);
+        while(currBits != 0 && numAllocated < count)
+        {
+            // Claim as many of this word's free bits as we need with a single CAS
+            uint64 claimedBits = 0;
+            uint64 remainingBits = currBits;
+            for(uint32 numClaimed = numAllocated; remainingBits != 0 && numClaimed < count; ++numClaimed)
+            {
+                const uint64 lowestBit = remainingBits & (~remainingBits + 1);
+                claimedBits |= lowestBit;
+                remainingBits &= ~lowestBit;
+            }
+
+            const uint64 prevBits = uint64(InterlockedCompareExchange64(word, int64(remainingBits), int64(currBits)));
+            if(prevBits != currBits)
+            {
+                // Someone else got here first, try again with the new value
+                currBits = prevBits;
+                continue;
+            }
+
+            while(claimedBits != 0)
+            {
+                unsigned long bitIdx = 0;
+                _BitScanForward64(&bitIdx, claimedBits);
+                indices[numAllocated++] = wordIdx * 64 + bitIdx;
+                claimedBits &= claimedBits - 1;
+            }
+
+            currBits = remainingBits;
+            DescriptorSearchStart = remainingBits != 0 ? wordIdx : wordIdx + 1;
+        }
+    }
+
+    InterlockedAdd64(&NumAllocated, numAllocated);
+    return numAllocated;
+}
+
+void PersistentDescriptorAllocator::FreeBulk(const uint32* indices, uint32 count)
+{
+    Assert_(indices != nullptr || count == 0);
+
+    // Runs of indices that land in the same word are freed with a single atomic
+    uint32 i = 0;
+    while(i < count)
+    {
+        const uint32 wordIdx = indices[i] / 64;
+        uint64 freedBits = 0;
+        uint32 numFreed = 0;
+        for(; i < count && indices[i] / 64 == wordIdx; ++i)
+        {
+            Assert_(indices[i] < NumIndices);
+            const uint64 bit = 1ull << (indices[i] % 64);
+            Assert_((freedBits & bit) == 0);
+            freedBits |= bit;
+            ++numFreed;
+        }
+
+        const uint64 prevBits = uint64(InterlockedOr64(&FreeBits[wordIdx].Bits, int64(freedBits)));
+        Assert_((prevBits & freedBits) == 0);
+        InterlockedAdd64(&NumAllocated, -int64(numFreed));
+    }
+}
+
 // == DescriptorHeap ==============================================================================
 
 void DescriptorHeap::Init(uint32 numPersistent, uint32 numTemporary, D3D12_DESCRIPTOR_HEAP_TYPE heapType, bool shaderVisible)
@@ -53,9 +189,7 @@ void DescriptorHeap::Init(uint32 numPersistent, uint32 numTemporary, D3D12_DESCR
 
     NumHeaps = ShaderVisible ? 2 : 1;
 
-    DeadList.Init(numPersistent);
-    for(uint32 i = 0; i < numPersistent; ++i)
-        DeadList[i] = uint32(i);
+    PersistentAllocator.Init(numPersistent);
 
     D3D12_DESCRIPTOR_HEAP_DESC heapDesc = { };
     heapDesc.NumDescriptors = uint32(totalNumDescriptors);
@@ -77,51 +211,59 @@ void DescriptorHeap::Init(uint32 numPersistent, uint32 numTemporary, D3D12_DESCR
 
 void DescriptorHeap::Shutdown()
 {
-    Assert_(PersistentAllocated == 0);
+    PersistentAllocator.Shutdown();
     for(uint64 i = 0; i < ArraySize_(Heaps); ++i)
         DX12::Release(Heaps[i]);
 }
 
-PersistentDescriptorAlloc DescriptorHeap::AllocatePersistent(DescriptorIndex index)
+static PersistentDescriptorAlloc MakePersistentAlloc(const DescriptorHeap& heap, uint32 index)
 {
-    Assert_(Heaps[0] != nullptr);
+    PersistentDescriptorAlloc alloc;
+    alloc.Index = index;
+    for(uint32 i = 0; i < heap.NumHeaps; ++i)
+    {
+        alloc.Handles[i] = heap.CPUStart[i];
+        alloc.Handles[i].ptr += index * heap.DescriptorSize;
+    }
 
-    AcquireSRWLockExclusive(&Lock);
+    return alloc;
+}
 
-    Assert_(PersistentAllocated < NumPersistent);
-    if(PersistentAllocated >= NumPersistent)
-        throw Exception(MakeString("Ran out of persistent descriptors in the global descriptor heap (max is %u)", NumPersistent));
+PersistentDescriptorAlloc DescriptorHeap::AllocatePersistent(DescriptorIndex index)
+{
+    Assert_(Heaps[0] != nullptr);
 
     if(index != InvalidDescriptorIndex)
     {
-        // Make sure the index is available, and swap it so it's next in the dead list
-        for(uint32 i = PersistentAllocated; i < NumPersistent; ++i)
-        {
-            if(DeadList[i] == index)
-            {
-                Swap(DeadList[i], DeadList[PersistentAllocated]);
-                break;
-            }
-        }
-
-        Assert_(DeadList[PersistentAllocated] == index);
+        // Make sure the specific index that was requested is available
+        if(PersistentAllocator.Reserve(index) == false)
+            throw Exception(MakeString("Persistent descriptor %u is already allocated, or is outside of the %u persistent descriptors in the heap", index, NumPersistent));
+        return MakePersistentAlloc(*this, index);
     }
 
-    // Use the next one from the dead list
-    index = DeadList[PersistentAllocated];
-    ++PersistentAllocated;
+    const uint32 newIndex = PersistentAllocator.Allocate();
+    Assert_(newIndex != uint32(-1));
+    if(newIndex == uint32(-1))
+        throw Exception(MakeString("Ran out of persistent descriptors in the global descriptor heap (max is %u)", NumPersistent));
 
-    ReleaseSRWLockExclusive(&Lock);
+    return MakePersistentAlloc(*this, newIndex);
+}
 
-    PersistentDescriptorAlloc alloc;
-    alloc.Index = index;
-    for(uint32 i = 0; i < NumHeaps; ++i)
+void DescriptorHeap::AllocatePersistent(PersistentDescriptorAlloc* allocs, uint32 count)
+{
+    Assert_(Heaps[0] != nullptr);
+    Assert_(allocs != nullptr || count == 0);
+
+    Array<uint32> indices(count);
+    const uint32 numAllocated = PersistentAllocator.AllocateBulk(indices.Data(), count);
+    if(numAllocated < count)
     {
-        alloc.Handles[i] = CPUStart[i];
-        alloc.Handles[i].ptr += index * DescriptorSize;
+        PersistentAllocator.FreeBulk(indices.Data(), numAllocated);
+        throw Exception(MakeString("Ran out of persistent descriptors in the global descriptor heap (max is %u)", NumPersistent));
     }
 
-    return alloc;
+    for(uint32 i = 0; i < count; ++i)
+        allocs[i] = MakePersistentAlloc(*this, indices[i]);
 }
 
 void DescriptorHeap::FreePersistent(DescriptorIndex& idx)
@@ -132,15 +274,30 @@ void DescriptorHeap::FreePersistent(DescriptorIndex& idx)
     Assert_(idx < NumPersistent);
     Assert_(Heaps[0] != nullptr);
 
-    AcquireSRWLockExclusive(&Lock);
+    PersistentAllocator.Free(idx);
 
-    Assert_(PersistentAllocated > 0);
-    DeadList[PersistentAllocated - 1] = idx;
-    --PersistentAllocated;
+    idx = uint32(-1);
+}
 
-    ReleaseSRWLockExclusive(&Lock);
+void DescriptorHeap::FreePersistent(DescriptorIndex* indices, uint32 count)
+{
+    Assert_(Heaps[0] != nullptr);
+    Assert_(indices != nullptr || count == 0);
 
-    idx = uint32(-1);
+    // Invalid indices are skipped, so that partially-initialized arrays can be freed
+    Array<uint32> validIndices(count);
+    uint32 numValid = 0;
+    for(uint32 i = 0; i < count; ++i)
+    {
+        if(indices[i] != InvalidDescriptorIndex)
+        {
+            Assert_(indices[i] < NumPersistent);
+            validIndices[numValid++] = indices[i];
+        }
+        indices[i] = uint32(-1);
+    }
+
+    PersistentAllocator.FreeBulk(validIndices.Data(), numValid);
 }
 
 void DescriptorHeap::FreePersistent(D3D12_CPU_DESCRIPTOR_HANDLE& handle)
@@ -324,16 +481,7 @@ void Buffer::Initialize(const BufferInit& init)
     {
         const uint64 numBuffers = init.Dynamic ? DX12::RenderLatency : 1;
         for(uint64 bufferIdx = 0; bufferIdx < numBuffers; ++bufferIdx)
-        {
-            UploadContext uploadContext = DX12::ResourceUploadBegin(init.Size);
-
-            memcpy(uploadContext.CPUAddress, (uint8*)init.InitData, init.Size);
-
-            const uint64 dstOffset = bufferIdx * init.Size;
-            uploadContext.CmdList->CopyBufferRegion(Resource, dstOffset, uploadContext.Resource, uploadContext.ResourceOffset, init.Size);
-
-            DX12::ResourceUploadEnd(uploadContext);
-        }
+            DX12::UploadBufferData(Resource, bufferIdx * init.Size, init.InitData, init.Size);
     }
 }
 
@@ -35,13 +35,43 @@ struct TempDescriptorAlloc
     DescriptorIndex StartIndex = InvalidDescriptorIndex;
 };
 
+// Lock-free allocator for persistent descriptor indices. Free indices are tracked as set bits in an
+// array of 64-bit words, so that freeing or reserving a specific index is a single atomic operation,
+// and allocating only needs to find a word with a free bit and CAS it. It doesn't touch D3D at all,
+// which means it can be exercised without a device. Each word gets its own cache line so that threads
+// working on neighboring words don't fight over it, and each thread keeps its own search position.
+struct PersistentDescriptorAllocator
+{
+    static const uint64 CacheLineSize = 64;
+
+    struct alignas(CacheLineSize) FreeBitWord
+    {
+        volatile int64 Bits = 0;
+        uint8 Padding[CacheLineSize - sizeof(int64)] = { };
+    };
+    StaticAssert_(sizeof(FreeBitWord) == CacheLineSize);
+
+    Array<FreeBitWord> FreeBits;
+    uint32 NumIndices = 0;
+    volatile int64 NumAllocated = 0;
+
+    void Init(uint32 numIndices);
+    void Shutdown();
+
+    uint32 Allocate();                                  // Returns uint32(-1) if there's nothing free
+    bool Reserve(uint32 index);                         // Returns false if the index is already allocated or out of range
+    void Free(uint32 index);
+
+    uint32 AllocateBulk(uint32* indices, uint32 count); // Returns the number that were allocated
+    void FreeBulk(const uint32* indices, uint32 count);
+};
+
 // Wrapper for D3D12 descriptor heaps that supports persistent and temporary allocations
 struct DescriptorHeap
 {
     ID3D12DescriptorHeap* Heaps[DX12::RenderLatency] = { };
     uint32 NumPersistent = 0;
-    uint32 PersistentAllocated = 0;
-    Array<DescriptorIndex> DeadList;
+    PersistentDescriptorAllocator PersistentAllocator;
     uint32 NumTemporary = 0;
     volatile int64 TemporaryAllocated = 0;
     uint32 HeapIndex = 0;
@@ -51,13 +81,14 @@ struct DescriptorHeap
     D3D12_DESCRIPTOR_HEAP_TYPE HeapType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     D3D12_CPU_DESCRIPTOR_HANDLE CPUStart[DX12::RenderLatency] = { };
     D3D12_GPU_DESCRIPTOR_HANDLE GPUStart[DX12::RenderLatency] = { };
-    SRWLOCK Lock = SRWLOCK_INIT;
 
     void Init(uint32 numPersistent, uint32 numTemporary, D3D12_DESCRIPTOR_HEAP_TYPE heapType, bool shaderVisible);
     void Shutdown();
 
     PersistentDescriptorAlloc AllocatePersistent(DescriptorIndex index = InvalidDescriptorIndex);
+    void AllocatePersistent(PersistentDescriptorAlloc* allocs, uint32 count);
     void FreePersistent(DescriptorIndex& idx);
+    void FreePersistent(DescriptorIndex* indices, uint32 count);
     void FreePersistent(D3D12_CPU_DESCRIPTOR_HANDLE& handle);
     void FreePersistent(D3D12_GPU_DESCRIPTOR_HANDLE& handle);
 
@@ -75,6 +106,7 @@ struct DescriptorHeap
 
     ID3D12DescriptorHeap* CurrentHeap() const;
     uint32 TotalNumDescriptors() const { return NumPersistent + NumTemporary; }
+    uint32 PersistentAllocated() const { return uint32(PersistentAllocator.NumAllocated); }
 };
 
 struct BufferInit
@@ -15,9 +15,11 @@
 #include "..\\Utility.h"
 #include "GraphicsTypes.h"
 #include "..\\Serialization.h"
+#include "..\\CompressedSerialization.h"
 #include "..\\FileIO.h"
 #include "..\\MurmurHash.h"
 #include "Textures.h"
+#include "..\\Jobs.h"
 
 using std::string;
 using std::wstring;
@@ -73,9 +75,26 @@ static Float4x4 ConvertMatrix(const aiMatrix4x4& mat)
                     Float4(mat.d1, mat.d2, mat.d3, mat.d4));
 }
 
+// Materials can refer to the same file with different casing or slashes
+static wstring TextureKey(const wstring& path)
+{
+    wstring key = path;
+    for(wchar& c : key)
+        c = c == L'/' ? L'\\' : wchar(towlower(c));
+
+    return key;
+}
+
 static void LoadMaterialResources(Array<MeshMaterial>& materials, const wstring& directory, bool32 forceSRGB,
                                   List<MaterialTexture*>& materialTextures)
 {
+    // Resolve and dedupe all of the paths first, and then load the new textures together
+    List<wstring> textureKeys;
+    for(const MaterialTexture* matTexture : materialTextures)
+        textureKeys.Add(TextureKey(matTexture->Name));
+
+    List<TextureLoadRequest> loadRequests;
+
     const uint64 numMaterials = materials.Size();
     for(uint64 matIdx = 0; matIdx < numMaterials; ++matIdx)
     {
@@ -90,10 +109,11 @@ static void LoadMaterialResources(Array<MeshMaterial>& materials, const wstring&
             else if(texType == uint64(MaterialTextures::Opacity))
                 material.Opaque = false;
 
+            const wstring key = TextureKey(path);
             const uint64 numLoaded = materialTextures.Count();
             for(uint64 i = 0; i < numLoaded; ++i)
             {
-                if(materialTextures[i]->Name == path)
+                if(textureKeys[i] == key)
                 {
                     material.Textures[texType] = &materialTextures[i]->Texture;
                     material.TextureIndices[texType] = uint32(i);
@@ -105,15 +125,33 @@ static void LoadMaterialResources(Array<MeshMaterial>& materials, const wstring&
             {
                 MaterialTexture* newMatTexture = new MaterialTexture();
                 newMatTexture->Name = path;
-                bool useSRGB = forceSRGB && texType == uint64(MaterialTextures::Albedo);
-                LoadTexture(newMatTexture->Texture, path.c_str(), useSRGB ? true : false);
                 uint64 idx = materialTextures.Add(newMatTexture);
+                textureKeys.Add(key);
+
+                TextureLoadRequest& request = loadRequests.Add();
+                request.Texture = &newMatTexture->Texture;
+                request.ForceSRGB = forceSRGB && texType == uint64(MaterialTextures::Albedo);
 
                 material.Textures[texType] = &newMatTexture->Texture;
                 material.TextureIndices[texType] = uint32(idx);
             }
         }
     }
+
+    // The names can't be pointed to until the list is done growing
+    const uint64 firstNewTexture = materialTextures.Count() - loadRequests.Count();
+    for(uint64 i = 0; i < loadRequests.Count(); ++i)
+        loadRequests[i].FilePath = materialTextures[firstNewTexture + i]->Name.c_str();
+
+    TextureLoadStats loadStats;
+    LoadTextures(loadRequests.Data(), loadRequests.Count(), &loadStats);
+
+    if(loadStats.NumTextures > 0)
+        WriteLog("Loaded %llu textures in %.2fms (%llu from the cache, %.2f MB in %llu uploads)", loadStats.NumTextures, loadStats.LoadTimeMS,
+                 loadStats.NumCacheHits, loadStats.UploadBytes / (1024.0 * 1024.0), loadStats.NumUploads);
+
+    textureKeys.Shutdown();
+    loadRequests.Shutdown();
 }
 
 static void TransformVertex(MeshVertex& v, const Float3& p, const Float3& s, const Quaternion& q)
@@ -127,25 +165,180 @@ static void TransformVertex(MeshVertex& v, const Float3& p, const Float3& s, con
     v.Bitangent = Float3::Transform(v.Bitangent, q);
 }
 
-static const uint64 CacheVersion = 6;
+static const uint64 CacheVersion = 7;
 static const wchar* CacheDir = L"ModelCache";
 
-static wstring MakeModelCachePath(ModelLoadSettings settings)
+// Maps a source file + load settings to the hash of its contents, so that the (potentially huge)
+// source file only needs to be read and hashed again when its size or timestamp changes
+struct ModelCacheIndexEntry
+{
+    wstring FilePath;
+    uint64 FileSize = 0;
+    uint64 Timestamp = 0;
+    Hash SettingsHash;
+    Hash ContentHash;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, FilePath);
+        SerializeItem(serializer, FileSize);
+        SerializeItem(serializer, Timestamp);
+        SerializeItem(serializer, SettingsHash.A);
+        SerializeItem(serializer, SettingsHash.B);
+        SerializeItem(serializer, ContentHash.A);
+        SerializeItem(serializer, ContentHash.B);
+    }
+};
+
+static const uint64 CacheIndexVersion = 1;
+static List<ModelCacheIndexEntry> CacheIndex;
+static bool CacheIndexLoaded = false;
+static SRWLOCK CacheIndexLock = SRWLOCK_INIT;
+
+static wstring CacheIndexPath()
+{
+    return MakeString(L"%ls\\CacheIndex.bin", CacheDir);
+}
+
+// Needs to be called with CacheIndexLock held
+static void LoadCacheIndex()
+{
+    CacheIndexLoaded = true;
+
+    const wstring indexPath = CacheIndexPath();
+    if(FileExists(indexPath.c_str()) == false)
+        return;
+
+    try
+    {
+        BufferedFileReadSerializer serializer(indexPath.c_str());
+        uint64 version = 0;
+        SerializeItem(serializer, version);
+        if(version == CacheIndexVersion)
+            SerializeItem(serializer, CacheIndex);
+    }
+    catch(Exception&)
+    {
+        // A truncated or corrupt index just means that the source files get re-hashed
+        CacheIndex.Shutdown();
+    }
+}
+
+// Needs to be called with CacheIndexLock held. The index is written to a temporary file first, so
+// that a failed write can't leave a truncated index behind.
+static void SaveCacheIndex()
 {
-    Array<uint8> fileData;
-    ReadFileAsByteArray(settings.FilePath, fileData);
+    if(CreateDirectory(CacheDir, nullptr) == false && GetLastError() != ERROR_ALREADY_EXISTS)
+        throw Win32Exception(GetLastError());
+
+    const wstring indexPath = CacheIndexPath();
+    const wstring tempPath = indexPath + L".tmp";
+    {
+        BufferedFileWriteSerializer serializer(tempPath.c_str());
+        uint64 version = CacheIndexVersion;
+        SerializeItem(serializer, version);
+        SerializeItem(serializer, CacheIndex);
+        serializer.Flush();
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), indexPath.c_str(), MOVEFILE_REPLACE_EXISTING));
+}
+
+static wstring MakeModelCachePath(const ModelLoadSettings& settings)
+{
+    const wstring filePath = settings.FilePath;
 
     Hash settingsHash = GenerateHash(settings.FilePath, int32(wcslen(settings.FilePath)));
     if(settings.TextureDir != nullptr)
         settingsHash = CombineHashes(settingsHash, GenerateHash(settings.TextureDir, int32(wcslen(settings.TextureDir))));
 
-    settings.FilePath = nullptr;
-    settings.TextureDir = nullptr;
-    settingsHash = CombineHashes(settingsHash, GenerateHash(&settings, sizeof(settings)));
+    const bool multiThreadedHash = settings.MultiThreadedHash;
+    const wchar* extension = settings.CompressedCache ? L"modelcachez" : L"modelcache";
+
+    // Only hash the settings that change the cached data, one field at a time so that the
+    // struct's padding bytes don't end up in the key
+    const uint8 settingsFlags[] =
+    {
+        uint8(settings.ForceSRGB),
+        uint8(settings.MergeMeshes),
+        uint8(settings.ConvertFromZUp),
+        uint8(settings.GenerateMeshlets),
+    };
+    settingsHash = CombineHashes(settingsHash, GenerateHash(&settings.SceneScale, sizeof(settings.SceneScale)));
+    settingsHash = CombineHashes(settingsHash, GenerateHash(settingsFlags, sizeof(settingsFlags)));
+
+    const uint64 fileSize = GetFileSizeInBytes(filePath.c_str());
+    const uint64 timestamp = GetFileTimestamp(filePath.c_str());
+
+    // Check the index first, which lets us skip hashing the source file entirely
+    Hash modelHash;
+    bool foundInIndex = false;
 
-    Hash modelHash = GenerateHash(fileData.Data(), int32(fileData.Size()));
+    AcquireSRWLockExclusive(&CacheIndexLock);
 
-    return MakeString(L"%ls\\%ls_%ls_%llu.modelcache", CacheDir, settingsHash.ToString().c_str(), modelHash.ToString().c_str(), CacheVersion);
+    try
+    {
+        if(CacheIndexLoaded == false)
+            LoadCacheIndex();
+
+        for(const ModelCacheIndexEntry& entry : CacheIndex)
+        {
+            if(entry.FilePath == filePath && entry.SettingsHash == settingsHash &&
+               entry.FileSize == fileSize && entry.Timestamp == timestamp)
+            {
+                modelHash = entry.ContentHash;
+                foundInIndex = true;
+                break;
+            }
+        }
+    }
+    catch(...)
+    {
+        ReleaseSRWLockExclusive(&CacheIndexLock);
+        throw;
+    }
+
+    ReleaseSRWLockExclusive(&CacheIndexLock);
+
+    if(foundInIndex == false)
+    {
+        // The file is new or has been touched since we last saw it, so hash the contents
+        modelHash = GenerateFileHash(filePath.c_str(), multiThreadedHash);
+
+        AcquireSRWLockExclusive(&CacheIndexLock);
+
+        try
+        {
+            ModelCacheIndexEntry* indexEntry = nullptr;
+            for(ModelCacheIndexEntry& entry : CacheIndex)
+            {
+                if(entry.FilePath == filePath && entry.SettingsHash == settingsHash)
+                    indexEntry = &entry;
+            }
+
+            if(indexEntry == nullptr)
+            {
+                indexEntry = &CacheIndex.Add();
+                indexEntry->FilePath = filePath;
+                indexEntry->SettingsHash = settingsHash;
+            }
+
+            indexEntry->FileSize = fileSize;
+            indexEntry->Timestamp = timestamp;
+            indexEntry->ContentHash = modelHash;
+
+            SaveCacheIndex();
+        }
+        catch(...)
+        {
+            ReleaseSRWLockExclusive(&CacheIndexLock);
+            throw;
+        }
+
+        ReleaseSRWLockExclusive(&CacheIndexLock);
+    }
+
+    return MakeString(L"%ls\\%ls_%ls_%llu.%ls", CacheDir, settingsHash.ToString().c_str(), modelHash.ToString().c_str(), CacheVersion, extension);
 }
 
 void Mesh::InitFromAssimpMesh(const aiMesh& assimpMesh, const ModelLoadSettings& loadSettings, MeshVertex* dstVertices, uint8* dstIndices, IndexType indexType_, const Float4x4& transform)
@@ -461,6 +654,22 @@ static void GatherMeshTransforms(const aiNode* node, const Float4x4& baseTransfo
         GatherMeshTransforms(node->mChildren[i], nodeTransform, meshTransforms);
 }
 
+uint32 AssimpPostProcessFlags(const ModelLoadSettings& settings)
+{
+    uint32 flags = aiProcess_CalcTangentSpace |
+                   aiProcess_Triangulate |
+                   aiProcess_JoinIdenticalVertices |
+                   aiProcess_MakeLeftHanded |
+                   aiProcess_RemoveRedundantMaterials |
+                   aiProcess_FlipUVs |
+                   aiProcess_FlipWindingOrder;
+
+    if(settings.MergeMeshes)
+        flags |= aiProcess_PreTransformVertices | aiProcess_OptimizeMeshes;
+
+    return flags;
+}
+
 // == Model =======================================================================================
 
 void Model::CreateWithAssimp(const ModelLoadSettings& settings)
@@ -474,10 +683,17 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
     if(FileExists(cachePath.c_str()))
     {
         WriteLog("Loading scene '%ls' from cache...", filePath);
-        CreateFromMeshData(cachePath.c_str());
-        WriteLog("Finished loading scene");
+        const bool loaded = settings.CompressedCache ? LoadCompressedCacheData(cachePath.c_str()) : LoadMappedCacheData(cachePath.c_str());
+        if(loaded)
+        {
+            CreateBuffers(geometry);
+            LoadMaterialResources(meshMaterials, textureDirectory, forceSRGB, materialTextures);
+            WriteLog("Finished loading scene");
 
-        return;
+            return;
+        }
+
+        WriteLog("Model cache '%ls' is invalid, re-importing the scene", cachePath.c_str());
     }
 
     WriteLog("Loading scene '%ls' with Assimp...", filePath);
@@ -546,18 +762,7 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
     pointLights.Resize(numPointLights);
 
     // Post-process the scene
-    uint32 flags = aiProcess_CalcTangentSpace |
-                   aiProcess_Triangulate |
-                   aiProcess_JoinIdenticalVertices |
-                   aiProcess_MakeLeftHanded |
-                   aiProcess_RemoveRedundantMaterials |
-                   aiProcess_FlipUVs |
-                   aiProcess_FlipWindingOrder;
-
-    if(settings.MergeMeshes)
-        flags |= aiProcess_PreTransformVertices | aiProcess_OptimizeMeshes;
-
-    scene = importer.ApplyPostProcessing(flags);
+    scene = importer.ApplyPostProcessing(AssimpPostProcessFlags(settings));
 
     // Load the materials
     const uint64 numMaterials = scene->mNumMaterials;
@@ -601,15 +806,40 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
     textureDirectory = settings.TextureDir ? fileDirectory + L"\\" + settings.TextureDir + L"\\" : fileDirectory;
     LoadMaterialResources(meshMaterials, textureDirectory, settings.ForceSRGB, materialTextures);
 
+    ImportMeshes(*scene, settings, settings.NumImportThreads);
+
+    if(settings.GenerateMeshlets)
+        GenerateMeshlets(settings.NumImportThreads);
+
+    CreateBuffers(OwnedGeometry());
+
+    WriteLog("Finished loading scene '%ls'", filePath);
+
+    if(DirectoryExists(CacheDir) == false)
+        Win32Call(CreateDirectory(CacheDir, nullptr));
+
+    if(settings.CompressedCache)
+        WriteCompressedCache(cachePath.c_str());
+    else
+        WriteMappedCache(cachePath.c_str());
+}
+
+void Model::ImportMeshes(const aiScene& scene, const ModelLoadSettings& settings, uint32 maxThreads)
+{
     indexType = IndexType::Index16Bit;
 
-    // Initialize the meshes
-    const uint64 numMeshes = scene->mNumMeshes;
+    // Compute the offsets of every mesh up-front, so that the meshes can be initialized independently
+    const uint64 numMeshes = scene.mNumMeshes;
+    Array<uint64> meshVtxOffsets(numMeshes);
+    Array<uint64> meshIdxOffsets(numMeshes);
     uint64 numVertices = 0;
     uint64 numIndices = 0;
     for(uint64 i = 0; i < numMeshes; ++i)
     {
-        const aiMesh& assimpMesh = *scene->mMeshes[i];
+        const aiMesh& assimpMesh = *scene.mMeshes[i];
+
+        meshVtxOffsets[i] = numVertices;
+        meshIdxOffsets[i] = numIndices;
 
         numVertices += assimpMesh.mNumVertices;
         numIndices += assimpMesh.mNumFaces * 3;
@@ -623,7 +853,7 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
     if(settings.MergeMeshes == false)
     {
         Float4x4 rootTransform;
-        GatherMeshTransforms(scene->mRootNode, rootTransform, meshTransforms);
+        GatherMeshTransforms(scene.mRootNode, rootTransform, meshTransforms);
     }
 
     const uint64 indexSize = indexType == IndexType::Index32Bit ? 4 : 2;
@@ -632,51 +862,303 @@ void Model::CreateWithAssimp(const ModelLoadSettings& settings)
     indices.Init(numIndices * indexSize);
     meshes.Init(numMeshes);
 
-    aabbMin = FloatMax;
-    aabbMax = -FloatMax;
-
-    uint64 vtxOffset = 0;
-    uint64 idxOffset = 0;
-    for(uint64 i = 0; i < numMeshes; ++i)
+    Jobs::ParallelFor(numMeshes, [&](uint64 i)
     {
-        meshes[i].InitFromAssimpMesh(*scene->mMeshes[i], settings, &vertices[vtxOffset], &indices[idxOffset], indexType, meshTransforms[i]);
+        const uint64 vtxOffset = meshVtxOffsets[i];
+        const uint64 idxOffset = meshIdxOffsets[i] * indexSize;
+        meshes[i].InitFromAssimpMesh(*scene.mMeshes[i], settings, &vertices[vtxOffset], &indices[idxOffset], indexType, meshTransforms[i]);
         meshes[i].vtxOffset = uint32(vtxOffset);
         meshes[i].idxOffset = uint32(idxOffset);
+    }, maxThreads);
 
+    aabbMin = FloatMax;
+    aabbMax = -FloatMax;
+    for(uint64 i = 0; i < numMeshes; ++i)
+    {
         aabbMin = Min(aabbMin, meshes[i].AABBMin());
         aabbMax = Max(aabbMax, meshes[i].AABBMax());
+    }
+}
 
-        vtxOffset += meshes[i].NumVertices();
-        idxOffset += meshes[i].NumIndices() * indexSize;
+void Model::CreateFromMeshData(const wchar* filePath)
+{
+    if(FileExists(filePath) == false)
+        throw Exception(MakeString(L"Model file with path '%ls' does not exist", filePath));
+
+    BufferedFileReadSerializer serializer(filePath);
+    Serialize(serializer);
+
+    CreateBuffers(OwnedGeometry());
+
+    LoadMaterialResources(meshMaterials, textureDirectory, forceSRGB, materialTextures);
+}
+
+void Model::CreateFromMappedCache(const wchar* filePath)
+{
+    if(FileExists(filePath) == false)
+        throw Exception(MakeString(L"Model cache with path '%ls' does not exist", filePath));
+
+    if(LoadMappedCacheData(filePath) == false)
+        throw Exception(MakeString(L"Model cache with path '%ls' is invalid or out of date", filePath));
+
+    CreateBuffers(geometry);
+
+    LoadMaterialResources(meshMaterials, textureDirectory, forceSRGB, materialTextures);
+}
+
+void Model::WriteMappedCache(const wchar* filePath)
+{
+    const ModelGeometry& geo = geometry;
+    Assert_(geo.Vertices != nullptr);
+
+    ComputeSizeSerializer sizeSerializer;
+    SerializeMetadata(sizeSerializer);
+
+    MappedCacheHeader header;
+    header.Magic = MappedCacheMagic;
+    header.Version = CacheVersion;
+    header.MetadataOffset = sizeof(MappedCacheHeader);
+    header.MetadataSize = sizeSerializer.Size();
+
+    const void* blockData[uint64(MappedCacheBlocks::Count)] =
+    {
+        geo.Vertices,
+        geo.Indices,
+        geo.Meshlets,
+        geo.MeshletVertices,
+        geo.MeshletTriangles,
+        geo.MeshletBoundingSpheres,
+    };
+
+    const uint64 blockSizes[uint64(MappedCacheBlocks::Count)] =
+    {
+        geo.NumVertices * sizeof(MeshVertex),
+        geo.IndexDataSize,
+        geo.NumMeshlets * sizeof(Meshlet),
+        geo.NumMeshletVertices * sizeof(uint32),
+        geo.NumMeshletTriangles * sizeof(MeshletTriangle),
+        geo.NumMeshlets * sizeof(MeshletBounds),
+    };
+
+    uint64 currOffset = header.MetadataOffset + header.MetadataSize;
+    for(uint64 i = 0; i < uint64(MappedCacheBlocks::Count); ++i)
+    {
+        currOffset = AlignTo(currOffset, MappedCacheBlockAlignment);
+        header.Blocks[i].Offset = currOffset;
+        header.Blocks[i].Size = blockSizes[i];
+        currOffset += blockSizes[i];
     }
 
-    if(settings.GenerateMeshlets)
-        GenerateMeshlets();
+    static const uint8 Padding[MappedCacheBlockAlignment] = { };
 
-    CreateBuffers();
+    // Written to a temporary file first, so that a failed write can't leave a truncated cache behind
+    const wstring tempPath = wstring(filePath) + L".tmp";
+    {
+        BufferedFileWriteSerializer serializer(tempPath.c_str());
+        serializer.SerializeItem(header);
+        SerializeMetadata(serializer);
 
-    WriteLog("Finished loading scene '%ls'", filePath);
+        currOffset = header.MetadataOffset + header.MetadataSize;
+        for(uint64 i = 0; i < uint64(MappedCacheBlocks::Count); ++i)
+        {
+            const uint64 paddingSize = header.Blocks[i].Offset - currOffset;
+            if(paddingSize > 0)
+                serializer.SerializeData(paddingSize, Padding);
 
-    if(DirectoryExists(CacheDir) == false)
-        Win32Call(CreateDirectory(CacheDir, nullptr));
+            if(blockSizes[i] > 0)
+                serializer.SerializeData(blockSizes[i], blockData[i]);
 
-    FileWriteSerializer serializer(cachePath.c_str());
-    Serialize(serializer);
+            currOffset = header.Blocks[i].Offset + blockSizes[i];
+        }
+
+        serializer.Flush();
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), filePath, MOVEFILE_REPLACE_EXISTING));
 }
 
-void Model::CreateFromMeshData(const wchar* filePath)
+void Model::CreateFromCompressedCache(const wchar* filePath)
 {
     if(FileExists(filePath) == false)
-        throw Exception(MakeString(L"Model file with path '%ls' does not exist", filePath));
+        throw Exception(MakeString(L"Model cache with path '%ls' does not exist", filePath));
 
-    FileReadSerializer serializer(filePath);
-    Serialize(serializer);
+    if(LoadCompressedCacheData(filePath) == false)
+        throw Exception(MakeString(L"Model cache with path '%ls' is invalid or out of date", filePath));
 
-    CreateBuffers();
+    CreateBuffers(geometry);
 
     LoadMaterialResources(meshMaterials, textureDirectory, forceSRGB, materialTextures);
 }
 
+void Model::WriteCompressedCache(const wchar* filePath)
+{
+    // Mapped geometry needs to be copied first, since Serialize() works on the model's own arrays
+    if(cacheMapping.IsOpen())
+        CopyMappedGeometry();
+
+    CompressedWriteSerializer serializer(filePath, CacheVersion);
+    Serialize(serializer);
+    serializer.Close();
+}
+
+// Decompresses the whole cache into the model's own arrays. Returns false if the file is truncated,
+// corrupted, or was written by an older version of the cache.
+bool Model::LoadCompressedCacheData(const wchar* filePath)
+{
+    try
+    {
+        CompressedReadSerializer serializer(filePath, CacheVersion);
+        Serialize(serializer);
+    }
+    catch(Exception& exception)
+    {
+        WriteLog(L"%ls", exception.GetMessage().c_str());
+        return false;
+    }
+
+    geometry = OwnedGeometry();
+    return true;
+}
+
+// Maps the cache file and points the model's geometry directly at the data inside the mapped view.
+// Returns false if the file is truncated or was written by an older version of the cache.
+bool Model::LoadMappedCacheData(const wchar* filePath)
+{
+    cacheMapping.Open(filePath);
+    const uint8* fileData = cacheMapping.Data();
+    const uint64 fileSize = cacheMapping.Size();
+
+    // The offsets and sizes are checked without adding them together, so that a corrupted
+    // header can't overflow its way past the checks
+    MappedCacheHeader header;
+    bool valid = fileSize >= sizeof(MappedCacheHeader);
+    if(valid)
+    {
+        memcpy(&header, fileData, sizeof(MappedCacheHeader));
+        valid = header.Magic == MappedCacheMagic && header.Version == CacheVersion;
+        valid = valid && header.MetadataOffset <= fileSize && header.MetadataSize <= fileSize - header.MetadataOffset;
+    }
+
+    const uint64 blockElementSizes[uint64(MappedCacheBlocks::Count)] =
+    {
+        sizeof(MeshVertex),
+        1,
+        sizeof(Meshlet),
+        sizeof(uint32),
+        sizeof(MeshletTriangle),
+        sizeof(MeshletBounds),
+    };
+
+    for(uint64 i = 0; i < uint64(MappedCacheBlocks::Count) && valid; ++i)
+    {
+        const MappedCacheBlock& block = header.Blocks[i];
+        valid = block.Offset % MappedCacheBlockAlignment == 0 && block.Offset <= fileSize && block.Size <= fileSize - block.Offset;
+        valid = valid && block.Size % blockElementSizes[i] == 0;
+    }
+
+    if(valid)
+    {
+        try
+        {
+            MemoryReadSerializer serializer(fileData + header.MetadataOffset, header.MetadataSize);
+            SerializeMetadata(serializer);
+        }
+        catch(Exception&)
+        {
+            valid = false;
+        }
+    }
+
+    const MappedCacheBlock* blocks = header.Blocks;
+    if(valid)
+    {
+        // The blocks need to hold exactly what the meshes say that they do
+        valid = indexType == IndexType::Index16Bit || indexType == IndexType::Index32Bit;
+        valid = valid && blocks[uint64(MappedCacheBlocks::Indices)].Size % IndexSize() == 0;
+
+        const uint64 numMeshlets = blocks[uint64(MappedCacheBlocks::Meshlets)].Size / sizeof(Meshlet);
+        valid = valid && blocks[uint64(MappedCacheBlocks::MeshletBounds)].Size / sizeof(MeshletBounds) == numMeshlets;
+
+        uint64 numVertices = 0;
+        uint64 numIndices = 0;
+        for(uint64 i = 0; i < meshes.Size() && valid; ++i)
+        {
+            const Mesh& mesh = meshes[i];
+            numVertices += mesh.NumVertices();
+            numIndices += mesh.NumIndices();
+            valid = uint64(mesh.MeshletOffset()) + mesh.NumMeshlets() <= numMeshlets;
+        }
+
+        valid = valid && numVertices == blocks[uint64(MappedCacheBlocks::Vertices)].Size / sizeof(MeshVertex);
+        valid = valid && numIndices * IndexSize() == blocks[uint64(MappedCacheBlocks::Indices)].Size;
+    }
+
+    if(valid == false)
+    {
+        // Don't leave partially-loaded metadata behind for whatever gets loaded instead
+        for(uint64 i = 0; i < meshes.Size(); ++i)
+            meshes[i].Shutdown();
+        meshes.Shutdown();
+        cacheMapping.Close();
+        return false;
+    }
+
+    geometry = ModelGeometry();
+    geometry.Vertices = reinterpret_cast<const MeshVertex*>(fileData + blocks[uint64(MappedCacheBlocks::Vertices)].Offset);
+    geometry.NumVertices = blocks[uint64(MappedCacheBlocks::Vertices)].Size / sizeof(MeshVertex);
+    geometry.Indices = fileData + blocks[uint64(MappedCacheBlocks::Indices)].Offset;
+    geometry.IndexDataSize = blocks[uint64(MappedCacheBlocks::Indices)].Size;
+    geometry.Meshlets = reinterpret_cast<const Meshlet*>(fileData + blocks[uint64(MappedCacheBlocks::Meshlets)].Offset);
+    geometry.NumMeshlets = blocks[uint64(MappedCacheBlocks::Meshlets)].Size / sizeof(Meshlet);
+    geometry.MeshletVertices = reinterpret_cast<const uint32*>(fileData + blocks[uint64(MappedCacheBlocks::MeshletVertices)].Offset);
+    geometry.NumMeshletVertices = blocks[uint64(MappedCacheBlocks::MeshletVertices)].Size / sizeof(uint32);
+    geometry.MeshletTriangles = reinterpret_cast<const MeshletTriangle*>(fileData + blocks[uint64(MappedCacheBlocks::MeshletTriangles)].Offset);
+    geometry.NumMeshletTriangles = blocks[uint64(MappedCacheBlocks::MeshletTriangles)].Size / sizeof(MeshletTriangle);
+    geometry.MeshletBoundingSpheres = reinterpret_cast<const MeshletBounds*>(fileData + blocks[uint64(MappedCacheBlocks::MeshletBounds)].Offset);
+
+    return true;
+}
+
+// Copies mapped geometry into the model's own arrays so that the mapping can be released
+void Model::CopyMappedGeometry()
+{
+    Assert_(cacheMapping.IsOpen());
+
+    vertices.Init(geometry.NumVertices);
+    memcpy(vertices.Data(), geometry.Vertices, vertices.MemorySize());
+    indices.Init(geometry.IndexDataSize);
+    memcpy(indices.Data(), geometry.Indices, indices.MemorySize());
+
+    meshlets.RemoveAll();
+    meshlets.Append(geometry.Meshlets, geometry.NumMeshlets);
+    meshletVertices.RemoveAll();
+    meshletVertices.Append(geometry.MeshletVertices, geometry.NumMeshletVertices);
+    meshletTriangles.RemoveAll();
+    meshletTriangles.Append(geometry.MeshletTriangles, geometry.NumMeshletTriangles);
+    meshletBounds.RemoveAll();
+    meshletBounds.Append(geometry.MeshletBoundingSpheres, geometry.NumMeshlets);
+
+    geometry = OwnedGeometry();
+    cacheMapping.Close();
+}
+
+ModelGeometry Model::OwnedGeometry() const
+{
+    ModelGeometry geo;
+    geo.Vertices = vertices.Data();
+    geo.NumVertices = vertices.Size();
+    geo.Indices = indices.Data();
+    geo.IndexDataSize = indices.Size();
+    geo.Meshlets = meshlets.Data();
+    geo.NumMeshlets = meshlets.Count();
+    geo.MeshletVertices = meshletVertices.Data();
+    geo.NumMeshletVertices = meshletVertices.Count();
+    geo.MeshletTriangles = meshletTriangles.Data();
+    geo.NumMeshletTriangles = meshletTriangles.Count();
+    geo.MeshletBoundingSpheres = meshletBounds.Data();
+    return geo;
+}
+
 void Model::GenerateBoxScene(const BoxSceneInit& init)
 {
     meshMaterials.Init(1);
@@ -700,7 +1182,7 @@ void Model::GenerateBoxScene(const BoxSceneInit& init)
     if(init.GenerateMeshlets)
         GenerateMeshlets();
 
-    CreateBuffers();
+    CreateBuffers(OwnedGeometry());
 }
 
 void Model::GenerateBoxTestScene(const BoxTestSceneInit& init)
@@ -734,7 +1216,7 @@ void Model::GenerateBoxTestScene(const BoxTestSceneInit& init)
     if(init.GenerateMeshlets)
         GenerateMeshlets();
 
-    CreateBuffers();
+    CreateBuffers(OwnedGeometry());
 }
 
 void Model::GeneratePlaneScene(const PlaneSceneInit& init)
@@ -760,7 +1242,7 @@ void Model::GeneratePlaneScene(const PlaneSceneInit& init)
     if(init.GenerateMeshlets)
         GenerateMeshlets();
 
-    CreateBuffers();
+    CreateBuffers(OwnedGeometry());
 }
 
 void Model::CreateProcedural(const ProceduralModelInit& init)
@@ -822,64 +1304,99 @@ void Model::CreateProcedural(const ProceduralModelInit& init)
     if(init.GenerateMeshlets)
         GenerateMeshlets();
 
-    CreateBuffers();
+    CreateBuffers(OwnedGeometry());
 }
 
-void Model::GenerateMeshlets()
+void Model::GenerateMeshlets(uint32 maxThreads)
 {
     Assert_(meshes.Size() > 0);
 
-    // Calculate the upper bounds on the number of meshlets
-    uint32 maxMeshlets = 0;
-    Array<uint32> maxMeshletsPerMesh(meshes.Size(), 0);
-    for(uint32 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+    const uint64 numMeshes = meshes.Size();
+
+    // Build the meshlets for each mesh into its own scratch memory. The meshes are independent of
+    // each other here, so this can be spread across threads.
+    struct MeshletBuildData
+    {
+        Array<meshopt_Meshlet> Meshlets;
+        Array<uint32> Vertices;
+        Array<uint8> Triangles;
+        uint32 NumMeshlets = 0;
+        uint32 NumVertices = 0;
+        uint32 NumTriangles = 0;
+    };
+
+    Array<MeshletBuildData> buildData(numMeshes);
+    Jobs::ParallelFor(numMeshes, [&](uint64 meshIdx)
     {
         const Mesh& mesh = meshes[meshIdx];
-        maxMeshletsPerMesh[meshIdx] = uint32(meshopt_buildMeshletsBound(mesh.NumIndices(), MaxMeshletVertices, MaxMeshletTriangles));
-        maxMeshlets += maxMeshletsPerMesh[meshIdx];
-    }
+        MeshletBuildData& meshData = buildData[meshIdx];
+
+        const uint64 maxMeshletsForThisMesh = meshopt_buildMeshletsBound(mesh.NumIndices(), MaxMeshletVertices, MaxMeshletTriangles);
+        meshData.Meshlets.Init(maxMeshletsForThisMesh);
+        memset(meshData.Meshlets.Data(), 0, meshData.Meshlets.MemorySize());
+        meshData.Vertices.Init(maxMeshletsForThisMesh * MaxMeshletVertices, 0xFFFFFFFF);
+        meshData.Triangles.Init(maxMeshletsForThisMesh * MaxMeshletTriangles * 3, 0);
 
-    meshlets.Init(maxMeshlets, maxMeshlets);
-    meshletVertices.Init(maxMeshlets * MaxMeshletVertices, maxMeshlets * MaxMeshletVertices, 0xFFFFFFFF);
-    meshletTriangles.Init(maxMeshlets * MaxMeshletTriangles, maxMeshlets * MaxMeshletTriangles);
-    meshletBounds.Init(maxMeshlets, maxMeshlets);
+        size_t numMeshMeshlets = 0;
+        if(mesh.IndexBufferType() == IndexType::Index32Bit)
+            numMeshMeshlets = meshopt_buildMeshlets(meshData.Meshlets.Data(), meshData.Vertices.Data(), meshData.Triangles.Data(), mesh.Indices32(), mesh.NumIndices(), (float*)mesh.Vertices(), mesh.NumVertices(), sizeof(MeshVertex), MaxMeshletVertices, MaxMeshletTriangles, 0.0f);
+        else
+            numMeshMeshlets = meshopt_buildMeshlets(meshData.Meshlets.Data(), meshData.Vertices.Data(), meshData.Triangles.Data(), mesh.Indices(), mesh.NumIndices(), (float*)mesh.Vertices(), mesh.NumVertices(), sizeof(MeshVertex), MaxMeshletVertices, MaxMeshletTriangles, 0.0f);
 
-    List<Float3> meshletPositions;
+        meshData.NumMeshlets = uint32(numMeshMeshlets);
+        for(uint64 meshletIdx = 0; meshletIdx < numMeshMeshlets; ++meshletIdx)
+        {
+            meshData.NumVertices += meshData.Meshlets[meshletIdx].vertex_count;
+            meshData.NumTriangles += meshData.Meshlets[meshletIdx].triangle_count;
+        }
+    }, maxThreads);
 
-    // Build the meshlets
+    // Prefix sum to figure out where each mesh's meshlets go in the combined lists
+    Array<uint32> meshVertexOffsets(numMeshes);
+    Array<uint32> meshTriangleOffsets(numMeshes);
     uint32 globalMeshletOffset = 0;
     uint32 globalVertexOffset = 0;
     uint32 globalTriangleOffset = 0;
-    for(uint32 meshIdx = 0; meshIdx < meshes.Size(); ++meshIdx)
+    for(uint64 meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
     {
         Mesh& mesh = meshes[meshIdx];
-        const MeshVertex* meshVertices = mesh.Vertices();
-
-        const uint32 maxMeshletsForThisMesh = maxMeshletsPerMesh[meshIdx];
-        Array<meshopt_Meshlet> meshOptMeshlets(maxMeshletsForThisMesh);
-        memset(meshOptMeshlets.Data(), 0, meshOptMeshlets.MemorySize());
+        mesh.numMeshlets = buildData[meshIdx].NumMeshlets;
+        mesh.meshletOffset = globalMeshletOffset;
+        meshVertexOffsets[meshIdx] = globalVertexOffset;
+        meshTriangleOffsets[meshIdx] = globalTriangleOffset;
+
+        globalMeshletOffset += buildData[meshIdx].NumMeshlets;
+        globalVertexOffset += buildData[meshIdx].NumVertices;
+        globalTriangleOffset += buildData[meshIdx].NumTriangles;
+    }
 
-        Array<uint8> meshOptTriangles(maxMeshletsForThisMesh * MaxMeshletTriangles, 0);
+    meshlets.Init(globalMeshletOffset, globalMeshletOffset);
+    meshletVertices.Init(globalVertexOffset, globalVertexOffset);
+    meshletTriangles.Init(globalTriangleOffset, globalTriangleOffset);
+    meshletBounds.Init(globalMeshletOffset, globalMeshletOffset);
 
-        size_t numMeshMeshlets = 0;
-        if(mesh.IndexBufferType() == IndexType::Index32Bit)
-            numMeshMeshlets = meshopt_buildMeshlets(meshOptMeshlets.Data(), &meshletVertices[globalVertexOffset], meshOptTriangles.Data(), mesh.Indices32(), mesh.NumIndices(), (float*)meshVertices, mesh.NumVertices(), sizeof(MeshVertex), MaxMeshletVertices, MaxMeshletTriangles, 0.0f);
-        else
-            numMeshMeshlets = meshopt_buildMeshlets(meshOptMeshlets.Data(), &meshletVertices[globalVertexOffset], meshOptTriangles.Data(), mesh.Indices(), mesh.NumIndices(), (float*)meshVertices, mesh.NumVertices(), sizeof(MeshVertex), MaxMeshletVertices, MaxMeshletTriangles, 0.0f);
+    // Fill in the final meshlet data, which once again is independent per-mesh
+    Jobs::ParallelFor(numMeshes, [&](uint64 meshIdx)
+    {
+        const Mesh& mesh = meshes[meshIdx];
+        const MeshletBuildData& meshData = buildData[meshIdx];
+        const MeshVertex* meshVertices = mesh.Vertices();
+        const uint32 meshVertexOffset = meshVertexOffsets[meshIdx];
+        const uint32 meshMeshletOffset = mesh.meshletOffset;
 
-        mesh.numMeshlets = uint32(numMeshMeshlets);
-        mesh.meshletOffset = uint32(globalMeshletOffset);
+        if(meshData.NumVertices > 0)
+            memcpy(&meshletVertices[meshVertexOffset], meshData.Vertices.Data(), meshData.NumVertices * sizeof(uint32));
 
+        List<Float3> meshletPositions;
         uint32 localTriangleOffset = 0;
-        uint32 localVertexOffset = 0;
 
-        for(uint32 meshMeshletIdx = 0; meshMeshletIdx < numMeshMeshlets; ++meshMeshletIdx)
+        for(uint32 meshMeshletIdx = 0; meshMeshletIdx < meshData.NumMeshlets; ++meshMeshletIdx)
         {
-            const meshopt_Meshlet& srcMeshlet = meshOptMeshlets[meshMeshletIdx];
-            Meshlet& dstMeshlet = meshlets[meshMeshletIdx + globalMeshletOffset];
+            const meshopt_Meshlet& srcMeshlet = meshData.Meshlets[meshMeshletIdx];
+            Meshlet& dstMeshlet = meshlets[meshMeshletIdx + meshMeshletOffset];
 
-            dstMeshlet.VertexOffset = uint32(srcMeshlet.vertex_offset + globalVertexOffset);
-            dstMeshlet.TriangleOffset = uint32(localTriangleOffset + globalTriangleOffset);
+            dstMeshlet.VertexOffset = uint32(srcMeshlet.vertex_offset + meshVertexOffset);
+            dstMeshlet.TriangleOffset = uint32(localTriangleOffset + meshTriangleOffsets[meshIdx]);
             dstMeshlet.VertexCount = SafeCast<uint16>(srcMeshlet.vertex_count);
             dstMeshlet.TriangleCount = SafeCast<uint16>(srcMeshlet.triangle_count);
 
@@ -890,9 +1407,9 @@ void Model::GenerateMeshlets()
 
             for(uint32 triIdx = 0; triIdx < srcMeshlet.triangle_count; ++triIdx)
             {
-                const uint32 v0 = meshOptTriangles[srcMeshlet.triangle_offset + triIdx * 3 + 0];
-                const uint32 v1 = meshOptTriangles[srcMeshlet.triangle_offset + triIdx * 3 + 1];
-                const uint32 v2 = meshOptTriangles[srcMeshlet.triangle_offset + triIdx * 3 + 2];
+                const uint32 v0 = meshData.Triangles[srcMeshlet.triangle_offset + triIdx * 3 + 0];
+                const uint32 v1 = meshData.Triangles[srcMeshlet.triangle_offset + triIdx * 3 + 1];
+                const uint32 v2 = meshData.Triangles[srcMeshlet.triangle_offset + triIdx * 3 + 2];
                 meshletTriangles[dstMeshlet.TriangleOffset + triIdx].Packed = v0 | (v1 << 8) | (v2 << 16);
             }
 
@@ -900,28 +1417,20 @@ void Model::GenerateMeshlets()
             meshletPositions.Reserve(dstMeshlet.VertexCount);
             for(uint32 meshletVertexIndex = 0; meshletVertexIndex < dstMeshlet.VertexCount; ++meshletVertexIndex)
             {
-                const uint32 meshVertexIndex = meshletVertices[globalVertexOffset + meshletVertexIndex + srcMeshlet.vertex_offset];
+                const uint32 meshVertexIndex = meshData.Vertices[meshletVertexIndex + srcMeshlet.vertex_offset];
                 Assert_(meshVertexIndex < mesh.NumVertices());
                 meshletPositions.Add(meshVertices[meshVertexIndex].Position);
             }
 
             DirectX::BoundingSphere meshletSphere;
             DirectX::BoundingSphere::CreateFromPoints(meshletSphere, dstMeshlet.VertexCount, (const DirectX::XMFLOAT3*)meshletPositions.Data(), sizeof(Float3));
-            meshletBounds[meshMeshletIdx + globalMeshletOffset] = { .Center = Float3(meshletSphere.Center), .Radius = meshletSphere.Radius };
+            meshletBounds[meshMeshletIdx + meshMeshletOffset] = { .Center = Float3(meshletSphere.Center), .Radius = meshletSphere.Radius };
 
-            localVertexOffset += uint32(srcMeshlet.vertex_count);
             localTriangleOffset += uint32(srcMeshlet.triangle_count);
         }
 
-        globalMeshletOffset += uint32(numMeshMeshlets);
-        globalVertexOffset += localVertexOffset;
-        globalTriangleOffset += localTriangleOffset;
-    }
-
-    meshlets.Trim(globalMeshletOffset);
-    meshletVertices.Trim(globalVertexOffset);
-    meshletTriangles.Trim(globalTriangleOffset);
-    meshletBounds.Trim(globalMeshletOffset);
+        meshletPositions.Shutdown();
+    }, maxThreads);
 }
 
 void Model::Shutdown()
@@ -948,6 +1457,13 @@ void Model::Shutdown()
     meshletVerticesBuffer.Shutdown();
     meshletTrianglesBuffer.Shutdown();
     meshletBoundsBuffer.Shutdown();
+    meshlets.Shutdown();
+    meshletVertices.Shutdown();
+    meshletTriangles.Shutdown();
+    meshletBounds.Shutdown();
+
+    geometry = ModelGeometry();
+    cacheMapping.Close();
 }
 
 const D3D12_INPUT_ELEMENT_DESC* Model::InputElements()
@@ -965,14 +1481,16 @@ uint64 Model::NumInputElements()
     return ArraySize_(StandardInputElements);
 }
 
-void Model::CreateBuffers()
+void Model::CreateBuffers(const ModelGeometry& geometrySource)
 {
     Assert_(meshes.Size() > 0);
 
+    geometry = geometrySource;
+
     StructuredBufferInit sbInit;
     sbInit.Stride = sizeof(MeshVertex);
-    sbInit.NumElements = vertices.Size();;
-    sbInit.InitData = vertices.Data();
+    sbInit.NumElements = geometry.NumVertices;
+    sbInit.InitData = geometry.Vertices;
     sbInit.Name = L"Model Vertex Buffer";
     vertexBuffer.Initialize(sbInit);
 
@@ -980,8 +1498,8 @@ void Model::CreateBuffers()
 
     FormattedBufferInit fbInit;
     fbInit.Format = IndexBufferFormat();
-    fbInit.NumElements = indices.Size() / indexSize;
-    fbInit.InitData = indices.Data();
+    fbInit.NumElements = geometry.IndexDataSize / indexSize;
+    fbInit.InitData = geometry.Indices;
     sbInit.Name = L"Model Index Buffer";
     indexBuffer.Initialize(fbInit);
 
@@ -992,38 +1510,38 @@ void Model::CreateBuffers()
     {
         uint64 vbOffset = vtxOffset * sizeof(MeshVertex);
         uint64 ibOffset = idxOffset * indexSize;
-        meshes[i].InitCommon(&vertices[vtxOffset], &indices[ibOffset], vertexBuffer.GPUAddress + vbOffset, indexBuffer.GPUAddress + ibOffset, vtxOffset, idxOffset);
+        meshes[i].InitCommon(geometry.Vertices + vtxOffset, geometry.Indices + ibOffset, vertexBuffer.GPUAddress + vbOffset, indexBuffer.GPUAddress + ibOffset, vtxOffset, idxOffset);
 
         vtxOffset += meshes[i].NumVertices();
         idxOffset += meshes[i].NumIndices();
     }
 
-    if(meshlets.Count() > 0)
+    if(geometry.NumMeshlets > 0)
     {
         meshletBuffer.Initialize({
             .Stride = sizeof(Meshlet),
-            .NumElements = uint32(meshlets.Count()),
-            .InitData = meshlets.Data(),
+            .NumElements = uint32(geometry.NumMeshlets),
+            .InitData = geometry.Meshlets,
             .Name = L"Meshlet Buffer",
         });
 
         meshletVerticesBuffer.Initialize({
-            .NumElements = uint32(meshletVertices.Count()),
-            .InitData = meshletVertices.Data(),
+            .NumElements = uint32(geometry.NumMeshletVertices),
+            .InitData = geometry.MeshletVertices,
             .Name = L"Meshlet Vertices Buffer",
         });
 
         meshletTrianglesBuffer.Initialize({
             .Stride = sizeof(MeshletTriangle),
-            .NumElements = meshletTriangles.Count(),
-            .InitData = meshletTriangles.Data(),
+            .NumElements = geometry.NumMeshletTriangles,
+            .InitData = geometry.MeshletTriangles,
             .Name = L"Meshlet Triangles Buffer",
         });
 
         meshletBoundsBuffer.Initialize({
             .Stride = sizeof(MeshletBounds),
-            .NumElements = uint32(meshlets.Count()),
-            .InitData = meshletBounds.Data(),
+            .NumElements = uint32(geometry.NumMeshlets),
+            .InitData = geometry.MeshletBoundingSpheres,
             .Name = L"Meshlet Bounds Buffer",
         });
     }
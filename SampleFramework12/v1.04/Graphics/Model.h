@@ -18,7 +18,10 @@
 #include "GraphicsTypes.h"
 #include "..\\Shaders\Mesh_Shared.h"
 
+#include <span>
+
 struct aiMesh;
+struct aiScene;
 
 namespace SampleFramework12
 {
@@ -117,6 +120,7 @@ struct ModelLoadSettings;
 class Mesh
 {
     friend class Model;
+    friend class ModelBenchmarks;
 
 public:
 
@@ -229,6 +233,9 @@ struct ModelLoadSettings
     bool MergeMeshes = true;
     bool ConvertFromZUp = false;
     bool GenerateMeshlets = false;
+    bool MultiThreadedHash = true;  // Only used when the source file needs to be re-hashed for the cache
+    uint32 NumImportThreads = 0;    // 0 means use all job system threads, 1 imports serially
+    bool CompressedCache = false;   // Caches the model in a compressed container instead of a mapped file, for slow or network drives
 };
 
 struct ProceduralModelInit
@@ -271,8 +278,59 @@ struct PlaneSceneInit
     bool GenerateMeshlets = false;
 };
 
+// Layout of a mapped .modelcache file: the header is followed by the serialized metadata (meshes,
+// materials, lights, etc.), and then by the raw geometry blocks. Each block starts on an aligned
+// offset so that it can be referenced in place from the mapped view of the file.
+static const uint64 MappedCacheMagic = 0x45484341434C444DULL;  // "MDLCACHE"
+static const uint64 MappedCacheBlockAlignment = 64;
+
+enum class MappedCacheBlocks : uint64
+{
+    Vertices = 0,
+    Indices,
+    Meshlets,
+    MeshletVertices,
+    MeshletTriangles,
+    MeshletBounds,
+
+    Count
+};
+
+struct MappedCacheBlock
+{
+    uint64 Offset = 0;
+    uint64 Size = 0;
+};
+
+struct MappedCacheHeader
+{
+    uint64 Magic = 0;
+    uint64 Version = 0;
+    uint64 MetadataOffset = 0;
+    uint64 MetadataSize = 0;
+    MappedCacheBlock Blocks[uint64(MappedCacheBlocks::Count)];
+};
+
+// Pointers to all of the CPU-side geometry data for a model
+struct ModelGeometry
+{
+    const MeshVertex* Vertices = nullptr;
+    uint64 NumVertices = 0;
+    const uint8* Indices = nullptr;
+    uint64 IndexDataSize = 0;
+    const Meshlet* Meshlets = nullptr;
+    uint64 NumMeshlets = 0;
+    const uint32* MeshletVertices = nullptr;
+    uint64 NumMeshletVertices = 0;
+    const MeshletTriangle* MeshletTriangles = nullptr;
+    uint64 NumMeshletTriangles = 0;
+    const MeshletBounds* MeshletBoundingSpheres = nullptr;
+};
+
 class Model
 {
+    friend class ModelBenchmarks;
+
 public:
 
     ~Model()
@@ -284,6 +342,10 @@ public:
     void CreateWithAssimp(const ModelLoadSettings& settings);
 
     void CreateFromMeshData(const wchar* filePath);
+    void CreateFromMappedCache(const wchar* filePath);
+    void WriteMappedCache(const wchar* filePath);
+    void CreateFromCompressedCache(const wchar* filePath);
+    void WriteCompressedCache(const wchar* filePath);
 
     // Procedural generation
     void GenerateBoxScene(const BoxSceneInit& init);
@@ -311,18 +373,29 @@ public:
     const StructuredBuffer& VertexBuffer() const { return vertexBuffer; }
     const FormattedBuffer& IndexBuffer() const { return indexBuffer; }
 
-    const List<Meshlet>& Meshlets() const { return meshlets; }
-    const List<uint32>& MeshletVertices() const { return meshletVertices; }
-    const List<MeshletTriangle>& MeshletTriangles() const { return meshletTriangles; }
+    // Only valid if the model owns its geometry, use the spans below for a model loaded from a mapped cache
+    const List<Meshlet>& Meshlets() const { Assert_(cacheMapping.IsOpen() == false); return meshlets; }
+    const List<uint32>& MeshletVertices() const { Assert_(cacheMapping.IsOpen() == false); return meshletVertices; }
+    const List<MeshletTriangle>& MeshletTriangles() const { Assert_(cacheMapping.IsOpen() == false); return meshletTriangles; }
+
+    // These point at either the model's own geometry or the mapped cache, whichever it was loaded into
+    std::span<const Meshlet> MeshletSpan() const { return { geometry.Meshlets, geometry.NumMeshlets }; }
+    std::span<const uint32> MeshletVertexSpan() const { return { geometry.MeshletVertices, geometry.NumMeshletVertices }; }
+    std::span<const MeshletTriangle> MeshletTriangleSpan() const { return { geometry.MeshletTriangles, geometry.NumMeshletTriangles }; }
+    std::span<const MeshletBounds> MeshletBoundsSpan() const { return { geometry.MeshletBoundingSpheres, geometry.NumMeshlets }; }
+    uint64 NumMeshlets() const { return geometry.NumMeshlets; }
+    uint64 NumMeshletVertices() const { return geometry.NumMeshletVertices; }
+    uint64 NumMeshletTriangles() const { return geometry.NumMeshletTriangles; }
 
     const StructuredBuffer& MeshletBuffer() const { return meshletBuffer; }
     const RawBuffer& MeshletVerticesBuffer() const { return meshletVerticesBuffer; }
     const StructuredBuffer& MeshletTrianglesBuffer() const { return meshletTrianglesBuffer; }
     const StructuredBuffer& MeshletBoundsBuffer() const { return meshletBoundsBuffer; }
 
-    const MeshVertex* Vertices() const { return vertices.Data(); }
-    const uint16* Indices() const { Assert_(indexType == IndexType::Index16Bit); return (const uint16*)indices.Data(); }
-    const uint32* Indices32() const { Assert_(indexType == IndexType::Index32Bit); return (const uint32*)indices.Data(); }
+    const MeshVertex* Vertices() const { return geometry.Vertices; }
+    const uint16* Indices() const { Assert_(indexType == IndexType::Index16Bit); return (const uint16*)geometry.Indices; }
+    const uint32* Indices32() const { Assert_(indexType == IndexType::Index32Bit); return (const uint32*)geometry.Indices; }
+    uint64 NumVertices() const { return geometry.NumVertices; }
 
     static const D3D12_INPUT_ELEMENT_DESC* InputElements();
     static const InputElementType* InputElementTypes();
@@ -355,10 +428,33 @@ public:
         BulkSerializeItem(serializer, meshletBounds);
     }
 
+    // Everything except for the large geometry blocks, which are stored separately in a mapped cache
+    template<typename TSerializer>
+    void SerializeMetadata(TSerializer& serializer)
+    {
+        SerializeItem(serializer, meshes);
+        SerializeItem(serializer, meshMaterials);
+        BulkSerializeItem(serializer, spotLights);
+        BulkSerializeItem(serializer, pointLights);
+        SerializeItem(serializer, textureDirectory);
+        SerializeItem(serializer, forceSRGB);
+        SerializeItem(serializer, aabbMin);
+        SerializeItem(serializer, aabbMax);
+        uint32 idxType = uint32(indexType);
+        SerializeItem(serializer, idxType);
+        indexType = IndexType(idxType);
+    }
+
 protected:
 
-    void GenerateMeshlets();
-    void CreateBuffers();
+    void ImportMeshes(const aiScene& scene, const ModelLoadSettings& settings, uint32 maxThreads);
+    void GenerateMeshlets(uint32 maxThreads = 0);
+    void CreateBuffers(const ModelGeometry& geometrySource);
+
+    ModelGeometry OwnedGeometry() const;
+    bool LoadMappedCacheData(const wchar* filePath);
+    bool LoadCompressedCacheData(const wchar* filePath);
+    void CopyMappedGeometry();
 
     Array<Mesh> meshes;
     Array<MeshMaterial> meshMaterials;
@@ -386,8 +482,16 @@ protected:
     StructuredBuffer meshletBoundsBuffer;
 
     List<MaterialTexture*> materialTextures;
+
+    // CPU-side geometry that's used by the meshes and buffers, which either points at
+    // the arrays/lists above or directly into the mapped cache file
+    ModelGeometry geometry;
+    MemoryMappedFile cacheMapping;
 };
 
+// The post-processing steps that CreateWithAssimp() has Assimp run on an imported scene
+uint32 AssimpPostProcessFlags(const ModelLoadSettings& settings);
+
 void MakeSphereGeometry(uint64 uDivisions, uint64 vDivisions, StructuredBuffer& vtxBuffer, FormattedBuffer& idxBuffer);
 void MakeBoxGeometry(StructuredBuffer& vtxBuffer, FormattedBuffer& idxBuffer, float scale = 1.0f);
 void MakeConeGeometry(uint64 divisions, StructuredBuffer& vtxBuffer, FormattedBuffer& idxBuffer, Array<Float3>& positions);
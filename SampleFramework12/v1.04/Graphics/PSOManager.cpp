@@ -0,0 +1,590 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "PSOManager.h"
+#include "DX12.h"
+#include "DX12_Helpers.h"
+#include "../InterfacePointers.h"
+#include "../Jobs.h"
+#include "../Timer.h"
+#include "../Utility.h"
+
+namespace SampleFramework12
+{
+
+struct PSOEntry
+{
+    Hash Key;
+    uint64 RefCount = 0;
+
+    bool Compute = false;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC GraphicsDesc = { };
+    D3D12_COMPUTE_PIPELINE_STATE_DESC ComputeDesc = { };
+    Array<D3D12_INPUT_ELEMENT_DESC> InputElements;
+    Array<std::string> SemanticNames;
+    Array<uint8> ByteCode[5];
+
+    ID3D12PipelineState* PSO = nullptr;
+
+    // Readiness comes from the job itself, since the scheduler can still be touching it for a bit
+    // after the function returns. Entries that are created inline never launch it.
+    Job CreateJob;
+    bool Launched = false;
+};
+
+// Accumulates a description one field at a time
+class PSOHashBuilder
+{
+
+public:
+
+    template<typename T> void Add(const T& value)
+    {
+        StaticAssert_(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void Add(Hash hash)
+    {
+        Add(hash.A);
+        Add(hash.B);
+    }
+
+    void Add(const char* str)
+    {
+        str = str != nullptr ? str : "";
+        bytes.append(str, strlen(str) + 1);
+    }
+
+    void Add(const CompiledShaderPtr& shader)
+    {
+        Add(shader.Valid() ? shader->ByteCodeHash : Hash());
+    }
+
+    Hash Finish() const
+    {
+        return GenerateHash(bytes.data(), int32(bytes.length()));
+    }
+
+protected:
+
+    std::string bytes;
+};
+
+enum class PSOType : uint32
+{
+    Graphics = 0,
+    Compute = 1,
+};
+
+static void AddStencilOp(PSOHashBuilder& builder, const D3D12_DEPTH_STENCILOP_DESC& desc)
+{
+    builder.Add(desc.StencilFailOp);
+    builder.Add(desc.StencilDepthFailOp);
+    builder.Add(desc.StencilPassOp);
+    builder.Add(desc.StencilFunc);
+}
+
+Hash HashPSODesc(const GraphicsPSODesc& desc)
+{
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& d = desc.Desc;
+    Assert_(d.StreamOutput.NumEntries == 0);
+
+    PSOHashBuilder builder;
+    builder.Add(PSOType::Graphics);
+    builder.Add(DX12::RootSignatureHash(d.pRootSignature));
+    builder.Add(desc.VS);
+    builder.Add(desc.HS);
+    builder.Add(desc.DS);
+    builder.Add(desc.GS);
+    builder.Add(desc.PS);
+
+    builder.Add(d.BlendState.AlphaToCoverageEnable);
+    builder.Add(d.BlendState.IndependentBlendEnable);
+    for(const D3D12_RENDER_TARGET_BLEND_DESC& rt : d.BlendState.RenderTarget)
+    {
+        builder.Add(rt.BlendEnable);
+        builder.Add(rt.LogicOpEnable);
+        builder.Add(rt.SrcBlend);
+        builder.Add(rt.DestBlend);
+        builder.Add(rt.BlendOp);
+        builder.Add(rt.SrcBlendAlpha);
+        builder.Add(rt.DestBlendAlpha);
+        builder.Add(rt.BlendOpAlpha);
+        builder.Add(rt.LogicOp);
+        builder.Add(rt.RenderTargetWriteMask);
+    }
+    builder.Add(d.SampleMask);
+
+    const D3D12_RASTERIZER_DESC& rs = d.RasterizerState;
+    builder.Add(rs.FillMode);
+    builder.Add(rs.CullMode);
+    builder.Add(rs.FrontCounterClockwise);
+    builder.Add(rs.DepthBias);
+    builder.Add(rs.DepthBiasClamp);
+    builder.Add(rs.SlopeScaledDepthBias);
+    builder.Add(rs.DepthClipEnable);
+    builder.Add(rs.MultisampleEnable);
+    builder.Add(rs.AntialiasedLineEnable);
+    builder.Add(rs.ForcedSampleCount);
+    builder.Add(rs.ConservativeRaster);
+
+    const D3D12_DEPTH_STENCIL_DESC& ds = d.DepthStencilState;
+    builder.Add(ds.DepthEnable);
+    builder.Add(ds.DepthWriteMask);
+    builder.Add(ds.DepthFunc);
+    builder.Add(ds.StencilEnable);
+    builder.Add(ds.StencilReadMask);
+    builder.Add(ds.StencilWriteMask);
+    AddStencilOp(builder, ds.FrontFace);
+    AddStencilOp(builder, ds.BackFace);
+
+    builder.Add(d.InputLayout.NumElements);
+    for(uint32 i = 0; i < d.InputLayout.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = d.InputLayout.pInputElementDescs[i];
+        builder.Add(element.SemanticName);
+        builder.Add(element.SemanticIndex);
+        builder.Add(element.Format);
+        builder.Add(element.InputSlot);
+        builder.Add(element.AlignedByteOffset);
+        builder.Add(element.InputSlotClass);
+        builder.Add(element.InstanceDataStepRate);
+    }
+
+    builder.Add(d.IBStripCutValue);
+    builder.Add(d.PrimitiveTopologyType);
+    builder.Add(d.NumRenderTargets);
+    for(uint32 i = 0; i < d.NumRenderTargets; ++i)
+        builder.Add(d.RTVFormats[i]);
+    builder.Add(d.DSVFormat);
+    builder.Add(d.SampleDesc.Count);
+    builder.Add(d.SampleDesc.Quality);
+    builder.Add(d.NodeMask);
+    builder.Add(d.Flags);
+
+    return builder.Finish();
+}
+
+Hash HashPSODesc(const ComputePSODesc& desc)
+{
+    PSOHashBuilder builder;
+    builder.Add(PSOType::Compute);
+    builder.Add(DX12::RootSignatureHash(desc.RootSignature));
+    builder.Add(desc.CS);
+    return builder.Finish();
+}
+
+// == DX12PSODevice ===============================================================================
+
+ID3D12PipelineState* DX12PSODevice::CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    ID3D12PipelineState* pso = nullptr;
+    HRESULT hr = DX12::Device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pso));
+    return SUCCEEDED(hr) ? pso : nullptr;
+}
+
+ID3D12PipelineState* DX12PSODevice::CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    ID3D12PipelineState* pso = nullptr;
+    HRESULT hr = DX12::Device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso));
+    return SUCCEEDED(hr) ? pso : nullptr;
+}
+
+void DX12PSODevice::ReleasePSO(ID3D12PipelineState* pso)
+{
+    // The GPU might still be using it
+    DX12::DeferredRelease(pso);
+}
+
+bool DX12PSODevice::GetCachedBlob(ID3D12PipelineState* pso, Array<uint8>& blob)
+{
+    ID3DBlobPtr cachedBlob;
+    if(FAILED(pso->GetCachedBlob(&cachedBlob)) || cachedBlob->GetBufferSize() == 0)
+        return false;
+
+    blob.Init(cachedBlob->GetBufferSize());
+    memcpy(blob.Data(), cachedBlob->GetBufferPointer(), blob.Size());
+    return true;
+}
+
+Hash DX12PSODevice::CacheValidationHash()
+{
+    DXGI_ADAPTER_DESC1 adapterDesc = { };
+    DXCall(DX12::Adapter->GetDesc1(&adapterDesc));
+
+    // This is the only way to get at the user-mode driver version through DXGI
+    LARGE_INTEGER driverVersion = { };
+    DX12::Adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+
+    const uint64 adapterInfo[] = { adapterDesc.VendorId, adapterDesc.DeviceId, adapterDesc.SubSysId,
+                                   adapterDesc.Revision, uint64(driverVersion.QuadPart) };
+    return CombineHashes(GenerateHash(adapterInfo, int32(sizeof(adapterInfo))), ShaderCompilerHash());
+}
+
+// The bytecode points into the shader cache archive, which can get compacted or closed while a
+// creation job is still running
+static D3D12_SHADER_BYTECODE CopyByteCode(const CompiledShaderPtr& shader, Array<uint8>& storage)
+{
+    D3D12_SHADER_BYTECODE byteCode = { };
+    if(shader.Valid() == false || shader->ByteCodeSize == 0)
+        return byteCode;
+
+    storage.Init(shader->ByteCodeSize);
+    memcpy(storage.Data(), shader->ByteCode, shader->ByteCodeSize);
+    byteCode.pShaderBytecode = storage.Data();
+    byteCode.BytecodeLength = storage.Size();
+    return byteCode;
+}
+
+// == PSOManager ==================================================================================
+
+PSOManager::~PSOManager()
+{
+    Assert_(entries.size() == 0);
+}
+
+void PSOManager::Initialize(PSODevice* device_, const wchar* pipelineCacheDir)
+{
+    device = device_ != nullptr ? device_ : &dx12Device;
+
+    const std::wstring cacheDir = pipelineCacheDir != nullptr ? pipelineCacheDir : ShaderCacheDirectory();
+    if(cacheDir.length() > 0)
+        pipelineCache.Open(cacheDir.c_str(), device->CacheValidationHash());
+}
+
+void PSOManager::Shutdown()
+{
+    for(auto& pair : entries)
+        pair.second->RefCount = 0;
+
+    FreeUnusedEntries(true);
+    Assert_(entries.size() == 0);
+
+    if(pipelineCache.IsOpen())
+    {
+        const PipelineCacheStats cacheStats = pipelineCache.Stats();
+        WriteLog("Pipeline cache: %llu hits, %llu misses, %llu rejected", cacheStats.Hits, cacheStats.Misses, cacheStats.Rejected);
+        pipelineCache.Close();
+    }
+
+    device = nullptr;
+}
+
+PSOEntry* PSOManager::FindOrAddEntry(Hash key, bool& added)
+{
+    Assert_(device != nullptr);
+
+    // Take the opportunity to get rid of anything that was dropped since the last request
+    FreeUnusedEntries(false);
+
+    numRequests += 1;
+
+    auto existing = entries.find(key);
+    if(existing != entries.end())
+    {
+        numDeduplicated += 1;
+        existing->second->RefCount += 1;
+        added = false;
+        return existing->second;
+    }
+
+    PSOEntry* entry = new PSOEntry();
+    entry->Key = key;
+    entry->RefCount = 1;
+    entries[key] = entry;
+    added = true;
+    return entry;
+}
+
+PSOEntry* PSOManager::Acquire(const GraphicsPSODesc& desc)
+{
+    bool added = false;
+    PSOEntry* entry = FindOrAddEntry(HashPSODesc(desc), added);
+    if(added == false)
+        return entry;
+
+    // The job might outlive the caller's description, so the entry gets its own copy
+    entry->GraphicsDesc = desc.Desc;
+    entry->GraphicsDesc.VS = CopyByteCode(desc.VS, entry->ByteCode[0]);
+    entry->GraphicsDesc.HS = CopyByteCode(desc.HS, entry->ByteCode[1]);
+    entry->GraphicsDesc.DS = CopyByteCode(desc.DS, entry->ByteCode[2]);
+    entry->GraphicsDesc.GS = CopyByteCode(desc.GS, entry->ByteCode[3]);
+    entry->GraphicsDesc.PS = CopyByteCode(desc.PS, entry->ByteCode[4]);
+
+    const D3D12_INPUT_LAYOUT_DESC& inputLayout = desc.Desc.InputLayout;
+    if(inputLayout.NumElements > 0)
+    {
+        entry->InputElements.Init(inputLayout.NumElements);
+        entry->SemanticNames.Init(inputLayout.NumElements);
+        for(uint32 i = 0; i < inputLayout.NumElements; ++i)
+        {
+            entry->InputElements[i] = inputLayout.pInputElementDescs[i];
+            entry->SemanticNames[i] = inputLayout.pInputElementDescs[i].SemanticName;
+            entry->InputElements[i].SemanticName = entry->SemanticNames[i].c_str();
+        }
+        entry->GraphicsDesc.InputLayout.pInputElementDescs = entry->InputElements.Data();
+    }
+
+    Launch(entry);
+    return entry;
+}
+
+PSOEntry* PSOManager::Acquire(const ComputePSODesc& desc)
+{
+    bool added = false;
+    PSOEntry* entry = FindOrAddEntry(HashPSODesc(desc), added);
+    if(added == false)
+        return entry;
+
+    entry->Compute = true;
+    entry->ComputeDesc.pRootSignature = desc.RootSignature;
+    entry->ComputeDesc.CS = CopyByteCode(desc.CS, entry->ByteCode[0]);
+
+    Launch(entry);
+    return entry;
+}
+
+static ID3D12PipelineState* CreatePSOWithBlob(PSODevice& device, PSOEntry& entry, const uint8* blob, uint64 blobSize)
+{
+    ID3D12PipelineState* pso = nullptr;
+    if(entry.Compute)
+    {
+        entry.ComputeDesc.CachedPSO = { blob, blobSize };
+        pso = device.CreateComputePSO(entry.ComputeDesc);
+        entry.ComputeDesc.CachedPSO = { };
+    }
+    else
+    {
+        entry.GraphicsDesc.CachedPSO = { blob, blobSize };
+        pso = device.CreateGraphicsPSO(entry.GraphicsDesc);
+        entry.GraphicsDesc.CachedPSO = { };
+    }
+
+    return pso;
+}
+
+void PSOManager::CreatePSO(PSOEntry* entry)
+{
+    // A blob from an earlier run lets the driver skip compiling the pipeline
+    const uint8* cachedBlob = nullptr;
+    uint64 cachedBlobSize = 0;
+    bool useCachedBlob = pipelineCache.IsOpen() && pipelineCache.Find(entry->Key, cachedBlob, cachedBlobSize);
+
+    entry->PSO = CreatePSOWithBlob(*device, *entry, cachedBlob, cachedBlobSize);
+    if(entry->PSO == nullptr && useCachedBlob)
+    {
+        pipelineCache.Reject(entry->Key);
+        entry->PSO = CreatePSOWithBlob(*device, *entry, nullptr, 0);
+        useCachedBlob = false;
+    }
+
+    Array<uint8> blob;
+    if(entry->PSO != nullptr && useCachedBlob == false && pipelineCache.IsOpen() && device->GetCachedBlob(entry->PSO, blob))
+        pipelineCache.Store(entry->Key, blob.Data(), blob.Size());
+}
+
+void PSOManager::Launch(PSOEntry* entry)
+{
+    auto createPSO = [this, entry](uint64 start, uint64 end, uint32 threadIdx)
+    {
+        Timer timer;
+        CreatePSO(entry);
+        timer.Update();
+
+        createTimeUS += uint64(timer.ElapsedMicroseconds());
+        if(entry->PSO != nullptr)
+            numCreated += 1;
+        else
+        {
+            numFailed += 1;
+            WriteLog(L"Failed to create PSO %ls", entry->Key.ToString().c_str());
+        }
+    };
+
+    if(Jobs::Initialized())
+    {
+        entry->CreateJob.Init(1, createPSO);
+        entry->Launched = true;
+        entry->CreateJob.Launch();
+    }
+    else
+    {
+        createPSO(0, 1, 0);
+    }
+}
+
+void PSOManager::FreeUnusedEntries(bool waitForPending)
+{
+    for(auto it = entries.begin(); it != entries.end(); )
+    {
+        PSOEntry* entry = it->second;
+        if(entry->RefCount > 0 || (IsReady(entry) == false && waitForPending == false))
+        {
+            ++it;
+            continue;
+        }
+
+        // An entry that was dropped while its job was still running sticks around until the job
+        // finishes, which also lets a new request pick it back up in the meantime. The job always
+        // gets waited on before the entry is deleted, even if it has already finished.
+        Wait(entry);
+        if(entry->PSO != nullptr)
+            device->ReleasePSO(entry->PSO);
+
+        delete entry;
+        it = entries.erase(it);
+    }
+}
+
+void PSOManager::AddRef(PSOEntry* entry)
+{
+    Assert_(entry != nullptr && entry->RefCount > 0);
+    entry->RefCount += 1;
+}
+
+void PSOManager::Release(PSOEntry* entry)
+{
+    if(entry == nullptr)
+        return;
+
+    Assert_(entry->RefCount > 0);
+    entry->RefCount -= 1;
+    if(entry->RefCount == 0)
+        FreeUnusedEntries(false);
+}
+
+bool PSOManager::IsReady(const PSOEntry* entry) const
+{
+    Assert_(entry != nullptr);
+    return entry->CreateJob.IsComplete();
+}
+
+void PSOManager::Wait(PSOEntry* entry)
+{
+    Assert_(entry != nullptr);
+    if(entry->Launched)
+        entry->CreateJob.Wait();
+    Assert_(entry->CreateJob.IsComplete());
+}
+
+ID3D12PipelineState* PSOManager::PSO(const PSOEntry* entry) const
+{
+    Assert_(entry != nullptr);
+    return IsReady(entry) ? entry->PSO : nullptr;
+}
+
+Hash PSOManager::Key(const PSOEntry* entry) const
+{
+    Assert_(entry != nullptr);
+    return entry->Key;
+}
+
+PSOManagerStats PSOManager::Stats() const
+{
+    PSOManagerStats stats;
+    stats.NumRequests = numRequests;
+    stats.NumDeduplicated = numDeduplicated;
+    stats.NumCreated = numCreated;
+    stats.NumFailed = numFailed;
+    stats.NumLive = entries.size();
+    stats.CreateTimeMS = createTimeUS / 1000.0;
+    stats.Cache = pipelineCache.Stats();
+    return stats;
+}
+
+// == ManagedPSO ==================================================================================
+
+ManagedPSO::~ManagedPSO()
+{
+    Assert_(current == nullptr && pending == nullptr);
+}
+
+void ManagedPSO::SetPending(PSOManager& newManager, PSOEntry* entry)
+{
+    Assert_(manager == nullptr || manager == &newManager);
+    manager = &newManager;
+
+    if(entry == current || entry == pending)
+    {
+        // Either nothing changed, or we went back to the PSO that we're already using
+        if(entry == current && pending != nullptr)
+        {
+            manager->Release(pending);
+            pending = nullptr;
+        }
+        manager->Release(entry);
+        return;
+    }
+
+    // Only the latest request matters, so an older one that's still in flight gets dropped
+    if(pending != nullptr)
+        manager->Release(pending);
+    pending = entry;
+}
+
+void ManagedPSO::Request(PSOManager& newManager, const GraphicsPSODesc& desc)
+{
+    SetPending(newManager, newManager.Acquire(desc));
+}
+
+void ManagedPSO::Request(PSOManager& newManager, const ComputePSODesc& desc)
+{
+    SetPending(newManager, newManager.Acquire(desc));
+}
+
+void ManagedPSO::Release()
+{
+    if(manager == nullptr)
+        return;
+
+    manager->Release(pending);
+    manager->Release(current);
+    pending = nullptr;
+    current = nullptr;
+}
+
+ID3D12PipelineState* ManagedPSO::Get()
+{
+    if(pending != nullptr && manager->IsReady(pending))
+    {
+        if(manager->PSO(pending) != nullptr)
+        {
+            manager->Release(current);
+            current = pending;
+        }
+        else
+        {
+            manager->Release(pending);
+        }
+        pending = nullptr;
+    }
+
+    return current != nullptr ? manager->PSO(current) : nullptr;
+}
+
+ID3D12PipelineState* ManagedPSO::GetOrWait()
+{
+    if(current == nullptr && pending != nullptr)
+        manager->Wait(pending);
+
+    return Get();
+}
+
+void ManagedPSO::Wait()
+{
+    if(pending != nullptr)
+        manager->Wait(pending);
+
+    Get();
+}
+
+}
\ No newline at end of file
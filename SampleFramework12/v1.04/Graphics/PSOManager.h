@@ -0,0 +1,178 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\Containers.h"
+#include "..\\MurmurHash.h"
+#include "ShaderCompilation.h"
+#include "PipelineCache.h"
+
+#include <atomic>
+#include <map>
+
+namespace SampleFramework12
+{
+
+// A graphics pipeline in terms of the framework's shaders. The bytecode fields in Desc are filled
+// in from the shaders, and the input layout gets copied when the PSO is requested.
+struct GraphicsPSODesc
+{
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc = { };
+    CompiledShaderPtr VS;
+    CompiledShaderPtr HS;
+    CompiledShaderPtr DS;
+    CompiledShaderPtr GS;
+    CompiledShaderPtr PS;
+};
+
+struct ComputePSODesc
+{
+    ID3D12RootSignature* RootSignature = nullptr;
+    CompiledShaderPtr CS;
+};
+
+// Hashes the state field-by-field, so that padding never ends up in the hash. Shaders contribute
+// their ByteCodeHash, and root signatures the hash from DX12::RootSignatureHash(). Root signatures
+// that weren't made with DX12::CreateRootSignature() are hashed by address, so PSOs that use them
+// won't hit the disk cache on the next run.
+Hash HashPSODesc(const GraphicsPSODesc& desc);
+Hash HashPSODesc(const ComputePSODesc& desc);
+
+// What the PSO manager uses to actually create pipeline states. Creation happens on the job
+// threads, so implementations need to be thread-safe. CacheValidationHash() should change whenever
+// blobs from GetCachedBlob() can no longer be passed back through CachedPSO.
+class PSODevice
+{
+
+public:
+
+    virtual ~PSODevice() { }
+
+    virtual ID3D12PipelineState* CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) = 0;
+    virtual ID3D12PipelineState* CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) = 0;
+    virtual void ReleasePSO(ID3D12PipelineState* pso) = 0;
+    virtual bool GetCachedBlob(ID3D12PipelineState* pso, Array<uint8>& blob) = 0;
+    virtual Hash CacheValidationHash() = 0;
+};
+
+class DX12PSODevice : public PSODevice
+{
+
+public:
+
+    virtual ID3D12PipelineState* CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) override;
+    virtual ID3D12PipelineState* CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) override;
+    virtual void ReleasePSO(ID3D12PipelineState* pso) override;
+    virtual bool GetCachedBlob(ID3D12PipelineState* pso, Array<uint8>& blob) override;
+
+    // Adapter, driver version, and shader compiler
+    virtual Hash CacheValidationHash() override;
+};
+
+struct PSOManagerStats
+{
+    uint64 NumRequests = 0;
+    uint64 NumDeduplicated = 0;
+    uint64 NumCreated = 0;
+    uint64 NumFailed = 0;
+    uint64 NumLive = 0;
+    double CreateTimeMS = 0.0;  // summed over all job threads
+    PipelineCacheStats Cache;
+};
+
+struct PSOEntry;
+
+// Creates PSOs on the job threads. Requests are keyed by the hash of their description, so asking
+// for the same PSO more than once shares a single entry (and a single creation). Entries are
+// ref-counted, and get released through the device once nothing refers to them anymore.
+class PSOManager
+{
+
+public:
+
+    ~PSOManager();
+
+    // Uses the DX12 device if device is null. Created PSOs are cached on disk in the shader cache
+    // directory unless pipelineCacheDir says otherwise, and an empty string turns the cache off.
+    void Initialize(PSODevice* device = nullptr, const wchar* pipelineCacheDir = nullptr);
+
+    // Waits for any creations that are still running, and releases all of the PSOs
+    void Shutdown();
+
+    // These return an entry with a reference that needs to be given back with Release()
+    PSOEntry* Acquire(const GraphicsPSODesc& desc);
+    PSOEntry* Acquire(const ComputePSODesc& desc);
+    void AddRef(PSOEntry* entry);
+    void Release(PSOEntry* entry);
+
+    bool IsReady(const PSOEntry* entry) const;
+    void Wait(PSOEntry* entry);
+    ID3D12PipelineState* PSO(const PSOEntry* entry) const;
+    Hash Key(const PSOEntry* entry) const;
+
+    PSOManagerStats Stats() const;
+
+protected:
+
+    PSOEntry* FindOrAddEntry(Hash key, bool& added);
+    void Launch(PSOEntry* entry);
+    void CreatePSO(PSOEntry* entry);
+    void FreeUnusedEntries(bool waitForPending);
+
+    DX12PSODevice dx12Device;
+    PSODevice* device = nullptr;
+
+    std::map<Hash, PSOEntry*> entries;
+    PipelineCache pipelineCache;
+
+    uint64 numRequests = 0;
+    uint64 numDeduplicated = 0;
+    std::atomic<uint64> numCreated = 0;
+    std::atomic<uint64> numFailed = 0;
+    std::atomic<uint64> createTimeUS = 0;
+};
+
+// A PSO slot for a renderer. Requesting a new PSO doesn't replace the current one until the new
+// one has been created, so rendering can carry on with the old PSO in the meantime. If a creation
+// fails the slot keeps the PSO that it had.
+class ManagedPSO
+{
+
+public:
+
+    ~ManagedPSO();
+
+    void Request(PSOManager& manager, const GraphicsPSODesc& desc);
+    void Request(PSOManager& manager, const ComputePSODesc& desc);
+    void Release();
+
+    // Returns the newest PSO that's ready to use, or null if the first one is still in flight
+    ID3D12PipelineState* Get();
+
+    // Same as Get(), except that it waits if there isn't anything to use yet
+    ID3D12PipelineState* GetOrWait();
+
+    // Waits for the latest request to finish, so that Get() returns its PSO
+    void Wait();
+
+    bool Pending() const { return pending != nullptr; }
+
+protected:
+
+    void SetPending(PSOManager& manager, PSOEntry* entry);
+
+    PSOManager* manager = nullptr;
+    PSOEntry* current = nullptr;
+    PSOEntry* pending = nullptr;
+};
+
+}
\ No newline at end of file
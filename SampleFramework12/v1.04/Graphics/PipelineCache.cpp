@@ -0,0 +1,119 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "PipelineCache.h"
+#include "../Utility.h"
+
+namespace SampleFramework12
+{
+
+static const uint64 PipelineCacheVersion = 1;
+
+// The validation hash is stored alongside the blobs under a key that no description hashes to in practice
+static const Hash ValidationKey = Hash(0, 0);
+
+PipelineCache::~PipelineCache()
+{
+    Close();
+}
+
+void PipelineCache::Open(const wchar* dirPath, Hash validationHash)
+{
+    Assert_(IsOpen() == false);
+
+    std::wstring dir = dirPath;
+    if(dir.length() > 0 && dir.back() != L'\\' && dir.back() != L'/')
+        dir += L"\\";
+
+    const std::wstring archivePath = dir + L"PSOs.archive";
+    const std::wstring logPath = dir + L"PSOs.log";
+
+    validationHash = CombineHashes(validationHash, Hash(PipelineCacheVersion, 0));
+
+    archive.Open(archivePath.c_str(), logPath.c_str());
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    bool valid = archive.Find(ValidationKey, data, size);
+    valid = valid && size == sizeof(Hash) && memcmp(data, &validationHash, sizeof(Hash)) == 0;
+    if(valid == false)
+    {
+        if(archive.NumArchiveEntries() + archive.NumLogEntries() > 0)
+            WriteLog(L"Discarding the pipeline cache in %ls, since the adapter, driver, or shader compiler changed", dirPath);
+
+        archive.Close();
+        DeleteFile(archivePath.c_str());
+        DeleteFile(logPath.c_str());
+
+        archive.Open(archivePath.c_str(), logPath.c_str());
+        archive.Add(ValidationKey, &validationHash, sizeof(Hash));
+    }
+
+    numHits = 0;
+    numMisses = 0;
+    numRejected = 0;
+    numStored = 0;
+}
+
+void PipelineCache::Close()
+{
+    if(IsOpen() == false)
+        return;
+
+    if(archive.NumLogEntries() > 0)
+        archive.Compact();
+    archive.Close();
+}
+
+bool PipelineCache::Find(Hash key, const uint8*& data, uint64& size)
+{
+    Assert_(IsOpen());
+
+    const bool found = key != ValidationKey && archive.Find(key, data, size);
+    if(found)
+        numHits += 1;
+    else
+        numMisses += 1;
+
+    return found;
+}
+
+void PipelineCache::Store(Hash key, const void* data, uint64 size)
+{
+    Assert_(IsOpen());
+    Assert_(key != ValidationKey);
+
+    archive.Add(key, data, size);
+    numStored += 1;
+}
+
+void PipelineCache::Reject(Hash key)
+{
+    Assert_(IsOpen());
+    Assert_(key != ValidationKey);
+
+    // Drop the blob so that it isn't handed out again, and so that a new one can be stored for the key
+    archive.Remove(key);
+    numRejected += 1;
+    WriteLog(L"Pipeline cache entry %ls was rejected by the driver", key.ToString().c_str());
+}
+
+PipelineCacheStats PipelineCache::Stats() const
+{
+    PipelineCacheStats stats;
+    stats.Hits = numHits;
+    stats.Misses = numMisses;
+    stats.Rejected = numRejected;
+    stats.Stored = numStored;
+    return stats;
+}
+
+}
\ No newline at end of file
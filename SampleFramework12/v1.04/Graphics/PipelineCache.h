@@ -0,0 +1,69 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\MurmurHash.h"
+#include "ShaderCacheArchive.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+struct PipelineCacheStats
+{
+    uint64 Hits = 0;
+    uint64 Misses = 0;
+    uint64 Rejected = 0;    // found, but the driver wouldn't take it
+    uint64 Stored = 0;
+};
+
+// Keeps the blobs that the driver hands out from ID3D12PipelineState::GetCachedBlob(), so that the
+// next run can pass them back through CachedPSO instead of compiling the pipeline from scratch.
+// The blobs are stored in the same archive format as compiled shaders.
+//
+// A blob is only good for the adapter and driver that made it, so the cache is opened with a hash
+// of everything that it depends on. When that doesn't match the cache on disk, the old contents
+// get deleted.
+class PipelineCache
+{
+
+public:
+
+    ~PipelineCache();
+
+    void Open(const wchar* dirPath, Hash validationHash);
+
+    // Folds anything that was stored this run into the archive
+    void Close();
+
+    bool IsOpen() const { return archive.IsOpen(); }
+
+    // These can be called from multiple threads. The data returned from Find() stays valid until
+    // the cache is closed.
+    bool Find(Hash key, const uint8*& data, uint64& size);
+    void Store(Hash key, const void* data, uint64 size);
+    void Reject(Hash key);
+
+    PipelineCacheStats Stats() const;
+
+protected:
+
+    ShaderCacheArchive archive;
+
+    std::atomic<uint64> numHits = 0;
+    std::atomic<uint64> numMisses = 0;
+    std::atomic<uint64> numRejected = 0;
+    std::atomic<uint64> numStored = 0;
+};
+
+}
\ No newline at end of file
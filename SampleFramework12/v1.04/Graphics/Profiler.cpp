@@ -10,7 +10,10 @@
 #include "PCH.h"
 #include "Profiler.h"
 #include "DX12.h"
+#include "DX12_Upload.h"
 #include "..\\Utility.h"
+#include "..\\FileIO.h"
+#include "..\\Jobs.h"
 #include "..\\ImGui\ImGui.h"
 
 using std::wstring;
@@ -19,23 +22,27 @@ using std::map;
 namespace SampleFramework12
 {
 
-// == Profiler ====================================================================================
-
-Profiler Profiler::GlobalProfiler;
+// == ProfileTree =================================================================================
 
-static const uint64 MaxProfiles = 64;
+static const uint32 InvalidNode = uint32(-1);
 
 struct ProfileData
 {
     const char* Name = nullptr;
 
-    bool QueryStarted = false;
-    bool QueryFinished = false ;
+    uint32 Parent = InvalidNode;
+    uint32 FirstChild = InvalidNode;
+    uint32 LastChild = InvalidNode;
+    uint32 NextSibling = InvalidNode;
+    uint32 Depth = 0;
+
     bool Active = false;
+    double FrameTime = 0.0;
+    uint32 FrameCalls = 0;
 
-    bool CPUProfile = false;
-    int64 StartTime = 0;
-    int64 EndTime = 0;
+    bool LastFrameActive = false;
+    double LastFrameTime = 0.0;
+    uint32 LastFrameCalls = 0;
 
     static const uint64 FilterSize = 64;
     double TimeSamples[FilterSize] = { };
@@ -45,6 +52,266 @@ struct ProfileData
     double MaxTime = 0.0;
 };
 
+static void UpdateProfile(ProfileData& profile)
+{
+    profile.TimeSamples[profile.CurrSample] = profile.FrameTime;
+    profile.CurrSample = (profile.CurrSample + 1) % ProfileData::FilterSize;
+
+    double maxTime = 0.0;
+    double avgTime = 0.0;
+    uint64 avgTimeSamples = 0;
+    for(uint64 i = 0; i < ProfileData::FilterSize; ++i)
+    {
+        if(profile.TimeSamples[i] <= 0.0)
+            continue;
+        maxTime = Max(profile.TimeSamples[i], maxTime);
+        avgTime += profile.TimeSamples[i];
+        ++avgTimeSamples;
+    }
+
+    if(avgTimeSamples > 0)
+        avgTime /= double(avgTimeSamples);
+
+    profile.AverageTime = avgTime;
+    profile.MaxTime = maxTime;
+
+    profile.LastFrameActive = profile.Active;
+    profile.LastFrameTime = profile.FrameTime;
+    profile.LastFrameCalls = profile.FrameCalls;
+
+    profile.Active = false;
+    profile.FrameTime = 0.0;
+    profile.FrameCalls = 0;
+}
+
+// Timings are accumulated per unique (parent, name) pair, and also per name so that they can
+// be looked up without knowing where in the hierarchy they were recorded. Names are compared by
+// pointer, so they need to be string literals or otherwise have a stable address.
+struct ProfileTree
+{
+    List<ProfileData> Nodes;
+    map<std::pair<uint32, const char*>, uint32> NodeLookup;
+    uint32 FirstRoot = InvalidNode;
+    uint32 LastRoot = InvalidNode;
+
+    List<ProfileData> Totals;
+    map<const char*, uint32> TotalLookup;
+
+    ~ProfileTree()
+    {
+        Nodes.Shutdown();
+        Totals.Shutdown();
+    }
+
+    void Clear()
+    {
+        Nodes.RemoveAll();
+        NodeLookup.clear();
+        FirstRoot = InvalidNode;
+        LastRoot = InvalidNode;
+        Totals.RemoveAll();
+        TotalLookup.clear();
+    }
+
+    uint32 AddTime(uint32 parent, const char* name, double time)
+    {
+        uint32 nodeIdx = InvalidNode;
+        const auto nodeIter = NodeLookup.find(std::make_pair(parent, name));
+        if(nodeIter != NodeLookup.end())
+        {
+            nodeIdx = nodeIter->second;
+        }
+        else
+        {
+            nodeIdx = uint32(Nodes.Count());
+            ProfileData& node = Nodes.Add();
+            node.Name = name;
+            node.Parent = parent;
+            NodeLookup[std::make_pair(parent, name)] = nodeIdx;
+
+            uint32& first = parent == InvalidNode ? FirstRoot : Nodes[parent].FirstChild;
+            uint32& last = parent == InvalidNode ? LastRoot : Nodes[parent].LastChild;
+            if(last != InvalidNode)
+                Nodes[last].NextSibling = nodeIdx;
+            else
+                first = nodeIdx;
+            last = nodeIdx;
+
+            Nodes[nodeIdx].Depth = parent == InvalidNode ? 0 : Nodes[parent].Depth + 1;
+        }
+
+        ProfileData& node = Nodes[nodeIdx];
+        node.Active = true;
+        node.FrameTime += time;
+        node.FrameCalls += 1;
+
+        uint32 totalIdx = InvalidNode;
+        const auto totalIter = TotalLookup.find(name);
+        if(totalIter != TotalLookup.end())
+        {
+            totalIdx = totalIter->second;
+        }
+        else
+        {
+            totalIdx = uint32(Totals.Count());
+            Totals.Add().Name = name;
+            TotalLookup[name] = totalIdx;
+        }
+
+        ProfileData& total = Totals[totalIdx];
+        total.Active = true;
+        total.FrameTime += time;
+        total.FrameCalls += 1;
+
+        return nodeIdx;
+    }
+
+    void EndFrame()
+    {
+        for(uint64 i = 0; i < Nodes.Count(); ++i)
+            UpdateProfile(Nodes[i]);
+        for(uint64 i = 0; i < Totals.Count(); ++i)
+            UpdateProfile(Totals[i]);
+    }
+
+    const ProfileData* FindTotal(const char* name) const
+    {
+        const auto iter = TotalLookup.find(name);
+        return iter != TotalLookup.end() ? &Totals[iter->second] : nullptr;
+    }
+
+    void Draw(uint32 firstNode) const
+    {
+        for(uint32 nodeIdx = firstNode; nodeIdx != InvalidNode; nodeIdx = Nodes[nodeIdx].NextSibling)
+        {
+            const ProfileData& node = Nodes[nodeIdx];
+            if(node.LastFrameActive == false)
+                continue;
+
+            if(node.LastFrameCalls > 1)
+                ImGui::Text("%*s%s: %.2fms (%.2fms max, %u calls)", int32(node.Depth * 2), "", node.Name, node.AverageTime, node.MaxTime, node.LastFrameCalls);
+            else
+                ImGui::Text("%*s%s: %.2fms (%.2fms max)", int32(node.Depth * 2), "", node.Name, node.AverageTime, node.MaxTime);
+
+            Draw(node.FirstChild);
+        }
+    }
+};
+
+// == ProfilerThread ==============================================================================
+
+// Each thread that records profile blocks gets its own ring buffer of events. The owning thread
+// is the only writer and the profiler is the only reader, so no locks are needed. Events are
+// written in the order that they started, and are only published once the outermost block has
+// ended so that the reader always sees complete hierarchies.
+struct ProfilerThread
+{
+    static const uint64 MaxEvents = 8 * 1024;
+
+    ProfileEvent Events[MaxEvents];
+    int64 NumWritten = 0;
+    volatile int64 NumPublished = 0;
+    volatile int64 NumRead = 0;
+    volatile int64 NumDropped = 0;
+
+    uint64 OpenEvents[Profiler::MaxDepth] = { };
+    uint32 Depth = 0;
+    uint32 GPUDepth = 0;
+
+    uint32 ThreadIdx = 0;
+    char Name[64] = { };
+};
+
+// These are never freed, since threads can outlive the profiler
+static ProfilerThread* ProfilerThreads[Profiler::MaxThreads] = { };
+static volatile int64 NumProfilerThreads = 0;
+static thread_local ProfilerThread* CurrProfilerThread = nullptr;
+static thread_local bool ProfilerThreadRegistered = false;
+
+static ProfilerThread* GetProfilerThread()
+{
+    if(ProfilerThreadRegistered)
+        return CurrProfilerThread;
+
+    ProfilerThreadRegistered = true;
+
+    const int64 threadIdx = InterlockedIncrement64(&NumProfilerThreads) - 1;
+    if(threadIdx >= int64(Profiler::MaxThreads))
+        return nullptr;
+
+    ProfilerThread* thread = new ProfilerThread();
+    thread->ThreadIdx = uint32(threadIdx);
+
+    const uint32 jobThreadIdx = Jobs::ThreadIndex();
+    if(jobThreadIdx > 0)
+        sprintf_s(thread->Name, "Job Thread %u", jobThreadIdx);
+    else
+        sprintf_s(thread->Name, "Thread %u", uint32(threadIdx));
+
+    InterlockedExchangePointer(reinterpret_cast<void* volatile*>(&ProfilerThreads[threadIdx]), thread);
+    CurrProfilerThread = thread;
+
+    return thread;
+}
+
+static int64 GetCPUTimestamp()
+{
+    LARGE_INTEGER counter = { };
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static int64 GetCPUTimestampFrequency()
+{
+    static int64 frequency = 0;
+    if(frequency == 0)
+    {
+        LARGE_INTEGER freq = { };
+        QueryPerformanceFrequency(&freq);
+        frequency = freq.QuadPart;
+    }
+
+    return frequency;
+}
+
+static void AppendJSONString(std::string& json, const char* str)
+{
+    json += '"';
+    for(const char* c = str; *c != 0; ++c)
+    {
+        if(*c == '"' || *c == '\\')
+        {
+            json += '\\';
+            json += *c;
+        }
+        else if(uint8(*c) < 0x20)
+            json += MakeString("\\u%04x", uint32(uint8(*c)));
+        else
+            json += *c;
+    }
+    json += '"';
+}
+
+// == Profiler ====================================================================================
+
+Profiler Profiler::GlobalProfiler;
+
+static const uint32 NumGPUEventSets = DX12::RenderLatency + 1;
+static const uint32 CaptureUIFrames = 60;
+
+Profiler::Profiler()
+{
+    gpuTree = new ProfileTree();
+    cpuTree = new ProfileTree();
+}
+
+Profiler::~Profiler()
+{
+    delete gpuTree;
+    delete cpuTree;
+    capturedEvents.Shutdown();
+}
+
 void Profiler::Initialize()
 {
     Shutdown();
@@ -52,19 +319,22 @@ void Profiler::Initialize()
     enableGPUProfiling = true;
 
     D3D12_QUERY_HEAP_DESC heapDesc = { };
-    heapDesc.Count = MaxProfiles * 2;
+    heapDesc.Count = MaxGPUProfiles * 2;
     heapDesc.NodeMask = 0;
     heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
     DX12::Device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&queryHeap));
 
     for(uint32 i = 0; i < DX12::RenderLatency; ++i)
     {
-        readbackBuffers[i].Initialize(MaxProfiles * 2 * sizeof(uint64));
+        readbackBuffers[i].Initialize(MaxGPUProfiles * 2 * sizeof(uint64));
         readbackBuffers[i].Resource->SetName(MakeString(L"Query Readback Buffer %u", i).c_str());
     }
 
-    profiles.Init(MaxProfiles);
-    cpuProfiles.Init(MaxProfiles);
+    for(uint32 i = 0; i < NumGPUEventSets; ++i)
+    {
+        gpuEvents[i].Init(MaxGPUProfiles);
+        numGPUEvents[i] = 0;
+    }
 }
 
 void Profiler::Shutdown()
@@ -72,9 +342,17 @@ void Profiler::Shutdown()
     DX12::DeferredRelease(queryHeap);
     for(uint32 i = 0; i < DX12::RenderLatency; ++i)
         readbackBuffers[i].Shutdown();
-    profiles.Shutdown();
-    cpuProfiles.Shutdown();
-    numProfiles = 0;
+    for(uint32 i = 0; i < NumGPUEventSets; ++i)
+    {
+        gpuEvents[i].Shutdown();
+        numGPUEvents[i] = 0;
+    }
+
+    gpuTree->Clear();
+    cpuTree->Clear();
+    capturedEvents.RemoveAll();
+    captureFramesLeft = 0;
+    enableGPUProfiling = false;
 }
 
 uint64 Profiler::StartProfile(ID3D12GraphicsCommandList* cmdList, const char* name)
@@ -83,48 +361,40 @@ uint64 Profiler::StartProfile(ID3D12GraphicsCommandList* cmdList, const char* na
     if(enableGPUProfiling == false)
         return uint64(-1);
 
-    uint64 profileIdx = uint64(-1);
-    for(uint64 i = 0; i < numProfiles; ++i)
-    {
-        if(profiles[i].Name == name)
-        {
-            profileIdx = i;
-            break;
-        }
-    }
+    // Every block gets its own pair of queries for the frame, so names can be used any number of times
+    const uint64 eventSet = DX12::CurrentCPUFrame % NumGPUEventSets;
+    const int64 profileIdx = InterlockedIncrement64(&numGPUEvents[eventSet]) - 1;
+    if(profileIdx >= int64(MaxGPUProfiles))
+        return uint64(-1);
 
-    if(profileIdx == uint64(-1))
-    {
-        Assert_(numProfiles < MaxProfiles);
-        profileIdx = numProfiles++;
-        profiles[profileIdx].Name = name;
-    }
+    ProfilerThread* thread = GetProfilerThread();
 
-    ProfileData& profileData = profiles[profileIdx];
-    Assert_(profileData.QueryStarted == false);
-    Assert_(profileData.QueryFinished == false);
-    profileData.CPUProfile = false;
-    profileData.Active = true;
+    ProfileEvent& profileEvent = gpuEvents[eventSet][profileIdx];
+    profileEvent.Name = name;
+    profileEvent.Depth = thread ? thread->GPUDepth++ : 0;
+    profileEvent.ThreadIdx = thread ? thread->ThreadIdx : 0;
+    profileEvent.GPU = true;
 
     // Insert the start timestamp
     const uint32 startQueryIdx = uint32(profileIdx * 2);
     cmdList->EndQuery(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, startQueryIdx);
 
-    profileData.QueryStarted = true;
-
-    return profileIdx;
+    return uint64(profileIdx);
 }
 
 void Profiler::EndProfile(ID3D12GraphicsCommandList* cmdList, uint64 idx)
 {
-    if(enableGPUProfiling == false)
+    if(enableGPUProfiling == false || idx == uint64(-1))
         return;
 
-    Assert_(idx < numProfiles);
+    Assert_(idx < MaxGPUProfiles);
 
-    ProfileData& profileData = profiles[idx];
-    Assert_(profileData.QueryStarted == true);
-    Assert_(profileData.QueryFinished == false);
+    ProfilerThread* thread = CurrProfilerThread;
+    if(thread != nullptr)
+    {
+        Assert_(thread->GPUDepth > 0);
+        thread->GPUDepth -= 1;
+    }
 
     // Insert the end timestamp
     const uint32 startQueryIdx = uint32(idx * 2);
@@ -134,122 +404,172 @@ void Profiler::EndProfile(ID3D12GraphicsCommandList* cmdList, uint64 idx)
     // Resolve the data
     const uint64 dstOffset = startQueryIdx * sizeof(uint64);
     cmdList->ResolveQueryData(queryHeap, D3D12_QUERY_TYPE_TIMESTAMP, startQueryIdx, 2, readbackBuffers[DX12::CurrFrameIdx].Resource, dstOffset);
-
-    profileData.QueryStarted = false;
-    profileData.QueryFinished = true;
 }
 
 uint64 Profiler::StartCPUProfile(const char* name)
 {
     Assert_(name != nullptr);
 
-    uint64 profileIdx = uint64(-1);
-    for(uint64 i = 0; i < numCPUProfiles; ++i)
-    {
-        if(cpuProfiles[i].Name == name)
-        {
-            profileIdx = i;
-            break;
-        }
-    }
+    ProfilerThread* thread = GetProfilerThread();
+    if(thread == nullptr)
+        return uint64(-1);
 
-    if(profileIdx == uint64(-1))
+    // Keep track of the nesting even when dropping an event, so that any children still end up
+    // at the right depth
+    const uint32 depth = thread->Depth++;
+    if(depth >= MaxDepth || thread->NumWritten - thread->NumRead >= int64(ProfilerThread::MaxEvents))
     {
-        Assert_(numCPUProfiles < MaxProfiles);
-        profileIdx = numCPUProfiles++;
-        cpuProfiles[profileIdx].Name = name;
+        if(depth < MaxDepth)
+            thread->OpenEvents[depth] = uint64(-1);
+        InterlockedIncrement64(&thread->NumDropped);
+        return uint64(-1);
     }
 
-    ProfileData& profileData = cpuProfiles[profileIdx];
-    Assert_(profileData.QueryStarted == false);
-    Assert_(profileData.QueryFinished == false);
-    profileData.CPUProfile = true;
-    profileData.Active = true;
-
-    timer.Update();
-    profileData.StartTime = timer.ElapsedMicroseconds();
+    const int64 eventIdx = thread->NumWritten++;
+    thread->OpenEvents[depth] = uint64(eventIdx);
 
-    profileData.QueryStarted = true;
+    ProfileEvent& profileEvent = thread->Events[eventIdx % ProfilerThread::MaxEvents];
+    profileEvent.Name = name;
+    profileEvent.Depth = depth;
+    profileEvent.ThreadIdx = thread->ThreadIdx;
+    profileEvent.GPU = false;
+    profileEvent.EndTime = 0;
+    profileEvent.StartTime = GetCPUTimestamp();
 
-    return profileIdx;
+    return uint64(eventIdx);
 }
 
 void Profiler::EndCPUProfile(uint64 idx)
 {
-    Assert_(idx < numCPUProfiles);
+    const int64 endTime = GetCPUTimestamp();
 
-    ProfileData& profileData = cpuProfiles[idx];
-    Assert_(profileData.QueryStarted == true);
-    Assert_(profileData.QueryFinished == false);
+    ProfilerThread* thread = CurrProfilerThread;
+    if(thread == nullptr)
+        return;
+
+    // Blocks need to be ended in the reverse order that they were started in, on the same thread
+    Assert_(thread->Depth > 0);
+    const uint32 depth = --thread->Depth;
+    Assert_(depth >= MaxDepth || thread->OpenEvents[depth] == idx);
 
-    timer.Update();
-    profileData.EndTime = timer.ElapsedMicroseconds();
+    if(idx != uint64(-1))
+        thread->Events[idx % ProfilerThread::MaxEvents].EndTime = endTime;
 
-    profileData.QueryStarted = false;
-    profileData.QueryFinished = true;
+    if(depth == 0)
+        InterlockedExchange64(&thread->NumPublished, thread->NumWritten);
 }
 
-static void UpdateProfile(ProfileData& profile, uint64 profileIdx, bool drawText, uint64 gpuFrequency, const uint64* frameQueryData)
+void Profiler::UpdateCPU()
 {
-    profile.QueryFinished = false;
+    ReadCPUEvents();
+    cpuTree->EndFrame();
+}
 
-    double time = 0.0f;
-    if(profile.CPUProfile)
-    {
-        time = double(profile.EndTime - profile.StartTime) / 1000.0;
-    }
-    else if(frameQueryData)
+void Profiler::ReadCPUEvents()
+{
+    const double msPerTick = 1000.0 / double(GetCPUTimestampFrequency());
+
+    const uint32 numThreads = uint32(Min<int64>(NumProfilerThreads, MaxThreads));
+    for(uint32 threadIdx = 0; threadIdx < numThreads; ++threadIdx)
     {
-        Assert_(frameQueryData != nullptr);
+        ProfilerThread* thread = ProfilerThreads[threadIdx];
+        if(thread == nullptr)
+            continue;
 
-        // Get the query data
-        uint64 startTime = frameQueryData[profileIdx * 2 + 0];
-        uint64 endTime = frameQueryData[profileIdx * 2 + 1];
+        uint32 parents[MaxDepth] = { };
+        uint32 numParents = 0;
 
-        if(endTime > startTime)
+        const int64 numPublished = thread->NumPublished;
+        for(int64 i = thread->NumRead; i < numPublished; ++i)
         {
-            uint64 delta = endTime - startTime;
-            double frequency = double(gpuFrequency);
-            time = (delta / frequency) * 1000.0;
+            const ProfileEvent& profileEvent = thread->Events[i % ProfilerThread::MaxEvents];
+
+            // The depth can skip a level if the parent was dropped
+            const uint32 depth = Min(profileEvent.Depth, numParents);
+            const uint32 parent = depth > 0 ? parents[depth - 1] : InvalidNode;
+            const double time = double(profileEvent.EndTime - profileEvent.StartTime) * msPerTick;
+            parents[depth] = cpuTree->AddTime(parent, profileEvent.Name, time);
+            numParents = depth + 1;
+
+            if(captureFramesLeft > 0)
+                capturedEvents.Add(profileEvent);
         }
+
+        InterlockedExchange64(&thread->NumRead, numPublished);
     }
+}
 
-    profile.TimeSamples[profile.CurrSample] = time;
-    profile.CurrSample = (profile.CurrSample + 1) % ProfileData::FilterSize;
+void Profiler::UpdateGPU(uint64 gpuFrequency)
+{
+    // The readback buffer for this frame has the results from RenderLatency frames ago
+    const uint64 currFrame = DX12::CurrentCPUFrame;
+    const uint64 eventSet = (currFrame + NumGPUEventSets - DX12::RenderLatency) % NumGPUEventSets;
+    const uint64 numEvents = currFrame >= DX12::RenderLatency ? Min<uint64>(numGPUEvents[eventSet], MaxGPUProfiles) : 0;
 
-    double maxTime = 0.0;
-    double avgTime = 0.0;
-    uint64 avgTimeSamples = 0;
-    for(UINT i = 0; i < ProfileData::FilterSize; ++i)
+    if(numEvents > 0 && gpuFrequency > 0)
     {
-        if(profile.TimeSamples[i] <= 0.0)
-            continue;
-        maxTime = Max(profile.TimeSamples[i], maxTime);
-        avgTime += profile.TimeSamples[i];
-        ++avgTimeSamples;
-    }
+        const uint64* frameQueryData = readbackBuffers[DX12::CurrFrameIdx].Map<uint64>();
 
-    if(avgTimeSamples > 0)
-        avgTime /= double(avgTimeSamples);
+        // Put the GPU timestamps on the same timeline as the CPU ones
+        uint64 gpuCalibration = 0;
+        uint64 cpuCalibration = 0;
+        DX12::GfxQueue->GetClockCalibration(&gpuCalibration, &cpuCalibration);
+        const double cpuTicksPerGPUTick = double(GetCPUTimestampFrequency()) / double(gpuFrequency);
+        const double msPerGPUTick = 1000.0 / double(gpuFrequency);
 
-    if(profile.Active && drawText)
-        ImGui::Text("%s: %.2fms (%.2fms max)", profile.Name, avgTime, maxTime);
+        // GPU blocks can be recorded from multiple threads, so track the hierarchy per-thread
+        uint32 parents[MaxThreads * MaxDepth] = { };
+        uint32 numParents[MaxThreads] = { };
 
-    profile.AverageTime = avgTime;
-    profile.MaxTime = maxTime;
+        for(uint64 i = 0; i < numEvents; ++i)
+        {
+            ProfileEvent profileEvent = gpuEvents[eventSet][i];
 
-    profile.Active = false;
+            const uint64 startTime = frameQueryData[i * 2 + 0];
+            const uint64 endTime = frameQueryData[i * 2 + 1];
+            const double time = endTime > startTime ? double(endTime - startTime) * msPerGPUTick : 0.0;
+
+            profileEvent.StartTime = int64(cpuCalibration) + int64((double(startTime) - double(gpuCalibration)) * cpuTicksPerGPUTick);
+            profileEvent.EndTime = profileEvent.StartTime + int64(double(endTime > startTime ? endTime - startTime : 0) * cpuTicksPerGPUTick);
+
+            const uint32 threadIdx = Min(profileEvent.ThreadIdx, MaxThreads - 1);
+            uint32* threadParents = &parents[threadIdx * MaxDepth];
+            const uint32 depth = Min(Min(profileEvent.Depth, numParents[threadIdx]), MaxDepth - 1);
+            const uint32 parent = depth > 0 ? threadParents[depth - 1] : InvalidNode;
+            threadParents[depth] = gpuTree->AddTime(parent, profileEvent.Name, time);
+            numParents[threadIdx] = depth + 1;
+
+            if(captureFramesLeft > 0)
+                capturedEvents.Add(profileEvent);
+        }
+
+        readbackBuffers[DX12::CurrFrameIdx].Unmap();
+    }
+
+    // This set gets re-used for the next frame
+    numGPUEvents[eventSet] = 0;
+
+    gpuTree->EndFrame();
 }
 
 void Profiler::EndFrame(uint32 displayWidth, uint32 displayHeight, uint32 avgFPS, double avgFrameTime)
 {
     uint64 gpuFrequency = 0;
-    const uint64* frameQueryData = nullptr;
-    if(enableGPUProfiling)
-    {
+    if(queryHeap != nullptr)
         DX12::GfxQueue->GetTimestampFrequency(&gpuFrequency);
 
-        frameQueryData = readbackBuffers[DX12::CurrFrameIdx].Map<uint64>();
+    UpdateGPU(gpuFrequency);
+    UpdateCPU();
+
+    if(captureFramesLeft > 0)
+    {
+        captureFramesLeft -= 1;
+        if(captureFramesLeft == 0 && captureFilePath.length() > 0)
+        {
+            ExportChromeTrace(captureFilePath.c_str());
+            WriteLog(L"Exported %llu profile events to %ls", capturedEvents.Count(), captureFilePath.c_str());
+            captureFilePath.clear();
+        }
     }
 
     bool drawText = false;
@@ -288,21 +608,42 @@ void Profiler::EndFrame(uint32 displayWidth, uint32 displayHeight, uint32 avgFPS
 
         ImGui::Text("GPU Timing");
         ImGui::Separator();
-    }
 
-    // Iterate over all of the profiles
-    for(uint64 profileIdx = 0; profileIdx < numProfiles; ++profileIdx)
-        UpdateProfile(profiles[profileIdx], profileIdx, drawText, gpuFrequency, frameQueryData);
+        gpuTree->Draw(gpuTree->FirstRoot);
 
-    if(drawText)
-    {
         ImGui::Text(" ");
         ImGui::Text("CPU Timing");
         ImGui::Separator();
-    }
 
-    for(uint64 profileIdx = 0; profileIdx < numCPUProfiles; ++profileIdx)
-        UpdateProfile(cpuProfiles[profileIdx], profileIdx, drawText, gpuFrequency, frameQueryData);
+        cpuTree->Draw(cpuTree->FirstRoot);
+
+        int64 numDropped = 0;
+        const uint32 numThreads = uint32(Min<int64>(NumProfilerThreads, MaxThreads));
+        for(uint32 threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+            numDropped += ProfilerThreads[threadIdx] ? ProfilerThreads[threadIdx]->NumDropped : 0;
+        if(numDropped > 0)
+            ImGui::Text("Dropped CPU Events: %lld", numDropped);
+
+        const DX12::UploadRingStats uploadStats = DX12::GetUploadRingStats();
+        ImGui::Text(" ");
+        ImGui::Text("Upload Ring");
+        ImGui::Separator();
+        ImGui::Text("Size: %.2f MB (%.2f MB peak usage, grown %llu times, shrunk %llu times)", uploadStats.RingSize / (1024.0 * 1024.0),
+                    uploadStats.HighWaterBytesUsed / (1024.0 * 1024.0), uploadStats.NumGrows, uploadStats.NumShrinks);
+        ImGui::Text("Uploads: %llu (%llu chunked)", uploadStats.NumUploads, uploadStats.NumChunkedUploads);
+        ImGui::Text("Stalls: %llu (%.2fms total)", uploadStats.NumStalls, uploadStats.StallTimeMS);
+        ImGui::Text("Wraps: %llu (%.2f MB padding)", uploadStats.NumWraps, uploadStats.WrapPaddingBytes / (1024.0 * 1024.0));
+
+        const DX12::TempBufferStats tempStats = DX12::GetTempBufferStats();
+        ImGui::Text(" ");
+        ImGui::Text("Temp Buffer Memory");
+        ImGui::Separator();
+        ImGui::Text("Last Frame: %.2f MB used (%.2f MB reserved)", tempStats.FrameBytesUsed / (1024.0 * 1024.0),
+                    tempStats.FrameBytesReserved / (1024.0 * 1024.0));
+        ImGui::Text("Peak: %.2f MB used (%.2f MB reserved)", tempStats.HighWaterBytesUsed / (1024.0 * 1024.0),
+                    tempStats.HighWaterBytesReserved / (1024.0 * 1024.0));
+        ImGui::Text("Pages: %llu (%.2f MB total)", tempStats.NumPages, tempStats.TotalPageBytes / (1024.0 * 1024.0));
+    }
 
     if(showUI)
     {
@@ -311,91 +652,114 @@ void Profiler::EndFrame(uint32 displayWidth, uint32 displayHeight, uint32 avgFPS
 
         ImGui::Text(" ");
         logToClipboard = ImGui::Button("Copy To Clipboard");
+
+        if(Capturing())
+        {
+            ImGui::Text("Capturing Trace...");
+        }
+        else
+        {
+            ImGui::SameLine();
+            if(ImGui::Button("Capture Trace"))
+                CaptureFrames(CaptureUIFrames, L"ProfileTrace.json");
+        }
     }
     else
         logToClipboard = false;
 
     ImGui::End();
 
-    if(enableGPUProfiling)
-        readbackBuffers[DX12::CurrFrameIdx].Unmap();
-
-    enableGPUProfiling = showUI || alwaysEnableGPUProfiling;
+    enableGPUProfiling = queryHeap != nullptr && (showUI || alwaysEnableGPUProfiling || Capturing());
 }
 
 double Profiler::GPUProfileTiming(const char* name) const
 {
-    uint64 profileIdx = uint64(-1);
-    for(uint64 i = 0; i < numProfiles; ++i)
-    {
-        if(profiles[i].Name == name)
-        {
-            profileIdx = i;
-            break;
-        }
-    }
-
-    if(profileIdx == uint64(-1))
-        return 0.0;
-
-    uint64 gpuFrequency = 0;
-    DX12::GfxQueue->GetTimestampFrequency(&gpuFrequency);
-
-    const uint64* frameQueryData = readbackBuffers[DX12::CurrFrameIdx].Map<uint64>();
-
-    // Get the query data
-    uint64 startTime = frameQueryData[profileIdx * 2 + 0];
-    uint64 endTime = frameQueryData[profileIdx * 2 + 1];
+    const ProfileData* profile = gpuTree->FindTotal(name);
+    return profile ? profile->LastFrameTime : 0.0;
+}
 
-    double time = 0.0;
-    if(endTime > startTime)
-    {
-        uint64 delta = endTime - startTime;
-        double frequency = double(gpuFrequency);
-        time = (delta / frequency) * 1000.0;
-    }
+double Profiler::CPUProfileTiming(const char* name) const
+{
+    const ProfileData* profile = cpuTree->FindTotal(name);
+    return profile ? profile->LastFrameTime : 0.0;
+}
 
-    readbackBuffers[DX12::CurrFrameIdx].Unmap();
+double Profiler::GPUProfileTimingAvg(const char* name) const
+{
+    const ProfileData* profile = gpuTree->FindTotal(name);
+    return profile ? profile->AverageTime : 0.0;
+}
 
-    return time;
+double Profiler::CPUProfileTimingAvg(const char* name) const
+{
+    const ProfileData* profile = cpuTree->FindTotal(name);
+    return profile ? profile->AverageTime : 0.0;
 }
 
-double Profiler::CPUProfileTiming(const char* name) const
+void Profiler::SetAlwaysEnableGPUProfiling(bool enable)
 {
-    for(uint64 i = 0; i < numCPUProfiles; ++i)
-    {
-        if(cpuProfiles[i].Name == name)
-            return (cpuProfiles[i].EndTime - cpuProfiles[i].StartTime) / 1000.0;
-    }
+    alwaysEnableGPUProfiling = enable;
+}
 
-    return 0.0;
+void Profiler::CaptureFrames(uint32 numFrames, const wchar* exportPath)
+{
+    capturedEvents.RemoveAll();
+    captureFramesLeft = numFrames;
+    captureFilePath = exportPath ? exportPath : L"";
 }
 
-double Profiler::GPUProfileTimingAvg(const char* name) const
+void Profiler::ExportChromeTrace(const wchar* filePath) const
 {
-    for(uint64 i = 0; i < numProfiles; ++i)
+    const uint32 CPUProcess = 0;
+    const uint32 GPUProcess = 1;
+
+    int64 baseTime = INT64_MAX;
+    for(uint64 i = 0; i < capturedEvents.Count(); ++i)
+        baseTime = Min(baseTime, capturedEvents[i].StartTime);
+    const double usPerTick = 1000000.0 / double(GetCPUTimestampFrequency());
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    json += MakeString("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n", CPUProcess);
+    json += MakeString("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"GPU\"}}", GPUProcess);
+
+    const uint32 numThreads = uint32(Min<int64>(NumProfilerThreads, MaxThreads));
+    for(uint32 threadIdx = 0; threadIdx < numThreads; ++threadIdx)
     {
-        if(profiles[i].Name == name)
-            return profiles[i].AverageTime;
-    }
+        const ProfilerThread* thread = ProfilerThreads[threadIdx];
+        if(thread == nullptr)
+            continue;
 
-    return 0.0;
-}
+        for(uint32 process = CPUProcess; process <= GPUProcess; ++process)
+        {
+            json += MakeString(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":", process, threadIdx);
+            AppendJSONString(json, thread->Name);
+            json += "}}";
+        }
+    }
 
-double Profiler::CPUProfileTimingAvg(const char* name) const
-{
-    for(uint64 i = 0; i < numCPUProfiles; ++i)
+    for(uint64 i = 0; i < capturedEvents.Count(); ++i)
     {
-        if(cpuProfiles[i].Name == name)
-            return cpuProfiles[i].AverageTime;
+        const ProfileEvent& profileEvent = capturedEvents[i];
+        const double timeStamp = double(profileEvent.StartTime - baseTime) * usPerTick;
+        const double duration = double(profileEvent.EndTime - profileEvent.StartTime) * usPerTick;
+
+        json += ",\n{\"name\":";
+        AppendJSONString(json, profileEvent.Name);
+        json += MakeString(",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                           profileEvent.GPU ? "GPU" : "CPU", profileEvent.GPU ? GPUProcess : CPUProcess,
+                           profileEvent.ThreadIdx, timeStamp, duration);
     }
 
-    return 0.0;
+    json += "\n]}\n";
+
+    WriteStringAsFile(filePath, json);
 }
 
-void Profiler::SetAlwaysEnableGPUProfiling(bool enable)
+void Profiler::SetThreadName(const char* name)
 {
-    alwaysEnableGPUProfiling = enable;
+    ProfilerThread* thread = GetProfilerThread();
+    if(thread != nullptr)
+        strncpy_s(thread->Name, name, _TRUNCATE);
 }
 
 // == ProfileBlock ================================================================================
@@ -19,7 +19,24 @@ namespace SampleFramework12
 {
 
 struct ProfileData;
+struct ProfileTree;
+struct ProfilerThread;
 
+// A single timed block. CPU timestamps are QueryPerformanceCounter ticks, and GPU timestamps are
+// converted to the same timeline so that they can be shown side-by-side.
+struct ProfileEvent
+{
+    const char* Name = nullptr;
+    int64 StartTime = 0;
+    int64 EndTime = 0;
+    uint32 Depth = 0;
+    uint32 ThreadIdx = 0;
+    bool GPU = false;
+};
+
+// CPU profile blocks can be used from any thread, and can be nested. Each thread records its
+// blocks into its own event buffer, which is gathered up once per frame into a tree of timings.
+// The CPU side doesn't need a D3D12 device, so UpdateCPU() can be used without Initialize().
 class Profiler
 {
 
@@ -27,6 +44,13 @@ public:
 
     static Profiler GlobalProfiler;
 
+    static const uint32 MaxThreads = 64;
+    static const uint32 MaxDepth = 32;
+    static const uint64 MaxGPUProfiles = 1024;
+
+    Profiler();
+    ~Profiler();
+
     void Initialize();
     void Shutdown();
 
@@ -38,6 +62,9 @@ public:
 
     void EndFrame(uint32 displayWidth, uint32 displayHeight, uint32 avgFPS, double avgFrameTime);
 
+    // Gathers up all CPU events that were completed since the last call, and updates the timings
+    void UpdateCPU();
+
     double GPUProfileTiming(const char* name) const;
     double CPUProfileTiming(const char* name) const;
 
@@ -46,13 +73,35 @@ public:
 
     void SetAlwaysEnableGPUProfiling(bool enable);
 
+    // Records every event for the next N frames, so that they can be exported as a trace. If a
+    // file path is provided, the trace is exported to that file once the capture finishes.
+    void CaptureFrames(uint32 numFrames, const wchar* exportPath = nullptr);
+    bool Capturing() const { return captureFramesLeft > 0; }
+    const List<ProfileEvent>& CapturedEvents() const { return capturedEvents; }
+
+    // Writes the captured events using the Chrome trace event format (chrome://tracing or Perfetto)
+    void ExportChromeTrace(const wchar* filePath) const;
+
+    // Names the calling thread in exported traces
+    static void SetThreadName(const char* name);
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
 protected:
 
-    Array<ProfileData> profiles;
-    Array<ProfileData> cpuProfiles;
-    uint64 numProfiles = 0;
-    uint64 numCPUProfiles = 0;
-    Timer timer;
+    void UpdateGPU(uint64 gpuFrequency);
+
+    // Moves published CPU events out of the per-thread buffers and into the current frame's timings
+    void ReadCPUEvents();
+
+    ProfileTree* gpuTree = nullptr;
+    ProfileTree* cpuTree = nullptr;
+    Array<ProfileEvent> gpuEvents[DX12::RenderLatency + 1];
+    volatile int64 numGPUEvents[DX12::RenderLatency + 1] = { };
+    List<ProfileEvent> capturedEvents;
+    uint32 captureFramesLeft = 0;
+    std::wstring captureFilePath;
     ID3D12QueryHeap* queryHeap = nullptr;
     ReadbackBuffer readbackBuffers[DX12::RenderLatency];
     bool enableGPUProfiling = false;
@@ -0,0 +1,122 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "RingAllocator.h"
+#include "../SF12_Math.h"
+#include "../Utility.h"
+
+namespace SampleFramework12
+{
+
+void RingAllocator::Init(uint64 size_)
+{
+    Assert_(size_ > 0);
+    size = size_;
+    start = 0;
+    used = 0;
+    stats = RingAllocatorStats();
+}
+
+bool RingAllocator::Allocate(uint64 allocSize, RingAllocation& allocation)
+{
+    Assert_(allocSize > 0);
+    Assert_(used <= size);
+
+    if(allocSize > (size - used))
+    {
+        stats.NumFailed += 1;
+        return false;
+    }
+
+    const uint64 end = start + used;
+    uint64 allocOffset = uint64(-1);
+    uint64 padding = 0;
+    if(end < size)
+    {
+        const uint64 endAmt = size - end;
+        if(endAmt >= allocSize)
+        {
+            allocOffset = end;
+        }
+        else if(start >= allocSize)
+        {
+            // Wrap around to the beginning
+            allocOffset = 0;
+            padding = endAmt;
+        }
+    }
+    else
+    {
+        const uint64 wrappedEnd = end % size;
+        if((start - wrappedEnd) >= allocSize)
+            allocOffset = wrappedEnd;
+    }
+
+    if(allocOffset == uint64(-1))
+    {
+        stats.NumFailed += 1;
+        return false;
+    }
+
+    used += allocSize + padding;
+
+    allocation.Offset = allocOffset;
+    allocation.Size = allocSize;
+    allocation.Padding = padding;
+
+    stats.NumAllocations += 1;
+    stats.HighWaterBytesUsed = Max(stats.HighWaterBytesUsed, used);
+    if(padding > 0)
+    {
+        stats.NumWraps += 1;
+        stats.PaddingBytes += padding;
+    }
+
+    return true;
+}
+
+void RingAllocator::Free(const RingAllocation& allocation)
+{
+    Assert_(allocation.Size > 0);
+    Assert_(used >= allocation.Size + allocation.Padding);
+
+    // Only the oldest allocation can be freed, since the ring can't have holes in it
+    start = (start + allocation.Padding) % size;
+    Assert_(allocation.Offset == start);
+    Assert_(start + allocation.Size <= size);
+    start = (start + allocation.Size) % size;
+    used -= (allocation.Size + allocation.Padding);
+
+    if(used == 0)
+        start = 0;
+}
+
+uint64 RingAllocator::GrowSize(uint64 currSize, uint64 requestSize, uint64 maxSize)
+{
+    if(requestSize > currSize)
+        return Max(requestSize, Min(currSize * 2, maxSize));
+
+    if(currSize >= maxSize)
+        return 0;
+
+    return Min(currSize * 2, maxSize);
+}
+
+uint64 RingAllocator::ShrinkSize(uint64 currSize, uint64 peakUsed, uint64 minSize)
+{
+    const uint64 newSize = Max(currSize / 2, minSize);
+    if(newSize >= currSize || peakUsed > newSize / 2)
+        return 0;
+
+    return newSize;
+}
+
+}
\ No newline at end of file
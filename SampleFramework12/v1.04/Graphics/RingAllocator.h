@@ -0,0 +1,67 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+namespace SampleFramework12
+{
+
+struct RingAllocation
+{
+    uint64 Offset = 0;
+    uint64 Size = 0;
+    uint64 Padding = 0;     // the end of the ring that was skipped to make this one fit
+};
+
+struct RingAllocatorStats
+{
+    uint64 NumAllocations = 0;
+    uint64 NumFailed = 0;
+    uint64 NumWraps = 0;
+    uint64 PaddingBytes = 0;
+    uint64 HighWaterBytesUsed = 0;  // padding included
+};
+
+// The bookkeeping for a FIFO ring of memory, without the memory itself. Allocations are always
+// contiguous, so one that doesn't fit at the end of the ring skips the rest of it and goes at the
+// start instead. Allocations need to be freed in the same order that they were made.
+class RingAllocator
+{
+
+public:
+
+    void Init(uint64 size);
+
+    bool Allocate(uint64 size, RingAllocation& allocation);
+    void Free(const RingAllocation& allocation);
+
+    uint64 Size() const { return size; }
+    uint64 Used() const { return used; }
+    bool Empty() const { return used == 0; }
+    const RingAllocatorStats& Stats() const { return stats; }
+
+    // How big a replacement ring should be when an allocation didn't fit, or 0 if the ring is
+    // already as large as it's allowed to get. Requests that are bigger than the ring always grow it.
+    static uint64 GrowSize(uint64 currSize, uint64 requestSize, uint64 maxSize);
+
+    // How big a replacement ring should be when usage stayed low for a while, or 0 if it shouldn't
+    // shrink. The ring is halved when the peak usage would have fit in half of the smaller ring.
+    static uint64 ShrinkSize(uint64 currSize, uint64 peakUsed, uint64 minSize);
+
+protected:
+
+    uint64 size = 0;
+    uint64 start = 0;
+    uint64 used = 0;
+    RingAllocatorStats stats;
+};
+
+}
\ No newline at end of file
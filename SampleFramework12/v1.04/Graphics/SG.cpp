@@ -28,6 +28,11 @@
 #include "SG.h"
 #include "Textures.h"
 #include "..\\Containers.h"
+#include "..\\Utility.h"
+#include "..\\Jobs.h"
+#include "..\\MurmurHash.h"
+
+#include <memory>
 
 namespace SampleFramework12
 {
@@ -233,11 +238,362 @@ static void SolveProjection(SGSolveParams& params)
         params.OutSGs[i].Amplitude *= monteCarloFactor;
 }
 
+// == Factored solver =============================================================================
+
+// The design matrix only depends on the sample directions and the SG basis, so it gets built once and
+// shared by every probe with the same layout. The normal equations (A^T * A) are also computed up-front,
+// so that each probe only needs to compute A^T * b and then solve a tiny NumSGs x NumSGs system.
+struct SGDesignMatrix
+{
+    uint64 NumSamples = 0;
+    uint64 NumSGs = 0;
+    Array<float> A;             // NumSamples x NumSGs, row-major
+    Array<double> AtA;          // NumSGs x NumSGs
+    Array<double> AtACholesky;  // Lower-triangular factor of AtA
+};
+
+// Partial sums are always computed over fixed-size chunks of samples and added up in order, which
+// keeps the results identical regardless of how many threads did the work
+static const uint64 SGSamplesPerChunk = 4096;
+
+// Design matrices for the most recently used layouts. A matrix holds NumSamples x NumSGs floats, so the
+// cache is bounded, and callers hold a reference so that an evicted matrix stays alive while it's in use.
+struct SGDesignMatrixCacheEntry
+{
+    Hash Key;
+    std::shared_ptr<const SGDesignMatrix> Matrix;
+    uint64 LastUse = 0;
+};
+
+static const uint64 MaxCachedDesignMatrices = 4;
+static SGDesignMatrixCacheEntry designMatrixCache[MaxCachedDesignMatrices];
+static uint64 designMatrixUseCount = 0;
+static SRWLOCK designMatrixCacheLock = SRWLOCK_INIT;
+
+// Factors the symmetric positive-definite n x n matrix m into L * L^T. Returns false if m isn't SPD.
+static bool CholeskyFactor(const double* m, uint64 n, double* l)
+{
+    for(uint64 i = 0; i < n * n; ++i)
+        l[i] = 0.0;
+
+    for(uint64 j = 0; j < n; ++j)
+    {
+        double diag = m[j * n + j];
+        for(uint64 k = 0; k < j; ++k)
+            diag -= l[j * n + k] * l[j * n + k];
+        if(diag <= 0.0)
+            return false;
+
+        l[j * n + j] = std::sqrt(diag);
+        for(uint64 i = j + 1; i < n; ++i)
+        {
+            double sum = m[i * n + j];
+            for(uint64 k = 0; k < j; ++k)
+                sum -= l[i * n + k] * l[j * n + k];
+            l[i * n + j] = sum / l[j * n + j];
+        }
+    }
+
+    return true;
+}
+
+// Solves L * L^T * x = b with forward and back substitution
+static void CholeskySolve(const double* l, uint64 n, const double* b, double* x)
+{
+    for(uint64 i = 0; i < n; ++i)
+    {
+        double sum = b[i];
+        for(uint64 k = 0; k < i; ++k)
+            sum -= l[i * n + k] * x[k];
+        x[i] = sum / l[i * n + i];
+    }
+
+    for(uint64 i = n; i-- > 0; )
+    {
+        double sum = x[i];
+        for(uint64 k = i + 1; k < n; ++k)
+            sum -= l[k * n + i] * x[k];
+        x[i] = sum / l[i * n + i];
+    }
+}
+
+// Lawson-Hanson active set NNLS, working on the normal equations instead of the full design matrix
+static void SolveNNLSNormalEquations(const double* ata, const double* atb, uint64 n, double* x)
+{
+    Array<uint8> passive(n, 0);
+    Array<uint64> passiveIndices(n);
+    Array<double> subMatrix(n * n);
+    Array<double> subFactor(n * n);
+    Array<double> subRHS(n);
+    Array<double> subSolution(n);
+    Array<double> z(n);
+
+    double maxATB = 0.0;
+    for(uint64 i = 0; i < n; ++i)
+    {
+        x[i] = 0.0;
+        maxATB = Max(maxATB, std::abs(atb[i]));
+    }
+    const double tolerance = 1e-10 * (1.0 + maxATB);
+
+    const uint64 maxIterations = n * 3;
+    for(uint64 iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        // Find the most negative gradient among the variables that are clamped to 0
+        uint64 bestIdx = uint64(-1);
+        double bestGradient = tolerance;
+        for(uint64 j = 0; j < n; ++j)
+        {
+            if(passive[j])
+                continue;
+
+            double gradient = atb[j];
+            for(uint64 k = 0; k < n; ++k)
+                gradient -= ata[j * n + k] * x[k];
+            if(gradient > bestGradient)
+            {
+                bestGradient = gradient;
+                bestIdx = j;
+            }
+        }
+
+        if(bestIdx == uint64(-1))
+            break;
+
+        passive[bestIdx] = 1;
+
+        for(uint64 innerIteration = 0; innerIteration < maxIterations; ++innerIteration)
+        {
+            // Solve the unconstrained problem for the passive set
+            uint64 numPassive = 0;
+            for(uint64 j = 0; j < n; ++j)
+                if(passive[j])
+                    passiveIndices[numPassive++] = j;
+
+            for(uint64 r = 0; r < numPassive; ++r)
+            {
+                subRHS[r] = atb[passiveIndices[r]];
+                for(uint64 c = 0; c < numPassive; ++c)
+                    subMatrix[r * numPassive + c] = ata[passiveIndices[r] * n + passiveIndices[c]];
+            }
+
+            if(CholeskyFactor(subMatrix.Data(), numPassive, subFactor.Data()) == false)
+            {
+                passive[bestIdx] = 0;
+                return;
+            }
+
+            CholeskySolve(subFactor.Data(), numPassive, subRHS.Data(), subSolution.Data());
+
+            bool allPositive = true;
+            for(uint64 j = 0; j < n; ++j)
+                z[j] = 0.0;
+            for(uint64 r = 0; r < numPassive; ++r)
+            {
+                z[passiveIndices[r]] = subSolution[r];
+                allPositive = allPositive && subSolution[r] > 0.0;
+            }
+
+            if(allPositive)
+            {
+                for(uint64 j = 0; j < n; ++j)
+                    x[j] = z[j];
+                break;
+            }
+
+            // Step as far as we can towards z while staying feasible, and drop the variables that hit 0
+            double alpha = 1.0;
+            for(uint64 j = 0; j < n; ++j)
+                if(passive[j] && z[j] <= 0.0)
+                    alpha = Min(alpha, x[j] / (x[j] - z[j]));
+
+            for(uint64 j = 0; j < n; ++j)
+            {
+                x[j] += alpha * (z[j] - x[j]);
+                if(passive[j] && x[j] <= tolerance)
+                {
+                    passive[j] = 0;
+                    x[j] = 0.0;
+                }
+            }
+        }
+    }
+}
+
+static void BuildDesignMatrix(const Float3* sampleDirs, uint64 numSamples, const SG* sgs, uint64 numSGs, SGDesignMatrix& matrix)
+{
+    Assert_(numSamples >= numSGs);
+
+    matrix.NumSamples = numSamples;
+    matrix.NumSGs = numSGs;
+    matrix.A.Init(numSamples * numSGs);
+    matrix.AtA.Init(numSGs * numSGs, 0.0);
+    matrix.AtACholesky.Init(numSGs * numSGs);
+
+    const uint64 numChunks = (numSamples + SGSamplesPerChunk - 1) / SGSamplesPerChunk;
+    Array<double> chunkAtA(numChunks * numSGs * numSGs, 0.0);
+
+    Jobs::ParallelFor(numChunks, [&](uint64 chunkIdx)
+    {
+        double* partialAtA = &chunkAtA[chunkIdx * numSGs * numSGs];
+        const uint64 end = Min((chunkIdx + 1) * SGSamplesPerChunk, numSamples);
+        for(uint64 i = chunkIdx * SGSamplesPerChunk; i < end; ++i)
+        {
+            float* row = &matrix.A[i * numSGs];
+            for(uint64 j = 0; j < numSGs; ++j)
+                row[j] = std::exp((Float3::Dot(sampleDirs[i], sgs[j].Axis) - 1.0f) * sgs[j].Sharpness);
+
+            for(uint64 r = 0; r < numSGs; ++r)
+                for(uint64 c = 0; c < numSGs; ++c)
+                    partialAtA[r * numSGs + c] += double(row[r]) * row[c];
+        }
+    });
+
+    for(uint64 chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+        for(uint64 i = 0; i < numSGs * numSGs; ++i)
+            matrix.AtA[i] += chunkAtA[chunkIdx * numSGs * numSGs + i];
+
+    // A tiny bit of regularization keeps the factorization stable when the lobes overlap heavily
+    double maxDiag = 0.0;
+    for(uint64 j = 0; j < numSGs; ++j)
+        maxDiag = Max(maxDiag, matrix.AtA[j * numSGs + j]);
+    for(uint64 j = 0; j < numSGs; ++j)
+        matrix.AtA[j * numSGs + j] += maxDiag * 1e-9;
+
+    if(CholeskyFactor(matrix.AtA.Data(), numSGs, matrix.AtACholesky.Data()) == false)
+        throw Exception(L"Failed to factor the SG design matrix, the sample directions don't cover the SG basis");
+}
+
+// Returns the cached design matrix for the sample directions + SG basis, building it if needed and
+// evicting the least recently used one if the cache is full. The matrix is built outside of the lock
+// since building it uses the job system.
+static std::shared_ptr<const SGDesignMatrix> GetDesignMatrix(const Float3* sampleDirs, uint64 numSamples, const SG* sgs, uint64 numSGs)
+{
+    Array<Float4> basis(numSGs);
+    for(uint64 j = 0; j < numSGs; ++j)
+        basis[j] = Float4(sgs[j].Axis, sgs[j].Sharpness);
+
+    Hash key = GenerateHash(sampleDirs, int32(numSamples * sizeof(Float3)), uint32(numSamples));
+    key = CombineHashes(key, GenerateHash(basis.Data(), int32(basis.MemorySize()), uint32(numSGs)));
+
+    std::shared_ptr<const SGDesignMatrix> matrix;
+
+    AcquireSRWLockExclusive(&designMatrixCacheLock);
+    for(uint64 i = 0; i < MaxCachedDesignMatrices; ++i)
+    {
+        SGDesignMatrixCacheEntry& entry = designMatrixCache[i];
+        if(entry.Matrix != nullptr && entry.Key == key)
+        {
+            matrix = entry.Matrix;
+            entry.LastUse = ++designMatrixUseCount;
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&designMatrixCacheLock);
+
+    if(matrix != nullptr)
+        return matrix;
+
+    std::shared_ptr<SGDesignMatrix> newMatrix = std::make_shared<SGDesignMatrix>();
+    BuildDesignMatrix(sampleDirs, numSamples, sgs, numSGs, *newMatrix);
+
+    AcquireSRWLockExclusive(&designMatrixCacheLock);
+    uint64 slot = 0;
+    for(uint64 i = 1; i < MaxCachedDesignMatrices; ++i)
+    {
+        if(designMatrixCache[i].LastUse < designMatrixCache[slot].LastUse)
+            slot = i;
+    }
+    designMatrixCache[slot].Key = key;
+    designMatrixCache[slot].Matrix = newMatrix;
+    designMatrixCache[slot].LastUse = ++designMatrixUseCount;
+    ReleaseSRWLockExclusive(&designMatrixCacheLock);
+
+    return newMatrix;
+}
+
+// Computes A^T * b for one chunk of samples, for all 3 channels at once. partialATB is stored as [channel][sg].
+static void ComputeChunkATB(const SGDesignMatrix& matrix, const Float3* sampleValues, uint64 chunkIdx, double* partialATB)
+{
+    const uint64 numSGs = matrix.NumSGs;
+    const uint64 end = Min((chunkIdx + 1) * SGSamplesPerChunk, matrix.NumSamples);
+    for(uint64 i = chunkIdx * SGSamplesPerChunk; i < end; ++i)
+    {
+        const float* row = &matrix.A[i * numSGs];
+        const Float3 value = sampleValues[i];
+        for(uint64 j = 0; j < numSGs; ++j)
+        {
+            partialATB[0 * numSGs + j] += double(row[j]) * value.x;
+            partialATB[1 * numSGs + j] += double(row[j]) * value.y;
+            partialATB[2 * numSGs + j] += double(row[j]) * value.z;
+        }
+    }
+}
+
+// Adds up the per-chunk partial sums of A^T * b in chunk order and solves all three channels against the
+// shared design matrix. outSGs needs to already contain the SG basis that the design matrix was built from.
+static void SolveFromChunkATB(const SGDesignMatrix& matrix, const double* chunkATB, SGSolveMode solveMode, SG* outSGs)
+{
+    const uint64 numSGs = matrix.NumSGs;
+    const uint64 numChunks = (matrix.NumSamples + SGSamplesPerChunk - 1) / SGSamplesPerChunk;
+
+    Array<double> atb(numSGs * 3, 0.0);
+    for(uint64 chunkIdx = 0; chunkIdx < numChunks; ++chunkIdx)
+        for(uint64 i = 0; i < numSGs * 3; ++i)
+            atb[i] += chunkATB[chunkIdx * numSGs * 3 + i];
+
+    // Every channel is solved against the same matrix, stored as [channel][sg]
+    Array<double> solution(numSGs * 3);
+    for(uint64 channel = 0; channel < 3; ++channel)
+    {
+        const double* channelATB = &atb[channel * numSGs];
+        double* channelSolution = &solution[channel * numSGs];
+        if(solveMode == SGSolveMode::FactoredNNLS)
+            SolveNNLSNormalEquations(matrix.AtA.Data(), channelATB, numSGs, channelSolution);
+        else
+            CholeskySolve(matrix.AtACholesky.Data(), numSGs, channelATB, channelSolution);
+    }
+
+    for(uint64 j = 0; j < numSGs; ++j)
+        outSGs[j].Amplitude = Float3(float(solution[j]), float(solution[numSGs + j]), float(solution[numSGs * 2 + j]));
+}
+
+// Solves a single probe against the shared design matrix, with the chunks spread across the job system
+static void SolveFactored(const SGDesignMatrix& matrix, const Float3* sampleValues, SGSolveMode solveMode, SG* outSGs)
+{
+    const uint64 chunkSize = matrix.NumSGs * 3;
+    const uint64 numChunks = (matrix.NumSamples + SGSamplesPerChunk - 1) / SGSamplesPerChunk;
+
+    Array<double> chunkATB(numChunks * chunkSize, 0.0);
+    Jobs::ParallelFor(numChunks, [&](uint64 chunkIdx)
+    {
+        ComputeChunkATB(matrix, sampleValues, chunkIdx, &chunkATB[chunkIdx * chunkSize]);
+    });
+
+    SolveFromChunkATB(matrix, chunkATB.Data(), solveMode, outSGs);
+}
+
+static bool IsFactoredSolveMode(SGSolveMode solveMode)
+{
+    return solveMode == SGSolveMode::FactoredLS || solveMode == SGSolveMode::FactoredNNLS;
+}
+
 // Solve the set of spherical gaussians based on input set of data
 void SolveSGs(SGSolveParams& params)
 {
     GenerateUniformSGs(params.OutSGs, params.NumSGs, params.Distribution);
 
+    if(IsFactoredSolveMode(params.SolveMode))
+    {
+        Assert_(params.SampleDirs != nullptr);
+        Assert_(params.SampleValues != nullptr);
+
+        const std::shared_ptr<const SGDesignMatrix> matrix = GetDesignMatrix(params.SampleDirs, params.NumSamples,
+                                                                             params.OutSGs, params.NumSGs);
+        SolveFactored(*matrix, params.SampleValues, params.SolveMode, params.OutSGs);
+        return;
+    }
+
     #if EnableEigen_
         if(params.SolveMode == SGSolveMode::NNLS)
             SolveNNLS(params);
@@ -250,6 +606,63 @@ void SolveSGs(SGSolveParams& params)
     #endif
 }
 
+void SolveSGsBatch(const SGBatchSolveParams& params)
+{
+    Assert_(params.SampleDirs != nullptr);
+    Assert_(params.SampleValues != nullptr);
+    Assert_(params.OutSGs != nullptr);
+    Assert_(params.NumSGs > 0);
+
+    if(params.NumProbes == 0)
+        return;
+
+    if(IsFactoredSolveMode(params.SolveMode) == false)
+    {
+        // The other modes don't share anything between probes, so just run the regular solve for each one
+        Jobs::ParallelFor(params.NumProbes, [&](uint64 probeIdx)
+        {
+            SGSolveParams probeParams;
+            probeParams.SampleDirs = const_cast<Float3*>(params.SampleDirs);
+            probeParams.SampleValues = const_cast<Float3*>(params.SampleValues + probeIdx * params.NumSamples);
+            probeParams.NumSamples = params.NumSamples;
+            probeParams.SolveMode = params.SolveMode;
+            probeParams.Distribution = params.Distribution;
+            probeParams.NumSGs = params.NumSGs;
+            probeParams.OutSGs = params.OutSGs + probeIdx * params.NumSGs;
+            SolveSGs(probeParams);
+        }, params.MaxThreads);
+
+        return;
+    }
+
+    // Every probe uses the same basis, so it only needs to be generated once
+    Array<SG> basis(params.NumSGs);
+    GenerateUniformSGs(basis.Data(), params.NumSGs, params.Distribution);
+    const std::shared_ptr<const SGDesignMatrix> matrix = GetDesignMatrix(params.SampleDirs, params.NumSamples,
+                                                                         basis.Data(), params.NumSGs);
+
+    // Every (probe, chunk) pair gets its own slot for its partial sums, and each probe's chunks are then
+    // added up in chunk order. This gives the same result as SolveSGs() no matter how many threads ran.
+    const uint64 chunkSize = params.NumSGs * 3;
+    const uint64 numChunks = (params.NumSamples + SGSamplesPerChunk - 1) / SGSamplesPerChunk;
+    Array<double> chunkATB(params.NumProbes * numChunks * chunkSize, 0.0);
+    Jobs::ParallelFor(params.NumProbes * numChunks, [&](uint64 idx)
+    {
+        const uint64 probeIdx = idx / numChunks;
+        const uint64 chunkIdx = idx % numChunks;
+        ComputeChunkATB(*matrix, params.SampleValues + probeIdx * params.NumSamples, chunkIdx, &chunkATB[idx * chunkSize]);
+    }, params.MaxThreads);
+
+    Jobs::ParallelFor(params.NumProbes, [&](uint64 probeIdx)
+    {
+        SG* probeSGs = params.OutSGs + probeIdx * params.NumSGs;
+        for(uint64 j = 0; j < params.NumSGs; ++j)
+            probeSGs[j] = basis[j];
+
+        SolveFromChunkATB(*matrix, &chunkATB[probeIdx * numChunks * chunkSize], params.SolveMode, probeSGs);
+    }, params.MaxThreads);
+}
+
 void SolveSGsForCubemap(const Texture& texture, SG* outSGs, uint64 numSGs, SGSolveMode solveMode)
 {
     Assert_(texture.Cubemap);
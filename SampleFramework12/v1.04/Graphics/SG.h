@@ -98,7 +98,13 @@ enum class SGSolveMode : uint32
 {
     NNLS,
     SVD,
-    Projection
+    Projection,
+
+    // These build the design matrix and its normal equations once per set of sample directions and SG
+    // basis and cache them, so that solving additional probes with the same layout is cheap. They
+    // don't depend on Eigen, unlike NNLS and SVD which fall back to Projection without it.
+    FactoredLS,
+    FactoredNNLS,
 };
 
 enum class SGDistribution : uint32
@@ -121,11 +127,32 @@ struct SGSolveParams
     SG* OutSGs = nullptr;                           // output of final SG's we solve for
 };
 
+// Input parameters for solving many probes that share the same sample directions
+struct SGBatchSolveParams
+{
+    const Float3* SampleDirs = nullptr;             // NumSamples directions shared by all probes
+    const Float3* SampleValues = nullptr;           // NumSamples values for each probe
+    uint64 NumSamples = 0;
+    uint64 NumProbes = 0;
+
+    SGSolveMode SolveMode = SGSolveMode::FactoredNNLS;
+    SGDistribution Distribution = SGDistribution::Spherical;
+
+    uint64 NumSGs = 0;                              // number of SG's we want to solve for, per probe
+    SG* OutSGs = nullptr;                           // NumSGs output SG's for each probe
+
+    uint32 MaxThreads = 0;                          // 0 means use all of the job system's threads
+};
+
 void GenerateUniformSGs(SG* outSGs, uint64 numSGs, SGDistribution distribution);
 
 // Solve for k-number of SG's based on a sphere or hemisphere of samples
 void SolveSGs(SGSolveParams& params);
 
+// Solves a batch of probes in parallel using the job system. The factored modes give the same results
+// as calling SolveSGs() for each probe, regardless of the number of threads.
+void SolveSGsBatch(const SGBatchSolveParams& params);
+
 // Projects a sample onto a set of SG's
 void ProjectOntoSGs(const Float3& dir, const Float3& color, SG* outSGs, uint64 numSGs);
 
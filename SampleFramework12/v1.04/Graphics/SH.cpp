@@ -10,9 +10,12 @@
 #include "PCH.h"
 #include "SH.h"
 #include "..\\Utility.h"
+#include "..\\Jobs.h"
 #include "ShaderCompilation.h"
 #include "Textures.h"
 
+#include <memory>
+
 namespace SampleFramework12
 {
 
@@ -114,45 +117,254 @@ H4 ConvertToH4(const SH9& sh)
     return hBasis;
 }
 
-SH9Color ProjectCubemapToSH(const Texture& texture)
+// Per-resolution tables used for projecting cubemaps. The basis functions are stored as planar
+// arrays with the solid angle weight pre-multiplied, and with each row padded out to a multiple
+// of the SIMD width so that the projection loop can always work on full batches of texels.
+struct CubemapProjectionTable
 {
-    Assert_(texture.Cubemap);
+    static const uint32 BatchSize = 4;
 
-    TextureData<Float4> textureData;
-    GetTextureData(texture, textureData);
-    Assert_(textureData.NumSlices == 6);
-    const uint32 width = textureData.Width;
-    const uint32 height = textureData.Height;
+    uint32 Resolution = 0;
+    uint32 RowStride = 0;
+    uint64 PlaneSize = 0;
+    Array<float> SH9Basis;      // 9 planes of PlaneSize
+    Array<float> H4Basis;       // 4 planes of PlaneSize, zero for the -Z hemisphere
+    float SH9WeightSum = 0.0f;
+    float H4WeightSum = 0.0f;
+};
 
-    SH9Color result;
-    float weightSum = 0.0f;
-    for(uint32 face = 0; face < 6; ++face)
+// Tables for the most recently used resolutions. The cache is bounded since a table is ~52 bytes per
+// texel, and callers hold a reference so that an evicted table stays alive until they're done with it.
+static const uint64 MaxProjectionTables = 4;
+static std::shared_ptr<const CubemapProjectionTable> projectionTables[MaxProjectionTables];
+static uint64 projectionTableLastUse[MaxProjectionTables] = { };
+static uint64 projectionTableUseCount = 0;
+static SRWLOCK projectionTablesLock = SRWLOCK_INIT;
+
+static void BuildProjectionTable(uint32 resolution, CubemapProjectionTable& table)
+{
+    table.Resolution = resolution;
+    table.RowStride = AlignTo(resolution, CubemapProjectionTable::BatchSize);
+    table.PlaneSize = uint64(table.RowStride) * resolution * 6;
+    table.SH9Basis.Init(table.PlaneSize * 9, 0.0f);
+    table.H4Basis.Init(table.PlaneSize * 4, 0.0f);
+
+    const uint32 numRows = resolution * 6;
+    Array<float> rowSH9WeightSums(numRows, 0.0f);
+    Array<float> rowH4WeightSums(numRows, 0.0f);
+
+    Jobs::ParallelFor(numRows, [&](uint64 row)
     {
-        for(uint32 y = 0; y < height; ++y)
+        const uint32 face = uint32(row / resolution);
+        const uint32 y = uint32(row % resolution);
+        for(uint32 x = 0; x < resolution; ++x)
         {
-            for(uint32 x = 0; x < width; ++x)
-            {
-                const uint32 idx = face * (width * height) + y * (width) + x;
-                Float3 sample = textureData.Texels[idx].To3D();
+            float u = (x + 0.5f) / resolution;
+            float v = (y + 0.5f) / resolution;
 
-                float u = (x + 0.5f) / width;
-                float v = (y + 0.5f) / height;
+            // Account for cubemap texel distribution
+            u = u * 2.0f - 1.0f;
+            v = v * 2.0f - 1.0f;
+            const float temp = 1.0f + u * u + v * v;
+            const float weight = 4.0f / (sqrt(temp) * temp);
 
-                // Account for cubemap texel distribution
-                u = u * 2.0f - 1.0f;
-                v = v * 2.0f - 1.0f;
-                const float temp = 1.0f + u * u + v * v;
-                const float weight = 4.0f / (sqrt(temp) * temp);
+            const Float3 dir = MapXYSToDirection(x, y, face, resolution, resolution);
+            const uint64 idx = row * table.RowStride + x;
 
-                Float3 dir = MapXYSToDirection(x, y, face, width, height);
-                result += ProjectOntoSH9Color(dir, sample) * weight;
-                weightSum += weight;
+            const SH9 sh9 = ProjectOntoSH9(dir);
+            for(uint64 i = 0; i < 9; ++i)
+                table.SH9Basis[i * table.PlaneSize + idx] = sh9[i] * weight;
+            rowSH9WeightSums[row] += weight;
+
+            if(dir.z >= 0.0f)
+            {
+                const H4 h4 = ProjectOntoH4(dir);
+                for(uint64 i = 0; i < 4; ++i)
+                    table.H4Basis[i * table.PlaneSize + idx] = h4[i] * weight;
+                rowH4WeightSums[row] += weight;
             }
         }
+    });
+
+    for(uint32 row = 0; row < numRows; ++row)
+    {
+        table.SH9WeightSum += rowSH9WeightSums[row];
+        table.H4WeightSum += rowH4WeightSums[row];
+    }
+}
+
+// Returns the table for the given resolution, building it on first use and evicting the least
+// recently used one if the cache is full. The table is built outside of the lock since building it
+// uses the job system, and a job waiting on the lock could deadlock.
+static std::shared_ptr<const CubemapProjectionTable> GetProjectionTable(uint32 resolution)
+{
+    std::shared_ptr<const CubemapProjectionTable> table;
+
+    AcquireSRWLockExclusive(&projectionTablesLock);
+    for(uint64 i = 0; i < MaxProjectionTables; ++i)
+    {
+        if(projectionTables[i] != nullptr && projectionTables[i]->Resolution == resolution)
+        {
+            table = projectionTables[i];
+            projectionTableLastUse[i] = ++projectionTableUseCount;
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&projectionTablesLock);
+
+    if(table != nullptr)
+        return table;
+
+    std::shared_ptr<CubemapProjectionTable> newTable = std::make_shared<CubemapProjectionTable>();
+    BuildProjectionTable(resolution, *newTable);
+
+    // If another thread beat us to it we end up with two copies for a while, which is harmless
+    AcquireSRWLockExclusive(&projectionTablesLock);
+    uint64 slot = 0;
+    for(uint64 i = 1; i < MaxProjectionTables; ++i)
+    {
+        if(projectionTableLastUse[i] < projectionTableLastUse[slot])
+            slot = i;
+    }
+    projectionTables[slot] = newTable;
+    projectionTableLastUse[slot] = ++projectionTableUseCount;
+    ReleaseSRWLockExclusive(&projectionTablesLock);
+
+    return newTable;
+}
+
+static float SumLanes(DirectX::FXMVECTOR v)
+{
+    DirectX::XMFLOAT4 lanes;
+    DirectX::XMStoreFloat4(&lanes, v);
+    return (lanes.x + lanes.y) + (lanes.z + lanes.w);
+}
+
+// Accumulates N weighted basis functions for one row of texels, processing a full batch of texels per
+// iteration. The RGB channels are transposed into separate registers so that each basis plane only
+// needs to be loaded once per batch.
+template<uint64 N> static void ProjectRow(const Float4* rowTexels, uint32 width, const float* basis, uint64 planeSize,
+                                          SH<Float3, N>& result)
+{
+    using namespace DirectX;
+
+    XMVECTOR accR[N];
+    XMVECTOR accG[N];
+    XMVECTOR accB[N];
+    for(uint64 i = 0; i < N; ++i)
+        accR[i] = accG[i] = accB[i] = XMVectorZero();
+
+    const uint32 batchSize = CubemapProjectionTable::BatchSize;
+    for(uint32 x = 0; x < width; x += batchSize)
+    {
+        const Float4* batchTexels = rowTexels + x;
+
+        // The table is padded with zeros past the end of the row, but the texel data isn't
+        Float4 tailTexels[batchSize];
+        if(x + batchSize > width)
+        {
+            for(uint32 i = 0; i < batchSize; ++i)
+                tailTexels[i] = x + i < width ? rowTexels[x + i] : Float4(0.0f);
+            batchTexels = tailTexels;
+        }
+
+        XMMATRIX texels;
+        texels.r[0] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&batchTexels[0]));
+        texels.r[1] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&batchTexels[1]));
+        texels.r[2] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&batchTexels[2]));
+        texels.r[3] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&batchTexels[3]));
+        texels = XMMatrixTranspose(texels);
+
+        for(uint64 i = 0; i < N; ++i)
+        {
+            const XMVECTOR b = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(basis + i * planeSize + x));
+            accR[i] = XMVectorMultiplyAdd(b, texels.r[0], accR[i]);
+            accG[i] = XMVectorMultiplyAdd(b, texels.r[1], accG[i]);
+            accB[i] = XMVectorMultiplyAdd(b, texels.r[2], accB[i]);
+        }
     }
 
-    result *= (4.0f * 3.14159f) / weightSum;
+    for(uint64 i = 0; i < N; ++i)
+        result[i] = Float3(SumLanes(accR[i]), SumLanes(accG[i]), SumLanes(accB[i]));
+}
+
+void ProjectCubemap(const TextureData<Float4>& cubemapData, SH9Color* sh, H4Color* h4)
+{
+    Assert_(cubemapData.NumSlices == 6);
+    Assert_(cubemapData.Width == cubemapData.Height);
+    Assert_(sh != nullptr || h4 != nullptr);
+
+    const uint32 resolution = cubemapData.Width;
+    const std::shared_ptr<const CubemapProjectionTable> tablePtr = GetProjectionTable(resolution);
+    const CubemapProjectionTable& table = *tablePtr;
+
+    // Each row gets its own partial sum, and the rows are then added together in order so that the
+    // result doesn't depend on how the work was split up across threads
+    const uint32 numRows = resolution * 6;
+    Array<SH9Color> rowSH(sh ? numRows : 0);
+    Array<H4Color> rowH4(h4 ? numRows : 0);
+
+    const uint64 rowsPerJob = Max<uint64>(1, 4096 / resolution);
+    Jobs::ParallelForRange(numRows, rowsPerJob, [&](uint64 startRow, uint64 endRow, uint32 threadIdx)
+    {
+        for(uint64 row = startRow; row < endRow; ++row)
+        {
+            const Float4* rowTexels = &cubemapData.Texels[row * resolution];
+            const uint64 tableOffset = row * table.RowStride;
+            if(sh)
+                ProjectRow<9>(rowTexels, resolution, table.SH9Basis.Data() + tableOffset, table.PlaneSize, rowSH[row]);
+            if(h4)
+                ProjectRow<4>(rowTexels, resolution, table.H4Basis.Data() + tableOffset, table.PlaneSize, rowH4[row]);
+        }
+    });
+
+    if(sh)
+    {
+        *sh = SH9Color();
+        for(uint32 row = 0; row < numRows; ++row)
+            *sh += rowSH[row];
+        *sh *= (4.0f * 3.14159f) / table.SH9WeightSum;
+    }
+
+    if(h4)
+    {
+        *h4 = H4Color();
+        for(uint32 row = 0; row < numRows; ++row)
+            *h4 += rowH4[row];
+        *h4 *= (2.0f * 3.14159f) / table.H4WeightSum;
+    }
+}
+
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& cubemapData)
+{
+    SH9Color result;
+    ProjectCubemap(cubemapData, &result, nullptr);
+    return result;
+}
+
+H4Color ProjectCubemapToH4(const TextureData<Float4>& cubemapData)
+{
+    H4Color result;
+    ProjectCubemap(cubemapData, nullptr, &result);
     return result;
 }
 
+SH9Color ProjectCubemapToSH(const Texture& texture)
+{
+    Assert_(texture.Cubemap);
+
+    TextureData<Float4> textureData;
+    GetTextureData(texture, textureData);
+    return ProjectCubemapToSH(textureData);
+}
+
+H4Color ProjectCubemapToH4(const Texture& texture)
+{
+    Assert_(texture.Cubemap);
+
+    TextureData<Float4> textureData;
+    GetTextureData(texture, textureData);
+    return ProjectCubemapToH4(textureData);
+}
+
 }
\ No newline at end of file
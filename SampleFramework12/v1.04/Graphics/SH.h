@@ -16,6 +16,7 @@ namespace SampleFramework12
 {
 
 struct Texture;
+template<typename T> struct TextureData;
 
 // Constants
 static const float CosineA0 = 1.0f * Pi;
@@ -225,8 +226,13 @@ H4 ProjectOntoH4(const Float3& dir);
 float EvalH4(const H4& h, const Float3& dir);
 H4 ConvertToH4(const SH9& sh);
 
-// Lighting environment generation functions
+// Lighting environment generation functions. Cubemaps are projected in SIMD batches of texels using
+// per-resolution tables of weighted basis values, and H4 projection uses the +Z hemisphere.
 SH9Color ProjectCubemapToSH(const Texture& texture);
+SH9Color ProjectCubemapToSH(const TextureData<Float4>& cubemapData);
+H4Color ProjectCubemapToH4(const Texture& texture);
+H4Color ProjectCubemapToH4(const TextureData<Float4>& cubemapData);
+void ProjectCubemap(const TextureData<Float4>& cubemapData, SH9Color* sh, H4Color* h4);
 
 // Constants
 static const H4 H4Identity = H4(std::sqrt(2.0f * 3.14159f), 0.0f, 0.0f, 0.0f);
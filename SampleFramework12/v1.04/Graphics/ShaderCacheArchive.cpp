@@ -0,0 +1,395 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ShaderCacheArchive.h"
+
+#include "../Utility.h"
+#include "../Exceptions.h"
+
+#include <algorithm>
+
+namespace SampleFramework12
+{
+
+// The archive header is followed by the entry table, which is followed by the bytecode
+static const uint64 ArchiveMagic = 0x45564843524153ULL;    // "SARCHVE"
+static const uint64 ArchiveVersion = 1;
+static const uint64 ArchiveDataAlignment = 16;
+
+// Every record in the log has a header followed by the bytecode. Tombstones have no data.
+static const uint64 LogRecordMagic = 0x474F4C524453ULL;        // "SDRLOG"
+static const uint64 LogTombstoneMagic = 0x424D4F54524453ULL;   // "SDRTOMB"
+
+struct ArchiveHeader
+{
+    uint64 Magic = 0;
+    uint64 Version = 0;
+    uint64 NumEntries = 0;
+};
+
+struct LogRecordHeader
+{
+    uint64 Magic = 0;
+    Hash Key;
+    uint64 Size = 0;
+    Hash DataHash;
+};
+
+ShaderCacheArchive::~ShaderCacheArchive()
+{
+    Close();
+}
+
+void ShaderCacheArchive::Open(const wchar* archivePath_, const wchar* logPath_)
+{
+    Assert_(IsOpen() == false);
+
+    archivePath = archivePath_;
+    logPath = logPath_;
+
+    OpenArchive();
+
+    if(LoadLog() == false)
+    {
+        WriteLog(L"Shader cache log %ls has a partially-written record at the end, compacting it", logPath.c_str());
+        Compact();
+    }
+}
+
+void ShaderCacheArchive::Close()
+{
+    archiveMapping.Close();
+    entries = nullptr;
+    numEntries = 0;
+    logEntries.clear();
+    removedData.Shutdown();
+    archivePath.clear();
+    logPath.clear();
+}
+
+void ShaderCacheArchive::OpenArchive()
+{
+    entries = nullptr;
+    numEntries = 0;
+
+    if(FileExists(archivePath.c_str()) == false || GetFileSizeInBytes(archivePath.c_str()) == 0)
+        return;
+
+    archiveMapping.Open(archivePath.c_str());
+    const uint8* fileData = archiveMapping.Data();
+    const uint64 fileSize = archiveMapping.Size();
+
+    ArchiveHeader header;
+    bool valid = fileSize >= sizeof(ArchiveHeader);
+    if(valid)
+    {
+        memcpy(&header, fileData, sizeof(ArchiveHeader));
+        valid = header.Magic == ArchiveMagic && header.Version == ArchiveVersion;
+        valid = valid && header.NumEntries <= (fileSize - sizeof(ArchiveHeader)) / sizeof(ShaderCacheArchiveEntry);
+    }
+
+    const ShaderCacheArchiveEntry* tableEntries = reinterpret_cast<const ShaderCacheArchiveEntry*>(fileData + sizeof(ArchiveHeader));
+    for(uint64 i = 0; i < header.NumEntries && valid; ++i)
+    {
+        const ShaderCacheArchiveEntry& entry = tableEntries[i];
+        valid = entry.Offset % ArchiveDataAlignment == 0 && entry.Offset <= fileSize && entry.Size <= fileSize - entry.Offset;
+        valid = valid && (i == 0 || tableEntries[i - 1].Key < entry.Key);
+    }
+
+    if(valid == false)
+    {
+        WriteLog(L"Ignoring shader cache archive %ls, since it's out of date or corrupted", archivePath.c_str());
+        archiveMapping.Close();
+        return;
+    }
+
+    entries = tableEntries;
+    numEntries = header.NumEntries;
+}
+
+// Returns false if a partially-written record was found at the end of the log
+bool ShaderCacheArchive::LoadLog()
+{
+    if(FileExists(logPath.c_str()) == false)
+        return true;
+
+    Array<uint8> logData;
+    ReadFileAsByteArray(logPath.c_str(), logData);
+
+    uint64 offset = 0;
+    while(offset < logData.Size())
+    {
+        LogRecordHeader record;
+        if(logData.Size() - offset < sizeof(LogRecordHeader))
+            return false;
+
+        memcpy(&record, logData.Data() + offset, sizeof(LogRecordHeader));
+        offset += sizeof(LogRecordHeader);
+        const bool tombstone = record.Magic == LogTombstoneMagic;
+        if((record.Magic != LogRecordMagic && tombstone == false) || record.Size > logData.Size() - offset)
+            return false;
+
+        const uint8* recordData = logData.Data() + offset;
+        if(GenerateHash(recordData, int32(record.Size)) != record.DataHash)
+            return false;
+
+        offset += record.Size;
+
+        // Later records for the same key replace the earlier ones
+        LogEntry& entry = logEntries[record.Key];
+        entry.Data.Init(record.Size);
+        entry.Removed = tombstone;
+        if(record.Size > 0)
+            memcpy(entry.Data.Data(), recordData, record.Size);
+    }
+
+    return true;
+}
+
+bool ShaderCacheArchive::FindInArchive(Hash key, const uint8*& data, uint64& size) const
+{
+    const ShaderCacheArchiveEntry* first = entries;
+    const ShaderCacheArchiveEntry* last = entries + numEntries;
+    const ShaderCacheArchiveEntry* found = std::lower_bound(first, last, key, [](const ShaderCacheArchiveEntry& entry, Hash value)
+    {
+        return entry.Key < value;
+    });
+
+    if(found == last || found->Key != key)
+        return false;
+
+    data = archiveMapping.Data() + found->Offset;
+    size = found->Size;
+    return true;
+}
+
+bool ShaderCacheArchive::Find(Hash key, const uint8*& data, uint64& size) const
+{
+    AcquireSRWLockShared(&lock);
+
+    // Entries in the log are newer than the packed archive, so they win (the same as in Compact())
+    bool found = false;
+    auto logEntry = logEntries.find(key);
+    if(logEntry != logEntries.end())
+    {
+        data = logEntry->second.Data.Data();
+        size = logEntry->second.Data.Size();
+        found = logEntry->second.Removed == false;
+    }
+    else
+    {
+        found = FindInArchive(key, data, size);
+    }
+
+    ReleaseSRWLockShared(&lock);
+
+    return found;
+}
+
+bool ShaderCacheArchive::Contains(Hash key) const
+{
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    return Find(key, data, size);
+}
+
+uint64 ShaderCacheArchive::NumLogEntries() const
+{
+    AcquireSRWLockShared(&lock);
+    const uint64 numLogEntries = logEntries.size();
+    ReleaseSRWLockShared(&lock);
+
+    return numLogEntries;
+}
+
+const uint8* ShaderCacheArchive::Add(Hash key, const void* data, uint64 size)
+{
+    Assert_(IsOpen());
+
+    AcquireSRWLockExclusive(&lock);
+
+    // Two threads might have compiled the same shader. Whoever got here first wins, since
+    // somebody could already be holding on to a pointer to their copy.
+    auto existing = logEntries.find(key);
+    if(existing != logEntries.end() && existing->second.Removed == false)
+    {
+        const uint8* existingData = existing->second.Data.Data();
+        ReleaseSRWLockExclusive(&lock);
+        return existingData;
+    }
+
+    LogEntry& entry = logEntries[key];
+    if(entry.Data.Size() > 0)
+        removedData.Add() = std::move(entry.Data);
+    entry.Data.Init(size);
+    entry.Removed = false;
+    memcpy(entry.Data.Data(), data, size);
+
+    AppendLogRecord(LogRecordMagic, key, data, size);
+
+    ReleaseSRWLockExclusive(&lock);
+
+    return entry.Data.Data();
+}
+
+void ShaderCacheArchive::Remove(Hash key)
+{
+    Assert_(IsOpen());
+
+    AcquireSRWLockExclusive(&lock);
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    auto existing = logEntries.find(key);
+    const bool inLog = existing != logEntries.end() && existing->second.Removed == false;
+    if(inLog || (existing == logEntries.end() && FindInArchive(key, data, size)))
+    {
+        LogEntry& entry = logEntries[key];
+        if(entry.Data.Size() > 0)
+            removedData.Add() = std::move(entry.Data);
+        entry.Removed = true;
+
+        AppendLogRecord(LogTombstoneMagic, key, nullptr, 0);
+    }
+
+    ReleaseSRWLockExclusive(&lock);
+}
+
+// Needs to be called with the lock held
+void ShaderCacheArchive::AppendLogRecord(uint64 magic, Hash key, const void* data, uint64 size)
+{
+    // Write the whole record in one go, so that it's either all there or detectably cut off
+    LogRecordHeader record;
+    record.Magic = magic;
+    record.Key = key;
+    record.Size = size;
+    record.DataHash = GenerateHash(data, int32(size));
+
+    Array<uint8> recordData(sizeof(LogRecordHeader) + size);
+    memcpy(recordData.Data(), &record, sizeof(LogRecordHeader));
+    if(size > 0)
+        memcpy(recordData.Data() + sizeof(LogRecordHeader), data, size);
+
+    try
+    {
+        File logFile(logPath.c_str(), FileOpenMode::Append);
+        logFile.Write(recordData.Size(), recordData.Data());
+    }
+    catch(Exception& exception)
+    {
+        // The data is still usable, it just won't be cached for next time
+        WriteLog(L"Failed to write to shader cache log %ls: %ls", logPath.c_str(), exception.GetMessage().c_str());
+    }
+}
+
+bool ShaderCacheArchive::Compact()
+{
+    Assert_(IsOpen());
+
+    AcquireSRWLockExclusive(&lock);
+
+    // Gather everything from both places, with the log taking priority
+    struct SourceEntry
+    {
+        Hash Key;
+        const uint8* Data = nullptr;
+        uint64 Size = 0;
+    };
+
+    List<SourceEntry> sourceEntries;
+    sourceEntries.Reserve(numEntries + logEntries.size());
+    for(uint64 i = 0; i < numEntries; ++i)
+    {
+        if(logEntries.find(entries[i].Key) == logEntries.end())
+            sourceEntries.Add({ entries[i].Key, archiveMapping.Data() + entries[i].Offset, entries[i].Size });
+    }
+
+    for(const auto& logEntry : logEntries)
+    {
+        if(logEntry.second.Removed == false)
+            sourceEntries.Add({ logEntry.first, logEntry.second.Data.Data(), logEntry.second.Data.Size() });
+    }
+
+    std::sort(sourceEntries.Data(), sourceEntries.Data() + sourceEntries.Count(), [](const SourceEntry& a, const SourceEntry& b)
+    {
+        return a.Key < b.Key;
+    });
+
+    ArchiveHeader header;
+    header.Magic = ArchiveMagic;
+    header.Version = ArchiveVersion;
+    header.NumEntries = sourceEntries.Count();
+
+    Array<ShaderCacheArchiveEntry> table(sourceEntries.Count());
+    uint64 dataOffset = AlignTo(sizeof(ArchiveHeader) + sizeof(ShaderCacheArchiveEntry) * table.Size(), ArchiveDataAlignment);
+    for(uint64 i = 0; i < sourceEntries.Count(); ++i)
+    {
+        table[i].Key = sourceEntries[i].Key;
+        table[i].Offset = dataOffset;
+        table[i].Size = sourceEntries[i].Size;
+        dataOffset = AlignTo(dataOffset + table[i].Size, ArchiveDataAlignment);
+    }
+
+    const std::wstring tempPath = archivePath + L".tmp";
+    bool replaced = false;
+    try
+    {
+        {
+            File file(tempPath.c_str(), FileOpenMode::Write);
+            file.Write(header);
+            if(table.Size() > 0)
+                file.Write(table.Size() * sizeof(ShaderCacheArchiveEntry), table.Data());
+
+            const uint8 padding[ArchiveDataAlignment] = { };
+            uint64 fileOffset = sizeof(ArchiveHeader) + sizeof(ShaderCacheArchiveEntry) * table.Size();
+            for(uint64 i = 0; i < sourceEntries.Count(); ++i)
+            {
+                file.Write(table[i].Offset - fileOffset, padding);
+                file.Write(table[i].Size, sourceEntries[i].Data);
+                fileOffset = table[i].Offset + table[i].Size;
+            }
+        }
+
+        // The old archive has to be unmapped before it can be replaced
+        archiveMapping.Close();
+        entries = nullptr;
+        numEntries = 0;
+
+        replaced = MoveFileEx(tempPath.c_str(), archivePath.c_str(), MOVEFILE_REPLACE_EXISTING) != false;
+        if(replaced)
+        {
+            DeleteFile(logPath.c_str());
+            logEntries.clear();
+            removedData.Shutdown();
+        }
+        else
+        {
+            WriteLog(L"Failed to replace shader cache archive %ls, another process might be using it", archivePath.c_str());
+            DeleteFile(tempPath.c_str());
+        }
+    }
+    catch(Exception& exception)
+    {
+        WriteLog(L"Failed to compact shader cache archive %ls: %ls", archivePath.c_str(), exception.GetMessage().c_str());
+        DeleteFile(tempPath.c_str());
+    }
+
+    sourceEntries.Shutdown();
+
+    if(archiveMapping.IsOpen() == false)
+        OpenArchive();
+
+    ReleaseSRWLockExclusive(&lock);
+
+    return replaced;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\Containers.h"
+#include "..\\FileIO.h"
+#include "..\\MurmurHash.h"
+
+#include <map>
+
+namespace SampleFramework12
+{
+
+// Packed storage for compiled shaders. The archive is a single file with a table of entries sorted
+// by key, followed by the bytecode for all of the entries. It's memory-mapped when opened, so a
+// lookup is a binary search over the table that returns a pointer into the mapped view.
+//
+// Shaders that aren't in the archive get appended to a separate log file, which is read into
+// memory when the archive is opened. Compact() merges the log into a new archive file.
+struct ShaderCacheArchiveEntry
+{
+    Hash Key;
+    uint64 Offset = 0;
+    uint64 Size = 0;
+};
+
+class ShaderCacheArchive
+{
+
+public:
+
+    ~ShaderCacheArchive();
+
+    // Missing or invalid files are treated as being empty. A log with a partially-written record at
+    // the end gets compacted right away, so that new records aren't appended after the bad one.
+    void Open(const wchar* archivePath, const wchar* logPath);
+    void Close();
+
+    // The returned pointer stays valid until Compact() or Close() is called
+    bool Find(Hash key, const uint8*& data, uint64& size) const;
+    bool Contains(Hash key) const;
+
+    // Keeps a copy in memory and writes it to the log, and returns a pointer to the copy. This can
+    // be called from multiple threads.
+    const uint8* Add(Hash key, const void* data, uint64 size);
+
+    // Drops an entry, for instance because its data turned out to be unusable. A tombstone gets
+    // written to the log so that the entry stays dropped after re-opening, and a later Add() for
+    // the same key replaces it. Pointers returned from Find() stay valid until Compact() or Close().
+    void Remove(Hash key);
+
+    // Writes a new archive with the contents of the old archive and the log, and then deletes the
+    // log. Returns false if the old archive couldn't be replaced, in which case the log is kept.
+    bool Compact();
+
+    bool IsOpen() const { return archivePath.length() > 0; }
+    uint64 NumArchiveEntries() const { return numEntries; }
+    uint64 NumLogEntries() const;
+
+protected:
+
+    void OpenArchive();
+    bool LoadLog();
+    bool FindInArchive(Hash key, const uint8*& data, uint64& size) const;
+
+    struct LogEntry
+    {
+        Array<uint8> Data;
+        bool Removed = false;
+    };
+
+    void AppendLogRecord(uint64 magic, Hash key, const void* data, uint64 size);
+
+    std::wstring archivePath;
+    std::wstring logPath;
+
+    MemoryMappedFile archiveMapping;
+    const ShaderCacheArchiveEntry* entries = nullptr;
+    uint64 numEntries = 0;
+
+    std::map<Hash, LogEntry> logEntries;
+    List<Array<uint8>> removedData;     // kept around so that pointers from Find() stay valid
+
+    mutable SRWLOCK lock = SRWLOCK_INIT;
+};
+
+}
\ No newline at end of file
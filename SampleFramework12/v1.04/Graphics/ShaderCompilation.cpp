@@ -10,6 +10,8 @@
 #include "PCH.h"
 
 #include "ShaderCompilation.h"
+#include "ShaderPrecompiler.h"
+#include "ShaderCacheArchive.h"
 #include "DX12.h"
 
 #include "../Utility.h"
@@ -18,6 +20,9 @@
 #include "../FileIO.h"
 #include "../MurmurHash.h"
 #include "../Containers.h"
+#include "../Serialization.h"
+#include "../DirectoryWatcher.h"
+#include "../Jobs.h"
 
 using std::vector;
 using std::wstring;
@@ -28,13 +33,14 @@ using std::map;
 namespace AppSettings
 {
     void GetShaderCompileOptions(SampleFramework12::CompileOptions& opts);
+    void GetShaderPermutationOptions(SampleFramework12::List<SampleFramework12::ShaderPermutationOption>& options);
     bool ShaderCompileOptionsChanged();
 }
 
 namespace SampleFramework12
 {
 
-static const uint64 CacheVersion = 1;
+static const uint64 CacheVersion = 2;
 
 static const char* TypeStrings[] = { "vertex", "hull", "domain", "geometry", "amplification", "mesh", "pixel", "compute", "lib" };
 StaticAssert_(ArraySize_(TypeStrings) == uint64(ShaderType::NumTypes));
@@ -50,41 +56,197 @@ static const char* ProfileStrings[] =
 
 StaticAssert_(ArraySize_(ProfileStrings) == uint64(ShaderType::NumTypes));
 
-static Hash MakeCompilerHash()
+static const wstring baseCacheDir = L"ShaderCache\\";
+
+#if Debug_
+    static const wstring cacheSubDir = L"Debug\\";
+#else
+    static const std::wstring cacheSubDir = L"Release\\";
+#endif
+
+static const wstring cacheDir = baseCacheDir + cacheSubDir;
+
+static string MakeDefinesString(const D3D_SHADER_MACRO* defines)
+{
+    string definesString = "";
+    while(defines && defines->Name != nullptr && defines != nullptr)
+    {
+        if(definesString.length() > 0)
+            definesString += "|";
+        definesString += defines->Name;
+        definesString += "=";
+        definesString += defines->Definition;
+        ++defines;
+    }
+
+    return definesString;
+}
+
+static Hash MakeShaderCacheKey(Hash sourceHash, Hash compilerHash, const char* functionName,
+                               const char* profile, const D3D_SHADER_MACRO* defines)
 {
-    HMODULE module = LoadLibrary(L"dxcompiler.dll");
+    string hashString;
+    if(functionName != nullptr)
+    {
+        hashString += functionName;
+        hashString += "\n";
+    }
+    hashString += profile;
+    hashString += "\n";
 
-    if(module == nullptr)
-        throw Exception(L"Failed to load compiler DLL");
+    hashString += MakeDefinesString(defines);
 
-    wchar dllPath[1024] = { };
-    GetModuleFileName(module, dllPath, ArraySize_(dllPath));
+    hashString += MakeString("%llu", CacheVersion);
 
-    File dllFile(dllPath, FileOpenMode::Read);
-    uint64 fileSize = dllFile.Size();
-    Array<uint8> fileData(fileSize);
-    dllFile.Read(fileSize, fileData.Data());
+    Hash codeHash = GenerateHash(hashString.data(), int(hashString.length()), 0);
+    codeHash = CombineHashes(codeHash, sourceHash);
+    codeHash = CombineHashes(codeHash, compilerHash);
 
-    return GenerateHash(fileData.Data(), int32(fileSize));
+    return codeHash;
 }
 
-static Hash CompilerHash = MakeCompilerHash();
+static void CreateShaderCacheDirectory()
+{
+    if(CreateDirectory(baseCacheDir.c_str(), nullptr) == false && GetLastError() != ERROR_ALREADY_EXISTS)
+        throw Win32Exception(GetLastError());
 
-static string GetExpandedShaderCode(const wchar* path, List<wstring>& filePaths)
+    if(CreateDirectory(cacheDir.c_str(), nullptr) == false && GetLastError() != ERROR_ALREADY_EXISTS)
+        throw Win32Exception(GetLastError());
+}
+
+// All of the compiled shaders live in one archive file, instead of having a file per shader
+static ShaderCacheArchive CacheArchive;
+static bool CacheArchiveOpened = false;
+static SRWLOCK CacheArchiveLock = SRWLOCK_INIT;
+
+static ShaderCacheArchive& GetCacheArchive()
 {
-    for(uint64 i = 0; i < filePaths.Count(); ++i)
-        if(filePaths[i] == path)
-            return string();
+    AcquireSRWLockShared(&CacheArchiveLock);
+    const bool opened = CacheArchiveOpened;
+    ReleaseSRWLockShared(&CacheArchiveLock);
 
-    filePaths.Add(path);
+    if(opened)
+        return CacheArchive;
+
+    AcquireSRWLockExclusive(&CacheArchiveLock);
+
+    try
+    {
+        if(CacheArchiveOpened == false)
+        {
+            CreateShaderCacheDirectory();
+            CacheArchive.Open((cacheDir + L"Shaders.archive").c_str(), (cacheDir + L"Shaders.log").c_str());
+            CacheArchiveOpened = true;
+        }
+    }
+    catch(...)
+    {
+        ReleaseSRWLockExclusive(&CacheArchiveLock);
+        throw;
+    }
+
+    ReleaseSRWLockExclusive(&CacheArchiveLock);
+
+    return CacheArchive;
+}
+
+// == Dependency index ============================================================================
+
+// Remembers the content hash and #includes of every shader file that we've looked at, so that
+// building a cache key only needs the file timestamps instead of reading and expanding the source.
+// The index is saved in the cache directory, which keeps it valid across runs.
+struct ShaderFileIndexEntry
+{
+    wstring FilePath;
+    uint64 FileSize = 0;
+    uint64 Timestamp = 0;
+    Hash ContentHash;
+    List<wstring> Includes;     // resolved paths, in the order that they appear in the file
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, FilePath);
+        SerializeItem(serializer, FileSize);
+        SerializeItem(serializer, Timestamp);
+        SerializeItem(serializer, ContentHash.A);
+        SerializeItem(serializer, ContentHash.B);
+        SerializeItem(serializer, Includes);
+    }
+};
+
+static const uint64 ShaderIndexVersion = 1;
+static List<ShaderFileIndexEntry> ShaderIndex;
+static map<wstring, uint64> ShaderIndexLookup;
+static bool ShaderIndexLoaded = false;
+static bool ShaderIndexDirty = false;
+static SRWLOCK ShaderIndexLock = SRWLOCK_INIT;
+
+static wstring ShaderIndexPath()
+{
+    return cacheDir + L"DependencyIndex.bin";
+}
+
+static void ClearShaderIndex()
+{
+    for(ShaderFileIndexEntry& entry : ShaderIndex)
+        entry.Includes.Shutdown();
+    ShaderIndex.Shutdown();
+    ShaderIndexLookup.clear();
+}
+
+static void LoadShaderIndex()
+{
+    ShaderIndexLoaded = true;
+
+    const wstring indexPath = ShaderIndexPath();
+    if(FileExists(indexPath.c_str()) == false)
+        return;
+
+    try
+    {
+        BufferedFileReadSerializer serializer(indexPath.c_str());
+        uint64 version = 0;
+        SerializeItem(serializer, version);
+        if(version == ShaderIndexVersion)
+            SerializeItem(serializer, ShaderIndex);
+    }
+    catch(Exception&)
+    {
+        // A truncated or corrupt index just means that everything gets re-hashed
+        ClearShaderIndex();
+    }
 
-    string fileContents = ReadFileAsString(path);
+    for(uint64 i = 0; i < ShaderIndex.Count(); ++i)
+        ShaderIndexLookup[ShaderIndex[i].FilePath] = i;
+}
+
+static void SaveShaderIndex()
+{
+    if(ShaderIndexDirty == false)
+        return;
+
+    CreateShaderCacheDirectory();
+
+    const wstring indexPath = ShaderIndexPath();
+    const wstring tempPath = indexPath + L".tmp";
+    {
+        BufferedFileWriteSerializer serializer(tempPath.c_str());
+        uint64 version = ShaderIndexVersion;
+        SerializeItem(serializer, version);
+        SerializeItem(serializer, ShaderIndex);
+        serializer.Flush();
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), indexPath.c_str(), MOVEFILE_REPLACE_EXISTING));
+    ShaderIndexDirty = false;
+}
 
+static void FindIncludes(const wchar* path, const string& fileContents, List<wstring>& includes)
+{
     wstring fileDirectory = GetDirectoryFromFilePath(path);
     if(fileDirectory.length() > 0)
         fileDirectory += L"\\";
 
-    // Look for includes
     size_t lineStart = 0;
     while(true)
     {
@@ -116,12 +278,7 @@ static string GetExpandedShaderCode(const wchar* path, List<wstring>& filePaths)
                 fullIncludePath = SampleFrameworkDir() + L"Shaders\\" + AnsiToWString(includePath.c_str());
             }
 
-            if(FileExists(fullIncludePath.c_str()) == false)
-                throw Exception(L"Couldn't find #included file \"" + fullIncludePath + L"\" in file " + path);
-
-            string includeCode = GetExpandedShaderCode(fullIncludePath.c_str(), filePaths);
-            fileContents.insert(lineEnd + 1, includeCode);
-            lineEnd += includeCode.length();
+            includes.Add(fullIncludePath);
         }
 
         if(lineEnd == string::npos)
@@ -129,57 +286,139 @@ static string GetExpandedShaderCode(const wchar* path, List<wstring>& filePaths)
 
         lineStart = lineEnd + 1;
     }
-
-    return fileContents;
 }
 
-static const wstring baseCacheDir = L"ShaderCache\\";
+// Returns the index entry for a file, which is only re-read if its size or timestamp changed.
+// Needs to be called with ShaderIndexLock held.
+static const ShaderFileIndexEntry& GetShaderIndexEntry(const wstring& path, bool scanIncludes)
+{
+    if(ShaderIndexLoaded == false)
+        LoadShaderIndex();
 
-#if Debug_
-    static const wstring cacheSubDir = L"Debug\\";
-#else
-    static const std::wstring cacheSubDir = L"Release\\";
-#endif
+    const uint64 fileSize = GetFileSizeInBytes(path.c_str());
+    const uint64 timestamp = GetFileTimestamp(path.c_str());
 
-static const wstring cacheDir = baseCacheDir + cacheSubDir;
+    uint64 entryIdx = uint64(-1);
+    auto lookup = ShaderIndexLookup.find(path);
+    if(lookup != ShaderIndexLookup.end())
+    {
+        entryIdx = lookup->second;
+        const ShaderFileIndexEntry& entry = ShaderIndex[entryIdx];
+        if(entry.FileSize == fileSize && entry.Timestamp == timestamp)
+            return entry;
+    }
+    else
+    {
+        entryIdx = ShaderIndex.Count();
+        ShaderIndex.Add().FilePath = path;
+        ShaderIndexLookup[path] = entryIdx;
+    }
 
-static string MakeDefinesString(const D3D_SHADER_MACRO* defines)
+    // The timestamp gets updated last, so that the entry stays stale if anything here throws
+    ShaderFileIndexEntry& entry = ShaderIndex[entryIdx];
+    entry.Includes.RemoveAll();
+    if(scanIncludes)
+    {
+        const string fileContents = ReadFileAsString(path.c_str());
+        entry.ContentHash = GenerateHash(fileContents.data(), int32(fileContents.length()));
+        FindIncludes(path.c_str(), fileContents, entry.Includes);
+    }
+    else
+    {
+        entry.ContentHash = GenerateFileHash(path.c_str());
+    }
+
+    entry.FileSize = fileSize;
+    entry.Timestamp = timestamp;
+    ShaderIndexDirty = true;
+
+    return entry;
+}
+
+// Walks the include graph in the same order that the preprocessor would expand it, skipping files
+// that were already visited, and combines the hashes of the files along the way
+static void HashShaderFile(const wstring& path, List<wstring>& filePaths, Hash& sourceHash)
 {
-    string definesString = "";
-    while(defines && defines->Name != nullptr && defines != nullptr)
+    for(uint64 i = 0; i < filePaths.Count(); ++i)
+        if(filePaths[i] == path)
+            return;
+
+    filePaths.Add(path);
+
+    const ShaderFileIndexEntry& entry = GetShaderIndexEntry(path, true);
+    sourceHash = CombineHashes(sourceHash, GenerateHash(path.data(), int32(path.length() * sizeof(wchar))));
+    sourceHash = CombineHashes(sourceHash, entry.ContentHash);
+
+    // The entry can move if the index grows, so make a copy of the includes
+    List<wstring> includes = entry.Includes;
+    for(const wstring& includePath : includes)
     {
-        if(definesString.length() > 0)
-            definesString += "|";
-        definesString += defines->Name;
-        definesString += "=";
-        definesString += defines->Definition;
-        ++defines;
+        if(FileExists(includePath.c_str()) == false)
+        {
+            includes.Shutdown();
+            throw Exception(L"Couldn't find #included file \"" + includePath + L"\" in file " + path);
+        }
+
+        HashShaderFile(includePath, filePaths, sourceHash);
     }
 
-    return definesString;
+    includes.Shutdown();
 }
 
-static wstring MakeShaderCacheName(const std::string& shaderCode, const char* functionName,
-                                   const char* profile, const D3D_SHADER_MACRO* defines)
+// Makes a hash off the shader file and everything that it includes, and returns the list of files
+static Hash MakeShaderSourceHash(const wchar* path, List<wstring>& filePaths)
 {
-    string hashString = shaderCode;
-    hashString += "\n";
-    if(functionName != nullptr)
+    Hash sourceHash;
+
+    AcquireSRWLockExclusive(&ShaderIndexLock);
+
+    try
     {
-        hashString += functionName;
-        hashString += "\n";
+        HashShaderFile(path, filePaths, sourceHash);
+    }
+    catch(...)
+    {
+        ReleaseSRWLockExclusive(&ShaderIndexLock);
+        throw;
     }
-    hashString += profile;
-    hashString += "\n";
 
-    hashString += MakeDefinesString(defines);
+    ReleaseSRWLockExclusive(&ShaderIndexLock);
 
-    hashString += MakeString("%llu", CacheVersion);
+    return sourceHash;
+}
 
-    Hash codeHash = GenerateHash(hashString.data(), int(hashString.length()), 0);
-    codeHash = CombineHashes(codeHash, CompilerHash);
+// The compiler DLL is large, so its hash goes through the index as well
+static Hash GetCompilerHash()
+{
+    static Hash compilerHash;
+    static bool initialized = false;
+
+    AcquireSRWLockExclusive(&ShaderIndexLock);
 
-    return cacheDir + codeHash.ToString() + L".cache";
+    try
+    {
+        if(initialized == false)
+        {
+            HMODULE module = LoadLibrary(L"dxcompiler.dll");
+            if(module == nullptr)
+                throw Exception(L"Failed to load compiler DLL");
+
+            wchar dllPath[1024] = { };
+            GetModuleFileName(module, dllPath, ArraySize_(dllPath));
+
+            compilerHash = GetShaderIndexEntry(dllPath, false).ContentHash;
+            initialized = true;
+        }
+    }
+    catch(...)
+    {
+        ReleaseSRWLockExclusive(&ShaderIndexLock);
+        throw;
+    }
+
+    ReleaseSRWLockExclusive(&ShaderIndexLock);
+
+    return compilerHash;
 }
 
 static HRESULT CompileShaderDXC(const wchar* path, const D3D_SHADER_MACRO* defines, const char* functionName,
@@ -262,14 +501,18 @@ static HRESULT CompileShaderDXC(const wchar* path, const D3D_SHADER_MACRO* defin
     return hr;
 }
 
-static void CompileShader(const wchar* path, const char* functionName, ShaderType type,
-                          const CompileOptions& baseCompileOpts, List<wstring>& filePaths,
-                          Array<uint8>& byteCode, bool& includesAppSettings)
+// Compiles the shader, or grabs it from the cache. Never waits on the user, so it's safe to call
+// from the job threads: compile errors come back through errorMessage instead. The AppSettings
+// constants are passed in, so that they can be grabbed on the main thread.
+static bool CompileShader(const wchar* path, const char* functionName, ShaderType type,
+                          const CompileOptions& baseCompileOpts, const CompileOptions& appSettingsCompileOpts,
+                          List<wstring>& filePaths, const uint8*& byteCode, uint64& byteCodeSize,
+                          bool& includesAppSettings, wstring& errorMessage)
 {
     if(FileExists(path) == false)
     {
-        Assert_(false);
-        throw Exception(L"Shader file " + std::wstring(path) + L" does not exist");
+        errorMessage = L"Shader file " + std::wstring(path) + L" does not exist";
+        return false;
     }
 
     uint64 profileIdx = uint64(type);
@@ -277,8 +520,7 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
     const char* profileString = ProfileStrings[profileIdx];
     includesAppSettings = false;
 
-    // Make a hash off the expanded shader code
-    string shaderCode = GetExpandedShaderCode(path, filePaths);
+    const Hash sourceHash = MakeShaderSourceHash(path, filePaths);
 
     for(const wstring& filePath : filePaths)
     {
@@ -289,21 +531,17 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
         }
     }
 
-    // Add AppSettings compile-time constants if necessary
-    CompileOptions opts = baseCompileOpts;
-    if(includesAppSettings)
-        AppSettings::GetShaderCompileOptions(opts);
+    // Use the AppSettings compile-time constants if necessary
+    const CompileOptions& opts = includesAppSettings ? appSettingsCompileOpts : baseCompileOpts;
 
     D3D_SHADER_MACRO defines[CompileOptions::MaxDefines + 1] = { };
     opts.MakeDefines(defines);
 
-    wstring cacheName = MakeShaderCacheName(shaderCode, functionName, profileString, defines);
+    const Hash cacheKey = MakeShaderCacheKey(sourceHash, GetCompilerHash(), functionName, profileString, defines);
 
-    if(FileExists(cacheName.c_str()))
-    {
-        ReadFileAsByteArray(cacheName.c_str(), byteCode);
-        return;
-    }
+    ShaderCacheArchive& cacheArchive = GetCacheArchive();
+    if(cacheArchive.Find(cacheKey, byteCode, byteCodeSize))
+        return true;
 
     if(type == ShaderType::Library)
     {
@@ -316,63 +554,52 @@ static void CompileShader(const wchar* path, const char* functionName, ShaderTyp
                  GetFileName(path).c_str(), functionName, MakeDefinesString(defines).c_str());
     }
 
-    // Loop until we succeed, or an exception is thrown
-    while(true)
+    IDxcBlobPtr compiledShader;
+    IDxcBlobEncodingPtr errorMessages;
+    HRESULT hr = CompileShaderDXC(path, defines, functionName, type, profileString, compiledShader, errorMessages);
+    if(FAILED(hr))
     {
-        IDxcBlobPtr compiledShader;
-        IDxcBlobEncodingPtr errorMessages;
-
-        HRESULT hr = CompileShaderDXC(path, defines, functionName, type, profileString, compiledShader, errorMessages);
-        if(FAILED(hr))
+        if(!errorMessages)
         {
-            if(errorMessages)
-            {
-                const char* errMsgStr = reinterpret_cast<const char*>(errorMessages->GetBufferPointer());
-                std::wstring fullMessage = MakeString(L"Error compiling shader file \"%s\" - %hs", path, errMsgStr);
-
-                // Pop up a message box allowing user to retry compilation
-                int32 retVal = MessageBoxW(nullptr, fullMessage.c_str(), L"Shader Compilation Error", MB_RETRYCANCEL);
-                if(retVal != IDRETRY)
-                    throw DXException(hr, fullMessage.c_str());
-            }
-            else
-            {
-                Assert_(false);
-                throw DXException(hr);
-            }
+            Assert_(false);
+            throw DXException(hr);
         }
-        else
-        {
-            // Create the cache directory if it doesn't exist
-            if(DirectoryExists(baseCacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(baseCacheDir.c_str(), nullptr));
 
-            if(DirectoryExists(cacheDir.c_str()) == false)
-                Win32Call(CreateDirectory(cacheDir.c_str(), nullptr));
-
-            File cacheFile(cacheName.c_str(), FileOpenMode::Write);
+        const char* errMsgStr = reinterpret_cast<const char*>(errorMessages->GetBufferPointer());
+        errorMessage = MakeString(L"Error compiling shader file \"%s\" - %hs", path, errMsgStr);
+        return false;
+    }
 
-            // Write the compiled shader to disk
-            const uint64 shaderSize = compiledShader->GetBufferSize();
-            cacheFile.Write(shaderSize, compiledShader->GetBufferPointer());
+    // Add the compiled shader to the cache, and return the cache's copy of the bytecode
+    byteCodeSize = compiledShader->GetBufferSize();
+    byteCode = cacheArchive.Add(cacheKey, compiledShader->GetBufferPointer(), byteCodeSize);
 
-            // Return the compiled shader bytecode
-            byteCode.Init(shaderSize);
-            memcpy(byteCode.Data(), compiledShader->GetBufferPointer(), shaderSize);
+    return true;
+}
 
-            return;
-        }
-    }
+// The base options with the current AppSettings constants added on. Needs to be called from the
+// main thread.
+static CompileOptions AppSettingsCompileOptions(const CompileOptions& baseCompileOpts)
+{
+    CompileOptions opts = baseCompileOpts;
+    AppSettings::GetShaderCompileOptions(opts);
+    return opts;
 }
 
 struct ShaderFile
 {
     wstring FilePath;
+    wstring WatchDirectory;     // full path of the directory that contains the file
+    wstring FileName;
     uint64 TimeStamp;
     List<CompiledShader*> Shaders;
 
     ShaderFile(const wstring& filePath) : TimeStamp(0), FilePath(filePath)
     {
+        const size_t separatorIdx = filePath.find_last_of(L"\\/");
+        const wstring directory = separatorIdx != wstring::npos ? filePath.substr(0, separatorIdx + 1) : wstring();
+        WatchDirectory = DirectoryWatcher::FullDirectoryPath(directory.c_str());
+        FileName = separatorIdx != wstring::npos ? filePath.substr(separatorIdx + 1) : filePath;
     }
 };
 
@@ -381,15 +608,52 @@ static List<CompiledShader*> CompiledShaders;
 static SRWLOCK ShaderFilesLock = SRWLOCK_INIT;
 static SRWLOCK CompiledShadersLock = SRWLOCK_INIT;
 
-static void CompileShader(CompiledShader* shader)
+static ShaderPrecompiler Precompiler;
+static bool PrecompileStatsLogged = true;
+
+// Hot-reloading
+static ShaderReloadMode ReloadMode = ShaderReloadMode::FileNotifications;
+static uint64 ReloadPollIntervalMS = 500;
+static const uint64 ReloadDebounceMS = 50;
+static DirectoryWatcher ShaderDirWatcher;
+static bool ShaderDirWatchFailed = false;
+static uint64 LastReloadPollTime = 0;
+
+// A shader that's being re-compiled in the background. The results get applied on the main
+// thread once all of them are done.
+struct ShaderReload
 {
-    Assert_(shader != nullptr);
+    CompiledShader* Shader = nullptr;
+    const uint8* ByteCode = nullptr;
+    uint64 ByteCodeSize = 0;
+    bool IncludesAppSettings = false;
+    CompileOptions AppSettingsCompileOpts;
+    List<wstring> FilePaths;
+    bool Succeeded = false;
+};
 
-    const char* functionName = shader->Type != ShaderType::Library ? shader->FunctionName.c_str() : nullptr;
+static List<ShaderReload> PendingReloads;
+static Job ReloadJob;
+static bool ReloadJobRunning = false;
 
-    List<wstring> filePaths;
-    CompileShader(shader->FilePath.c_str(), functionName, shader->Type, shader->CompileOpts, filePaths, shader->ByteCode, shader->IncludesAppSettings);
-    shader->ByteCodeHash = GenerateHash(shader->ByteCode.Data(), int(shader->ByteCode.Size()));
+// Needs to be called with ShaderFilesLock held
+static void WatchShaderFile(const ShaderFile& shaderFile)
+{
+    if(ReloadMode != ShaderReloadMode::FileNotifications || ShaderDirWatchFailed)
+        return;
+
+    if(ShaderDirWatcher.Watch(shaderFile.WatchDirectory.c_str()) == false)
+    {
+        WriteLog("Couldn't watch %ls for changes, falling back to polling for shader changes", shaderFile.WatchDirectory.c_str());
+        ShaderDirWatchFailed = true;
+        ShaderDirWatcher.Shutdown();
+    }
+}
+
+// Makes sure that the shader gets re-compiled if any of the files that it uses are modified
+static void AddShaderFileDependencies(CompiledShader* shader, const List<wstring>& filePaths)
+{
+    AcquireSRWLockExclusive(&ShaderFilesLock);
 
     for(uint64 fileIdx = 0; fileIdx < filePaths.Count(); ++ fileIdx)
     {
@@ -407,12 +671,9 @@ static void CompileShader(CompiledShader* shader)
         if(shaderFile == nullptr)
         {
             shaderFile = new ShaderFile(filePath);
-
-            AcquireSRWLockExclusive(&ShaderFilesLock);
-
+            shaderFile->TimeStamp = GetFileTimestamp(filePath.c_str());
             ShaderFiles.Add(shaderFile);
-
-            ReleaseSRWLockExclusive(&ShaderFilesLock);
+            WatchShaderFile(*shaderFile);
         }
 
         bool containsShader = false;
@@ -428,6 +689,36 @@ static void CompileShader(CompiledShader* shader)
         if(containsShader == false)
             shaderFile->Shaders.Add(shader);
     }
+
+    ReleaseSRWLockExclusive(&ShaderFilesLock);
+}
+
+// Compiles a newly-created shader. There's no older version to fall back to, so a compile error
+// pops up a message box that lets the user fix the shader and retry.
+static void CompileShader(CompiledShader* shader)
+{
+    Assert_(shader != nullptr);
+
+    const char* functionName = shader->Type != ShaderType::Library ? shader->FunctionName.c_str() : nullptr;
+    const CompileOptions appSettingsCompileOpts = AppSettingsCompileOptions(shader->CompileOpts);
+
+    List<wstring> filePaths;
+    wstring errorMessage;
+    while(CompileShader(shader->FilePath.c_str(), functionName, shader->Type, shader->CompileOpts, appSettingsCompileOpts,
+                        filePaths, shader->ByteCode, shader->ByteCodeSize, shader->IncludesAppSettings, errorMessage) == false)
+    {
+        // Pop up a message box allowing user to retry compilation
+        int32 retVal = MessageBoxW(nullptr, errorMessage.c_str(), L"Shader Compilation Error", MB_RETRYCANCEL);
+        if(retVal != IDRETRY)
+            throw Exception(errorMessage);
+
+        filePaths.RemoveAll();
+    }
+
+    shader->ByteCodeHash = GenerateHash(shader->ByteCode, int(shader->ByteCodeSize));
+
+    AddShaderFileDependencies(shader, filePaths);
+    filePaths.Shutdown();
 }
 
 CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName,
@@ -450,86 +741,458 @@ CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName,
     return compiledShader;
 }
 
-bool UpdateShaders(bool updateAll)
+// Runs on the job system, so this can't pop up message boxes or touch the CompiledShader list
+static ShaderPermutationStatus PrecompileShaderPermutation(const ShaderPermutation& permutation)
 {
-    uint64 numShaderFiles = ShaderFiles.Count();
-    if(numShaderFiles == 0)
-        return false;
+    const ShaderPrecompileItem& item = *permutation.Item;
+    const char* functionName = item.Type != ShaderType::Library ? item.FunctionName.c_str() : nullptr;
+    const char* profileString = ProfileStrings[uint64(item.Type)];
 
-    if(AppSettings::ShaderCompileOptionsChanged())
+    D3D_SHADER_MACRO defines[CompileOptions::MaxDefines + 1] = { };
+    permutation.CompileOpts.MakeDefines(defines);
+
+    const Hash cacheKey = MakeShaderCacheKey(item.SourceHash, item.CompilerHash, functionName, profileString, defines);
+    ShaderCacheArchive& cacheArchive = GetCacheArchive();
+    if(cacheArchive.Contains(cacheKey))
+        return ShaderPermutationStatus::CacheHit;
+
+    try
     {
-        WriteLog("Hot-swapping shaders that use compile-time constants from AppSettings");
+        IDxcBlobPtr compiledShader;
+        IDxcBlobEncodingPtr errorMessages;
+        HRESULT hr = CompileShaderDXC(item.FilePath.c_str(), defines, functionName, item.Type, profileString, compiledShader, errorMessages);
+        if(FAILED(hr))
+        {
+            // The error will come up again through the usual path if this permutation ever gets used
+            const char* errMsgStr = errorMessages ? reinterpret_cast<const char*>(errorMessages->GetBufferPointer()) : "";
+            WriteLog("Failed to precompile %ls %s: %s", GetFileName(item.FilePath.c_str()).c_str(),
+                     MakeDefinesString(defines).c_str(), errMsgStr);
+            return ShaderPermutationStatus::Failed;
+        }
 
-        AcquireSRWLockExclusive(&CompiledShadersLock);
+        cacheArchive.Add(cacheKey, compiledShader->GetBufferPointer(), compiledShader->GetBufferSize());
+    }
+    catch(Exception& exception)
+    {
+        WriteLog(L"Failed to precompile %ls: %ls", GetFileName(item.FilePath.c_str()).c_str(), exception.GetMessage().c_str());
+        return ShaderPermutationStatus::Failed;
+    }
 
-        // Re-compile all shaders that included AppSettings.hlsl
-        for(CompiledShader* shader : CompiledShaders)
+    return ShaderPermutationStatus::Compiled;
+}
+
+void PrecompileShaderPermutations(bool async)
+{
+    if(Precompiler.Finished() == false)
+        return;
+
+    List<ShaderPermutationOption> options;
+    AppSettings::GetShaderPermutationOptions(options);
+
+    // Grab the unique shaders that include AppSettings.hlsl
+    List<ShaderPrecompileItem> items;
+    AcquireSRWLockShared(&CompiledShadersLock);
+
+    for(const CompiledShader* shader : CompiledShaders)
+    {
+        if(shader->IncludesAppSettings == false)
+            continue;
+
+        const std::string definesString = shader->CompileOpts.DefinesString();
+        bool duplicate = false;
+        for(const ShaderPrecompileItem& item : items)
         {
-            if(shader->IncludesAppSettings)
-                CompileShader(shader);
+            if(item.FilePath == shader->FilePath && item.FunctionName == shader->FunctionName &&
+               item.Type == shader->Type && item.BaseCompileOpts.DefinesString() == definesString)
+            {
+                duplicate = true;
+                break;
+            }
         }
 
-        ReleaseSRWLockExclusive(&CompiledShadersLock);
+        if(duplicate)
+            continue;
 
-        return true;
+        ShaderPrecompileItem& item = items.Add();
+        item.FilePath = shader->FilePath;
+        item.FunctionName = shader->FunctionName;
+        item.Type = shader->Type;
+        item.BaseCompileOpts = shader->CompileOpts;
     }
 
-    static uint64 currFile = 0;
+    ReleaseSRWLockShared(&CompiledShadersLock);
 
-    const uint64 numShadersToCheck = updateAll ? numShaderFiles : 1;
-    bool shaderChanged = false;
+    // Hashing the source only needs to happen once per shader, and needs the index lock
+    const Hash compilerHash = GetCompilerHash();
+    for(ShaderPrecompileItem& item : items)
+    {
+        List<wstring> filePaths;
+        item.SourceHash = MakeShaderSourceHash(item.FilePath.c_str(), filePaths);
+        item.CompilerHash = compilerHash;
+        filePaths.Shutdown();
+    }
 
-    for(uint64 i = 0; i < numShadersToCheck; ++i)
+    if(Precompiler.Start(items, options, PrecompileShaderPermutation))
     {
-        currFile = (currFile + 1) % uint64(numShaderFiles);
+        WriteLog("Precompiling %llu permutations for %llu shaders", NumShaderPermutations(options), items.Count());
+        PrecompileStatsLogged = false;
+        if(async == false)
+            Precompiler.Wait();
+    }
 
-        ShaderFile* file = ShaderFiles[currFile];
-        const uint64 newTimeStamp = GetFileTimestamp(file->FilePath.c_str());
-        if(file->TimeStamp == 0)
+    options.Shutdown();
+    items.Shutdown();
+}
+
+bool PrecompilingShaderPermutations()
+{
+    return Precompiler.Finished() == false;
+}
+
+static void ClearShaderReloads()
+{
+    for(ShaderReload& reload : PendingReloads)
+        reload.FilePaths.Shutdown();
+    PendingReloads.RemoveAll();
+}
+
+// Runs on the job threads, so errors only get logged. A shader that fails to compile keeps its
+// previous bytecode until one of its files changes again.
+static void RecompileShader(ShaderReload& reload)
+{
+    const CompiledShader& shader = *reload.Shader;
+    const char* functionName = shader.Type != ShaderType::Library ? shader.FunctionName.c_str() : nullptr;
+
+    wstring errorMessage;
+    try
+    {
+        // Retry a few times to avoid file conflicts with text editors
+        const uint64 NumRetries = 1000;
+        for(uint64 retryCount = 0; retryCount < NumRetries; ++retryCount)
         {
-            file->TimeStamp = newTimeStamp;
-            return false;
+            try
+            {
+                reload.FilePaths.RemoveAll();
+                reload.Succeeded = CompileShader(shader.FilePath.c_str(), functionName, shader.Type, shader.CompileOpts,
+                                                 reload.AppSettingsCompileOpts, reload.FilePaths, reload.ByteCode,
+                                                 reload.ByteCodeSize, reload.IncludesAppSettings, errorMessage);
+                break;
+            }
+            catch(Win32Exception& exception)
+            {
+                if(retryCount == NumRetries - 1)
+                    throw exception;
+                Sleep(15);
+            }
         }
+    }
+    catch(Exception& exception)
+    {
+        errorMessage = exception.GetMessage();
+    }
+
+    if(reload.Succeeded == false)
+        WriteLog(L"Failed to hot-swap %ls, keeping the previous version: %ls", shader.FilePath.c_str(), errorMessage.c_str());
+}
+
+// Kicks off a background job that re-compiles the shaders. The current bytecode keeps getting
+// used until FinishShaderReloads() swaps in the results.
+static void StartShaderReloads(const List<CompiledShader*>& shaders)
+{
+    Assert_(ReloadJobRunning == false);
+    Assert_(PendingReloads.Count() == 0);
+
+    for(CompiledShader* shader : shaders)
+    {
+        bool alreadyAdded = false;
+        for(const ShaderReload& reload : PendingReloads)
+            alreadyAdded = alreadyAdded || reload.Shader == shader;
+
+        if(alreadyAdded)
+            continue;
+
+        ShaderReload& reload = PendingReloads.Add();
+        reload.Shader = shader;
+        reload.AppSettingsCompileOpts = AppSettingsCompileOptions(shader->CompileOpts);
+    }
+
+    if(PendingReloads.Count() == 0)
+        return;
+
+    if(Jobs::Initialized())
+    {
+        ReloadJob.Init(PendingReloads.Count(), [](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            for(uint64 i = start; i < end; ++i)
+                RecompileShader(PendingReloads[i]);
+        });
+        ReloadJob.Launch();
+    }
+    else
+    {
+        for(ShaderReload& reload : PendingReloads)
+            RecompileShader(reload);
+    }
+
+    ReloadJobRunning = true;
+}
+
+// Re-compiles every shader that uses one of the modified files
+static void StartShaderReloads(const List<ShaderFile*>& changedFiles)
+{
+    List<CompiledShader*> shaders;
+    for(const ShaderFile* file : changedFiles)
+    {
+        WriteLog("Hot-swapping shaders for %ls\n", file->FilePath.c_str());
 
+        for(CompiledShader* shader : file->Shaders)
+            shaders.Add(shader);
+    }
+
+    StartShaderReloads(shaders);
+    shaders.Shutdown();
+}
+
+static bool ShaderReloadsFinished()
+{
+    return ReloadJobRunning == false || Jobs::Initialized() == false || ReloadJob.IsComplete();
+}
+
+static void WaitForShaderReloads()
+{
+    if(ReloadJobRunning && Jobs::Initialized())
+        ReloadJob.Wait();
+}
+
+// Swaps in the new bytecode, and returns true if any of the shaders changed
+static bool FinishShaderReloads()
+{
+    Assert_(ShaderReloadsFinished());
+
+    bool shaderChanged = false;
+    for(ShaderReload& reload : PendingReloads)
+    {
+        // A failed shader keeps its old bytecode, but it still needs to pick up any files that it
+        // started including so that fixing one of them triggers another re-compile
+        CompiledShader* shader = reload.Shader;
+        if(reload.Succeeded == false)
+        {
+            AddShaderFileDependencies(shader, reload.FilePaths);
+            continue;
+        }
+
+        shader->ByteCode = reload.ByteCode;
+        shader->ByteCodeSize = reload.ByteCodeSize;
+        shader->ByteCodeHash = GenerateHash(shader->ByteCode, int(shader->ByteCodeSize));
+        shader->IncludesAppSettings = reload.IncludesAppSettings;
+        AddShaderFileDependencies(shader, reload.FilePaths);
+        shaderChanged = true;
+    }
+
+    ClearShaderReloads();
+    ReloadJobRunning = false;
+
+    return shaderChanged;
+}
+
+// Checks the timestamps of the files, and adds the ones that were modified to the list
+static void FindModifiedShaderFiles(const List<ShaderFile*>& candidates, List<ShaderFile*>& changedFiles)
+{
+    for(ShaderFile* file : candidates)
+    {
+        const uint64 newTimeStamp = GetFileTimestamp(file->FilePath.c_str());
         if(file->TimeStamp < newTimeStamp)
         {
-            WriteLog("Hot-swapping shaders for %ls\n", file->FilePath.c_str());
             file->TimeStamp = newTimeStamp;
-            for(uint64 fileIdx = 0; fileIdx < file->Shaders.Count(); ++fileIdx)
+            changedFiles.Add(file);
+        }
+    }
+}
+
+bool UpdateShaders(bool updateAll)
+{
+    if(PrecompileStatsLogged == false && Precompiler.Finished())
+    {
+        const ShaderPrecompileStats stats = Precompiler.Stats();
+        WriteLog("Finished precompiling shader permutations in %.2fms: %llu compiled, %llu already cached, %llu failed",
+                 stats.TimeMS, stats.NumCompiled, stats.NumCacheHits, stats.NumFailed);
+        PrecompileStatsLogged = true;
+    }
+
+    // Any files that were hashed since the last update get written out in one go
+    AcquireSRWLockExclusive(&ShaderIndexLock);
+    SaveShaderIndex();
+    ReleaseSRWLockExclusive(&ShaderIndexLock);
+
+    uint64 numShaderFiles = ShaderFiles.Count();
+    if(numShaderFiles == 0)
+        return false;
+
+    const bool appSettingsChanged = AppSettings::ShaderCompileOptionsChanged();
+
+    // Apply the results of the background re-compile once it's done. If the AppSettings changed,
+    // the results need to be in before the shaders get compiled again below.
+    bool shaderChanged = false;
+    if(ReloadJobRunning)
+    {
+        if(appSettingsChanged || updateAll)
+            WaitForShaderReloads();
+
+        if(ShaderReloadsFinished())
+            shaderChanged = FinishShaderReloads();
+    }
+
+    if(appSettingsChanged)
+    {
+        WriteLog("Hot-swapping shaders that use compile-time constants from AppSettings");
+
+        // Re-compile all shaders that included AppSettings.hlsl. Permutations that the precompiler
+        // hasn't gotten to yet are compiled on the job threads instead of stalling the main thread.
+        List<CompiledShader*> shaders;
+        AcquireSRWLockShared(&CompiledShadersLock);
+
+        for(CompiledShader* shader : CompiledShaders)
+        {
+            if(shader->IncludesAppSettings)
+                shaders.Add(shader);
+        }
+
+        ReleaseSRWLockShared(&CompiledShadersLock);
+
+        StartShaderReloads(shaders);
+        shaders.Shutdown();
+
+        if(updateAll && ReloadJobRunning)
+        {
+            WaitForShaderReloads();
+            shaderChanged = FinishShaderReloads() || shaderChanged;
+        }
+
+        return shaderChanged;
+    }
+
+    // Changes that come in while a re-compile is in progress get picked up once it's done
+    if(ReloadJobRunning || ReloadMode == ShaderReloadMode::Disabled)
+        return shaderChanged;
+
+    // Figure out which files might have changed. With notifications, only the files that the OS
+    // told us about need to be looked at, otherwise every file gets checked on a fixed interval.
+    List<ShaderFile*> candidates;
+    const bool useNotifications = ReloadMode == ShaderReloadMode::FileNotifications && ShaderDirWatchFailed == false;
+    const uint64 currTime = GetTickCount64();
+    if(updateAll || (useNotifications == false && currTime - LastReloadPollTime >= ReloadPollIntervalMS))
+    {
+        LastReloadPollTime = currTime;
+        for(ShaderFile* file : ShaderFiles)
+            candidates.Add(file);
+    }
+    else if(useNotifications && ShaderDirWatcher.Failed())
+    {
+        // We stopped getting notifications for one of the directories, so switch over to polling
+        // and check everything once in case a change got missed
+        WriteLog("Stopped receiving shader file notifications, falling back to polling for shader changes");
+        ShaderDirWatchFailed = true;
+        ShaderDirWatcher.Shutdown();
+
+        LastReloadPollTime = currTime;
+        for(ShaderFile* file : ShaderFiles)
+            candidates.Add(file);
+    }
+    else if(useNotifications)
+    {
+        List<DirectoryChange> changes;
+        if(ShaderDirWatcher.GetChanges(changes, ReloadDebounceMS))
+        {
+            for(ShaderFile* file : ShaderFiles)
             {
-                // Retry a few times to avoid file conflicts with text editors
-                const uint64 NumRetries = 1000;
-                for(uint64 retryCount = 0; retryCount < NumRetries; ++retryCount)
+                for(const DirectoryChange& change : changes)
                 {
-                    try
+                    if(change.Directory == file->WatchDirectory &&
+                       (change.FileName.length() == 0 || _wcsicmp(change.FileName.c_str(), file->FileName.c_str()) == 0))
                     {
-                        CompiledShader* shader = file->Shaders[fileIdx];
-                        CompileShader(shader);
+                        candidates.Add(file);
                         break;
                     }
-                    catch(Win32Exception& exception)
-                    {
-                        if(retryCount == NumRetries - 1)
-                            throw exception;
-                        Sleep(15);
-                    }
                 }
             }
-
-            shaderChanged = true;
         }
+
+        changes.Shutdown();
     }
 
+    List<ShaderFile*> changedFiles;
+    FindModifiedShaderFiles(candidates, changedFiles);
+    StartShaderReloads(changedFiles);
+
+    // The caller wants the results right away
+    if(updateAll && ReloadJobRunning)
+    {
+        WaitForShaderReloads();
+        shaderChanged = FinishShaderReloads() || shaderChanged;
+    }
+
+    candidates.Shutdown();
+    changedFiles.Shutdown();
+
     return shaderChanged;
 }
 
+void SetShaderReloadMode(ShaderReloadMode mode, uint64 pollIntervalMS)
+{
+    ReloadMode = mode;
+    ReloadPollIntervalMS = pollIntervalMS;
+
+    AcquireSRWLockExclusive(&ShaderFilesLock);
+
+    ShaderDirWatcher.Shutdown();
+    ShaderDirWatchFailed = false;
+    for(const ShaderFile* file : ShaderFiles)
+        WatchShaderFile(*file);
+
+    ReleaseSRWLockExclusive(&ShaderFilesLock);
+}
+
+std::wstring ShaderCacheDirectory()
+{
+    CreateShaderCacheDirectory();
+    return cacheDir;
+}
+
+Hash ShaderCompilerHash()
+{
+    return GetCompilerHash();
+}
+
 void ShutdownShaders()
 {
+    Precompiler.Cancel();
+
+    WaitForShaderReloads();
+    ClearShaderReloads();
+    ReloadJobRunning = false;
+    PendingReloads.Shutdown();
+    ShaderDirWatcher.Shutdown();
+
+    AcquireSRWLockExclusive(&ShaderIndexLock);
+    SaveShaderIndex();
+    ClearShaderIndex();
+    ShaderIndexLoaded = false;
+    ReleaseSRWLockExclusive(&ShaderIndexLock);
+
     for(uint64 i = 0; i < ShaderFiles.Count(); ++i)
         delete ShaderFiles[i];
 
     for(uint64 i = 0; i < CompiledShaders.Count(); ++i)
         delete CompiledShaders[i];
+
+    // Nothing points at the cached bytecode anymore, so this is when the log gets folded into the archive
+    if(CacheArchiveOpened)
+    {
+        if(CacheArchive.NumLogEntries() > 0)
+            CacheArchive.Compact();
+        CacheArchive.Close();
+        CacheArchiveOpened = false;
+    }
 }
 
 // == CompileOptions ==============================================================================
@@ -589,4 +1252,11 @@ void CompileOptions::MakeDefines(D3D_SHADER_MACRO defines[MaxDefines + 1]) const
     defines[numDefines].Definition = nullptr;
 }
 
+std::string CompileOptions::DefinesString() const
+{
+    D3D_SHADER_MACRO defines[MaxDefines + 1] = { };
+    MakeDefines(defines);
+    return MakeDefinesString(defines);
+}
+
 }
\ No newline at end of file
@@ -34,6 +34,7 @@ public:
     void Reset();
 
     void MakeDefines(D3D_SHADER_MACRO defines[MaxDefines + 1]) const;
+    std::string DefinesString() const;
 
 private:
 
@@ -44,6 +45,15 @@ private:
     uint32 bufferIdx;
 };
 
+// A compile-time constant from AppSettings, along with the range of values that it can have
+struct ShaderPermutationOption
+{
+    std::string Name;
+    int32 MinValue = 0;
+    uint32 NumValues = 0;
+    int32 CurrentValue = 0;
+};
+
 enum class ShaderType
 {
     Vertex = 0,
@@ -67,7 +77,8 @@ public:
     std::wstring FilePath;
     std::string FunctionName;
     CompileOptions CompileOpts;
-    Array<uint8> ByteCode;
+    const uint8* ByteCode = nullptr;    // points into the shader cache archive
+    uint64 ByteCodeSize = 0;
     ShaderType Type;
     Hash ByteCodeHash;
     bool IncludesAppSettings = false;
@@ -115,8 +126,8 @@ public:
     {
         Assert_(ptr != nullptr);
         D3D12_SHADER_BYTECODE byteCode;
-        byteCode.pShaderBytecode = ptr->ByteCode.Data();
-        byteCode.BytecodeLength = ptr->ByteCode.Size();
+        byteCode.pShaderBytecode = ptr->ByteCode;
+        byteCode.BytecodeLength = ptr->ByteCodeSize;
         return byteCode;
     }
 
@@ -131,7 +142,30 @@ typedef CompiledShaderPtr ShaderPtr;
 CompiledShaderPtr CompileFromFile(const wchar* path, const char* functionName, ShaderType type,
                                   const CompileOptions& compileOpts = CompileOptions());
 
+// How UpdateShaders() finds out that a shader file was modified. File notifications fall back to
+// polling if one of the directories can't be watched.
+enum class ShaderReloadMode
+{
+    FileNotifications = 0,
+    Polling,
+    Disabled,
+};
+
+// Modified shaders get re-compiled in the background, and UpdateShaders() returns true on the frame
+// that the new bytecode gets swapped in. Passing updateAll checks every file and waits for the results.
 bool UpdateShaders(bool updateAll);
+void SetShaderReloadMode(ShaderReloadMode mode, uint64 pollIntervalMS = 500);
 void ShutdownShaders();
 
+// Compiles every permutation of the AppSettings compile-time constants for the shaders that include
+// AppSettings.hlsl, and writes them to the shader cache. Changing those settings afterwards loads
+// the bytecode from the cache instead of stalling on the compiler.
+void PrecompileShaderPermutations(bool async = true);
+bool PrecompilingShaderPermutations();
+
+// Other caches that depend on compiled shaders can live next to them, and use the compiler's hash
+// to find out when they're out of date
+std::wstring ShaderCacheDirectory();
+Hash ShaderCompilerHash();
+
 }
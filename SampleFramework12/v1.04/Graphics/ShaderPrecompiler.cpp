@@ -0,0 +1,220 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "ShaderPrecompiler.h"
+
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+uint64 NumShaderPermutations(const List<ShaderPermutationOption>& options)
+{
+    uint64 numPermutations = 1;
+    for(uint64 i = 0; i < options.Count(); ++i)
+    {
+        const uint64 numValues = Max<uint64>(options[i].NumValues, 1);
+        if(numPermutations > UINT64_MAX / numValues)
+            return UINT64_MAX;
+        numPermutations *= numValues;
+    }
+
+    return numPermutations;
+}
+
+uint64 CurrentShaderPermutation(const List<ShaderPermutationOption>& options)
+{
+    uint64 permutationIdx = 0;
+    uint64 stride = 1;
+    for(uint64 i = 0; i < options.Count(); ++i)
+    {
+        const ShaderPermutationOption& option = options[i];
+        const uint64 numValues = Max<uint64>(option.NumValues, 1);
+        const int64 valueIdx = Clamp<int64>(int64(option.CurrentValue) - option.MinValue, 0, numValues - 1);
+        permutationIdx += uint64(valueIdx) * stride;
+        stride *= numValues;
+    }
+
+    return permutationIdx;
+}
+
+void AddShaderPermutationDefines(const List<ShaderPermutationOption>& options, uint64 permutationIdx, CompileOptions& opts)
+{
+    for(uint64 i = 0; i < options.Count(); ++i)
+    {
+        const ShaderPermutationOption& option = options[i];
+        const uint64 numValues = Max<uint64>(option.NumValues, 1);
+        const int64 value = option.MinValue + int64(permutationIdx % numValues);
+        permutationIdx /= numValues;
+
+        // Matches the generated AppSettings::GetShaderCompileOptions(), which is what ends up in the cache key
+        opts.Add(option.Name, uint32(value));
+    }
+}
+
+void OrderShaderPermutations(const List<ShaderPermutationOption>& options, List<uint64>& order)
+{
+    const uint64 numPermutations = NumShaderPermutations(options);
+    const uint64 currPermutation = CurrentShaderPermutation(options);
+
+    order.RemoveAll();
+    order.Reserve(numPermutations);
+
+    // Counting sort on the number of options that differ
+    List<uint64> distances;
+    distances.Reserve(numPermutations);
+    for(uint64 permutationIdx = 0; permutationIdx < numPermutations; ++permutationIdx)
+    {
+        uint64 distance = 0;
+        uint64 a = permutationIdx;
+        uint64 b = currPermutation;
+        for(uint64 i = 0; i < options.Count(); ++i)
+        {
+            const uint64 numValues = Max<uint64>(options[i].NumValues, 1);
+            distance += (a % numValues) != (b % numValues) ? 1 : 0;
+            a /= numValues;
+            b /= numValues;
+        }
+        distances.Add(distance);
+    }
+
+    for(uint64 distance = 0; distance <= options.Count(); ++distance)
+    {
+        for(uint64 permutationIdx = 0; permutationIdx < numPermutations; ++permutationIdx)
+        {
+            if(distances[permutationIdx] == distance)
+                order.Add(permutationIdx);
+        }
+    }
+
+    distances.Shutdown();
+}
+
+// == ShaderPrecompiler ===========================================================================
+
+ShaderPrecompiler::~ShaderPrecompiler()
+{
+    Cancel();
+
+    items.Shutdown();
+    options.Shutdown();
+    order.Shutdown();
+}
+
+bool ShaderPrecompiler::Start(const List<ShaderPrecompileItem>& items_, const List<ShaderPermutationOption>& options_,
+                              ShaderPermutationCompileFunc compileFunc_)
+{
+    Assert_(Finished());
+    Assert_(compileFunc_);
+
+    items.RemoveAll();
+    options.RemoveAll();
+    for(uint64 i = 0; i < items_.Count(); ++i)
+        items.Add(items_[i]);
+    for(uint64 i = 0; i < options_.Count(); ++i)
+        options.Add(options_[i]);
+    compileFunc = compileFunc_;
+
+    cancelled = false;
+    numDone = 0;
+    numCancelled = 0;
+    for(std::atomic<uint64>& count : statusCounts)
+        count = 0;
+    timeMS = 0.0;
+    timer = Timer();
+
+    numPermutations = NumShaderPermutations(options);
+    if(items.Count() == 0 || options.Count() == 0)
+        return false;
+
+    if(numPermutations > MaxPermutations)
+    {
+        WriteLog("Skipping shader permutation precompile, %llu permutations is more than the limit of %llu", numPermutations, MaxPermutations);
+        numPermutations = 0;
+        return false;
+    }
+
+    OrderShaderPermutations(options, order);
+
+    // All shaders get their closest permutations done before moving on to the next ones
+    numWorkItems = numPermutations * items.Count();
+    if(Jobs::Initialized())
+    {
+        job.Init(numWorkItems, [this](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            for(uint64 workIdx = start; workIdx < end; ++workIdx)
+                CompilePermutation(workIdx);
+        });
+        job.Launch();
+    }
+    else
+    {
+        for(uint64 workIdx = 0; workIdx < numWorkItems; ++workIdx)
+            CompilePermutation(workIdx);
+    }
+
+    return true;
+}
+
+void ShaderPrecompiler::CompilePermutation(uint64 workIdx)
+{
+    if(cancelled)
+    {
+        ++numCancelled;
+    }
+    else
+    {
+        ShaderPermutation permutation;
+        permutation.ItemIdx = workIdx % items.Count();
+        permutation.PermutationIdx = order[workIdx / items.Count()];
+        permutation.Item = &items[permutation.ItemIdx];
+        permutation.CompileOpts = permutation.Item->BaseCompileOpts;
+        AddShaderPermutationDefines(options, permutation.PermutationIdx, permutation.CompileOpts);
+
+        const ShaderPermutationStatus status = compileFunc(permutation);
+        Assert_(uint64(status) < uint64(ShaderPermutationStatus::NumValues));
+        ++statusCounts[uint64(status)];
+    }
+
+    // Whoever finishes the last one records the time
+    if(++numDone == numWorkItems)
+    {
+        timer.Update();
+        timeMS = timer.ElapsedMillisecondsD();
+    }
+}
+
+void ShaderPrecompiler::Wait()
+{
+    if(Finished() == false)
+        job.Wait();
+}
+
+void ShaderPrecompiler::Cancel()
+{
+    cancelled = true;
+    Wait();
+}
+
+ShaderPrecompileStats ShaderPrecompiler::Stats() const
+{
+    ShaderPrecompileStats stats;
+    stats.NumItems = items.Count();
+    stats.NumPermutations = numPermutations;
+    stats.NumCompiled = statusCounts[uint64(ShaderPermutationStatus::Compiled)];
+    stats.NumCacheHits = statusCounts[uint64(ShaderPermutationStatus::CacheHit)];
+    stats.NumFailed = statusCounts[uint64(ShaderPermutationStatus::Failed)];
+    stats.NumCancelled = numCancelled;
+    stats.TimeMS = Finished() ? timeMS : 0.0;
+    return stats;
+}
+
+}
\ No newline at end of file
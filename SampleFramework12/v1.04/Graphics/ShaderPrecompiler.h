@@ -0,0 +1,119 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+#include "..\\Containers.h"
+#include "..\\Jobs.h"
+#include "..\\Timer.h"
+#include "ShaderCompilation.h"
+
+#include <atomic>
+#include <functional>
+
+namespace SampleFramework12
+{
+
+// A shader entry point that needs every permutation compiled
+struct ShaderPrecompileItem
+{
+    std::wstring FilePath;
+    std::string FunctionName;
+    ShaderType Type = ShaderType::Vertex;
+    CompileOptions BaseCompileOpts;
+    Hash SourceHash;                // the shader file and its includes, for building the cache key
+    Hash CompilerHash;
+};
+
+struct ShaderPermutation
+{
+    const ShaderPrecompileItem* Item = nullptr;
+    uint64 ItemIdx = 0;
+    uint64 PermutationIdx = 0;
+    CompileOptions CompileOpts;     // the item's options, followed by the defines for the permutation
+};
+
+enum class ShaderPermutationStatus
+{
+    Compiled = 0,
+    CacheHit,
+    Failed,
+
+    NumValues
+};
+
+// Compiles a single permutation. This gets called from the worker threads, so it can't touch
+// anything that isn't thread-safe.
+typedef std::function<ShaderPermutationStatus(const ShaderPermutation& permutation)> ShaderPermutationCompileFunc;
+
+struct ShaderPrecompileStats
+{
+    uint64 NumItems = 0;
+    uint64 NumPermutations = 0;     // per item
+    uint64 NumCompiled = 0;
+    uint64 NumCacheHits = 0;
+    uint64 NumFailed = 0;
+    uint64 NumCancelled = 0;
+    double TimeMS = 0.0;
+};
+
+// Permutations are indexed like a mixed-radix number, with the first option varying fastest
+uint64 NumShaderPermutations(const List<ShaderPermutationOption>& options);
+uint64 CurrentShaderPermutation(const List<ShaderPermutationOption>& options);
+void AddShaderPermutationDefines(const List<ShaderPermutationOption>& options, uint64 permutationIdx, CompileOptions& opts);
+
+// Sorts the permutations by how many options differ from the current values, so that the ones
+// that are a single toggle away get compiled first
+void OrderShaderPermutations(const List<ShaderPermutationOption>& options, List<uint64>& order);
+
+// Compiles every permutation of a set of shaders on the job system. Start() returns immediately,
+// and the work happens in the background until Wait() or Cancel() is called.
+class ShaderPrecompiler
+{
+
+public:
+
+    // Anything past this is probably an int setting with a huge range, and not worth trying
+    static const uint64 MaxPermutations = 4096;
+
+    ~ShaderPrecompiler();
+
+    // Returns false if there was nothing to compile
+    bool Start(const List<ShaderPrecompileItem>& items, const List<ShaderPermutationOption>& options,
+               ShaderPermutationCompileFunc compileFunc);
+
+    void Wait();
+    void Cancel();
+
+    bool Finished() const { return job.IsComplete(); }
+    ShaderPrecompileStats Stats() const;
+
+protected:
+
+    void CompilePermutation(uint64 workIdx);
+
+    List<ShaderPrecompileItem> items;
+    List<ShaderPermutationOption> options;
+    List<uint64> order;
+    ShaderPermutationCompileFunc compileFunc;
+    Job job;
+    Timer timer;
+
+    uint64 numPermutations = 0;
+    uint64 numWorkItems = 0;
+    std::atomic<bool> cancelled = false;
+    std::atomic<uint64> numDone = 0;
+    std::atomic<uint64> statusCounts[uint64(ShaderPermutationStatus::NumValues)] = { };
+    std::atomic<uint64> numCancelled = 0;
+    double timeMS = 0.0;
+};
+
+}
\ No newline at end of file
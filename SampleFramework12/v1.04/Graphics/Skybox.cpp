@@ -13,6 +13,7 @@
 
 #include "../Utility.h"
 #include "../SF12_Math.h"
+#include "../Jobs.h"
 #include "../HosekSky/ArHosekSkyModel.h"
 #include "ShaderCompilation.h"
 #include "Textures.h"
@@ -37,6 +38,21 @@ static float AngleBetween(const Float3& dir0, const Float3& dir1)
     return std::acos(std::max(Float3::Dot(dir0, dir1), 0.00001f));
 }
 
+// The sky LUT is indexed by sqrt(1 - cos(angle)), which is proportional to sin(angle / 2). This keeps
+// the texels spaced almost linearly in angle (with extra density near the sun), while letting lookups
+// skip the acos. The cosines are clamped the same way as AngleBetween().
+static const float MinSkyCosAngle = 0.00001f;
+
+static float SkyLUTCoord(float cosAngle)
+{
+    return std::sqrt((1.0f - Clamp(cosAngle, MinSkyCosAngle, 1.0f)) / (1.0f - MinSkyCosAngle));
+}
+
+static float SkyLUTAngle(float lutCoord)
+{
+    return std::acos(1.0f - lutCoord * lutCoord * (1.0f - MinSkyCosAngle));
+}
+
 // Returns the result of performing a irradiance integral over the portion
 // of the hemisphere covered by a region with angular radius = theta
 static float IrradianceIntegral(float theta)
@@ -45,7 +61,7 @@ static float IrradianceIntegral(float theta)
     return Pi * sinTheta * sinTheta;
 }
 
-bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& groundAlbedo_, float turbidity, bool createCubemap)
+bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& groundAlbedo_, float turbidity, bool createCubemap, bool useLUT)
 {
     Float3 sunDirection = sunDirection_;
     Float3 groundAlbedo = groundAlbedo_;
@@ -56,7 +72,8 @@ bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& gr
     sunSize = Max(sunSize, 0.01f);
 
     // Do nothing if we're already up-to-date
-    if(Initialized() && sunDirection == SunDirection && groundAlbedo == Albedo && turbidity == Turbidity && SunSize == sunSize)
+    if(Initialized() && sunDirection == SunDirection && groundAlbedo == Albedo && turbidity == Turbidity && SunSize == sunSize &&
+       useLUT == (LUT.Size() > 0))
         return false;
 
     Shutdown();
@@ -86,8 +103,10 @@ bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& gr
 
     // Init the Hosek solar radiance model for all wavelengths
     ArHosekSkyModelState* skyStates[NumSpectralSamples] = { };
-    for(int32 i = 0; i < NumSpectralSamples; ++i)
-        skyStates[i] = arhosekskymodelstate_alloc_init(thetaS, turbidity, groundAlbedoSpectrum[i]);
+    Jobs::ParallelFor(NumSpectralSamples, [&](uint64 i)
+    {
+        skyStates[i] = arhosekskymodelstate_alloc_init(thetaS, turbidity, groundAlbedoSpectrum[int32(i)]);
+    });
 
     SunIrradiance = Float3(0.0f);
 
@@ -153,6 +172,22 @@ bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& gr
         sunColor *= (FP16Max / maxComponent);
     SunRenderColor = Float3::Clamp(sunColor, 0.0f, FP16Max);
 
+    if(useLUT)
+    {
+        // Bake the sky model into a table, so that the cubemap and any other sampling only needs
+        // a bilinear lookup instead of 3 evaluations of the model
+        LUT.Init(LUTThetaRes * LUTGammaRes);
+        Jobs::ParallelFor(LUTThetaRes, [&](uint64 thetaIdx)
+        {
+            const float theta = SkyLUTAngle(thetaIdx / (LUTThetaRes - 1.0f));
+            for(uint32 gammaIdx = 0; gammaIdx < LUTGammaRes; ++gammaIdx)
+            {
+                const float gamma = SkyLUTAngle(gammaIdx / (LUTGammaRes - 1.0f));
+                LUT[thetaIdx * LUTGammaRes + gammaIdx] = SampleModel(theta, gamma);
+            }
+        });
+    }
+
     if(createCubemap)
     {
         // Make a pre-computed cubemap with the sky radiance values, minus the sun.
@@ -164,47 +199,37 @@ bool SkyCache::Init(const Float3& sunDirection_, float sunSize, const Float3& gr
         Array<Half4> texels(NumTexels);
 
         // We'll also project the sky onto SH coefficients for use during rendering
-        SH = SH9Color();
-        float weightSum = 0.0f;
+        TextureData<Float4> skyData;
+        skyData.Init(CubeMapRes, CubeMapRes, 6);
 
-        for(uint32 s = 0; s < 6; ++s)
+        Jobs::ParallelFor(CubeMapRes * 6, [&](uint64 row)
         {
-            for(uint32 y = 0; y < CubeMapRes; ++y)
+            const uint32 s = uint32(row / CubeMapRes);
+            const uint32 y = uint32(row % CubeMapRes);
+            for(uint32 x = 0; x < CubeMapRes; ++x)
             {
-                for(uint32 x = 0; x < CubeMapRes; ++x)
-                {
-                    Float3 dir = MapXYSToDirection(x, y, s, CubeMapRes, CubeMapRes);
-                    Float3 radiance = Sample(dir);
-
-                    uint32 idx = (s * CubeMapRes * CubeMapRes) + (y * CubeMapRes) + x;
-                    samples[idx] = radiance;
-                    texels[idx] = Half4(Float4(radiance, 1.0f));
-                    sampleDirs[idx] = dir;
-
-                    float u = (x + 0.5f) / CubeMapRes;
-                    float v = (y + 0.5f) / CubeMapRes;
-
-                    // Account for cubemap texel distribution
-                    u = u * 2.0f - 1.0f;
-                    v = v * 2.0f - 1.0f;
-                    const float temp = 1.0f + u * u + v * v;
-                    const float weight = 4.0f / (std::sqrt(temp) * temp);
-
-                    SH += ProjectOntoSH9Color(dir, radiance) * weight;
-                    weightSum += weight;
-                }
+                Float3 dir = MapXYSToDirection(x, y, s, CubeMapRes, CubeMapRes);
+                Float3 radiance = Sample(dir);
+
+                uint32 idx = (s * CubeMapRes * CubeMapRes) + (y * CubeMapRes) + x;
+                samples[idx] = radiance;
+                texels[idx] = Half4(Float4(radiance, 1.0f));
+                sampleDirs[idx] = dir;
+                skyData.Texels[idx] = Float4(radiance, 1.0f);
             }
-        }
+        });
 
-        SH *= (4.0f * 3.14159f) / weightSum;
+        SH = ProjectCubemapToSH(skyData);
 
         Create2DTexture(CubeMap, CubeMapRes, CubeMapRes, 1, 1, DXGI_FORMAT_R16G16B16A16_FLOAT, true, texels.Data());
 
+        // This used to ask for NNLS, which quietly became a projection since Eigen isn't enabled.
+        // The factored solver does a real non-negative fit without it.
         SGSolveParams solveParams;
         solveParams.SampleDirs = sampleDirs.Data();
         solveParams.SampleValues = samples.Data();
         solveParams.NumSamples = NumTexels;
-        solveParams.SolveMode = SGSolveMode::NNLS;
+        solveParams.SolveMode = SGSolveMode::FactoredNNLS;
         solveParams.Distribution = SGDistribution::Spherical;
         solveParams.NumSGs = 9;
         solveParams.OutSGs = SG.Lobes;
@@ -235,6 +260,7 @@ void SkyCache::Shutdown()
     }
 
     CubeMap.Shutdown();
+    LUT.Shutdown();
     Turbidity = 0.0f;
     Albedo = 0.0f;
     Elevation = 0.0f;
@@ -253,8 +279,25 @@ Float3 SkyCache::Sample(Float3 sampleDir) const
 {
     Assert_(StateR != nullptr);
 
-    float gamma = AngleBetween(sampleDir, SunDirection);
-    float theta = AngleBetween(sampleDir, Float3(0, 1, 0));
+    if(LUT.Size() == 0)
+        return SampleModel(AngleBetween(sampleDir, Float3(0, 1, 0)), AngleBetween(sampleDir, SunDirection));
+
+    const float thetaCoord = SkyLUTCoord(sampleDir.y) * (LUTThetaRes - 1);
+    const float gammaCoord = SkyLUTCoord(Float3::Dot(sampleDir, SunDirection)) * (LUTGammaRes - 1);
+
+    const uint32 theta0 = Min(uint32(thetaCoord), LUTThetaRes - 2);
+    const uint32 gamma0 = Min(uint32(gammaCoord), LUTGammaRes - 2);
+    const float thetaLerp = thetaCoord - theta0;
+    const float gammaLerp = gammaCoord - gamma0;
+
+    const Float3* row0 = &LUT[theta0 * LUTGammaRes + gamma0];
+    const Float3* row1 = row0 + LUTGammaRes;
+    return Lerp(Lerp(row0[0], row0[1], gammaLerp), Lerp(row1[0], row1[1], gammaLerp), thetaLerp);
+}
+
+Float3 SkyCache::SampleModel(float theta, float gamma) const
+{
+    Assert_(StateR != nullptr);
 
     Float3 radiance;
 
@@ -44,13 +44,19 @@ struct SkyCache
     SH9Color SH;
     SG9 SG;
 
-    bool Init(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity, bool createCubemap);
+    // Optional (theta, gamma) table of sky radiance, used by Sample() instead of evaluating the model
+    static const uint32 LUTThetaRes = 64;
+    static const uint32 LUTGammaRes = 256;
+    Array<Float3> LUT;
+
+    bool Init(const Float3& sunDirection, float sunSize, const Float3& groundAlbedo, float turbidity, bool createCubemap, bool useLUT = false);
     void Shutdown();
     ~SkyCache();
 
     bool Initialized() const { return StateR != nullptr; }
 
     Float3 Sample(Float3 sampleDir) const;
+    Float3 SampleModel(float theta, float gamma) const;
 };
 
 #endif // EnableSkyModel_
@@ -13,10 +13,14 @@
 #include "..\\Exceptions.h"
 #include "Textures.h"
 #include "..\\FileIO.h"
+#include "..\\MurmurHash.h"
 #include "ShaderCompilation.h"
 #include "GraphicsTypes.h"
 #include "TinyEXR.h"
 #include "DX12.h"
+#include "..\\AsyncIO.h"
+#include "..\\Jobs.h"
+#include "..\\Timer.h"
 
 namespace SampleFramework12
 {
@@ -35,33 +39,9 @@ static uint64 NumMipLevels(uint64 width, uint64 height, uint64 depth = 1)
     return numMips;
 }
 
-void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
+// Creates the resource and SRV for a decoded image, and returns the description that it was created with
+static D3D12_RESOURCE_DESC1 CreateTextureResource(Texture& texture, const DirectX::TexMetadata& metaData, const wchar* name, bool forceSRGB)
 {
-    texture.Shutdown();
-    if(FileExists(filePath) == false)
-        throw Exception(MakeString(L"Texture file with path '%ls' does not exist", filePath));
-
-    DirectX::ScratchImage image;
-
-    const std::wstring extension = GetFileExtension(filePath);
-    if(extension == L"DDS" || extension == L"dds")
-    {
-        DXCall(DirectX::LoadFromDDSFile(filePath, DirectX::DDS_FLAGS_NONE, nullptr, image));
-    }
-    else if(extension == L"TGA" || extension == L"tga")
-    {
-        DirectX::ScratchImage tempImage;
-        DXCall(DirectX::LoadFromTGAFile(filePath, nullptr, tempImage));
-        DXCall(DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false));
-    }
-    else
-    {
-        DirectX::ScratchImage tempImage;
-        DXCall(DirectX::LoadFromWICFile(filePath, DirectX::WIC_FLAGS_IGNORE_SRGB, nullptr, tempImage));
-        DXCall(DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false));
-    }
-
-    const DirectX::TexMetadata& metaData = image.GetMetadata();
     DXGI_FORMAT format = metaData.format;
     if(forceSRGB)
         format = DirectX::MakeSRGB(format);
@@ -84,7 +64,7 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
     ID3D12Device10* device = DX12::Device;
     DXCall(device->CreateCommittedResource3(DX12::GetDefaultHeapProps(), D3D12_HEAP_FLAG_NONE, &textureDesc,
                                            D3D12_BARRIER_LAYOUT_COMMON, nullptr, nullptr, 0, nullptr, IID_PPV_ARGS(&texture.Resource)));
-    texture.Resource->SetName(filePath);
+    texture.Resource->SetName(name);
 
     PersistentDescriptorAlloc srvAlloc = DX12::SRVDescriptorHeap.AllocatePersistent();
     texture.SRV = srvAlloc.Index;
@@ -105,21 +85,24 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
     for(uint32 i = 0; i < DX12::SRVDescriptorHeap.NumHeaps; ++i)
         device->CreateShaderResourceView(texture.Resource, srvDescPtr, srvAlloc.Handles[i]);
 
-    const uint64 numSubResources = metaData.mipLevels * metaData.arraySize;
-    D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts = (D3D12_PLACED_SUBRESOURCE_FOOTPRINT*)_alloca(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) * numSubResources);
-    uint32* numRows = (uint32*)_alloca(sizeof(uint32) * numSubResources);
-    uint64* rowSizes = (uint64*)_alloca(sizeof(uint64) * numSubResources);
-
-    uint64 textureMemSize = 0;
-    device->GetCopyableFootprints1(&textureDesc, 0, uint32(numSubResources), 0, layouts, numRows, rowSizes, &textureMemSize);
+    texture.Width = uint32(metaData.width);
+    texture.Height = uint32(metaData.height);
+    texture.Depth = uint32(metaData.depth);
+    texture.NumMips = uint32(metaData.mipLevels);
+    texture.ArraySize = uint32(metaData.arraySize);
+    texture.Format = metaData.format;
+    texture.Cubemap = metaData.IsCubemap() ? 1 : 0;
 
-    // Get a GPU upload buffer
-    UploadContext uploadContext = DX12::ResourceUploadBegin(textureMemSize);
-    uint8* uploadMem = reinterpret_cast<uint8*>(uploadContext.CPUAddress);
+    return textureDesc;
+}
 
+// Copies every subresource of the image into upload memory, laid out according to the footprints
+static void CopyImageToUploadMem(const DirectX::ScratchImage& image, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                                 const uint32* numRows, uint8* uploadMem)
+{
+    const DirectX::TexMetadata& metaData = image.GetMetadata();
     for(uint64 arrayIdx = 0; arrayIdx < metaData.arraySize; ++arrayIdx)
     {
-
         for(uint64 mipIdx = 0; mipIdx < metaData.mipLevels; ++mipIdx)
         {
             const uint64 subResourceIdx = mipIdx + (arrayIdx * metaData.mipLevels);
@@ -128,7 +111,7 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
             const uint64 subResourceHeight = numRows[subResourceIdx];
             const uint64 subResourcePitch = subResourceLayout.Footprint.RowPitch;
             const uint64 subResourceDepth = subResourceLayout.Footprint.Depth;
-            uint8* dstSubResourceMem = reinterpret_cast<uint8*>(uploadMem) + subResourceLayout.Offset;
+            uint8* dstSubResourceMem = uploadMem + subResourceLayout.Offset;
 
             for(uint64 z = 0; z < subResourceDepth; ++z)
             {
@@ -136,6 +119,14 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
                 Assert_(subImage != nullptr);
                 const uint8* srcSubResourceMem = subImage->pixels;
 
+                // Rows that are already padded out to the required pitch can go in one copy
+                if(subImage->rowPitch == subResourcePitch)
+                {
+                    memcpy(dstSubResourceMem, srcSubResourceMem, subResourcePitch * subResourceHeight);
+                    dstSubResourceMem += subResourcePitch * subResourceHeight;
+                    continue;
+                }
+
                 for(uint64 y = 0; y < subResourceHeight; ++y)
                 {
                     memcpy(dstSubResourceMem, srcSubResourceMem, Min(subResourcePitch, subImage->rowPitch));
@@ -145,7 +136,11 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
             }
         }
     }
+}
 
+static void RecordTextureCopies(const Texture& texture, const D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, uint64 numSubResources,
+                                const UploadContext& uploadContext, uint64 uploadOffset)
+{
     for(uint64 subResourceIdx = 0; subResourceIdx < numSubResources; ++subResourceIdx)
     {
         D3D12_TEXTURE_COPY_LOCATION dst = { };
@@ -156,19 +151,741 @@ void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
         src.pResource = uploadContext.Resource;
         src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
         src.PlacedFootprint = layouts[subResourceIdx];
-        src.PlacedFootprint.Offset += uploadContext.ResourceOffset;
+        src.PlacedFootprint.Offset += uploadContext.ResourceOffset + uploadOffset;
         uploadContext.CmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
     }
+}
+
+// Creates the texture from a decoded image, and uploads all of its subresources
+static void CreateTextureFromImage(Texture& texture, const DirectX::ScratchImage& image, const wchar* name, bool forceSRGB)
+{
+    const DirectX::TexMetadata& metaData = image.GetMetadata();
+    const D3D12_RESOURCE_DESC1 textureDesc = CreateTextureResource(texture, metaData, name, forceSRGB);
+
+    const uint64 numSubResources = metaData.mipLevels * metaData.arraySize;
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts = (D3D12_PLACED_SUBRESOURCE_FOOTPRINT*)_alloca(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) * numSubResources);
+    uint32* numRows = (uint32*)_alloca(sizeof(uint32) * numSubResources);
+    uint64* rowSizes = (uint64*)_alloca(sizeof(uint64) * numSubResources);
+
+    uint64 textureMemSize = 0;
+    DX12::Device->GetCopyableFootprints1(&textureDesc, 0, uint32(numSubResources), 0, layouts, numRows, rowSizes, &textureMemSize);
 
+    // Get a GPU upload buffer
+    UploadContext uploadContext = DX12::ResourceUploadBegin(textureMemSize);
+    CopyImageToUploadMem(image, layouts, numRows, reinterpret_cast<uint8*>(uploadContext.CPUAddress));
+    RecordTextureCopies(texture, layouts, numSubResources, uploadContext, 0);
     DX12::ResourceUploadEnd(uploadContext);
+}
 
-    texture.Width = uint32(metaData.width);
-    texture.Height = uint32(metaData.height);
-    texture.Depth = uint32(metaData.depth);
-    texture.NumMips = uint32(metaData.mipLevels);
-    texture.ArraySize = uint32(metaData.arraySize);
-    texture.Format = metaData.format;
-    texture.Cubemap = metaData.IsCubemap() ? 1 : 0;
+// Decodes a texture file from memory, and generates a full mip chain for formats that don't store
+// one. Only touches the CPU, so it can run on any thread that has COM initialized.
+HRESULT DecodeTextureFile(const void* fileData, uint64 fileSize, const wchar* filePath, DirectX::ScratchImage& image)
+{
+    const std::wstring extension = GetFileExtension(filePath);
+    if(extension == L"DDS" || extension == L"dds")
+        return DirectX::LoadFromDDSMemory(fileData, size_t(fileSize), DirectX::DDS_FLAGS_NONE, nullptr, image);
+
+    DirectX::ScratchImage tempImage;
+    HRESULT hr = S_OK;
+    if(extension == L"TGA" || extension == L"tga")
+        hr = DirectX::LoadFromTGAMemory(fileData, size_t(fileSize), nullptr, tempImage);
+    else
+        hr = DirectX::LoadFromWICMemory(fileData, size_t(fileSize), DirectX::WIC_FLAGS_IGNORE_SRGB, nullptr, tempImage);
+
+    if(FAILED(hr))
+        return hr;
+
+    return DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false);
+}
+
+void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB)
+{
+    texture.Shutdown();
+    if(FileExists(filePath) == false)
+        throw Exception(MakeString(L"Texture file with path '%ls' does not exist", filePath));
+
+    const std::wstring extension = GetFileExtension(filePath);
+    if(extension != L"DDS" && extension != L"dds")
+    {
+        // Everything else needs decoding and mips, so it goes through the texture cache
+        TextureLoadRequest request;
+        request.Texture = &texture;
+        request.FilePath = filePath;
+        request.ForceSRGB = forceSRGB;
+        LoadTextures(&request, 1);
+        return;
+    }
+
+    DirectX::ScratchImage image;
+    DXCall(DirectX::LoadFromDDSFile(filePath, DirectX::DDS_FLAGS_NONE, nullptr, image));
+
+    CreateTextureFromImage(texture, image, filePath, forceSRGB);
+}
+
+void LoadTexture(Texture& texture, const void* fileData, uint64 fileSize, const wchar* filePath, bool forceSRGB)
+{
+    texture.Shutdown();
+    Assert_(fileData != nullptr && fileSize > 0);
+
+    DirectX::ScratchImage image;
+    DXCall(DecodeTextureFile(fileData, fileSize, filePath, image));
+
+    CreateTextureFromImage(texture, image, filePath, forceSRGB);
+}
+
+// == Texture cache ===============================================================================
+
+// Decoded textures get cached on disk with their full mip chain, already laid out the way that an
+// upload buffer needs them. Cache files are named after a hash of the source file's contents, and
+// an index maps source files to those hashes so that a warm load never has to touch the source.
+static const wchar* TextureCacheDir = L"TextureCache";
+static const uint64 TextureCacheMagic = 0x4548434143584554ULL;     // "TEXCACHE"
+static const uint64 TextureCacheVersion = 1;
+static const uint64 TextureCacheDataAlignment = 64;
+
+struct TextureCacheHeader
+{
+    uint64 Magic = 0;
+    uint64 Version = 0;
+    uint64 Width = 0;
+    uint64 Height = 0;
+    uint64 Depth = 0;
+    uint64 ArraySize = 0;
+    uint64 MipLevels = 0;
+    uint32 Format = 0;
+    uint32 Dimension = 0;
+    uint32 MiscFlags = 0;
+    uint32 MiscFlags2 = 0;
+    uint64 DataOffset = 0;
+    uint64 DataSize = 0;
+};
+
+struct TextureCacheIndexEntry
+{
+    std::wstring FilePath;
+    uint64 FileSize = 0;
+    uint64 Timestamp = 0;
+    Hash ContentHash;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, FilePath);
+        SerializeItem(serializer, FileSize);
+        SerializeItem(serializer, Timestamp);
+        SerializeItem(serializer, ContentHash.A);
+        SerializeItem(serializer, ContentHash.B);
+    }
+};
+
+static const uint64 TextureCacheIndexVersion = 1;
+static List<TextureCacheIndexEntry> TextureCacheIndex;
+static bool TextureCacheIndexLoaded = false;
+static SRWLOCK TextureCacheIndexLock = SRWLOCK_INIT;
+
+static std::wstring TextureCacheIndexPath()
+{
+    return MakeString(L"%ls\\CacheIndex.bin", TextureCacheDir);
+}
+
+static void CreateTextureCacheDirectory()
+{
+    if(CreateDirectory(TextureCacheDir, nullptr) == false && GetLastError() != ERROR_ALREADY_EXISTS)
+        throw Win32Exception(GetLastError());
+}
+
+// Needs to be called with TextureCacheIndexLock held
+static void LoadTextureCacheIndex()
+{
+    TextureCacheIndexLoaded = true;
+
+    const std::wstring indexPath = TextureCacheIndexPath();
+    if(FileExists(indexPath.c_str()) == false)
+        return;
+
+    try
+    {
+        BufferedFileReadSerializer serializer(indexPath.c_str());
+        uint64 version = 0;
+        SerializeItem(serializer, version);
+        if(version == TextureCacheIndexVersion)
+            SerializeItem(serializer, TextureCacheIndex);
+    }
+    catch(Exception&)
+    {
+        // A truncated or corrupt index just means that the source files get re-hashed
+        TextureCacheIndex.Shutdown();
+    }
+}
+
+// Needs to be called with TextureCacheIndexLock held. The index is written to a temporary file first,
+// so that a failed write can't leave a truncated index behind.
+static void SaveTextureCacheIndex()
+{
+    CreateTextureCacheDirectory();
+
+    const std::wstring indexPath = TextureCacheIndexPath();
+    const std::wstring tempPath = indexPath + L".tmp";
+    {
+        BufferedFileWriteSerializer serializer(tempPath.c_str());
+        uint64 version = TextureCacheIndexVersion;
+        SerializeItem(serializer, version);
+        SerializeItem(serializer, TextureCacheIndex);
+        serializer.Flush();
+    }
+
+    Win32Call(MoveFileEx(tempPath.c_str(), indexPath.c_str(), MOVEFILE_REPLACE_EXISTING));
+}
+
+static std::wstring MakeTextureCachePath(Hash contentHash, bool forceSRGB, bool compress)
+{
+    const uint32 flags = (forceSRGB ? 1 : 0) | (compress ? 2 : 0);
+    return MakeString(L"%ls\\%ls_%u_%llu.texcache", TextureCacheDir, contentHash.ToString().c_str(), flags, TextureCacheVersion);
+}
+
+static Hash HashTextureFile(const Array<uint8>& fileData)
+{
+    Assert_(fileData.Size() <= INT32_MAX);
+    return GenerateHash(fileData.Data(), int32(fileData.Size()));
+}
+
+// Lays out the subresources the same way that GetCopyableFootprints does, with aligned row pitches
+// and subresource offsets, which doesn't depend on the device. Returns the total size.
+uint64 ComputeTextureCacheLayout(const DirectX::TexMetadata& metaData, Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts,
+                                 Array<uint32>& numRows)
+{
+    const uint64 numSubResources = metaData.mipLevels * metaData.arraySize;
+    layouts.Init(numSubResources);
+    numRows.Init(numSubResources);
+
+    const bool is3D = metaData.dimension == DirectX::TEX_DIMENSION_TEXTURE3D;
+    const bool compressed = DirectX::IsCompressed(metaData.format);
+
+    uint64 offset = 0;
+    for(uint64 arrayIdx = 0; arrayIdx < metaData.arraySize; ++arrayIdx)
+    {
+        for(uint64 mipIdx = 0; mipIdx < metaData.mipLevels; ++mipIdx)
+        {
+            const uint64 subResourceIdx = mipIdx + (arrayIdx * metaData.mipLevels);
+            const uint64 width = Max<uint64>(metaData.width >> mipIdx, 1);
+            const uint64 height = Max<uint64>(metaData.height >> mipIdx, 1);
+            const uint64 depth = is3D ? Max<uint64>(metaData.depth >> mipIdx, 1) : 1;
+
+            size_t rowPitch = 0;
+            size_t slicePitch = 0;
+            DirectX::ComputePitch(metaData.format, width, height, rowPitch, slicePitch);
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = layouts[subResourceIdx];
+            layout.Offset = AlignTo(offset, uint64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+            layout.Footprint.Format = metaData.format;
+            layout.Footprint.Width = uint32(width);
+            layout.Footprint.Height = uint32(height);
+            layout.Footprint.Depth = uint32(depth);
+            layout.Footprint.RowPitch = uint32(AlignTo(uint64(rowPitch), uint64(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT)));
+            numRows[subResourceIdx] = uint32(compressed ? Max<uint64>((height + 3) / 4, 1) : height);
+
+            offset = layout.Offset + uint64(layout.Footprint.RowPitch) * numRows[subResourceIdx] * depth;
+        }
+    }
+
+    return offset;
+}
+
+// Block compresses the decoded image if that was asked for and it's possible, and copies all of
+// its subresources into the cache layout
+HRESULT BuildTextureCache(DirectX::ScratchImage& image, bool forceSRGB, bool compress, DirectX::TexMetadata& metaData, Array<uint8>& data)
+{
+    const DirectX::TexMetadata& srcMetaData = image.GetMetadata();
+    const bool canCompress = DirectX::IsCompressed(srcMetaData.format) == false && srcMetaData.dimension == DirectX::TEX_DIMENSION_TEXTURE2D &&
+                             srcMetaData.width % 4 == 0 && srcMetaData.height % 4 == 0;
+    if(compress && canCompress)
+    {
+        const DXGI_FORMAT bcFormat = image.IsAlphaAllOpaque() ? DXGI_FORMAT_BC1_UNORM : DXGI_FORMAT_BC3_UNORM;
+        const DWORD compressFlags = forceSRGB ? DirectX::TEX_COMPRESS_SRGB : DirectX::TEX_COMPRESS_DEFAULT;
+
+        DirectX::ScratchImage compressedImage;
+        const HRESULT hr = DirectX::Compress(image.GetImages(), image.GetImageCount(), srcMetaData, bcFormat, compressFlags,
+                                             DirectX::TEX_THRESHOLD_DEFAULT, compressedImage);
+        if(FAILED(hr))
+            return hr;
+
+        image = std::move(compressedImage);
+    }
+
+    metaData = image.GetMetadata();
+
+    Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+    Array<uint32> numRows;
+    data.Init(ComputeTextureCacheLayout(metaData, layouts, numRows), 0);
+    CopyImageToUploadMem(image, layouts.Data(), numRows.Data(), data.Data());
+
+    return S_OK;
+}
+
+// The file is written under a temporary name first, so that a partially-written cache never shows
+// up under the real name. Returns false if the cache couldn't be written, which isn't fatal.
+bool WriteTextureCache(const wchar* cachePath, const DirectX::TexMetadata& metaData, const Array<uint8>& data)
+{
+    TextureCacheHeader header;
+    header.Magic = TextureCacheMagic;
+    header.Version = TextureCacheVersion;
+    header.Width = metaData.width;
+    header.Height = metaData.height;
+    header.Depth = metaData.depth;
+    header.ArraySize = metaData.arraySize;
+    header.MipLevels = metaData.mipLevels;
+    header.Format = uint32(metaData.format);
+    header.Dimension = uint32(metaData.dimension);
+    header.MiscFlags = uint32(metaData.miscFlags);
+    header.MiscFlags2 = uint32(metaData.miscFlags2);
+    header.DataOffset = AlignTo(uint64(sizeof(header)), TextureCacheDataAlignment);
+    header.DataSize = data.Size();
+
+    const std::wstring tempPath = MakeString(L"%ls.%u.tmp", cachePath, GetCurrentThreadId());
+    try
+    {
+        const uint8 padding[TextureCacheDataAlignment] = { };
+
+        File file(tempPath.c_str(), FileOpenMode::Write);
+        file.Write(header);
+        file.Write(header.DataOffset - sizeof(header), padding);
+        file.Write(data.Size(), data.Data());
+    }
+    catch(Exception&)
+    {
+        DeleteFile(tempPath.c_str());
+        return false;
+    }
+
+    if(MoveFileEx(tempPath.c_str(), cachePath, MOVEFILE_REPLACE_EXISTING) == false)
+    {
+        DeleteFile(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Maps a cache file and checks that it's intact. The data stays valid for as long as the file is open.
+bool MapTextureCache(const wchar* cachePath, MemoryMappedFile& cacheFile, DirectX::TexMetadata& metaData,
+                     const uint8*& data, uint64& dataSize)
+{
+    if(FileExists(cachePath) == false)
+        return false;
+
+    try
+    {
+        cacheFile.Open(cachePath);
+    }
+    catch(Exception&)
+    {
+        return false;
+    }
+
+    TextureCacheHeader header;
+    bool valid = cacheFile.Size() >= sizeof(header);
+    if(valid)
+        memcpy(&header, cacheFile.Data(), sizeof(header));
+
+    valid = valid && header.Magic == TextureCacheMagic && header.Version == TextureCacheVersion;
+    valid = valid && header.Width > 0 && header.Height > 0 && header.Depth > 0 && header.ArraySize > 0;
+    valid = valid && header.MipLevels > 0 && header.MipLevels <= NumMipLevels(header.Width, header.Height, header.Depth);
+    valid = valid && header.DataOffset >= sizeof(header) && header.DataOffset <= cacheFile.Size();
+    valid = valid && header.DataSize <= cacheFile.Size() - header.DataOffset;
+
+    if(valid)
+    {
+        metaData = DirectX::TexMetadata();
+        metaData.width = size_t(header.Width);
+        metaData.height = size_t(header.Height);
+        metaData.depth = size_t(header.Depth);
+        metaData.arraySize = size_t(header.ArraySize);
+        metaData.mipLevels = size_t(header.MipLevels);
+        metaData.format = DXGI_FORMAT(header.Format);
+        metaData.dimension = DirectX::TEX_DIMENSION(header.Dimension);
+        metaData.miscFlags = header.MiscFlags;
+        metaData.miscFlags2 = header.MiscFlags2;
+
+        Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+        Array<uint32> numRows;
+        valid = ComputeTextureCacheLayout(metaData, layouts, numRows) == header.DataSize;
+    }
+
+    if(valid == false)
+    {
+        cacheFile.Close();
+        return false;
+    }
+
+    data = cacheFile.Data() + header.DataOffset;
+    dataSize = header.DataSize;
+
+    return true;
+}
+
+// Copies cached data into upload memory. The cache layout should always match the device's, which
+// makes this a single copy, but it falls back to going row by row if it doesn't.
+void CopyCachedDataToUploadMem(const uint8* data, uint64 dataSize, const DirectX::TexMetadata& metaData,
+                               const Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts, const Array<uint32>& numRows,
+                               uint64 uploadSize, uint8* uploadMem)
+{
+    Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> cacheLayouts;
+    Array<uint32> cacheNumRows;
+    ComputeTextureCacheLayout(metaData, cacheLayouts, cacheNumRows);
+    Assert_(cacheLayouts.Size() == layouts.Size());
+
+    bool sameLayout = true;
+    for(uint64 i = 0; i < layouts.Size(); ++i)
+    {
+        sameLayout = sameLayout && cacheLayouts[i].Offset == layouts[i].Offset && cacheLayouts[i].Footprint.RowPitch == layouts[i].Footprint.RowPitch &&
+                     cacheLayouts[i].Footprint.Depth == layouts[i].Footprint.Depth && cacheNumRows[i] == numRows[i];
+    }
+
+    if(sameLayout)
+    {
+        memcpy(uploadMem, data, Min(dataSize, uploadSize));
+        return;
+    }
+
+    for(uint64 i = 0; i < layouts.Size(); ++i)
+    {
+        const uint64 srcPitch = cacheLayouts[i].Footprint.RowPitch;
+        const uint64 dstPitch = layouts[i].Footprint.RowPitch;
+        const uint64 rowCount = uint64(Min(cacheNumRows[i], numRows[i])) * Min(cacheLayouts[i].Footprint.Depth, layouts[i].Footprint.Depth);
+
+        const uint8* srcMem = data + cacheLayouts[i].Offset;
+        uint8* dstMem = uploadMem + layouts[i].Offset;
+        for(uint64 row = 0; row < rowCount; ++row)
+            memcpy(dstMem + row * dstPitch, srcMem + row * srcPitch, Min(srcPitch, dstPitch));
+    }
+}
+
+// == Batched loading =============================================================================
+
+struct BatchedTexture
+{
+    // Textures are either uploaded from the decoded image, or from data in the cache layout. The
+    // cached data is either mapped from the cache file or was just built from the image.
+    DirectX::ScratchImage Image;
+    DirectX::TexMetadata Metadata;
+    MemoryMappedFile CacheFile;
+    Array<uint8> CacheData;
+    const uint8* CachedData = nullptr;
+    uint64 CachedDataSize = 0;
+    bool CacheHit = false;
+    bool CacheBuilt = false;
+    bool ReadFailed = false;
+    HRESULT DecodeResult = S_OK;
+
+    Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+    Array<uint32> NumRows;
+    uint64 UploadSize = 0;
+    uint64 UploadOffset = 0;
+
+    void Reset()
+    {
+        Image.Release();
+        CacheFile.Close();
+        CacheData.Shutdown();
+        CachedData = nullptr;
+        CachedDataSize = 0;
+        CacheHit = false;
+        CacheBuilt = false;
+        ReadFailed = false;
+        DecodeResult = S_OK;
+    }
+};
+
+// What's known about a texture's cache before any of its files are touched
+struct TextureCacheLookup
+{
+    bool Cacheable = false;
+    bool IndexHit = false;      // the index has a content hash for the file as it is now, and that cache exists
+    bool UpdateIndex = false;
+    uint64 FileSize = 0;
+    uint64 Timestamp = 0;
+    Hash ContentHash;
+};
+
+static void ReadTextureBatch(const TextureLoadRequest* requests, const Array<TextureCacheLookup>& cacheLookups, uint64 batchStart,
+                             uint64 batchEnd, Array<Array<uint8>>& fileData, Array<AsyncRead>& reads)
+{
+    // Cache hits don't need the source file at all
+    for(uint64 i = batchStart; i < batchEnd; ++i)
+    {
+        if(cacheLookups[i].IndexHit == false)
+            reads[i] = AsyncIO::ReadFile(requests[i].FilePath, fileData[i]);
+    }
+}
+
+static void LoadBatchedTexture(const TextureLoadRequest& request, TextureCacheLookup& cacheLookup, Array<uint8>& fileData,
+                               AsyncRead& read, BatchedTexture& batchedTexture)
+{
+    if(cacheLookup.IndexHit)
+    {
+        const std::wstring cachePath = MakeTextureCachePath(cacheLookup.ContentHash, request.ForceSRGB, request.CompressCache);
+        batchedTexture.CacheHit = MapTextureCache(cachePath.c_str(), batchedTexture.CacheFile, batchedTexture.Metadata,
+                                                  batchedTexture.CachedData, batchedTexture.CachedDataSize);
+        if(batchedTexture.CacheHit)
+            return;
+
+        // The cache is broken, so it has to be rebuilt from the source
+        read = AsyncIO::ReadFile(request.FilePath, fileData);
+    }
+
+    if(read.Wait() != AsyncIOStatus::Succeeded || fileData.Size() == 0)
+    {
+        batchedTexture.ReadFailed = true;
+        return;
+    }
+
+    if(cacheLookup.Cacheable)
+    {
+        cacheLookup.ContentHash = HashTextureFile(fileData);
+        cacheLookup.UpdateIndex = true;
+
+        // The file might have only been touched, in which case its contents are still cached
+        const std::wstring cachePath = MakeTextureCachePath(cacheLookup.ContentHash, request.ForceSRGB, request.CompressCache);
+        batchedTexture.CacheHit = MapTextureCache(cachePath.c_str(), batchedTexture.CacheFile, batchedTexture.Metadata,
+                                                  batchedTexture.CachedData, batchedTexture.CachedDataSize);
+        if(batchedTexture.CacheHit)
+            return;
+
+        batchedTexture.DecodeResult = DecodeTextureFile(fileData.Data(), fileData.Size(), request.FilePath, batchedTexture.Image);
+        if(SUCCEEDED(batchedTexture.DecodeResult))
+            batchedTexture.DecodeResult = BuildTextureCache(batchedTexture.Image, request.ForceSRGB, request.CompressCache,
+                                                            batchedTexture.Metadata, batchedTexture.CacheData);
+        if(FAILED(batchedTexture.DecodeResult))
+            return;
+
+        // Only the cache layout is needed from here on
+        batchedTexture.Image.Release();
+        batchedTexture.CachedData = batchedTexture.CacheData.Data();
+        batchedTexture.CachedDataSize = batchedTexture.CacheData.Size();
+        batchedTexture.CacheBuilt = WriteTextureCache(cachePath.c_str(), batchedTexture.Metadata, batchedTexture.CacheData);
+        return;
+    }
+
+    batchedTexture.DecodeResult = DecodeTextureFile(fileData.Data(), fileData.Size(), request.FilePath, batchedTexture.Image);
+    if(SUCCEEDED(batchedTexture.DecodeResult))
+        batchedTexture.Metadata = batchedTexture.Image.GetMetadata();
+}
+
+void LoadTextures(const TextureLoadRequest* requests, uint64 numRequests, TextureLoadStats* stats)
+{
+    Assert_(requests != nullptr || numRequests == 0);
+
+    Timer timer;
+    TextureLoadStats batchStats;
+    batchStats.NumTextures = numRequests;
+
+    // Look everything up in the cache index up-front, so that the source files of cache hits never
+    // need to be read. DDS files already have their mips, and are loaded as-is.
+    Array<TextureCacheLookup> cacheLookups(numRequests);
+    bool anyCacheable = false;
+    for(uint64 i = 0; i < numRequests; ++i)
+    {
+        const std::wstring extension = GetFileExtension(requests[i].FilePath);
+        TextureCacheLookup& cacheLookup = cacheLookups[i];
+        cacheLookup.Cacheable = requests[i].UseCache && extension != L"DDS" && extension != L"dds" && FileExists(requests[i].FilePath);
+        if(cacheLookup.Cacheable == false)
+            continue;
+
+        cacheLookup.FileSize = GetFileSizeInBytes(requests[i].FilePath);
+        cacheLookup.Timestamp = GetFileTimestamp(requests[i].FilePath);
+        cacheLookup.Cacheable = cacheLookup.FileSize <= INT32_MAX;
+        anyCacheable = anyCacheable || cacheLookup.Cacheable;
+    }
+
+    if(anyCacheable)
+    {
+        // The cache files get written from the decode jobs, so the directory needs to exist up front
+        CreateTextureCacheDirectory();
+
+        AcquireSRWLockExclusive(&TextureCacheIndexLock);
+
+        try
+        {
+            if(TextureCacheIndexLoaded == false)
+                LoadTextureCacheIndex();
+
+            for(uint64 i = 0; i < numRequests; ++i)
+            {
+                TextureCacheLookup& cacheLookup = cacheLookups[i];
+                if(cacheLookup.Cacheable == false)
+                    continue;
+
+                for(const TextureCacheIndexEntry& entry : TextureCacheIndex)
+                {
+                    if(entry.FilePath == requests[i].FilePath && entry.FileSize == cacheLookup.FileSize && entry.Timestamp == cacheLookup.Timestamp)
+                    {
+                        const std::wstring cachePath = MakeTextureCachePath(entry.ContentHash, requests[i].ForceSRGB, requests[i].CompressCache);
+                        cacheLookup.IndexHit = FileExists(cachePath.c_str());
+                        cacheLookup.ContentHash = entry.ContentHash;
+                        break;
+                    }
+                }
+            }
+        }
+        catch(...)
+        {
+            ReleaseSRWLockExclusive(&TextureCacheIndexLock);
+            throw;
+        }
+
+        ReleaseSRWLockExclusive(&TextureCacheIndexLock);
+    }
+
+    // The reads need to be declared after the data so that they're waited on before it's freed
+    Array<Array<uint8>> fileData(numRequests);
+    Array<AsyncRead> reads(numRequests);
+    Array<BatchedTexture> textures(Min(numRequests, MaxTextureLoadBatchSize));
+
+    ReadTextureBatch(requests, cacheLookups, 0, Min(numRequests, MaxTextureLoadBatchSize), fileData, reads);
+
+    for(uint64 batchStart = 0; batchStart < numRequests; batchStart += MaxTextureLoadBatchSize)
+    {
+        const uint64 batchEnd = Min(batchStart + MaxTextureLoadBatchSize, numRequests);
+        const uint64 batchSize = batchEnd - batchStart;
+
+        // Get the files for the next batch coming in while this one is decoded and uploaded
+        ReadTextureBatch(requests, cacheLookups, batchEnd, Min(batchEnd + MaxTextureLoadBatchSize, numRequests), fileData, reads);
+
+        Jobs::ParallelForRange(batchSize, 1, [&](uint64 start, uint64 end, uint32)
+        {
+            // WIC needs COM on the decoding thread
+            const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+            for(uint64 i = start; i < end; ++i)
+            {
+                const uint64 requestIdx = batchStart + i;
+                textures[i].Reset();
+                LoadBatchedTexture(requests[requestIdx], cacheLookups[requestIdx], fileData[requestIdx], reads[requestIdx], textures[i]);
+
+                reads[requestIdx].Release();
+                fileData[requestIdx].Shutdown();
+            }
+
+            if(SUCCEEDED(comResult))
+                CoUninitialize();
+        });
+
+        // Create all of the resources, and figure out where each texture goes in the upload buffer
+        for(uint64 i = 0; i < batchSize; ++i)
+        {
+            const TextureLoadRequest& request = requests[batchStart + i];
+            BatchedTexture& batchedTexture = textures[i];
+            if(batchedTexture.ReadFailed)
+                throw Exception(MakeString(L"Failed to read texture file '%ls'", request.FilePath));
+            if(FAILED(batchedTexture.DecodeResult))
+                throw Exception(MakeString(L"Failed to load texture '%ls': %ls", request.FilePath, GetDXErrorString(batchedTexture.DecodeResult).c_str()));
+
+            batchStats.NumCacheHits += batchedTexture.CacheHit ? 1 : 0;
+            batchStats.NumCachesBuilt += batchedTexture.CacheBuilt ? 1 : 0;
+
+            request.Texture->Shutdown();
+            const DirectX::TexMetadata& metaData = batchedTexture.Metadata;
+            const D3D12_RESOURCE_DESC1 textureDesc = CreateTextureResource(*request.Texture, metaData, request.FilePath, request.ForceSRGB);
+
+            const uint64 numSubResources = metaData.mipLevels * metaData.arraySize;
+            batchedTexture.Layouts.Init(numSubResources);
+            batchedTexture.NumRows.Init(numSubResources);
+            DX12::Device->GetCopyableFootprints1(&textureDesc, 0, uint32(numSubResources), 0, batchedTexture.Layouts.Data(),
+                                                 batchedTexture.NumRows.Data(), nullptr, &batchedTexture.UploadSize);
+        }
+
+        // Pack as many textures as will fit into each upload
+        for(uint64 uploadStart = 0; uploadStart < batchSize;)
+        {
+            uint64 uploadEnd = uploadStart;
+            uint64 uploadSize = 0;
+            while(uploadEnd < batchSize)
+            {
+                const uint64 offset = AlignTo(uploadSize, uint64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+                const uint64 textureUploadSize = textures[uploadEnd].UploadSize;
+                if(uploadEnd > uploadStart && offset + textureUploadSize > MaxTextureUploadSize)
+                    break;
+
+                textures[uploadEnd].UploadOffset = offset;
+                uploadSize = offset + textureUploadSize;
+                ++uploadEnd;
+            }
+
+            UploadContext uploadContext = DX12::ResourceUploadBegin(uploadSize);
+            uint8* uploadMem = reinterpret_cast<uint8*>(uploadContext.CPUAddress);
+
+            Jobs::ParallelFor(uploadEnd - uploadStart, [&](uint64 i)
+            {
+                const BatchedTexture& batchedTexture = textures[uploadStart + i];
+                uint8* textureUploadMem = uploadMem + batchedTexture.UploadOffset;
+                if(batchedTexture.CachedData != nullptr)
+                    CopyCachedDataToUploadMem(batchedTexture.CachedData, batchedTexture.CachedDataSize, batchedTexture.Metadata,
+                                              batchedTexture.Layouts, batchedTexture.NumRows, batchedTexture.UploadSize, textureUploadMem);
+                else
+                    CopyImageToUploadMem(batchedTexture.Image, batchedTexture.Layouts.Data(), batchedTexture.NumRows.Data(), textureUploadMem);
+            });
+
+            for(uint64 i = uploadStart; i < uploadEnd; ++i)
+                RecordTextureCopies(*requests[batchStart + i].Texture, textures[i].Layouts.Data(), textures[i].Layouts.Size(),
+                                    uploadContext, textures[i].UploadOffset);
+
+            DX12::ResourceUploadEnd(uploadContext);
+
+            batchStats.NumUploads += 1;
+            batchStats.UploadBytes += uploadSize;
+            uploadStart = uploadEnd;
+        }
+
+        for(uint64 i = 0; i < batchSize; ++i)
+            textures[i].Reset();
+    }
+
+    // Remember the content hashes of any files that had to be read, so that they can be skipped next time
+    bool indexChanged = false;
+    AcquireSRWLockExclusive(&TextureCacheIndexLock);
+
+    try
+    {
+        for(uint64 i = 0; i < numRequests; ++i)
+        {
+            const TextureCacheLookup& cacheLookup = cacheLookups[i];
+            if(cacheLookup.UpdateIndex == false)
+                continue;
+
+            TextureCacheIndexEntry* indexEntry = nullptr;
+            for(TextureCacheIndexEntry& entry : TextureCacheIndex)
+            {
+                if(entry.FilePath == requests[i].FilePath)
+                    indexEntry = &entry;
+            }
+
+            if(indexEntry == nullptr)
+            {
+                indexEntry = &TextureCacheIndex.Add();
+                indexEntry->FilePath = requests[i].FilePath;
+            }
+
+            indexEntry->FileSize = cacheLookup.FileSize;
+            indexEntry->Timestamp = cacheLookup.Timestamp;
+            indexEntry->ContentHash = cacheLookup.ContentHash;
+            indexChanged = true;
+        }
+
+        if(indexChanged)
+            SaveTextureCacheIndex();
+    }
+    catch(...)
+    {
+        ReleaseSRWLockExclusive(&TextureCacheIndexLock);
+        throw;
+    }
+
+    ReleaseSRWLockExclusive(&TextureCacheIndexLock);
+
+    timer.Update();
+    batchStats.LoadTimeMS = timer.ElapsedMillisecondsD();
+
+    if(stats != nullptr)
+        *stats = batchStats;
 }
 
 void Create2DTexture(Texture& texture, uint64 width, uint64 height, uint64 numMips,
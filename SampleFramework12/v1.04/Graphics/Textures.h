@@ -26,6 +26,68 @@ class File;
 
 // Texture loading and creation
 void LoadTexture(Texture& texture, const wchar* filePath, bool forceSRGB = false);
+
+// Decodes a texture file that's already been read into memory. The path is only used for picking
+// the file format, and for naming the resource.
+void LoadTexture(Texture& texture, const void* fileData, uint64 fileSize, const wchar* filePath, bool forceSRGB = false);
+
+struct TextureLoadRequest
+{
+    Texture* Texture = nullptr;
+    const wchar* FilePath = nullptr;
+    bool ForceSRGB = false;
+    bool UseCache = true;           // only applies to formats that need decoding, so not DDS
+    bool CompressCache = false;     // BC1/BC3 compress the cached data, if the texture is a multiple of 4 in size
+};
+
+struct TextureLoadStats
+{
+    uint64 NumTextures = 0;
+    uint64 NumUploads = 0;
+    uint64 UploadBytes = 0;
+    uint64 NumCacheHits = 0;
+    uint64 NumCachesBuilt = 0;
+    double LoadTimeMS = 0.0;
+};
+
+// Textures are loaded in batches of this many, which limits how many decoded images are in memory
+static const uint64 MaxTextureLoadBatchSize = 32;
+
+// Textures are packed together into uploads of up to this size, unless a single texture is bigger
+static const uint64 MaxTextureUploadSize = 64 * 1024 * 1024;
+
+// Loads many textures at once. The files are read through AsyncIO, decoded and given mips on the
+// job threads, and then copied into a few large uploads. The next batch of files is read while the
+// current one is being decoded and uploaded. Every request needs its own texture.
+//
+// Decoded textures are cached in the TextureCache directory with their mips, in the same layout
+// that they have in an upload buffer. A cached texture is mapped and copied straight into the
+// upload without reading the source file, as long as the file's size and timestamp haven't changed.
+void LoadTextures(const TextureLoadRequest* requests, uint64 numRequests, TextureLoadStats* stats = nullptr);
+
+// CPU-side decoding and texture cache steps that LoadTextures() is built from. None of these need a device.
+
+// Decodes a texture file from memory, and generates a full mip chain for formats that don't store one
+HRESULT DecodeTextureFile(const void* fileData, uint64 fileSize, const wchar* filePath, DirectX::ScratchImage& image);
+
+// Lays out the subresources the way an upload buffer would, without needing the device. Returns the total size.
+uint64 ComputeTextureCacheLayout(const DirectX::TexMetadata& metaData, Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts,
+                                 Array<uint32>& numRows);
+
+// Optionally block compresses a decoded image, and copies it into the cache layout
+HRESULT BuildTextureCache(DirectX::ScratchImage& image, bool forceSRGB, bool compress, DirectX::TexMetadata& metaData, Array<uint8>& data);
+
+// Returns false if the cache file couldn't be written
+bool WriteTextureCache(const wchar* cachePath, const DirectX::TexMetadata& metaData, const Array<uint8>& data);
+
+// Returns false if the cache file is missing or damaged. The data stays valid for as long as the file is open.
+bool MapTextureCache(const wchar* cachePath, MemoryMappedFile& cacheFile, DirectX::TexMetadata& metaData,
+                     const uint8*& data, uint64& dataSize);
+
+void CopyCachedDataToUploadMem(const uint8* data, uint64 dataSize, const DirectX::TexMetadata& metaData,
+                               const Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& layouts, const Array<uint32>& numRows,
+                               uint64 uploadSize, uint8* uploadMem);
+
 void Create2DTexture(Texture& texture, uint64 width, uint64 height, uint64 numMips,
                      uint64 arraySize, DXGI_FORMAT format, bool cubeMap, const void* initData);
 void Create3DTexture(Texture& texture, uint64 width, uint64 height, uint64 depth, uint64 numMips,
@@ -0,0 +1,101 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+#include "Jobs.h"
+#include "Utility.h"
+
+namespace SampleFramework12
+{
+
+namespace Jobs
+{
+
+static enki::TaskScheduler* scheduler = nullptr;
+static uint32 numThreads = 1;
+
+void Initialize(uint32 threadCount)
+{
+    Assert_(scheduler == nullptr);
+
+    numThreads = threadCount > 0 ? threadCount : enki::GetNumHardwareThreads();
+    scheduler = new enki::TaskScheduler();
+    scheduler->Initialize(numThreads);
+
+    WriteLog("Initialized job system with %u threads", numThreads);
+}
+
+void Shutdown()
+{
+    if(scheduler == nullptr)
+        return;
+
+    scheduler->WaitforAllAndShutdown();
+    delete scheduler;
+    scheduler = nullptr;
+    numThreads = 1;
+}
+
+bool Initialized()
+{
+    return scheduler != nullptr;
+}
+
+uint32 NumThreads()
+{
+    return numThreads;
+}
+
+uint32 ThreadIndex()
+{
+    return scheduler ? scheduler->GetThreadNum() : 0;
+}
+
+enki::TaskScheduler& Scheduler()
+{
+    Assert_(scheduler != nullptr);
+    return *scheduler;
+}
+
+void Run(enki::ITaskSet& taskSet)
+{
+    Assert_(scheduler != nullptr);
+    scheduler->AddTaskSetToPipe(&taskSet);
+    scheduler->WaitforTask(&taskSet);
+}
+
+}
+
+// == Job =========================================================================================
+
+void Job::Init(uint64 count, RangeFunction func, uint64 minRange)
+{
+    Assert_(taskSet.GetIsComplete());
+    Assert_(count > 0 && count <= UINT32_MAX);
+    Assert_(func);
+
+    taskSet.m_SetSize = uint32(count);
+    taskSet.m_MinRange = uint32(Max<uint64>(minRange, 1));
+    taskSet.m_Function = [func](enki::TaskSetPartition range, uint32_t threadNum)
+    {
+        func(uint64(range.start), uint64(range.end), uint32(threadNum));
+    };
+}
+
+void Job::Launch()
+{
+    Jobs::Scheduler().AddTaskSetToPipe(&taskSet);
+}
+
+void Job::Wait()
+{
+    Jobs::Scheduler().WaitforTask(&taskSet);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "PCH.h"
+#include "Containers.h"
+#include "SF12_Assert.h"
+#include "SF12_Math.h"
+#include "EnkiTS\\TaskScheduler.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+// Framework-wide job system built on top of EnkiTS. The App owns the scheduler, and initializes it
+// before anything else so that loading code can use it. Jobs need to be launched and waited on
+// from the thread that called Initialize(), or from inside of other jobs.
+namespace Jobs
+{
+    void Initialize(uint32 numThreads = 0);     // 0 means use all hardware threads
+    void Shutdown();
+
+    bool Initialized();
+    uint32 NumThreads();
+    uint32 ThreadIndex();
+    enki::TaskScheduler& Scheduler();
+
+    // Runs the task set and waits for it to complete, helping out with the work while waiting
+    void Run(enki::ITaskSet& taskSet);
+
+    // Calls func(start, end, threadIdx) over sub-ranges of [0, count). Ranges are at least minRange
+    // elements (apart from the last one), and at most maxThreads threads will work on them at once.
+    // Runs inline on the calling thread if the job system isn't initialized or the count is small.
+    template<typename TFunc> void ParallelForRange(uint64 count, uint64 minRange, const TFunc& func, uint32 maxThreads = 0)
+    {
+        if(count == 0)
+            return;
+
+        minRange = minRange > 0 ? minRange : 1;
+        const uint32 numThreads = Initialized() ? (maxThreads > 0 ? Min(maxThreads, NumThreads()) : NumThreads()) : 1;
+        if(numThreads <= 1 || count <= minRange)
+        {
+            func(uint64(0), count, ThreadIndex());
+            return;
+        }
+
+        Assert_(count <= UINT32_MAX);
+
+        if(numThreads < NumThreads())
+        {
+            // Limit the concurrency by only creating one partition per thread, and have those
+            // partitions pull ranges from a shared counter
+            std::atomic<uint64> nextStart = 0;
+            enki::TaskSet taskSet(numThreads, [&](enki::TaskSetPartition range, uint32_t threadNum)
+            {
+                for(uint64 start = nextStart.fetch_add(minRange); start < count; start = nextStart.fetch_add(minRange))
+                    func(start, Min(start + minRange, count), uint32(threadNum));
+            });
+            Run(taskSet);
+        }
+        else
+        {
+            enki::TaskSet taskSet(uint32(count), [&](enki::TaskSetPartition range, uint32_t threadNum)
+            {
+                func(uint64(range.start), uint64(range.end), uint32(threadNum));
+            });
+            taskSet.m_MinRange = uint32(minRange);
+            Run(taskSet);
+        }
+    }
+
+    // Calls func(idx) for every index in [0, count)
+    template<typename TFunc> void ParallelFor(uint64 count, const TFunc& func, uint32 maxThreads = 0)
+    {
+        ParallelForRange(count, 1, [&](uint64 start, uint64 end, uint32 threadIdx)
+        {
+            for(uint64 i = start; i < end; ++i)
+                func(i);
+        }, maxThreads);
+    }
+
+    // Calls func(element, idx) for every element of the container
+    template<typename T, typename TFunc> void ParallelFor(Array<T>& elements, const TFunc& func, uint32 maxThreads = 0)
+    {
+        ParallelFor(elements.Size(), [&](uint64 i) { func(elements[i], i); }, maxThreads);
+    }
+
+    template<typename T, typename TFunc> void ParallelFor(List<T>& elements, const TFunc& func, uint32 maxThreads = 0)
+    {
+        ParallelFor(elements.Count(), [&](uint64 i) { func(elements[i], i); }, maxThreads);
+    }
+}
+
+// A task set that runs a function over [0, count) in the background. Unlike Jobs::Run(), launching
+// doesn't block, so the job needs to outlive the work and has to be waited on before it's destroyed
+// or re-initialized.
+class Job
+{
+
+public:
+
+    typedef std::function<void(uint64 start, uint64 end, uint32 threadIdx)> RangeFunction;
+
+    Job() { }
+    Job(uint64 count, RangeFunction func, uint64 minRange = 1)
+    {
+        Init(count, func, minRange);
+    }
+
+    void Init(uint64 count, RangeFunction func, uint64 minRange = 1);
+
+    void Launch();
+    void Wait();
+
+    bool IsComplete() const { return taskSet.GetIsComplete(); }
+
+    Job(const Job&) = delete;
+    Job& operator=(const Job&) = delete;
+
+private:
+
+    enki::TaskSet taskSet;
+};
+
+}
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include "PCH.h"
 #include "MurmurHash.h"
 #include "Utility.h"
+#include "FileIO.h"
+#include "Jobs.h"
 
 namespace SampleFramework12
 {
@@ -158,4 +160,36 @@ Hash CombineHashes(Hash a, Hash b)
     return c;
 }
 
+Hash GenerateFileHash(const wchar* filePath, bool multiThreaded, uint64 chunkSize)
+{
+    Assert_(chunkSize > 0 && chunkSize <= INT32_MAX);
+
+    File file(filePath, FileOpenMode::Read);
+    const uint64 fileSize = file.Size();
+    file.Close();
+
+    if(fileSize == 0)
+        return GenerateHash(nullptr, 0);
+
+    // Each chunk is hashed independently using its index as the seed, and then the chunk hashes
+    // are hashed together in order. This keeps the result identical no matter how many threads
+    // are used, and avoids identical chunks cancelling each other out.
+    MemoryMappedFile mappedFile(filePath);
+    const uint8* fileData = mappedFile.Data();
+
+    const uint64 numChunks = (fileSize + chunkSize - 1) / chunkSize;
+    Array<Hash> chunkHashes(numChunks);
+
+    auto hashChunk = [&](uint64 chunkIdx)
+    {
+        const uint64 chunkStart = chunkIdx * chunkSize;
+        const uint64 chunkEnd = Min(chunkStart + chunkSize, fileSize);
+        chunkHashes[chunkIdx] = GenerateHash(fileData + chunkStart, int32(chunkEnd - chunkStart), uint32(chunkIdx));
+    };
+
+    Jobs::ParallelFor(numChunks, hashChunk, multiThreaded ? 0 : 1);
+
+    return GenerateHash(chunkHashes.Data(), int32(chunkHashes.MemorySize()), uint32(fileSize));
+}
+
 }
\ No newline at end of file
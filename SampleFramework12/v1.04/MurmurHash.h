@@ -30,7 +30,22 @@ inline bool operator==(const Hash& a, const Hash& b)
     return a.A == b.A && a.B == b.B;
 }
 
+inline bool operator!=(const Hash& a, const Hash& b)
+{
+    return (a == b) == false;
+}
+
+inline bool operator<(const Hash& a, const Hash& b)
+{
+    return a.A < b.A || (a.A == b.A && a.B < b.B);
+}
+
 Hash GenerateHash(const void* key, int32 len, uint32 seed = 0);
 Hash CombineHashes(Hash a, Hash b);
 
+// Hashes the contents of a file in fixed-size chunks, optionally spreading the chunks across
+// multiple threads. The result only depends on the file contents and chunk size.
+static const uint64 DefaultFileHashChunkSize = 4 * 1024 * 1024;
+Hash GenerateFileHash(const wchar* filePath, bool multiThreaded = false, uint64 chunkSize = DefaultFileHashChunkSize);
+
 }
\ No newline at end of file
@@ -143,6 +143,7 @@ typedef uint32_t bool32;
 #pragma comment(lib, "psapi.lib")
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "D3D12.lib")
+#pragma comment(lib, "Cabinet.lib")
 
 // DXC
 #include "..\\..\\Externals\\DXCompiler\\Include\\dxcapi.h"
@@ -74,6 +74,255 @@ public:
     static bool IsWriteSerializer() { return true; }
 };
 
+// Reads a file through a large staging buffer, so that serializing lots of small items doesn't turn
+// into a ReadFile() call for each one of them. Reads that are bigger than the buffer bypass it.
+class BufferedFileReadSerializer
+{
+
+private:
+
+    File file;
+    Array<uint8> buffer;
+    uint64 bufferOffset = 0;    // read position within the buffer
+    uint64 bufferSize = 0;      // number of valid bytes in the buffer
+    uint64 fileRemaining = 0;   // bytes that haven't been read into the buffer yet
+
+    void Refill()
+    {
+        bufferSize = Min(buffer.Size(), fileRemaining);
+        file.Read(bufferSize, buffer.Data());
+        fileRemaining -= bufferSize;
+        bufferOffset = 0;
+    }
+
+public:
+
+    static const uint64 DefaultBufferSize = 1024 * 1024;
+
+    explicit BufferedFileReadSerializer(const wchar* path, uint64 stagingBufferSize = DefaultBufferSize)
+    {
+        Assert_(stagingBufferSize > 0);
+        file.Open(path, FileOpenMode::Read);
+        fileRemaining = file.Size();
+        buffer.Init(stagingBufferSize);
+    }
+
+    template<typename T> void SerializeItem(T& data)
+    {
+        if(bufferSize - bufferOffset >= sizeof(T))
+        {
+            memcpy(&data, buffer.Data() + bufferOffset, sizeof(T));
+            bufferOffset += sizeof(T);
+        }
+        else
+            SerializeData(sizeof(T), &data);
+    }
+
+    void SerializeData(uint64 size, void* data)
+    {
+        uint8* dst = reinterpret_cast<uint8*>(data);
+
+        // Use up whatever's left in the buffer first
+        const uint64 buffered = Min(size, bufferSize - bufferOffset);
+        if(buffered > 0)
+        {
+            memcpy(dst, buffer.Data() + bufferOffset, buffered);
+            bufferOffset += buffered;
+            dst += buffered;
+            size -= buffered;
+        }
+
+        if(size == 0)
+            return;
+
+        if(size > fileRemaining)
+            throw Exception(L"Attempted to serialize past the end of a file");
+
+        if(size >= buffer.Size())
+        {
+            file.Read(size, dst);
+            fileRemaining -= size;
+            return;
+        }
+
+        Refill();
+        memcpy(dst, buffer.Data(), size);
+        bufferOffset = size;
+    }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Collects writes in a large staging buffer, and only writes to the file once it fills up. Flush()
+// needs to be called once everything has been serialized: the destructor doesn't write anything, so
+// that a serializer that goes out of scope during unwinding can't throw or append a partial item.
+class BufferedFileWriteSerializer
+{
+
+private:
+
+    File file;
+    Array<uint8> buffer;
+    uint64 bufferUsed = 0;
+
+public:
+
+    static const uint64 DefaultBufferSize = 1024 * 1024;
+
+    explicit BufferedFileWriteSerializer(const wchar* path, uint64 stagingBufferSize = DefaultBufferSize)
+    {
+        Assert_(stagingBufferSize > 0);
+        file.Open(path, FileOpenMode::Write);
+        buffer.Init(stagingBufferSize);
+    }
+
+    template<typename T> void SerializeItem(const T& data)
+    {
+        if(buffer.Size() - bufferUsed >= sizeof(T))
+        {
+            memcpy(buffer.Data() + bufferUsed, &data, sizeof(T));
+            bufferUsed += sizeof(T);
+        }
+        else
+            SerializeData(sizeof(T), &data);
+    }
+
+    void SerializeData(uint64 size, const void* data)
+    {
+        if(size > buffer.Size() - bufferUsed)
+            Flush();
+
+        if(size >= buffer.Size())
+        {
+            file.Write(size, data);
+            return;
+        }
+
+        memcpy(buffer.Data() + bufferUsed, data, size);
+        bufferUsed += size;
+    }
+
+    void Flush()
+    {
+        if(bufferUsed == 0)
+            return;
+
+        file.Write(bufferUsed, buffer.Data());
+        bufferUsed = 0;
+    }
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+};
+
+// Reads from a block of memory that's owned by someone else (for instance a MemoryMappedFile)
+class MemoryReadSerializer
+{
+
+private:
+
+    const uint8* data = nullptr;
+    uint64 size = 0;
+    uint64 offset = 0;
+
+public:
+
+    MemoryReadSerializer(const void* data_, uint64 size_) : data(reinterpret_cast<const uint8*>(data_)), size(size_)
+    {
+    }
+
+    explicit MemoryReadSerializer(const Array<uint8>& array) : data(array.Data()), size(array.Size())
+    {
+    }
+
+    explicit MemoryReadSerializer(const MemoryMappedFile& file) : data(file.Data()), size(file.Size())
+    {
+        Assert_(file.IsOpen());
+    }
+
+    template<typename T> void SerializeItem(T& item)
+    {
+        SerializeData(sizeof(T), &item);
+    }
+
+    void SerializeData(uint64 dataSize, void* dst)
+    {
+        if(offset + dataSize > size)
+            throw Exception(L"Attempted to serialize past the end of a memory block");
+
+        memcpy(dst, data + offset, dataSize);
+        offset += dataSize;
+    }
+
+    uint64 Offset() const { return offset; }
+
+    static bool IsReadSerializer() { return true; }
+    static bool IsWriteSerializer() { return false; }
+};
+
+// Writes to either a fixed-size block of memory that's owned by someone else, or to an Array that
+// gets grown as needed. Call Finish() to trim the Array down to the number of bytes that were written.
+class MemoryWriteSerializer
+{
+
+private:
+
+    uint8* data = nullptr;
+    uint64 size = 0;
+    uint64 offset = 0;
+    Array<uint8>* array = nullptr;
+
+    void Grow(uint64 minSize)
+    {
+        if(array == nullptr)
+            throw Exception(L"Attempted to serialize past the end of a memory block");
+
+        array->Resize(Max(minSize, Max(size * 2, uint64(4096))));
+        data = array->Data();
+        size = array->Size();
+    }
+
+public:
+
+    MemoryWriteSerializer(void* data_, uint64 size_) : data(reinterpret_cast<uint8*>(data_)), size(size_)
+    {
+    }
+
+    explicit MemoryWriteSerializer(Array<uint8>& array_) : data(array_.Data()), size(array_.Size()), array(&array_)
+    {
+    }
+
+    template<typename T> void SerializeItem(const T& item)
+    {
+        SerializeData(sizeof(T), &item);
+    }
+
+    void SerializeData(uint64 dataSize, const void* src)
+    {
+        if(offset + dataSize > size)
+            Grow(offset + dataSize);
+
+        memcpy(data + offset, src, dataSize);
+        offset += dataSize;
+    }
+
+    void Finish()
+    {
+        if(array == nullptr || array->Size() == offset)
+            return;
+
+        array->Resize(offset);
+        data = array->Data();
+        size = array->Size();
+    }
+
+    uint64 Offset() const { return offset; }
+
+    static bool IsReadSerializer() { return false; }
+    static bool IsWriteSerializer() { return true; }
+};
+
 class ComputeSizeSerializer
 {
 
@@ -304,15 +553,16 @@ void BulkSerializeItem(TSerializer& serializer, List<TValue>& list)
 template<typename T>
 void SerializeFromFile(const wchar* filePath, T& item)
 {
-    FileReadSerializer serializer(filePath);
+    BufferedFileReadSerializer serializer(filePath);
     SerializeItem(serializer, item);
 }
 
 template<typename T>
-void SerializeToFile(const wchar* filePath, const T& item)
+void SerializeToFile(const wchar* filePath, T& item)
 {
-    FileWriteSerializer serializer(filePath);
+    BufferedFileWriteSerializer serializer(filePath);
     SerializeItem(serializer, item);
+    serializer.Flush();
 }
 
 }
\ No newline at end of file
@@ -294,6 +294,7 @@ namespace SettingsCompiler
             lines.Add("    void BindCBufferGfx(ID3D12GraphicsCommandList* cmdList, uint32 rootParameter);");
             lines.Add("    void BindCBufferCompute(ID3D12GraphicsCommandList* cmdList, uint32 rootParameter);");
             lines.Add("    void GetShaderCompileOptions(CompileOptions& opts);");
+            lines.Add("    void GetShaderPermutationOptions(List<ShaderPermutationOption>& options);");
             lines.Add("    bool ShaderCompileOptionsChanged();");
 
             lines.Add("};");
@@ -408,6 +409,30 @@ namespace SettingsCompiler
 
             lines.Add("    }");
 
+            lines.Add("");
+            lines.Add("    void GetShaderPermutationOptions(List<ShaderPermutationOption>& options)");
+            lines.Add("    {");
+
+            foreach(Setting setting in shaderCompTimeConstants)
+            {
+                long minValue = 0;
+                long numValues = 2;
+                if(setting.Type == SettingType.Enum)
+                {
+                    numValues = ((EnumSetting)setting).NumEnumValues;
+                }
+                else if(setting.Type == SettingType.Int)
+                {
+                    IntSetting intSetting = (IntSetting)setting;
+                    minValue = intSetting.MinValue;
+                    numValues = Math.Min((long)intSetting.MaxValue - intSetting.MinValue + 1, (long)uint.MaxValue);
+                }
+
+                lines.Add(string.Format("        options.Add({{ \"{0}_\", {1}, {2}, int32({0}.Value()) }});", setting.Name, minValue, numValues));
+            }
+
+            lines.Add("    }");
+
             lines.Add("");
             lines.Add("    bool ShaderCompileOptionsChanged()");
             lines.Add("    {");
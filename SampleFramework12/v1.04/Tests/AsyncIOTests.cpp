@@ -0,0 +1,113 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\AsyncIO.h"
+#include "..\\FileIO.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+bool TestAsyncIO()
+{
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring filePath = std::wstring(tempDir) + L"SF12_AsyncIOTest.bin";
+
+    // Big enough that a whole-file read gets split
+    Array<uint8> fileData(AsyncIO::MaxReadSize + 12345);
+    Random random;
+    for(uint64 i = 0; i < fileData.Size(); ++i)
+        fileData[i] = uint8(random.RandomUint());
+
+    {
+        File file(filePath.c_str(), FileOpenMode::Write);
+        file.Write(fileData.Size(), fileData.Data());
+    }
+
+    const AsyncIOStats startStats = AsyncIO::Stats();
+    std::atomic<uint64> numCallbacks = { 0 };
+    auto countCallback = [&numCallbacks](AsyncIOStatus) { numCallbacks += 1; };
+
+    bool passed = true;
+
+    {
+        Array<uint8> readData;
+        AsyncRead read = AsyncIO::ReadFile(filePath.c_str(), readData, countCallback);
+        passed = passed && read.Wait() == AsyncIOStatus::Succeeded;
+        passed = passed && readData.Size() == fileData.Size() && memcmp(readData.Data(), fileData.Data(), fileData.Size()) == 0;
+    }
+
+    // Lots of small scatter-gather requests, so that more reads are queued up than can be in flight
+    const uint64 numRangeRequests = 64;
+    const uint64 rangesPerRequest = 4;
+    const uint64 rangeSize = 4096;
+    {
+        Array<uint8> rangeData(numRangeRequests * rangesPerRequest * rangeSize);
+        Array<AsyncReadRange> ranges(numRangeRequests * rangesPerRequest);
+        Array<AsyncRead> reads(numRangeRequests);
+        for(uint64 requestIdx = 0; requestIdx < numRangeRequests; ++requestIdx)
+        {
+            for(uint64 i = 0; i < rangesPerRequest; ++i)
+            {
+                const uint64 rangeIdx = requestIdx * rangesPerRequest + i;
+                ranges[rangeIdx].FileOffset = random.RandomUint() % (fileData.Size() - rangeSize);
+                ranges[rangeIdx].Size = rangeSize;
+                ranges[rangeIdx].Dst = &rangeData[rangeIdx * rangeSize];
+            }
+
+            reads[requestIdx] = AsyncIO::ReadRanges(filePath.c_str(), &ranges[requestIdx * rangesPerRequest], rangesPerRequest, countCallback);
+        }
+
+        for(AsyncRead& read : reads)
+            passed = passed && read.Wait() == AsyncIOStatus::Succeeded;
+
+        for(uint64 rangeIdx = 0; rangeIdx < ranges.Size(); ++rangeIdx)
+            passed = passed && memcmp(ranges[rangeIdx].Dst, &fileData[ranges[rangeIdx].FileOffset], rangeSize) == 0;
+    }
+
+    {
+        // Reading past the end of the file, and reading a file that doesn't exist, both fail
+        uint8 dst[16] = { };
+        AsyncReadRange range;
+        range.FileOffset = fileData.Size() - 8;
+        range.Size = sizeof(dst);
+        range.Dst = dst;
+        AsyncRead pastEnd = AsyncIO::ReadRanges(filePath.c_str(), &range, 1, countCallback);
+
+        const std::wstring missingPath = std::wstring(tempDir) + L"SF12_AsyncIOTest_Missing.bin";
+        Array<uint8> missingData;
+        AsyncRead missing = AsyncIO::ReadFile(missingPath.c_str(), missingData, countCallback);
+
+        passed = passed && pastEnd.Wait() == AsyncIOStatus::Failed && missing.Wait() == AsyncIOStatus::Failed;
+    }
+
+    const AsyncIOStats endStats = AsyncIO::Stats();
+    const uint64 numRequests = endStats.NumRequests - startStats.NumRequests;
+    passed = passed && numCallbacks == numRangeRequests + 3 && numRequests == numRangeRequests + 3;
+    passed = passed && endStats.NumFailed - startStats.NumFailed == 2;
+    passed = passed && endStats.MaxReadsInFlight <= AsyncIO::MaxReadsInFlight;
+
+    DeleteFile(filePath.c_str());
+
+    WriteLog("Async I/O: %llu requests, %llu reads, %.1f MB read, %llu reads in flight at most",
+             numRequests, endStats.NumReads - startStats.NumReads,
+             (endStats.BytesRead - startStats.BytesRead) / (1024.0 * 1024.0), endStats.MaxReadsInFlight);
+    WriteLog("Async I/O self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\GraphicsTypes.h"
+#include "..\\Jobs.h"
+#include "..\\Timer.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+// The allocator that DescriptorHeap used previously: a dead list protected by a lock, with a linear
+// search when reserving a specific index. Used as the baseline for the benchmark.
+struct LockedDeadListAllocator
+{
+    Array<uint32> DeadList;
+    uint32 NumAllocated = 0;
+    SRWLOCK Lock = SRWLOCK_INIT;
+
+    void Init(uint32 numIndices)
+    {
+        DeadList.Init(numIndices);
+        for(uint32 i = 0; i < numIndices; ++i)
+            DeadList[i] = i;
+    }
+
+    uint32 Allocate()
+    {
+        AcquireSRWLockExclusive(&Lock);
+        uint32 index = NumAllocated < DeadList.Size() ? DeadList[NumAllocated++] : uint32(-1);
+        ReleaseSRWLockExclusive(&Lock);
+        return index;
+    }
+
+    bool Reserve(uint32 index)
+    {
+        bool found = false;
+        AcquireSRWLockExclusive(&Lock);
+        for(uint64 i = NumAllocated; i < DeadList.Size(); ++i)
+        {
+            if(DeadList[i] == index)
+            {
+                Swap(DeadList[i], DeadList[NumAllocated++]);
+                found = true;
+                break;
+            }
+        }
+        ReleaseSRWLockExclusive(&Lock);
+        return found;
+    }
+
+    void Free(uint32 index)
+    {
+        AcquireSRWLockExclusive(&Lock);
+        DeadList[--NumAllocated] = index;
+        ReleaseSRWLockExclusive(&Lock);
+    }
+};
+
+bool BenchmarkDescriptorContention(uint32 numIndices, uint32 maxThreads)
+{
+    maxThreads = maxThreads > 0 ? Min(maxThreads, Jobs::NumThreads()) : Jobs::NumThreads();
+
+    const uint32 batchSize = 64;
+    const uint32 numIterations = 2000;
+
+    WriteLog("Persistent descriptor allocation contention (%u descriptors, %u allocs per thread)", numIndices, batchSize * numIterations);
+
+    // Every thread needs to be able to hold a full batch at once
+    maxThreads = Max(Min(maxThreads, numIndices / batchSize), 1u);
+    Assert_(batchSize <= numIndices);
+
+    bool passed = true;
+    volatile int64 numFailedAllocs = 0;
+    for(uint32 numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        // Every thread repeatedly grabs a batch of indices one at a time and then frees them, which is
+        // roughly what happens when streaming textures from multiple threads
+        LockedDeadListAllocator lockedAllocator;
+        lockedAllocator.Init(numIndices);
+
+        Timer timer;
+        Jobs::ParallelFor(numThreads, [&](uint64)
+        {
+            uint32 batch[batchSize];
+            for(uint32 iteration = 0; iteration < numIterations; ++iteration)
+            {
+                for(uint32 i = 0; i < batchSize; ++i)
+                    batch[i] = lockedAllocator.Allocate();
+                for(uint32 i = 0; i < batchSize; ++i)
+                    lockedAllocator.Free(batch[i]);
+            }
+        }, numThreads);
+        timer.Update();
+        const double lockedTime = timer.ElapsedMillisecondsD();
+
+        PersistentDescriptorAllocator allocator;
+        allocator.Init(numIndices);
+
+        timer = Timer();
+        Jobs::ParallelFor(numThreads, [&](uint64)
+        {
+            uint32 batch[batchSize];
+            for(uint32 iteration = 0; iteration < numIterations; ++iteration)
+            {
+                uint32 numAllocated = 0;
+                for(uint32 i = 0; i < batchSize; ++i)
+                {
+                    batch[numAllocated] = allocator.Allocate();
+                    if(batch[numAllocated] != uint32(-1))
+                        ++numAllocated;
+                }
+                if(numAllocated < batchSize)
+                    InterlockedIncrement64(&numFailedAllocs);
+                for(uint32 i = 0; i < numAllocated; ++i)
+                    allocator.Free(batch[i]);
+            }
+        }, numThreads);
+        timer.Update();
+        const double lockFreeTime = timer.ElapsedMillisecondsD();
+        passed = passed && allocator.NumAllocated == 0;
+
+        timer = Timer();
+        Jobs::ParallelFor(numThreads, [&](uint64)
+        {
+            uint32 batch[batchSize];
+            for(uint32 iteration = 0; iteration < numIterations; ++iteration)
+            {
+                const uint32 numAllocated = allocator.AllocateBulk(batch, batchSize);
+                if(numAllocated < batchSize)
+                    InterlockedIncrement64(&numFailedAllocs);
+                allocator.FreeBulk(batch, numAllocated);
+            }
+        }, numThreads);
+        timer.Update();
+        const double bulkTime = timer.ElapsedMillisecondsD();
+        passed = passed && allocator.NumAllocated == 0;
+        allocator.NumAllocated = 0;
+
+        WriteLog("    %u threads: locked %.3fms, lock-free %.3fms (%.2fx), bulk %.3fms (%.2fx)", numThreads,
+                 lockedTime, lockFreeTime, lockedTime / lockFreeTime, bulkTime, lockedTime / bulkTime);
+
+        allocator.Shutdown();
+    }
+
+    // Check that every index gets handed out exactly once when threads race to drain the allocator,
+    // and compare the cost of reserving specific indices
+    PersistentDescriptorAllocator allocator;
+    allocator.Init(numIndices);
+    Array<uint32> allocated(numIndices, uint32(-1));
+    Jobs::ParallelFor(numIndices, [&](uint64 i)
+    {
+        allocated[i] = allocator.Allocate();
+    }, maxThreads);
+
+    bool uniqueIndices = true;
+    Array<uint8> seen(numIndices, 0);
+    for(uint32 i = 0; i < numIndices && uniqueIndices; ++i)
+    {
+        uniqueIndices = allocated[i] < numIndices && seen[allocated[i]] == 0;
+        if(uniqueIndices)
+            seen[allocated[i]] = 1;
+    }
+    uniqueIndices = uniqueIndices && allocator.Allocate() == uint32(-1);
+    passed = passed && uniqueIndices && numFailedAllocs == 0;
+
+    // Start over with everything free. The count is cleared directly so that a failed check above
+    // doesn't also trip the leak assert in Shutdown().
+    allocator.NumAllocated = 0;
+    allocator.Init(numIndices);
+
+    // The locked version is O(N) per reservation, so only do a subset of the indices
+    const uint32 numReservations = Min(numIndices, 4096u);
+    LockedDeadListAllocator lockedAllocator;
+    lockedAllocator.Init(numIndices);
+
+    Timer timer;
+    for(uint32 i = 0; i < numReservations; ++i)
+        lockedAllocator.Reserve(numIndices - i - 1);
+    timer.Update();
+    const double lockedReserveTime = timer.ElapsedMillisecondsD();
+
+    bool allReserved = true;
+    timer = Timer();
+    for(uint32 i = 0; i < numReservations; ++i)
+        allReserved = allocator.Reserve(numIndices - i - 1) && allReserved;
+    timer.Update();
+    const double reserveTime = timer.ElapsedMillisecondsD();
+
+    WriteLog("    Reserving %u specific indices: locked %.3fms, lock-free %.3fms", numReservations, lockedReserveTime, reserveTime);
+
+    // Reserving an index that's already taken, or that's out of range, has to fail
+    const bool rejectedReservations = allocator.Reserve(numIndices - 1) == false && allocator.Reserve(numIndices) == false;
+    passed = passed && allReserved && rejectedReservations;
+
+    allocator.NumAllocated = 0;
+    allocator.Shutdown();
+
+    WriteLog("Persistent descriptor allocator self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
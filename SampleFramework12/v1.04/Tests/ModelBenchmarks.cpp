@@ -0,0 +1,602 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\Model.h"
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+#include "..\\Serialization.h"
+#include "..\\CompressedSerialization.h"
+#include "..\\FileIO.h"
+#include "..\\Timer.h"
+#include "..\\Jobs.h"
+
+using std::wstring;
+
+namespace SampleFramework12
+{
+
+// Friend of Model and Mesh, so that the benchmarks can build models directly and get at the import
+// and cache loading steps separately
+class ModelBenchmarks
+{
+
+public:
+
+    static bool CacheLoading(const wchar* mappedCachePath, uint64 numIterations);
+    static bool ImportScaling(const ModelLoadSettings& settings, uint32 maxThreads);
+    static bool Serializers(uint64 numIterations);
+
+protected:
+
+    static void InitSyntheticModel(Model& model);
+};
+
+// Lots of small meshes and materials, which is where the serializer spends most of its calls,
+// along with enough geometry to make the bulk copies count
+void ModelBenchmarks::InitSyntheticModel(Model& model)
+{
+    const uint64 NumMeshes = 4096;
+    const uint64 PartsPerMesh = 4;
+    const uint64 VerticesPerMesh = 64;
+    const uint64 IndicesPerMesh = 3 * 96;
+    const uint64 MeshletsPerMesh = 2;
+    const uint64 MeshletVertexCount = 32;
+    const uint64 MeshletTriangleCount = 48;
+    const uint64 NumMaterials = 1024;
+
+    model.indexType = IndexType::Index32Bit;
+    model.textureDirectory = L"..\\Content\\Models\\SerializerBenchmark\\";
+    model.aabbMin = Float3(-1000.0f);
+    model.aabbMax = Float3(1000.0f);
+
+    model.vertices.Init(NumMeshes * VerticesPerMesh);
+    for(uint64 i = 0; i < model.vertices.Size(); ++i)
+    {
+        MeshVertex& vertex = model.vertices[i];
+        vertex.Position = Float3(float(i), float(i % 7), float(i % 13));
+        vertex.Normal = Float3(0.0f, 1.0f, 0.0f);
+        vertex.UV = Float2(float(i % 64) / 64.0f, float(i % 32) / 32.0f);
+        vertex.Tangent = Float3(1.0f, 0.0f, 0.0f);
+        vertex.Bitangent = Float3(0.0f, 0.0f, 1.0f);
+    }
+
+    model.indices.Init(NumMeshes * IndicesPerMesh * sizeof(uint32));
+    uint32* indexData = reinterpret_cast<uint32*>(model.indices.Data());
+    for(uint64 i = 0; i < NumMeshes * IndicesPerMesh; ++i)
+        indexData[i] = uint32(i % VerticesPerMesh);
+
+    model.meshes.Init(NumMeshes);
+    for(uint64 meshIdx = 0; meshIdx < NumMeshes; ++meshIdx)
+    {
+        Mesh& mesh = model.meshes[meshIdx];
+        mesh.meshParts.Init(PartsPerMesh);
+        for(uint64 partIdx = 0; partIdx < PartsPerMesh; ++partIdx)
+        {
+            MeshPart& part = mesh.meshParts[partIdx];
+            part.VertexStart = 0;
+            part.VertexCount = uint32(VerticesPerMesh);
+            part.IndexStart = uint32(partIdx * (IndicesPerMesh / PartsPerMesh));
+            part.IndexCount = uint32(IndicesPerMesh / PartsPerMesh);
+            part.MaterialIdx = uint32((meshIdx + partIdx) % NumMaterials);
+        }
+
+        mesh.numVertices = uint32(VerticesPerMesh);
+        mesh.numIndices = uint32(IndicesPerMesh);
+        mesh.vtxOffset = uint32(meshIdx * VerticesPerMesh);
+        mesh.idxOffset = uint32(meshIdx * IndicesPerMesh * sizeof(uint32));
+        mesh.indexType = IndexType::Index32Bit;
+        mesh.aabbMin = Float3(float(meshIdx), 0.0f, 0.0f);
+        mesh.aabbMax = Float3(float(meshIdx) + 1.0f, 7.0f, 13.0f);
+        mesh.meshletOffset = uint32(meshIdx * MeshletsPerMesh);
+        mesh.numMeshlets = uint32(MeshletsPerMesh);
+
+        for(uint64 i = 0; i < MeshletsPerMesh; ++i)
+        {
+            Meshlet& meshlet = model.meshlets.Add();
+            meshlet.VertexOffset = uint32(model.meshletVertices.Count());
+            meshlet.TriangleOffset = uint32(model.meshletTriangles.Count());
+            meshlet.VertexCount = uint16(MeshletVertexCount);
+            meshlet.TriangleCount = uint16(MeshletTriangleCount);
+            meshlet.MeshIndex = uint16(meshIdx);
+            meshlet.MaterialIndex = uint16(meshIdx % NumMaterials);
+            meshlet.MeshVertexOffset = mesh.vtxOffset;
+
+            for(uint64 v = 0; v < MeshletVertexCount; ++v)
+                model.meshletVertices.Add(uint32(i * MeshletVertexCount + v));
+            for(uint64 t = 0; t < MeshletTriangleCount; ++t)
+                model.meshletTriangles.Add(MeshletTriangle::Pack(uint32(t % 30), uint32(t % 30 + 1), uint32(t % 30 + 2)));
+
+            MeshletBounds& bounds = model.meshletBounds.Add();
+            bounds.Center = Float3(float(meshIdx), float(i), 0.0f);
+            bounds.Radius = 8.0f;
+        }
+    }
+
+    model.meshMaterials.Init(NumMaterials);
+    for(uint64 matIdx = 0; matIdx < NumMaterials; ++matIdx)
+    {
+        MeshMaterial& material = model.meshMaterials[matIdx];
+        for(uint64 texType = 0; texType < uint64(MaterialTextures::Count); ++texType)
+        {
+            material.TextureNames[texType] = MakeString(L"Material%04llu_%llu.dds", matIdx, texType);
+            material.TextureIndices[texType] = uint32(matIdx * uint64(MaterialTextures::Count) + texType);
+        }
+        material.Opaque = matIdx % 4 != 0;
+        material.OpacityInAlphaChannel = matIdx % 8 == 0;
+    }
+
+    model.spotLights.Init(64);
+    for(uint64 i = 0; i < model.spotLights.Size(); ++i)
+    {
+        ModelSpotLight& light = model.spotLights[i];
+        light.Position = Float3(float(i), 10.0f, 0.0f);
+        light.Intensity = Float3(100.0f);
+        light.Direction = Float3(0.0f, -1.0f, 0.0f);
+        light.Orientation = Quaternion();
+        light.AngularAttenuation = Float2(0.5f, 0.75f);
+    }
+
+    model.pointLights.Init(256);
+    for(uint64 i = 0; i < model.pointLights.Size(); ++i)
+    {
+        model.pointLights[i].Position = Float3(0.0f, float(i), 10.0f);
+        model.pointLights[i].Intensity = Float3(50.0f);
+    }
+}
+
+bool ModelBenchmarks::CacheLoading(const wchar* mappedCachePath, uint64 numIterations)
+{
+    Assert_(numIterations > 0);
+
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+
+    // Without a cache to work with, write one out for the same synthetic model that the serializer benchmark uses
+    wstring syntheticCachePath;
+    if(mappedCachePath == nullptr)
+    {
+        syntheticCachePath = wstring(tempDir) + L"SF12_CacheLoadingBenchmark.modelcache";
+
+        Model source;
+        InitSyntheticModel(source);
+        source.geometry = source.OwnedGeometry();
+        source.WriteMappedCache(syntheticCachePath.c_str());
+        source.Shutdown();
+
+        mappedCachePath = syntheticCachePath.c_str();
+    }
+
+    // Make a serializer-based copy of the cache to compare against
+    const wstring serializedPath = GetFilePathWithoutExtension(mappedCachePath) + L".serializedcache";
+    {
+        Model model;
+        if(model.LoadMappedCacheData(mappedCachePath) == false)
+            throw Exception(MakeString(L"Model cache with path '%ls' is invalid or out of date", mappedCachePath));
+        model.CopyMappedGeometry();
+
+        BufferedFileWriteSerializer serializer(serializedPath.c_str());
+        model.Serialize(serializer);
+        serializer.Flush();
+        model.Shutdown();
+    }
+
+    // Both paths end up copying the geometry into an upload buffer, so do the same here. This
+    // also makes sure that the pages of the mapped file are actually touched.
+    Array<uint8> stagingData;
+    uint64 stagedSize = 0;
+    auto stageGeometry = [&](const ModelGeometry& geo)
+    {
+        const uint64 totalSize = geo.NumVertices * sizeof(MeshVertex) + geo.IndexDataSize + geo.NumMeshlets * (sizeof(Meshlet) + sizeof(MeshletBounds)) +
+                                 geo.NumMeshletVertices * sizeof(uint32) + geo.NumMeshletTriangles * sizeof(MeshletTriangle);
+        if(stagingData.Size() < totalSize)
+            stagingData.Init(totalSize);
+        stagedSize = totalSize;
+
+        uint8* dst = stagingData.Data();
+        memcpy(dst, geo.Vertices, geo.NumVertices * sizeof(MeshVertex));
+        dst += geo.NumVertices * sizeof(MeshVertex);
+        memcpy(dst, geo.Indices, geo.IndexDataSize);
+        dst += geo.IndexDataSize;
+        memcpy(dst, geo.Meshlets, geo.NumMeshlets * sizeof(Meshlet));
+        dst += geo.NumMeshlets * sizeof(Meshlet);
+        memcpy(dst, geo.MeshletVertices, geo.NumMeshletVertices * sizeof(uint32));
+        dst += geo.NumMeshletVertices * sizeof(uint32);
+        memcpy(dst, geo.MeshletTriangles, geo.NumMeshletTriangles * sizeof(MeshletTriangle));
+        dst += geo.NumMeshletTriangles * sizeof(MeshletTriangle);
+        memcpy(dst, geo.MeshletBoundingSpheres, geo.NumMeshlets * sizeof(MeshletBounds));
+    };
+
+    // Both paths need to stage exactly the same geometry
+    bool identical = true;
+    Array<uint8> serializedStaging;
+
+    double serializedTime = 0.0;
+    double mappedTime = 0.0;
+    for(uint64 i = 0; i < numIterations; ++i)
+    {
+        {
+            // The baseline is the original unbuffered file serializer, not the buffered one
+            Timer timer;
+            Model model;
+            FileReadSerializer serializer(serializedPath.c_str());
+            model.Serialize(serializer);
+            stageGeometry(model.OwnedGeometry());
+            timer.Update();
+            serializedTime += timer.ElapsedMillisecondsD();
+            model.Shutdown();
+        }
+
+        if(i == 0)
+        {
+            serializedStaging.Init(stagedSize);
+            memcpy(serializedStaging.Data(), stagingData.Data(), stagedSize);
+        }
+
+        {
+            Timer timer;
+            Model model;
+            const bool loaded = model.LoadMappedCacheData(mappedCachePath);
+            if(loaded)
+                stageGeometry(model.geometry);
+            timer.Update();
+            mappedTime += timer.ElapsedMillisecondsD();
+            model.Shutdown();
+
+            identical = identical && loaded;
+        }
+
+        if(i == 0)
+            identical = identical && stagedSize == serializedStaging.Size() && memcmp(stagingData.Data(), serializedStaging.Data(), stagedSize) == 0;
+    }
+
+    // Damaged caches need to be rejected, rather than handing out geometry that doesn't match the meshes
+    Array<uint8> cacheData;
+    ReadFileAsByteArray(mappedCachePath, cacheData);
+    MappedCacheHeader header;
+    memcpy(&header, cacheData.Data(), sizeof(MappedCacheHeader));
+
+    const wstring damagedPath = serializedPath + L".damaged";
+    auto rejectsCache = [&](const Array<uint8>& damagedData)
+    {
+        WriteFileAsByteArray(damagedPath.c_str(), damagedData);
+
+        Model model;
+        const bool loaded = model.LoadMappedCacheData(damagedPath.c_str());
+        model.Shutdown();
+        return loaded == false;
+    };
+
+    auto rejectsHeader = [&](auto damageHeader)
+    {
+        MappedCacheHeader damagedHeader = header;
+        damageHeader(damagedHeader);
+
+        Array<uint8> damagedData = cacheData;
+        memcpy(damagedData.Data(), &damagedHeader, sizeof(MappedCacheHeader));
+        return rejectsCache(damagedData);
+    };
+
+    Array<uint8> truncatedData(cacheData.Size() / 2);
+    memcpy(truncatedData.Data(), cacheData.Data(), truncatedData.Size());
+    bool rejected = rejectsCache(truncatedData);
+
+    rejected = rejected && rejectsHeader([](MappedCacheHeader& damagedHeader)
+    {
+        damagedHeader.MetadataSize = sizeof(uint64);
+    });
+
+    rejected = rejected && rejectsHeader([](MappedCacheHeader& damagedHeader)
+    {
+        // Wraps around if the offset and size get added together
+        MappedCacheBlock& block = damagedHeader.Blocks[uint64(MappedCacheBlocks::Indices)];
+        block.Offset = UINT64_MAX - (MappedCacheBlockAlignment - 1);
+        block.Size = MappedCacheBlockAlignment;
+    });
+
+    if(header.Blocks[uint64(MappedCacheBlocks::Vertices)].Size > 0)
+    {
+        rejected = rejected && rejectsHeader([](MappedCacheHeader& damagedHeader)
+        {
+            damagedHeader.Blocks[uint64(MappedCacheBlocks::Vertices)].Size -= sizeof(MeshVertex);
+        });
+
+        rejected = rejected && rejectsHeader([](MappedCacheHeader& damagedHeader)
+        {
+            damagedHeader.Blocks[uint64(MappedCacheBlocks::Vertices)].Size -= 1;
+        });
+    }
+
+    if(header.Blocks[uint64(MappedCacheBlocks::MeshletBounds)].Size > 0)
+    {
+        rejected = rejected && rejectsHeader([](MappedCacheHeader& damagedHeader)
+        {
+            damagedHeader.Blocks[uint64(MappedCacheBlocks::MeshletBounds)].Size -= sizeof(MeshletBounds);
+        });
+    }
+
+    DeleteFile(damagedPath.c_str());
+    Win32Call(DeleteFile(serializedPath.c_str()));
+    if(syntheticCachePath.length() > 0)
+        DeleteFile(syntheticCachePath.c_str());
+
+    const bool passed = identical && rejected;
+
+    WriteLog(L"Model cache load times for '%ls' (%llu iterations)", mappedCachePath, numIterations);
+    WriteLog(L"    FileReadSerializer: %.3fms", serializedTime / numIterations);
+    WriteLog(L"    Mapped: %.3fms%ls", mappedTime / numIterations, identical ? L"" : L" OUTPUT MISMATCH");
+    WriteLog(L"Model cache loading benchmark %ls%ls", passed ? L"passed" : L"FAILED", rejected ? L"" : L" (a damaged cache was accepted)");
+
+    return passed;
+}
+
+// Writes out an OBJ file with lots of separate grid meshes, for benchmarking the import without needing any content
+static void WriteSyntheticOBJScene(const wchar* filePath, uint32 numMeshes, uint32 gridSize)
+{
+    std::string obj;
+    const uint32 vertsPerRow = gridSize + 1;
+    for(uint32 meshIdx = 0; meshIdx < numMeshes; ++meshIdx)
+    {
+        obj += MakeString("o Mesh%u\n", meshIdx);
+        for(uint32 y = 0; y < vertsPerRow; ++y)
+        {
+            for(uint32 x = 0; x < vertsPerRow; ++x)
+            {
+                const float u = float(x) / gridSize;
+                const float v = float(y) / gridSize;
+                obj += MakeString("v %f %f %f\nvt %f %f\nvn 0 1 0\n", float(meshIdx % 32) + u, 0.1f * (x % 3), float(meshIdx / 32) + v, u, v);
+            }
+        }
+
+        // OBJ indices are 1-based, and count up across the whole file
+        const uint32 baseIdx = meshIdx * vertsPerRow * vertsPerRow + 1;
+        for(uint32 y = 0; y < gridSize; ++y)
+        {
+            for(uint32 x = 0; x < gridSize; ++x)
+            {
+                const uint32 i0 = baseIdx + y * vertsPerRow + x;
+                const uint32 i1 = i0 + 1;
+                const uint32 i2 = i0 + vertsPerRow;
+                const uint32 i3 = i2 + 1;
+                obj += MakeString("f %u/%u/%u %u/%u/%u %u/%u/%u\n", i0, i0, i0, i2, i2, i2, i1, i1, i1);
+                obj += MakeString("f %u/%u/%u %u/%u/%u %u/%u/%u\n", i1, i1, i1, i2, i2, i2, i3, i3, i3);
+            }
+        }
+    }
+
+    WriteStringAsFile(filePath, obj);
+}
+
+bool ModelBenchmarks::ImportScaling(const ModelLoadSettings& loadSettings, uint32 maxThreads)
+{
+    maxThreads = maxThreads > 0 ? Min(maxThreads, Jobs::NumThreads()) : Jobs::NumThreads();
+
+    // Without a file to work with, generate a scene with enough separate meshes to spread across the threads
+    ModelLoadSettings settings = loadSettings;
+    wstring syntheticScenePath;
+    if(settings.FilePath == nullptr)
+    {
+        wchar tempDir[MAX_PATH] = { };
+        GetTempPath(ArraySize_(tempDir), tempDir);
+        syntheticScenePath = wstring(tempDir) + L"SF12_ImportScalingBenchmark.obj";
+        WriteSyntheticOBJScene(syntheticScenePath.c_str(), 256, 16);
+
+        settings.FilePath = syntheticScenePath.c_str();
+        settings.MergeMeshes = false;
+        settings.GenerateMeshlets = true;
+    }
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(WStringToAnsi(settings.FilePath), AssimpPostProcessFlags(settings));
+    if(syntheticScenePath.length() > 0)
+        DeleteFile(syntheticScenePath.c_str());
+    if(scene == nullptr || scene->mNumMeshes == 0)
+        throw Exception(L"Failed to load scene " + std::wstring(settings.FilePath) +
+                        L": " + AnsiToWString(importer.GetErrorString()));
+
+    // The serial path is the reference that every thread count has to match exactly
+    Model reference;
+    reference.ImportMeshes(*scene, settings, 1);
+    if(settings.GenerateMeshlets)
+        reference.GenerateMeshlets(1);
+
+    auto matches = [](const auto& a, const auto& b)
+    {
+        return a.Count() == b.Count() && (a.Count() == 0 || memcmp(a.Data(), b.Data(), a.Count() * sizeof(a[0])) == 0);
+    };
+
+    WriteLog(L"Mesh import scaling for '%ls' (%llu meshes)", settings.FilePath, reference.meshes.Size());
+
+    bool passed = true;
+    double singleThreadTime = 0.0;
+    for(uint32 numThreads = 1; numThreads <= maxThreads; ++numThreads)
+    {
+        Model model;
+        Timer timer;
+        model.ImportMeshes(*scene, settings, numThreads);
+        if(settings.GenerateMeshlets)
+            model.GenerateMeshlets(numThreads);
+        timer.Update();
+
+        const double time = timer.ElapsedMillisecondsD();
+        if(numThreads == 1)
+            singleThreadTime = time;
+
+        bool identical = model.vertices.MemorySize() == reference.vertices.MemorySize() &&
+                         memcmp(model.vertices.Data(), reference.vertices.Data(), model.vertices.MemorySize()) == 0 &&
+                         model.indices.Size() == reference.indices.Size() &&
+                         memcmp(model.indices.Data(), reference.indices.Data(), model.indices.Size()) == 0;
+        identical = identical && matches(model.meshlets, reference.meshlets) && matches(model.meshletVertices, reference.meshletVertices) &&
+                    matches(model.meshletTriangles, reference.meshletTriangles) && matches(model.meshletBounds, reference.meshletBounds);
+
+        WriteLog(L"    %u threads: %.3fms (%.2fx)%ls", numThreads, time, singleThreadTime / time, identical ? L"" : L" OUTPUT MISMATCH");
+        passed = passed && identical;
+
+        model.Shutdown();
+    }
+
+    reference.Shutdown();
+
+    WriteLog(L"Mesh import scaling benchmark %ls", passed ? L"passed" : L"FAILED");
+
+    return passed;
+}
+
+bool ModelBenchmarks::Serializers(uint64 numIterations)
+{
+    Assert_(numIterations > 0);
+
+    Model source;
+    InitSyntheticModel(source);
+
+    // Everything gets checked against the bytes of the source model, so that a backend that drops or
+    // reorders anything shows up as a mismatch
+    Array<uint8> reference;
+    {
+        MemoryWriteSerializer serializer(reference);
+        source.Serialize(serializer);
+        serializer.Finish();
+    }
+
+    Array<uint8> checkData;
+    auto matchesSource = [&](Model& model)
+    {
+        MemoryWriteSerializer serializer(checkData);
+        model.Serialize(serializer);
+        return serializer.Offset() == reference.Size() && memcmp(checkData.Data(), reference.Data(), reference.Size()) == 0;
+    };
+
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const wstring filePath = wstring(tempDir) + L"SF12_SerializerBenchmark.bin";
+
+    WriteLog(L"Serializer round-trip times for a %.2f MB model (%llu meshes, %llu materials, %llu iterations)",
+             reference.Size() / (1024.0 * 1024.0), source.meshes.Size(), source.meshMaterials.Size(), numIterations);
+
+    bool passed = true;
+    auto runBackend = [&](const wchar* name, auto writeModel, auto readModel)
+    {
+        double writeTime = 0.0;
+        double readTime = 0.0;
+        bool identical = true;
+        for(uint64 i = 0; i < numIterations; ++i)
+        {
+            Timer writeTimer;
+            writeModel();
+            writeTimer.Update();
+            writeTime += writeTimer.ElapsedMillisecondsD();
+
+            Model model;
+            Timer readTimer;
+            readModel(model);
+            readTimer.Update();
+            readTime += readTimer.ElapsedMillisecondsD();
+
+            identical = identical && matchesSource(model);
+            model.Shutdown();
+        }
+
+        WriteLog(L"    %ls: %.3fms write, %.3fms read%ls", name, writeTime / numIterations, readTime / numIterations,
+                 identical ? L"" : L" OUTPUT MISMATCH");
+        passed = passed && identical;
+    };
+
+    auto writeBuffered = [&]()
+    {
+        BufferedFileWriteSerializer serializer(filePath.c_str());
+        source.Serialize(serializer);
+        serializer.Flush();
+    };
+
+    runBackend(L"File",
+    [&]()
+    {
+        FileWriteSerializer serializer(filePath.c_str());
+        source.Serialize(serializer);
+    },
+    [&](Model& model)
+    {
+        FileReadSerializer serializer(filePath.c_str());
+        model.Serialize(serializer);
+    });
+
+    runBackend(L"Buffered file", writeBuffered,
+    [&](Model& model)
+    {
+        BufferedFileReadSerializer serializer(filePath.c_str());
+        model.Serialize(serializer);
+    });
+
+    runBackend(L"Mapped file", writeBuffered,
+    [&](Model& model)
+    {
+        MemoryMappedFile mapping(filePath.c_str());
+        MemoryReadSerializer serializer(mapping);
+        model.Serialize(serializer);
+    });
+
+    const uint64 SerializerVersion = 1;
+    CompressedFileStats compressedStats;
+    runBackend(L"Compressed file",
+    [&]()
+    {
+        CompressedWriteSerializer serializer(filePath.c_str(), SerializerVersion);
+        source.Serialize(serializer);
+        serializer.Close();
+        compressedStats = serializer.Stats();
+    },
+    [&](Model& model)
+    {
+        CompressedReadSerializer serializer(filePath.c_str(), SerializerVersion);
+        model.Serialize(serializer);
+    });
+
+    WriteLog(L"        %.2f MB -> %.2f MB in %llu chunks (%llu stored uncompressed)", compressedStats.UncompressedSize / (1024.0 * 1024.0),
+             compressedStats.StoredSize / (1024.0 * 1024.0), compressedStats.NumChunks, compressedStats.NumRawChunks);
+
+    Array<uint8> memoryData;
+    runBackend(L"Memory",
+    [&]()
+    {
+        MemoryWriteSerializer serializer(memoryData);
+        source.Serialize(serializer);
+        serializer.Finish();
+    },
+    [&](Model& model)
+    {
+        MemoryReadSerializer serializer(memoryData);
+        model.Serialize(serializer);
+    });
+
+    DeleteFile(filePath.c_str());
+    source.Shutdown();
+
+    WriteLog(L"Serializer benchmark %ls", passed ? L"passed" : L"FAILED");
+
+    return passed;
+}
+
+bool BenchmarkModelSerializers(uint64 numIterations)
+{
+    return ModelBenchmarks::Serializers(numIterations);
+}
+
+bool BenchmarkModelCacheLoading(const wchar* mappedCachePath, uint64 numIterations)
+{
+    return ModelBenchmarks::CacheLoading(mappedCachePath, numIterations);
+}
+
+bool BenchmarkModelImportScaling(const ModelLoadSettings& settings, uint32 maxThreads)
+{
+    return ModelBenchmarks::ImportScaling(settings, maxThreads);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\PSOManager.h"
+#include "..\\Jobs.h"
+#include "..\\Utility.h"
+
+#include <atomic>
+
+namespace SampleFramework12
+{
+
+// Hands out made-up pointers, and optionally holds creation up until the test lets it through
+class FakePSODevice : public PSODevice
+{
+
+public:
+
+    static const uint64 BlobSize = 48;
+    static const uint8 BlobValue = 0xAB;
+
+    std::atomic<uint64> NumCreated = 0;
+    std::atomic<uint64> NumCreatedFromBlob = 0;
+    std::atomic<uint64> NumReleased = 0;
+    std::atomic<bool> Blocked = false;
+    std::atomic<bool> FailNext = false;
+    Hash ValidationHash;
+
+    virtual ID3D12PipelineState* CreateGraphicsPSO(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) override
+    {
+        return Create(desc.CachedPSO);
+    }
+
+    virtual ID3D12PipelineState* CreateComputePSO(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc) override
+    {
+        return Create(desc.CachedPSO);
+    }
+
+    virtual void ReleasePSO(ID3D12PipelineState* pso) override
+    {
+        NumReleased += 1;
+    }
+
+    virtual bool GetCachedBlob(ID3D12PipelineState* pso, Array<uint8>& blob) override
+    {
+        blob.Init(BlobSize, BlobValue);
+        return true;
+    }
+
+    virtual Hash CacheValidationHash() override
+    {
+        return ValidationHash;
+    }
+
+protected:
+
+    ID3D12PipelineState* Create(const D3D12_CACHED_PIPELINE_STATE& cachedPSO)
+    {
+        while(Blocked)
+            Sleep(1);
+
+        if(FailNext.exchange(false))
+            return nullptr;
+
+        if(cachedPSO.pCachedBlob != nullptr)
+        {
+            // Blobs that didn't come from GetCachedBlob() get turned down, like a real driver would
+            const uint8* blobData = reinterpret_cast<const uint8*>(cachedPSO.pCachedBlob);
+            for(uint64 i = 0; i < cachedPSO.CachedBlobSizeInBytes; ++i)
+            {
+                if(blobData[i] != BlobValue)
+                    return nullptr;
+            }
+
+            if(cachedPSO.CachedBlobSizeInBytes != BlobSize)
+                return nullptr;
+
+            NumCreatedFromBlob += 1;
+        }
+
+        const uint64 idx = ++NumCreated;
+        return reinterpret_cast<ID3D12PipelineState*>(uintptr_t(idx * 16));
+    }
+};
+
+bool TestPSOManager()
+{
+    bool passed = true;
+
+    FakePSODevice fakeDevice;
+    PSOManager manager;
+    manager.Initialize(&fakeDevice, L"");
+
+    // Fill the descriptions with garbage first, padding included, to make sure that only the
+    // fields make it into the hash
+    GraphicsPSODesc baseDesc;
+    memset(&baseDesc.Desc, 0xCD, sizeof(baseDesc.Desc));
+    baseDesc.Desc.pRootSignature = nullptr;
+    baseDesc.Desc.StreamOutput = { };
+    baseDesc.Desc.InputLayout = { };
+    baseDesc.Desc.CachedPSO = { };
+    baseDesc.Desc.BlendState = { };
+    baseDesc.Desc.RasterizerState = { };
+    baseDesc.Desc.DepthStencilState = { };
+    baseDesc.Desc.DepthStencilState.DepthEnable = true;
+    baseDesc.Desc.SampleMask = UINT_MAX;
+    baseDesc.Desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    baseDesc.Desc.NumRenderTargets = 1;
+    baseDesc.Desc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    baseDesc.Desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+    baseDesc.Desc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+    baseDesc.Desc.SampleDesc = { 1, 0 };
+    baseDesc.Desc.NodeMask = 0;
+    baseDesc.Desc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+
+    GraphicsPSODesc sameDesc = baseDesc;
+    memset(sameDesc.Desc.RTVFormats + 1, 0x3F, sizeof(sameDesc.Desc.RTVFormats) - sizeof(DXGI_FORMAT));
+    passed = passed && HashPSODesc(baseDesc) == HashPSODesc(sameDesc);
+
+    GraphicsPSODesc depthWriteDesc = baseDesc;
+    depthWriteDesc.Desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    passed = passed && HashPSODesc(baseDesc) != HashPSODesc(depthWriteDesc);
+
+    ComputePSODesc computeDesc;
+    passed = passed && HashPSODesc(computeDesc) != HashPSODesc(baseDesc);
+
+    {
+        // Identical requests share one PSO
+        ManagedPSO a;
+        ManagedPSO b;
+        a.Request(manager, baseDesc);
+        b.Request(manager, sameDesc);
+        a.Wait();
+        b.Wait();
+        passed = passed && a.Get() != nullptr && a.Get() == b.Get();
+        passed = passed && fakeDevice.NumCreated == 1;
+
+        // Asking for what's already there doesn't do anything
+        a.Request(manager, baseDesc);
+        passed = passed && a.Pending() == false && fakeDevice.NumCreated == 1;
+
+        // The old PSO stays in use until the new one is done
+        ID3D12PipelineState* oldPSO = a.Get();
+        fakeDevice.Blocked = Jobs::Initialized();
+        a.Request(manager, depthWriteDesc);
+        if(Jobs::Initialized())
+            passed = passed && a.Pending() && a.Get() == oldPSO;
+        fakeDevice.Blocked = false;
+        a.Wait();
+        passed = passed && a.Pending() == false && a.Get() != oldPSO && a.Get() != nullptr;
+        passed = passed && b.Get() == oldPSO && fakeDevice.NumReleased == 0;
+
+        // Dropping the last reference releases the PSO
+        b.Release();
+        passed = passed && fakeDevice.NumReleased == 1;
+
+        // A failed creation leaves the slot with what it had
+        ID3D12PipelineState* goodPSO = a.Get();
+        fakeDevice.FailNext = true;
+        a.Request(manager, computeDesc);
+        a.Wait();
+        passed = passed && a.Get() == goodPSO && manager.Stats().NumFailed == 1;
+
+        a.Release();
+    }
+
+    const PSOManagerStats stats = manager.Stats();
+    passed = passed && stats.NumCreated == fakeDevice.NumCreated && stats.NumDeduplicated == 2;
+
+    manager.Shutdown();
+    passed = passed && fakeDevice.NumReleased == fakeDevice.NumCreated;
+
+    // A cold and a warm run through a pipeline cache in the temp directory, followed by a run where
+    // the validation hash changed
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring cacheDir = std::wstring(tempDir) + L"SF12_PipelineCacheTest\\";
+    CreateDirectory(cacheDir.c_str(), nullptr);
+    DeleteFile((cacheDir + L"PSOs.archive").c_str());
+    DeleteFile((cacheDir + L"PSOs.log").c_str());
+
+    auto runCachePass = [&](Hash validationHash, PipelineCacheStats& cacheStats)
+    {
+        FakePSODevice passDevice;
+        passDevice.ValidationHash = validationHash;
+
+        PSOManager passManager;
+        passManager.Initialize(&passDevice, cacheDir.c_str());
+
+        ManagedPSO a;
+        ManagedPSO b;
+        a.Request(passManager, baseDesc);
+        b.Request(passManager, depthWriteDesc);
+        a.Wait();
+        b.Wait();
+        const bool created = a.Get() != nullptr && b.Get() != nullptr;
+        a.Release();
+        b.Release();
+
+        cacheStats = passManager.Stats().Cache;
+        passManager.Shutdown();
+
+        return created ? passDevice.NumCreatedFromBlob.load() : uint64(-1);
+    };
+
+    PipelineCacheStats coldStats;
+    PipelineCacheStats warmStats;
+    PipelineCacheStats invalidatedStats;
+    passed = passed && runCachePass(Hash(1, 1), coldStats) == 0 && coldStats.Misses == 2 && coldStats.Stored == 2;
+    passed = passed && runCachePass(Hash(1, 1), warmStats) == 2 && warmStats.Hits == 2 && warmStats.Stored == 0;
+    passed = passed && runCachePass(Hash(2, 2), invalidatedStats) == 0 && invalidatedStats.Hits == 0;
+
+    DeleteFile((cacheDir + L"PSOs.archive").c_str());
+    DeleteFile((cacheDir + L"PSOs.log").c_str());
+    RemoveDirectory(cacheDir.c_str());
+
+    WriteLog("PSO manager self-test %s (%llu requests, %llu deduplicated, %llu created, %llu warm cache hits)",
+             passed ? "passed" : "FAILED", stats.NumRequests, stats.NumDeduplicated, stats.NumCreated, warmStats.Hits);
+
+    return passed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\Profiler.h"
+#include "..\\Jobs.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+bool TestProfiler(const wchar* tracePath)
+{
+    static const char* OuterName = "Headless Outer";
+    static const char* InnerName = "Headless Inner";
+    static const char* LeafName = "Headless Leaf";
+    const uint64 numItems = 256;
+
+    Profiler profiler;
+
+    // The per-thread buffers only have one read position, so let the global profiler pick up
+    // anything that was recorded before the test started. That way the test profiler only sees
+    // its own blocks.
+    Profiler::GlobalProfiler.UpdateCPU();
+    profiler.CaptureFrames(1);
+
+    {
+        CPUProfileBlock outerBlock(OuterName);
+
+        Jobs::ParallelFor(numItems, [&](uint64 itemIdx)
+        {
+            CPUProfileBlock innerBlock(InnerName);
+
+            volatile float dummy = 0.0f;
+            {
+                CPUProfileBlock leafBlock(LeafName);
+                for(uint64 i = 0; i < 1000; ++i)
+                    dummy = dummy + std::sqrt(float(i + itemIdx));
+            }
+        });
+    }
+
+    profiler.UpdateCPU();
+
+    bool passed = true;
+    uint64 numOuter = 0;
+    uint64 numInner = 0;
+    uint64 numLeaf = 0;
+    uint64 threadMask = 0;
+
+    // Every event needs to be nested inside of the event that precedes it on the same thread at
+    // the next depth up
+    const List<ProfileEvent>& events = profiler.CapturedEvents();
+    for(uint64 i = 0; i < events.Count(); ++i)
+    {
+        const ProfileEvent& profileEvent = events[i];
+        numOuter += profileEvent.Name == OuterName ? 1 : 0;
+        numInner += profileEvent.Name == InnerName ? 1 : 0;
+        numLeaf += profileEvent.Name == LeafName ? 1 : 0;
+        threadMask |= 1ull << (profileEvent.ThreadIdx % 64);
+
+        if(profileEvent.EndTime < profileEvent.StartTime)
+            passed = false;
+
+        if(profileEvent.Depth == 0)
+            continue;
+
+        for(int64 parentIdx = int64(i) - 1; parentIdx >= 0; --parentIdx)
+        {
+            const ProfileEvent& parentEvent = events[parentIdx];
+            if(parentEvent.ThreadIdx != profileEvent.ThreadIdx || parentEvent.Depth != profileEvent.Depth - 1)
+                continue;
+
+            if(parentEvent.StartTime > profileEvent.StartTime || parentEvent.EndTime < profileEvent.EndTime)
+                passed = false;
+            if(profileEvent.Name == LeafName && parentEvent.Name != InnerName)
+                passed = false;
+            break;
+        }
+    }
+
+    passed = passed && numOuter == 1 && numInner == numItems && numLeaf == numItems;
+
+    // Every leaf is nested inside of an inner block, so the leaves can't add up to more time
+    const double innerTime = profiler.CPUProfileTiming(InnerName);
+    const double leafTime = profiler.CPUProfileTiming(LeafName);
+    if(innerTime <= 0.0 || leafTime <= 0.0 || leafTime > innerTime)
+        passed = false;
+
+    WriteLog("Profiler test: %llu events across %u threads, outer block took %.3fms, %s",
+             events.Count(), uint32(__popcnt64(threadMask)), profiler.CPUProfileTiming(OuterName),
+             passed ? "passed" : "FAILED");
+
+    if(tracePath != nullptr)
+        profiler.ExportChromeTrace(tracePath);
+
+    return passed;
+}
+
+}
\ No newline at end of file
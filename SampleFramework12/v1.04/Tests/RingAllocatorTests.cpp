@@ -0,0 +1,292 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\RingAllocator.h"
+#include "..\\Containers.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+struct RingTrace
+{
+    const char* Name = nullptr;
+    uint64 NumUploads = 0;
+    uint64 MinSize = 0;
+    uint64 MaxSize = 0;
+    bool Chunked = false;
+    uint64 UploadsPerTick = 0;
+    uint64 MinLatency = 0;      // ticks until the simulated GPU is done with an upload
+    uint64 MaxLatency = 0;
+    uint64 NumQuietUploads = 0; // small uploads at one per tick afterwards, so the ring can shrink back
+};
+
+struct RingTraceResult
+{
+    uint64 NumAllocations = 0;
+    uint64 NumStalls = 0;
+    uint64 StallTicks = 0;
+    uint64 NumGrows = 0;
+    uint64 NumShrinks = 0;
+    uint64 MaxLiveRings = 0;
+    uint64 MaxRingSize = 0;
+    uint64 FinalRingSize = 0;
+    uint64 NumWraps = 0;
+    uint64 PaddingBytes = 0;
+    bool Valid = true;
+};
+
+struct SimUpload
+{
+    RingAllocator* Ring = nullptr;
+    RingAllocation Allocation;
+    uint64 CompleteTick = 0;
+};
+
+// Mirrors the setup in DX12_Upload.cpp, scaled down
+static const uint64 SimAlignment = 512;
+static const uint64 SimInitialRingSize = 1024 * 1024;
+static const uint64 SimMaxRingSize = 8 * 1024 * 1024;
+static const uint64 SimChunkSize = 256 * 1024;
+static const uint64 SimMaxInFlight = 16;
+static const uint64 SimShrinkCheckTicks = 64;
+static const uint64 SimQuietMaxSize = 16 * 1024;
+
+static uint64 RandomRange(Random& random, uint64 minValue, uint64 maxValue)
+{
+    return minValue + (uint64(random.RandomUint()) % (maxValue - minValue + 1));
+}
+
+static RingTraceResult RunRingTrace(const RingTrace& trace, Random& random)
+{
+    RingTraceResult result;
+
+    // Old rings stick around until everything that was allocated from them has finished, and
+    // their stats get folded into the result once they're retired
+    List<RingAllocator*> rings;
+    auto retireRing = [&](uint64 ringIdx)
+    {
+        RingAllocator* ring = rings[ringIdx];
+        result.Valid = result.Valid && ring->Empty();
+        result.NumWraps += ring->Stats().NumWraps;
+        result.PaddingBytes += ring->Stats().PaddingBytes;
+        delete ring;
+        rings.Remove(ringIdx);
+    };
+
+    uint64 peakUsed = 0;
+    uint64 ticksSinceShrinkCheck = 0;
+    auto addRing = [&](uint64 size)
+    {
+        if(rings.Count() > 0 && rings[rings.Count() - 1]->Empty())
+            retireRing(rings.Count() - 1);
+
+        RingAllocator* ring = new RingAllocator();
+        ring->Init(size);
+        rings.Add(ring);
+        result.MaxLiveRings = Max(result.MaxLiveRings, rings.Count());
+
+        peakUsed = 0;
+        ticksSinceShrinkCheck = 0;
+    };
+
+    addRing(SimInitialRingSize);
+
+    List<SimUpload> inFlight;
+    uint64 tick = 0;
+
+    // The GPU finishes in order, so only the oldest upload can be retired
+    auto retire = [&](uint64 currTick)
+    {
+        while(inFlight.Count() > 0 && inFlight[0].CompleteTick <= currTick)
+        {
+            inFlight[0].Ring->Free(inFlight[0].Allocation);
+            inFlight.Remove(0);
+        }
+
+        for(uint64 i = 0; i + 1 < rings.Count(); )
+        {
+            if(rings[i]->Empty())
+                retireRing(i);
+            else
+                ++i;
+        }
+    };
+
+    // Mirrors the once-per-frame check in DX12_Upload.cpp
+    auto advanceTick = [&]()
+    {
+        tick += 1;
+        ticksSinceShrinkCheck += 1;
+        if(ticksSinceShrinkCheck < SimShrinkCheckTicks)
+            return;
+
+        const uint64 newSize = RingAllocator::ShrinkSize(rings[rings.Count() - 1]->Size(), peakUsed, SimInitialRingSize);
+        if(newSize > 0)
+        {
+            retire(tick);
+            addRing(newSize);
+            result.NumShrinks += 1;
+        }
+
+        peakUsed = 0;
+        ticksSinceShrinkCheck = 0;
+    };
+
+    const uint64 numUploads = trace.NumUploads + trace.NumQuietUploads;
+    for(uint64 uploadIdx = 0; uploadIdx < numUploads; ++uploadIdx)
+    {
+        const bool quiet = uploadIdx >= trace.NumUploads;
+        const uint64 minSize = quiet ? SimAlignment : trace.MinSize;
+        const uint64 maxSize = quiet ? SimQuietMaxSize : trace.MaxSize;
+        const uint64 uploadSize = AlignTo(RandomRange(random, minSize, maxSize), SimAlignment);
+        const uint64 chunkSize = trace.Chunked ? SimChunkSize : uploadSize;
+
+        for(uint64 chunkStart = 0; chunkStart < uploadSize; chunkStart += chunkSize)
+        {
+            const uint64 allocSize = Min(chunkSize, uploadSize - chunkStart);
+
+            RingAllocation allocation;
+            while(true)
+            {
+                retire(tick);
+
+                const bool haveSubmission = inFlight.Count() < SimMaxInFlight;
+                if(haveSubmission && rings[rings.Count() - 1]->Allocate(allocSize, allocation))
+                    break;
+
+                const uint64 newSize = RingAllocator::GrowSize(rings[rings.Count() - 1]->Size(), allocSize, SimMaxRingSize);
+                if(haveSubmission && newSize > 0)
+                {
+                    addRing(newSize);
+                    result.NumGrows += 1;
+                    result.MaxRingSize = Max(result.MaxRingSize, newSize);
+                    continue;
+                }
+
+                // Stall until the GPU finishes the oldest upload
+                if(inFlight.Count() == 0)
+                {
+                    result.Valid = false;
+                    break;
+                }
+
+                result.NumStalls += 1;
+                result.StallTicks += inFlight[0].CompleteTick - tick;
+                tick = inFlight[0].CompleteTick;
+            }
+
+            if(result.Valid == false)
+                break;
+
+            // Nothing that the GPU might still be reading can be handed out again
+            RingAllocator* ring = rings[rings.Count() - 1];
+            result.Valid = result.Valid && allocation.Offset + allocation.Size <= ring->Size();
+            for(const SimUpload& upload : inFlight)
+            {
+                if(upload.Ring != ring)
+                    continue;
+
+                const bool disjoint = allocation.Offset + allocation.Size <= upload.Allocation.Offset ||
+                                      upload.Allocation.Offset + upload.Allocation.Size <= allocation.Offset;
+                result.Valid = result.Valid && disjoint;
+            }
+
+            peakUsed = Max(peakUsed, ring->Used());
+
+            SimUpload& upload = inFlight.Add();
+            upload.Ring = ring;
+            upload.Allocation = allocation;
+            upload.CompleteTick = tick + RandomRange(random, trace.MinLatency, trace.MaxLatency);
+            result.NumAllocations += 1;
+        }
+
+        if(result.Valid == false)
+            break;
+
+        if(quiet || (uploadIdx + 1) % trace.UploadsPerTick == 0)
+            advanceTick();
+    }
+
+    // Once the GPU is done with everything, only the current ring should be left
+    retire(uint64(-1));
+    result.Valid = result.Valid && rings.Count() == 1;
+    result.FinalRingSize = rings[rings.Count() - 1]->Size();
+    while(rings.Count() > 0)
+        retireRing(rings.Count() - 1);
+
+    rings.Shutdown();
+    inFlight.Shutdown();
+
+    return result;
+}
+
+bool TestRingAllocator()
+{
+    bool passed = true;
+
+    {
+        // An allocation that doesn't fit at the end wraps around, and pays for the skipped space
+        RingAllocator ring;
+        ring.Init(1024);
+
+        RingAllocation a, b, c;
+        passed = passed && ring.Allocate(512, a) && a.Offset == 0;
+        passed = passed && ring.Allocate(256, b) && b.Offset == 512;
+        ring.Free(a);
+        passed = passed && ring.Allocate(512, c) && c.Offset == 0 && c.Padding == 256;
+        passed = passed && ring.Used() == 1024 && ring.Stats().NumWraps == 1 && ring.Stats().PaddingBytes == 256;
+
+        RingAllocation d;
+        passed = passed && ring.Allocate(1, d) == false;
+
+        ring.Free(b);
+        ring.Free(c);
+        passed = passed && ring.Empty();
+    }
+
+    passed = passed && GrowSize(1024, 512, 4096) == 2048 && GrowSize(4096, 512, 4096) == 0 && GrowSize(4096, 8192, 4096) == 8192;
+    passed = passed && ShrinkSize(4096, 1024, 1024) == 2048 && ShrinkSize(4096, 1025, 1024) == 0 && ShrinkSize(1024, 0, 1024) == 0;
+
+    const RingTrace traces[] =
+    {
+        { "Small uploads", 4096, 1024, 64 * 1024, false, 8, 1, 3 },
+        { "Large chunked uploads", 512, 256 * 1024, 4 * 1024 * 1024, true, 2, 2, 6 },
+        { "Oversized uploads", 64, 2 * 1024 * 1024, 12 * 1024 * 1024, false, 1, 1, 4 },
+        { "Slow GPU", 1024, 16 * 1024, 512 * 1024, false, 16, 8, 16 },
+        { "Burst then quiet", 64, 2 * 1024 * 1024, 6 * 1024 * 1024, false, 1, 1, 4, 1024 },
+    };
+
+    Random random;
+    for(const RingTrace& trace : traces)
+    {
+        const RingTraceResult result = RunRingTrace(trace, random);
+        passed = passed && result.Valid;
+
+        // A long enough quiet stretch has to bring the ring all the way back down
+        if(trace.NumQuietUploads > 0)
+            passed = passed && result.NumGrows > 0 && result.FinalRingSize == SimInitialRingSize;
+
+        WriteLog("Ring trace '%s': %llu allocations, %llu stalls (%llu ticks), %llu grows (%.1f MB max), %llu shrinks (%.1f MB final), "
+                 "%llu rings live at most, %llu wraps (%.1f KB padding)",
+                 trace.Name, result.NumAllocations, result.NumStalls, result.StallTicks, result.NumGrows,
+                 result.MaxRingSize / (1024.0 * 1024.0), result.NumShrinks, result.FinalRingSize / (1024.0 * 1024.0),
+                 result.MaxLiveRings, result.NumWraps, result.PaddingBytes / 1024.0);
+    }
+
+    WriteLog("Ring allocator self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\SG.h"
+#include "..\\Graphics\\Sampling.h"
+#include "..\\Containers.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+static const uint64 TestNumSGs = 9;
+static const uint64 TestNumProbes = 6;
+
+// Random directions over the sphere, with a smooth environment plus some noise for each probe
+static void InitSGTestSamples(uint64 numSamples, Random& random, Array<Float3>& sampleDirs, Array<Float3>& sampleValues)
+{
+    sampleDirs.Init(numSamples);
+    for(uint64 i = 0; i < numSamples; ++i)
+        sampleDirs[i] = SampleDirectionSphere(random.RandomFloat(), random.RandomFloat());
+
+    sampleValues.Init(numSamples * TestNumProbes);
+    for(uint64 probeIdx = 0; probeIdx < TestNumProbes; ++probeIdx)
+    {
+        const Float3 lightDir = SampleDirectionSphere(random.RandomFloat(), random.RandomFloat());
+        for(uint64 i = 0; i < numSamples; ++i)
+        {
+            const float light = std::pow(Saturate(Float3::Dot(sampleDirs[i], lightDir)), 4.0f) * 8.0f;
+            const Float3 noise = Float3(random.RandomFloat(), random.RandomFloat(), random.RandomFloat()) * 0.1f;
+            sampleValues[probeIdx * numSamples + i] = Float3(0.5f, 0.6f, 1.0f) + light + noise;
+        }
+    }
+}
+
+static void SolveBatch(const Array<Float3>& sampleDirs, const Array<Float3>& sampleValues, SGSolveMode solveMode,
+                       uint32 maxThreads, Array<SG>& outSGs)
+{
+    outSGs.Init(TestNumProbes * TestNumSGs);
+
+    SGBatchSolveParams params;
+    params.SampleDirs = sampleDirs.Data();
+    params.SampleValues = sampleValues.Data();
+    params.NumSamples = sampleDirs.Size();
+    params.NumProbes = TestNumProbes;
+    params.SolveMode = solveMode;
+    params.NumSGs = TestNumSGs;
+    params.OutSGs = outSGs.Data();
+    params.MaxThreads = maxThreads;
+    SolveSGsBatch(params);
+}
+
+static bool SGsMatch(const SG* a, const SG* b, uint64 numSGs)
+{
+    for(uint64 i = 0; i < numSGs; ++i)
+    {
+        if(memcmp(&a[i].Amplitude, &b[i].Amplitude, sizeof(Float3)) != 0 ||
+           memcmp(&a[i].Axis, &b[i].Axis, sizeof(Float3)) != 0 || a[i].Sharpness != b[i].Sharpness)
+            return false;
+    }
+
+    return true;
+}
+
+bool TestSGBatchSolve()
+{
+    bool passed = true;
+
+    // The sample counts aren't a multiple of the chunk size, and there are more layouts than the design
+    // matrix cache holds so that the first one has to get rebuilt at the end
+    const uint64 sampleCounts[] = { 10000, 4096, 777, 2500, 6000 };
+    const SGSolveMode solveModes[] = { SGSolveMode::FactoredLS, SGSolveMode::FactoredNNLS };
+    const uint32 threadCounts[] = { 1, 2, 3, 0 };
+
+    Random random;
+
+    Array<Float3> firstDirs;
+    Array<Float3> firstValues;
+    Array<SG> firstSGs;
+
+    for(uint64 countIdx = 0; countIdx < ArraySize_(sampleCounts); ++countIdx)
+    {
+        Array<Float3> sampleDirs;
+        Array<Float3> sampleValues;
+        InitSGTestSamples(sampleCounts[countIdx], random, sampleDirs, sampleValues);
+
+        for(SGSolveMode solveMode : solveModes)
+        {
+            // Every thread count has to give exactly the same results
+            Array<SG> batchSGs;
+            SolveBatch(sampleDirs, sampleValues, solveMode, threadCounts[0], batchSGs);
+            for(uint64 threadIdx = 1; threadIdx < ArraySize_(threadCounts); ++threadIdx)
+            {
+                Array<SG> otherSGs;
+                SolveBatch(sampleDirs, sampleValues, solveMode, threadCounts[threadIdx], otherSGs);
+                passed = passed && SGsMatch(batchSGs.Data(), otherSGs.Data(), batchSGs.Size());
+            }
+
+            // ...and has to match solving each probe on its own
+            for(uint64 probeIdx = 0; probeIdx < TestNumProbes; ++probeIdx)
+            {
+                SG probeSGs[TestNumSGs];
+                SGSolveParams params;
+                params.SampleDirs = sampleDirs.Data();
+                params.SampleValues = &sampleValues[probeIdx * sampleDirs.Size()];
+                params.NumSamples = sampleDirs.Size();
+                params.SolveMode = solveMode;
+                params.NumSGs = TestNumSGs;
+                params.OutSGs = probeSGs;
+                SolveSGs(params);
+
+                const SG* batchProbeSGs = &batchSGs[probeIdx * TestNumSGs];
+                passed = passed && SGsMatch(probeSGs, batchProbeSGs, TestNumSGs);
+
+                for(uint64 i = 0; i < TestNumSGs; ++i)
+                {
+                    const Float3 amplitude = batchProbeSGs[i].Amplitude;
+                    passed = passed && std::isfinite(amplitude.x) && std::isfinite(amplitude.y) && std::isfinite(amplitude.z);
+                    if(solveMode == SGSolveMode::FactoredNNLS)
+                        passed = passed && amplitude.x >= 0.0f && amplitude.y >= 0.0f && amplitude.z >= 0.0f;
+                }
+            }
+
+            if(countIdx == 0 && solveMode == SGSolveMode::FactoredNNLS)
+                firstSGs = batchSGs;
+        }
+
+        if(countIdx == 0)
+        {
+            firstDirs = sampleDirs;
+            firstValues = sampleValues;
+        }
+
+        WriteLog("SG batch solve: %llu samples x %llu probes", sampleCounts[countIdx], TestNumProbes);
+    }
+
+    {
+        // The first layout's design matrix has been evicted by now, and the rebuilt one has to give the same result
+        Array<SG> rebuiltSGs;
+        SolveBatch(firstDirs, firstValues, SGSolveMode::FactoredNNLS, 0, rebuiltSGs);
+        passed = passed && SGsMatch(rebuiltSGs.Data(), firstSGs.Data(), firstSGs.Size());
+    }
+
+    WriteLog("SG batch solve self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
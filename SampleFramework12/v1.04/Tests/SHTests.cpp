@@ -0,0 +1,175 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\SH.h"
+#include "..\\Graphics\\Textures.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+// Fills a cubemap with noise on top of a smooth gradient, so that every coefficient has something in it
+static void InitTestCubemap(uint32 resolution, Random& random, TextureData<Float4>& cubemap)
+{
+    cubemap.Init(resolution, resolution, 6);
+    for(uint32 face = 0; face < 6; ++face)
+    {
+        for(uint32 y = 0; y < resolution; ++y)
+        {
+            for(uint32 x = 0; x < resolution; ++x)
+            {
+                const Float3 dir = MapXYSToDirection(x, y, face, resolution, resolution);
+                const Float3 gradient = Float3(1.0f + dir.x, 1.0f + dir.y * dir.z, 2.0f - dir.z) * 4.0f;
+                const Float3 noise = Float3(random.RandomFloat(), random.RandomFloat(), random.RandomFloat());
+                cubemap.Texels[face * resolution * resolution + y * resolution + x] = Float4(gradient + noise, 1.0f);
+            }
+        }
+    }
+}
+
+// Straightforward per-texel projection, accumulated in double precision. H4 only uses the +Z hemisphere.
+static void ProjectCubemapReference(const TextureData<Float4>& cubemap, SH9Color& sh, H4Color& h4)
+{
+    const uint32 resolution = cubemap.Width;
+
+    double sh9Sums[9][3] = { };
+    double h4Sums[4][3] = { };
+    double sh9WeightSum = 0.0;
+    double h4WeightSum = 0.0;
+    for(uint32 face = 0; face < 6; ++face)
+    {
+        for(uint32 y = 0; y < resolution; ++y)
+        {
+            for(uint32 x = 0; x < resolution; ++x)
+            {
+                const Float3 sample = cubemap.Texels[face * resolution * resolution + y * resolution + x].To3D();
+
+                float u = (x + 0.5f) / resolution;
+                float v = (y + 0.5f) / resolution;
+                u = u * 2.0f - 1.0f;
+                v = v * 2.0f - 1.0f;
+                const float temp = 1.0f + u * u + v * v;
+                const double weight = 4.0f / (sqrt(temp) * temp);
+
+                const Float3 dir = MapXYSToDirection(x, y, face, resolution, resolution);
+                const SH9 sh9Basis = ProjectOntoSH9(dir);
+                for(uint64 i = 0; i < 9; ++i)
+                {
+                    sh9Sums[i][0] += sh9Basis[i] * weight * sample.x;
+                    sh9Sums[i][1] += sh9Basis[i] * weight * sample.y;
+                    sh9Sums[i][2] += sh9Basis[i] * weight * sample.z;
+                }
+                sh9WeightSum += weight;
+
+                if(dir.z >= 0.0f)
+                {
+                    const H4 h4Basis = ProjectOntoH4(dir);
+                    for(uint64 i = 0; i < 4; ++i)
+                    {
+                        h4Sums[i][0] += h4Basis[i] * weight * sample.x;
+                        h4Sums[i][1] += h4Basis[i] * weight * sample.y;
+                        h4Sums[i][2] += h4Basis[i] * weight * sample.z;
+                    }
+                    h4WeightSum += weight;
+                }
+            }
+        }
+    }
+
+    const double sh9Scale = (4.0 * 3.14159) / sh9WeightSum;
+    for(uint64 i = 0; i < 9; ++i)
+        sh[i] = Float3(float(sh9Sums[i][0] * sh9Scale), float(sh9Sums[i][1] * sh9Scale), float(sh9Sums[i][2] * sh9Scale));
+
+    const double h4Scale = (2.0 * 3.14159) / h4WeightSum;
+    for(uint64 i = 0; i < 4; ++i)
+        h4[i] = Float3(float(h4Sums[i][0] * h4Scale), float(h4Sums[i][1] * h4Scale), float(h4Sums[i][2] * h4Scale));
+}
+
+// Returns the largest difference between two sets of coefficients, relative to the largest reference coefficient
+template<uint64 N> static float MaxRelativeError(const SH<Float3, N>& result, const SH<Float3, N>& reference)
+{
+    float maxRef = 0.0f;
+    float maxDiff = 0.0f;
+    for(uint64 i = 0; i < N; ++i)
+    {
+        for(uint32 c = 0; c < 3; ++c)
+        {
+            maxRef = Max(maxRef, std::abs(reference[i][c]));
+            maxDiff = Max(maxDiff, std::abs(result[i][c] - reference[i][c]));
+        }
+    }
+
+    return maxDiff / Max(maxRef, 1e-6f);
+}
+
+bool TestCubemapProjection()
+{
+    bool passed = true;
+
+    // Odd sizes leave partial SIMD batches at the end of each row, and there are more sizes than the
+    // projection code caches tables for so that the first one has to get rebuilt at the end
+    const uint32 resolutions[] = { 5, 13, 16, 31, 64 };
+    const float tolerance = 1e-4f;
+
+    Random random;
+
+    TextureData<Float4> firstCubemap;
+    SH9Color firstSH;
+    H4Color firstH4;
+
+    for(uint64 resIdx = 0; resIdx < ArraySize_(resolutions); ++resIdx)
+    {
+        TextureData<Float4> cubemap;
+        InitTestCubemap(resolutions[resIdx], random, cubemap);
+
+        SH9Color sh;
+        H4Color h4;
+        ProjectCubemap(cubemap, &sh, &h4);
+
+        SH9Color refSH;
+        H4Color refH4;
+        ProjectCubemapReference(cubemap, refSH, refH4);
+
+        const float shError = MaxRelativeError(sh, refSH);
+        const float h4Error = MaxRelativeError(h4, refH4);
+        passed = passed && shError <= tolerance && h4Error <= tolerance;
+
+        // The single-basis entry points need to match the combined one exactly
+        const SH9Color shOnly = ProjectCubemapToSH(cubemap);
+        const H4Color h4Only = ProjectCubemapToH4(cubemap);
+        passed = passed && memcmp(&shOnly, &sh, sizeof(sh)) == 0 && memcmp(&h4Only, &h4, sizeof(h4)) == 0;
+
+        WriteLog("Cubemap projection %ux%u: SH9 error %.2e, H4 error %.2e", resolutions[resIdx], resolutions[resIdx], shError, h4Error);
+
+        if(resIdx == 0)
+        {
+            firstCubemap = cubemap;
+            firstSH = sh;
+            firstH4 = h4;
+        }
+    }
+
+    {
+        // The table for the first resolution has been evicted by now, and the rebuilt one has to give the same result
+        SH9Color sh;
+        H4Color h4;
+        ProjectCubemap(firstCubemap, &sh, &h4);
+        passed = passed && memcmp(&sh, &firstSH, sizeof(sh)) == 0 && memcmp(&h4, &firstH4, sizeof(h4)) == 0;
+    }
+
+    WriteLog("Cubemap projection self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\CompressedSerialization.h"
+#include "..\\Exceptions.h"
+#include "..\\FileIO.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+struct SerializationTestData
+{
+    std::wstring Name;
+    Array<Float3> Points;       // lots of small items
+    Array<uint32> Pattern;      // compresses well
+    Array<uint8> Noise;         // doesn't compress at all
+    uint64 Footer = 0;
+
+    template<typename TSerializer> void Serialize(TSerializer& serializer)
+    {
+        SerializeItem(serializer, Name);
+        SerializeItem(serializer, Points);
+        BulkSerializeItem(serializer, Pattern);
+        BulkSerializeItem(serializer, Noise);
+        SerializeItem(serializer, Footer);
+    }
+};
+
+static void InitTestData(SerializationTestData& source)
+{
+    source.Name = L"Serialization self-test";
+    source.Points.Init(4096);
+    for(uint64 i = 0; i < source.Points.Size(); ++i)
+        source.Points[i] = Float3(float(i), float(i % 3), 1.0f);
+
+    source.Pattern.Init(256 * 1024);
+    for(uint64 i = 0; i < source.Pattern.Size(); ++i)
+        source.Pattern[i] = uint32(i % 1024);
+
+    Random random;
+    source.Noise.Init(300 * 1024);
+    for(uint64 i = 0; i < source.Noise.Size(); ++i)
+        source.Noise[i] = uint8(random.RandomUint());
+
+    source.Footer = 0x0123456789ABCDEFULL;
+}
+
+static bool MatchesReference(SerializationTestData& result, const Array<uint8>& reference)
+{
+    Array<uint8> resultData;
+    MemoryWriteSerializer resultSerializer(resultData);
+    result.Serialize(resultSerializer);
+    return resultSerializer.Offset() == reference.Size() && memcmp(resultData.Data(), reference.Data(), reference.Size()) == 0;
+}
+
+bool TestCompressedSerialization()
+{
+    SerializationTestData source;
+    InitTestData(source);
+
+    Array<uint8> reference;
+    {
+        MemoryWriteSerializer serializer(reference);
+        source.Serialize(serializer);
+        serializer.Finish();
+    }
+
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring filePath = std::wstring(tempDir) + L"SF12_CompressedSerializationTest.bin";
+
+    const uint64 contentVersion = 3;
+    const uint64 chunkSize = 64 * 1024;
+
+    bool passed = true;
+    CompressedFileStats writeStats;
+    {
+        CompressedWriteSerializer serializer(filePath.c_str(), contentVersion, chunkSize);
+        source.Serialize(serializer);
+        serializer.Close();
+        writeStats = serializer.Stats();
+    }
+
+    // Every chunk needs to be independently decodable, so the noise has to have ended up in raw
+    // chunks of its own while the pattern got compressed
+    passed = passed && writeStats.UncompressedSize == reference.Size();
+    passed = passed && writeStats.NumChunks > 1 && writeStats.NumRawChunks >= (source.Noise.Size() / chunkSize);
+    passed = passed && writeStats.StoredSize < writeStats.UncompressedSize;
+
+    auto readsBack = [&]()
+    {
+        try
+        {
+            SerializationTestData result;
+            CompressedReadSerializer serializer(filePath.c_str(), contentVersion);
+            result.Serialize(serializer);
+            return MatchesReference(result, reference);
+        }
+        catch(Exception&)
+        {
+            return false;
+        }
+    };
+
+    const bool roundTrip = readsBack();
+    passed = passed && roundTrip;
+
+    bool rejectedVersion = false;
+    try
+    {
+        CompressedReadSerializer serializer(filePath.c_str(), contentVersion + 1);
+    }
+    catch(Exception&)
+    {
+        rejectedVersion = true;
+    }
+
+    Array<uint8> fileData;
+    ReadFileAsByteArray(filePath.c_str(), fileData);
+
+    // Flip a bit near the end of the file, which is stored chunk data
+    Array<uint8> corruptedData = fileData;
+    corruptedData[corruptedData.Size() - 16] ^= 0x10;
+    WriteFileAsByteArray(filePath.c_str(), corruptedData);
+    const bool rejectedCorrupted = readsBack() == false;
+
+    Array<uint8> truncatedData(fileData.Size() / 2);
+    memcpy(truncatedData.Data(), fileData.Data(), truncatedData.Size());
+    WriteFileAsByteArray(filePath.c_str(), truncatedData);
+    const bool rejectedTruncated = readsBack() == false;
+
+    DeleteFile(filePath.c_str());
+
+    // A serializer that goes away without being closed shouldn't leave anything behind
+    {
+        CompressedWriteSerializer serializer(filePath.c_str(), contentVersion, chunkSize);
+        source.Serialize(serializer);
+    }
+    const bool discardedUnclosed = FileExists(filePath.c_str()) == false && FileExists((filePath + L".tmp").c_str()) == false;
+
+    passed = passed && rejectedVersion && rejectedCorrupted && rejectedTruncated && discardedUnclosed;
+
+    WriteLog(L"Compressed serialization: %.1f KB -> %.1f KB in %llu chunks (%llu raw)", writeStats.UncompressedSize / 1024.0,
+             writeStats.StoredSize / 1024.0, writeStats.NumChunks, writeStats.NumRawChunks);
+    WriteLog(L"Compressed serialization self-test %ls", passed ? L"passed" : L"FAILED");
+
+    return passed;
+}
+
+bool TestFileSerialization()
+{
+    SerializationTestData source;
+    InitTestData(source);
+
+    Array<uint8> reference;
+    {
+        MemoryWriteSerializer serializer(reference);
+        source.Serialize(serializer);
+        serializer.Finish();
+    }
+
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring filePath = std::wstring(tempDir) + L"SF12_FileSerializationTest.bin";
+
+    // Bigger than the staging buffer, so that some of it gets written directly and the rest is
+    // still sitting in the buffer at the end
+    SerializeToFile(filePath.c_str(), source);
+    bool passed = GetFileSizeInBytes(filePath.c_str()) == reference.Size();
+
+    SerializationTestData result;
+    SerializeFromFile(filePath.c_str(), result);
+    passed = passed && MatchesReference(result, reference);
+
+    // Small enough to never leave the staging buffer
+    std::wstring name = source.Name;
+    SerializeToFile(filePath.c_str(), name);
+    std::wstring nameResult;
+    SerializeFromFile(filePath.c_str(), nameResult);
+    passed = passed && nameResult == name;
+
+    DeleteFile(filePath.c_str());
+
+    WriteLog(L"File serialization self-test %ls", passed ? L"passed" : L"FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\ShaderPrecompiler.h"
+#include "..\\Graphics\\ShaderCacheArchive.h"
+#include "..\\FileIO.h"
+#include "..\\Utility.h"
+
+#include <atomic>
+#include <set>
+
+namespace SampleFramework12
+{
+
+bool TestShaderPrecompiler()
+{
+    List<ShaderPermutationOption> options;
+    options.Add({ .Name = "ModeA_", .MinValue = 0, .NumValues = 3, .CurrentValue = 1 });
+    options.Add({ .Name = "Toggle_", .MinValue = 0, .NumValues = 2, .CurrentValue = 0 });
+    options.Add({ .Name = "Offset_", .MinValue = -1, .NumValues = 4, .CurrentValue = 2 });
+
+    List<ShaderPrecompileItem> items;
+    for(uint32 i = 0; i < 5; ++i)
+    {
+        ShaderPrecompileItem& item = items.Add();
+        item.FilePath = MakeString(L"Shader%u.hlsl", i);
+        item.FunctionName = "Main";
+        item.Type = i % 2 == 0 ? ShaderType::Pixel : ShaderType::Compute;
+        item.BaseCompileOpts.Add("ItemIdx_", i);
+    }
+
+    const uint64 numPermutations = NumShaderPermutations(options);
+    bool passed = numPermutations == 24;
+
+    // The ordering has to be a permutation that starts with the current values
+    List<uint64> order;
+    OrderShaderPermutations(options, order);
+    Array<bool> seen(numPermutations, false);
+    for(uint64 i = 0; i < order.Count(); ++i)
+    {
+        passed = passed && order[i] < numPermutations && seen[order[i]] == false;
+        if(order[i] < numPermutations)
+            seen[order[i]] = true;
+    }
+    passed = passed && order.Count() == numPermutations && order.Count() > 0 && order[0] == CurrentShaderPermutation(options);
+
+    // The stub "compiler" records the defines it was given, and fails one of the permutations on purpose
+    Array<std::atomic<uint32>> compileCounts(items.Count() * numPermutations);
+    for(uint64 i = 0; i < compileCounts.Size(); ++i)
+        compileCounts[i] = 0;
+    Array<std::string> compileDefines(items.Count() * numPermutations);
+
+    ShaderPrecompiler precompiler;
+    precompiler.Start(items, options, [&](const ShaderPermutation& permutation)
+    {
+        const uint64 idx = permutation.ItemIdx * numPermutations + permutation.PermutationIdx;
+        if(compileCounts[idx]++ == 0)
+            compileDefines[idx] = permutation.CompileOpts.DefinesString();
+
+        if(permutation.ItemIdx == 1 && permutation.PermutationIdx == 5)
+            return ShaderPermutationStatus::Failed;
+        return permutation.PermutationIdx % 2 == 0 ? ShaderPermutationStatus::CacheHit : ShaderPermutationStatus::Compiled;
+    });
+    precompiler.Wait();
+
+    std::set<std::string> uniqueDefines;
+    for(uint64 i = 0; i < compileCounts.Size(); ++i)
+    {
+        passed = passed && compileCounts[i] == 1;
+        uniqueDefines.insert(compileDefines[i]);
+    }
+    passed = passed && uniqueDefines.size() == compileCounts.Size();
+
+    // Spot check the mixed-radix decoding: 23 = 2 + 1 * 3 + 3 * 6, and Offset_ starts at -1
+    CompileOptions lastOpts;
+    lastOpts.Add("ItemIdx_", 0);
+    AddShaderPermutationDefines(options, 23, lastOpts);
+    passed = passed && compileDefines[23] == lastOpts.DefinesString();
+    passed = passed && lastOpts.DefinesString() == "ItemIdx_=0|ModeA_=2|Toggle_=1|Offset_=2";
+
+    const ShaderPrecompileStats stats = precompiler.Stats();
+    passed = passed && stats.NumFailed == 1 && stats.NumCancelled == 0;
+    passed = passed && stats.NumCacheHits + stats.NumCompiled + stats.NumFailed == items.Count() * numPermutations;
+
+    WriteLog("Shader precompiler self-test %s: %llu items x %llu permutations, %llu compiled, %llu cache hits, %llu failed",
+             passed ? "passed" : "FAILED", stats.NumItems, stats.NumPermutations, stats.NumCompiled, stats.NumCacheHits, stats.NumFailed);
+
+    options.Shutdown();
+    items.Shutdown();
+    order.Shutdown();
+
+    return passed;
+}
+
+bool TestShaderCacheArchive()
+{
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring archivePath = std::wstring(tempDir) + L"SF12_ShaderCacheArchiveTest.bin";
+    const std::wstring logPath = std::wstring(tempDir) + L"SF12_ShaderCacheArchiveTest.log";
+    DeleteFile(archivePath.c_str());
+    DeleteFile(logPath.c_str());
+
+    const uint64 numTestEntries = 37;
+    auto makeKey = [](uint64 idx) { return Hash(idx * 0x9E3779B97F4A7C15ULL, idx); };
+    auto makeData = [](uint64 idx, uint64 version, Array<uint8>& data)
+    {
+        data.Init(idx * 13 + 1);
+        for(uint64 i = 0; i < data.Size(); ++i)
+            data[i] = uint8(idx * 7 + i + version * 31);
+    };
+
+    auto check = [&](const ShaderCacheArchive& archive, uint64 idx, uint64 version)
+    {
+        Array<uint8> expected;
+        makeData(idx, version, expected);
+
+        const uint8* data = nullptr;
+        uint64 size = 0;
+        return archive.Find(makeKey(idx), data, size) && size == expected.Size() && memcmp(data, expected.Data(), size) == 0;
+    };
+
+    bool passed = true;
+    Array<uint8> data;
+
+    {
+        // Everything goes into the log at first
+        ShaderCacheArchive archive;
+        archive.Open(archivePath.c_str(), logPath.c_str());
+        for(uint64 i = 0; i < numTestEntries; ++i)
+        {
+            makeData(i, 0, data);
+            archive.Add(makeKey(i), data.Data(), data.Size());
+        }
+
+        for(uint64 i = 0; i < numTestEntries; ++i)
+            passed = passed && check(archive, i, 0);
+        passed = passed && archive.Contains(makeKey(numTestEntries)) == false;
+    }
+
+    {
+        // Re-load the log, and then pack it
+        ShaderCacheArchive archive;
+        archive.Open(archivePath.c_str(), logPath.c_str());
+        passed = passed && archive.NumLogEntries() == numTestEntries && archive.NumArchiveEntries() == 0;
+        passed = passed && archive.Compact();
+        passed = passed && archive.NumLogEntries() == 0 && archive.NumArchiveEntries() == numTestEntries;
+        passed = passed && FileExists(logPath.c_str()) == false;
+
+        for(uint64 i = 0; i < numTestEntries; ++i)
+            passed = passed && check(archive, i, 0);
+
+        // Replace one entry and add a new one through the log
+        makeData(3, 1, data);
+        archive.Add(makeKey(3), data.Data(), data.Size());
+        makeData(numTestEntries, 0, data);
+        archive.Add(makeKey(numTestEntries), data.Data(), data.Size());
+
+        // Drop one entry from the archive, and drop and then replace another
+        archive.Remove(makeKey(5));
+        passed = passed && archive.Contains(makeKey(5)) == false;
+        archive.Remove(makeKey(7));
+        passed = passed && archive.Contains(makeKey(7)) == false;
+        makeData(7, 2, data);
+        archive.Add(makeKey(7), data.Data(), data.Size());
+        passed = passed && check(archive, 3, 1) && check(archive, 7, 2);
+    }
+
+    {
+        // Simulate a crash in the middle of writing a record, by chopping off the end of the last one
+        ShaderCacheArchive archive;
+        archive.Open(archivePath.c_str(), logPath.c_str());
+        makeData(numTestEntries + 1, 0, data);
+        archive.Add(makeKey(numTestEntries + 1), data.Data(), data.Size());
+        archive.Close();
+
+        Array<uint8> logData;
+        ReadFileAsByteArray(logPath.c_str(), logData);
+        Array<uint8> truncatedLog(logData.Size() - data.Size() / 2);
+        memcpy(truncatedLog.Data(), logData.Data(), truncatedLog.Size());
+        WriteFileAsByteArray(logPath.c_str(), truncatedLog);
+    }
+
+    {
+        // The bad record should get dropped, and the rest compacted into the archive
+        ShaderCacheArchive archive;
+        archive.Open(archivePath.c_str(), logPath.c_str());
+        passed = passed && archive.NumLogEntries() == 0 && archive.NumArchiveEntries() == numTestEntries;
+        passed = passed && check(archive, 3, 1) && check(archive, 7, 2) && check(archive, numTestEntries, 0);
+        passed = passed && archive.Contains(makeKey(5)) == false;
+        passed = passed && archive.Contains(makeKey(numTestEntries + 1)) == false;
+        for(uint64 i = 0; i < numTestEntries; ++i)
+            passed = passed && (i == 3 || i == 5 || i == 7 || check(archive, i, 0));
+    }
+
+    DeleteFile(archivePath.c_str());
+    DeleteFile(logPath.c_str());
+
+    WriteLog("Shader cache archive self-test %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file
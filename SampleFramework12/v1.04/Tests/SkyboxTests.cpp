@@ -0,0 +1,82 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\Skybox.h"
+#include "..\\Graphics\\Sampling.h"
+#include "..\\SF12_Math.h"
+#include "..\\Utility.h"
+
+namespace SampleFramework12
+{
+
+bool TestSkyLUT()
+{
+    #if EnableSkyModel_
+        bool passed = true;
+
+        // Overall error, as a fraction of the total radiance over the sphere
+        const float tolerance = 0.01f;
+        const uint64 numSamples = 64 * 1024;
+
+        const Float3 sunDirections[] =
+        {
+            Float3::Normalize(Float3(0.3f, 0.9f, 0.2f)),
+            Float3::Normalize(Float3(-0.5f, 0.25f, 0.8f)),
+            Float3::Normalize(Float3(0.9f, 0.02f, -0.1f)),
+        };
+
+        for(const Float3& sunDirection : sunDirections)
+        {
+            SkyCache direct;
+            SkyCache lut;
+            direct.Init(sunDirection, 0.27f, Float3(0.5f), 2.0f, false, false);
+            lut.Init(sunDirection, 0.27f, Float3(0.5f), 2.0f, false, true);
+            passed = passed && direct.LUT.Size() == 0 && lut.LUT.Size() == SkyCache::LUTThetaRes * SkyCache::LUTGammaRes;
+
+            double totalRadiance = 0.0;
+            double totalError = 0.0;
+            float maxRelativeError = 0.0f;
+            for(uint64 i = 0; i < numSamples; ++i)
+            {
+                const Float2 u = Hammersley2D(i, numSamples);
+                const Float3 dir = SampleDirectionSphere(u.x, u.y);
+                const Float3 expected = direct.Sample(dir);
+                const Float3 actual = lut.Sample(dir);
+
+                const float radiance = expected.x + expected.y + expected.z;
+                const float error = std::abs(actual.x - expected.x) + std::abs(actual.y - expected.y) + std::abs(actual.z - expected.z);
+                totalRadiance += radiance;
+                totalError += error;
+                if(radiance > 0.0f)
+                    maxRelativeError = Max(maxRelativeError, error / radiance);
+            }
+
+            const float relativeError = float(totalError / Max(totalRadiance, 1e-6));
+            passed = passed && relativeError <= tolerance;
+
+            WriteLog("Sky LUT with sun at (%.2f, %.2f, %.2f): %.3f%% overall error, %.2f%% max error",
+                     sunDirection.x, sunDirection.y, sunDirection.z, relativeError * 100.0f, maxRelativeError * 100.0f);
+
+            direct.Shutdown();
+            lut.Shutdown();
+        }
+
+        WriteLog("Sky LUT self-test %s", passed ? "passed" : "FAILED");
+
+        return passed;
+    #else
+        WriteLog("Sky LUT self-test skipped, the sky model isn't enabled");
+        return true;
+    #endif
+}
+
+}
\ No newline at end of file
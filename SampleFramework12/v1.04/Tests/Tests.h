@@ -0,0 +1,91 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#pragma once
+
+#include "..\\PCH.h"
+
+namespace SampleFramework12
+{
+
+struct ModelLoadSettings;
+
+// Self-tests and benchmarks for the framework. None of these need a window or a D3D12 device, but
+// they expect the job system and the async I/O service to be running. Each one logs its results
+// and returns false on failure.
+
+// Reads a generated file through whole-file, scatter-gather, and failing requests, with more
+// requests queued than can be in flight at once
+bool TestAsyncIO();
+
+// Round-trips a mix of small items, compressible and incompressible bulk data, and checks that
+// corrupted, truncated, and out-of-date files get rejected and that unclosed writes are discarded
+bool TestCompressedSerialization();
+
+// Round-trips data through SerializeToFile() and SerializeFromFile(), both bigger and smaller than
+// the staging buffer
+bool TestFileSerialization();
+
+// Projects generated cubemaps of several sizes onto SH9 and H4 with the SIMD tables, and checks the
+// results against a straightforward per-texel projection
+bool TestCubemapProjection();
+
+// Solves batches of probes with the factored SG solvers using different numbers of threads, and checks
+// that the results are identical to each other and to solving each probe on its own
+bool TestSGBatchSolve();
+
+// Compares sampling the sky through the baked (theta, gamma) LUT against evaluating the sky model
+// directly, for a few sun directions. Passes without doing anything if the sky model isn't enabled.
+bool TestSkyLUT();
+
+// Runs the enumeration and scheduling with a stub compiler, and checks that every permutation
+// was handed to the compiler exactly once
+bool TestShaderPrecompiler();
+
+// Round-trips entries through the log and a compacted archive in the temp directory
+bool TestShaderCacheArchive();
+
+// Runs the queueing, dedupe, and caching logic against a fake device
+bool TestPSOManager();
+
+// Feeds synthetic upload traces through rings that grow, get retired once a simulated GPU has
+// drained them, and shrink back down when things are quiet. Checks that live allocations never
+// overlap and that everything gets freed.
+bool TestRingAllocator();
+
+// Measures allocate/free throughput with many threads hammering the persistent descriptor allocator,
+// and compares it against a locked dead list. Fails if an index gets handed out twice, an allocation
+// fails while there should be room, or a reservation doesn't behave.
+bool BenchmarkDescriptorContention(uint32 numIndices = 64 * 1024, uint32 maxThreads = 0);
+
+// Records nested blocks from the job system, and validates the results
+bool TestProfiler(const wchar* tracePath = nullptr);
+
+// Round-trips a large synthetic model through each of the serializer backends, and checks that
+// all of them read back exactly what was written
+bool BenchmarkModelSerializers(uint64 numIterations);
+
+// Compares CPU load times for the serializer-based cache vs. the memory-mapped cache, and checks
+// that both load the same geometry and that damaged mapped caches get rejected. A mapped cache is
+// written for a synthetic model if mappedCachePath is null.
+bool BenchmarkModelCacheLoading(const wchar* mappedCachePath, uint64 numIterations);
+
+// Times mesh import + meshlet generation for 1..maxThreads threads, and checks that the output is
+// identical. A generated scene with lots of meshes is imported if settings.FilePath is null.
+bool BenchmarkModelImportScaling(const ModelLoadSettings& settings, uint32 maxThreads = 0);
+
+// Times building a texture cache from a generated PNG against loading it back, both with and
+// without block compression, and checks that the cached data round-trips
+bool BenchmarkTextureCache(uint64 numIterations);
+
+// Times decoding and generating mips for a set of generated PNGs on one thread, against the batched
+// job decode that LoadTextures() uses, and checks that both produce the same data
+bool BenchmarkTextureDecoding(uint64 numTextures);
+
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+//=================================================================================================
+//
+//  MJP's DX12 Sample Framework
+//  https://therealmjp.github.io/
+//
+//  All code licensed under the MIT license
+//
+//=================================================================================================
+
+#include "PCH.h"
+
+#include "Tests.h"
+#include "..\\Graphics\\Textures.h"
+#include "..\\Exceptions.h"
+#include "..\\Utility.h"
+#include "..\\FileIO.h"
+#include "..\\SF12_Math.h"
+#include "..\\Timer.h"
+#include "..\\Jobs.h"
+
+namespace SampleFramework12
+{
+
+bool BenchmarkTextureCache(uint64 numIterations)
+{
+    Assert_(numIterations > 0);
+
+    // WIC needs COM on this thread
+    const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    wchar tempDir[MAX_PATH] = { };
+    GetTempPath(ArraySize_(tempDir), tempDir);
+    const std::wstring sourcePath = std::wstring(tempDir) + L"SF12_TextureCacheTest.png";
+    const std::wstring cachePath = std::wstring(tempDir) + L"SF12_TextureCacheTest.texcache";
+    const std::wstring brokenCachePath = std::wstring(tempDir) + L"SF12_TextureCacheTest_Broken.texcache";
+
+    // Smooth gradients with a bit of noise, so that the PNG is a realistic size
+    const uint64 sourceSize = 1024;
+    bool passed = true;
+    {
+        DirectX::ScratchImage sourceImage;
+        DXCall(sourceImage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, sourceSize, sourceSize, 1, 1));
+
+        Random random;
+        const DirectX::Image& image = *sourceImage.GetImage(0, 0, 0);
+        for(uint64 y = 0; y < sourceSize; ++y)
+        {
+            uint8* row = image.pixels + y * image.rowPitch;
+            for(uint64 x = 0; x < sourceSize; ++x)
+            {
+                const uint8 noise = uint8(random.RandomUint() % 16);
+                row[x * 4 + 0] = uint8(x * 255 / sourceSize) ^ noise;
+                row[x * 4 + 1] = uint8(y * 255 / sourceSize) ^ noise;
+                row[x * 4 + 2] = uint8((x + y) * 127 / sourceSize);
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        DXCall(DirectX::SaveToWICFile(image, DirectX::WIC_FLAGS_NONE, DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), sourcePath.c_str()));
+    }
+
+    WriteLog(L"Texture cache load times for a %llux%llu PNG (%llu iterations)", sourceSize, sourceSize, numIterations);
+
+    for(uint64 compress = 0; compress < 2; ++compress)
+    {
+        // Cold: read the source, decode it, generate mips, build the cache, and write it out
+        Array<uint8> builtData;
+        DirectX::TexMetadata builtMetaData;
+        double coldTime = 0.0;
+        for(uint64 i = 0; i < numIterations; ++i)
+        {
+            Timer timer;
+
+            Array<uint8> fileData;
+            ReadFileAsByteArray(sourcePath.c_str(), fileData);
+
+            DirectX::ScratchImage image;
+            HRESULT hr = DecodeTextureFile(fileData.Data(), fileData.Size(), sourcePath.c_str(), image);
+            if(SUCCEEDED(hr))
+                hr = BuildTextureCache(image, false, compress != 0, builtMetaData, builtData);
+            passed = passed && SUCCEEDED(hr) && WriteTextureCache(cachePath.c_str(), builtMetaData, builtData);
+
+            timer.Update();
+            coldTime += timer.ElapsedMillisecondsD();
+        }
+
+        // Warm: map the cache, and copy it into memory laid out like an upload buffer would be
+        Array<uint8> uploadMem(builtData.Size());
+        Array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+        Array<uint32> numRows;
+        double warmTime = 0.0;
+        for(uint64 i = 0; i < numIterations; ++i)
+        {
+            Timer timer;
+
+            MemoryMappedFile cacheFile;
+            DirectX::TexMetadata metaData;
+            const uint8* data = nullptr;
+            uint64 dataSize = 0;
+            const bool mapped = MapTextureCache(cachePath.c_str(), cacheFile, metaData, data, dataSize);
+            if(mapped)
+            {
+                ComputeTextureCacheLayout(metaData, layouts, numRows);
+                CopyCachedDataToUploadMem(data, dataSize, metaData, layouts, numRows, uploadMem.Size(), uploadMem.Data());
+            }
+
+            timer.Update();
+            warmTime += timer.ElapsedMillisecondsD();
+
+            passed = passed && mapped && dataSize == builtData.Size() && metaData.format == builtMetaData.format;
+            passed = passed && metaData.mipLevels == CalculateNumMips(uint32(sourceSize), uint32(sourceSize));
+        }
+
+        passed = passed && memcmp(uploadMem.Data(), builtData.Data(), builtData.Size()) == 0;
+
+        WriteLog(L"    %ls: %.3fms cold, %.3fms warm (%.1fx), %.2f MB cached", compress ? L"Block compressed" : L"Uncompressed",
+                 coldTime / numIterations, warmTime / numIterations, coldTime / warmTime, builtData.Size() / (1024.0 * 1024.0));
+    }
+
+    {
+        // A truncated cache has to be rejected rather than read past its end
+        Array<uint8> cacheData;
+        ReadFileAsByteArray(cachePath.c_str(), cacheData);
+        {
+            File file(brokenCachePath.c_str(), FileOpenMode::Write);
+            file.Write(cacheData.Size() - 1, cacheData.Data());
+        }
+
+        MemoryMappedFile cacheFile;
+        DirectX::TexMetadata metaData;
+        const uint8* data = nullptr;
+        uint64 dataSize = 0;
+        passed = passed && MapTextureCache(brokenCachePath.c_str(), cacheFile, metaData, data, dataSize) == false;
+    }
+
+    DeleteFile(sourcePath.c_str());
+    DeleteFile(cachePath.c_str());
+    DeleteFile(brokenCachePath.c_str());
+
+    if(SUCCEEDED(comResult))
+        CoUninitialize();
+
+    WriteLog("Texture cache benchmark %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+bool BenchmarkTextureDecoding(uint64 numTextures)
+{
+    Assert_(numTextures > 0);
+
+    // WIC needs COM on this thread
+    const HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    // A handful of different PNGs in memory, so that the decode isn't just hitting the same data
+    const uint64 NumSourceImages = 4;
+    const uint64 sourceSize = 512;
+    const wchar* sourcePath = L"SF12_TextureDecodeBenchmark.png";
+    DirectX::Blob sourceFiles[NumSourceImages];
+    Random random;
+    for(uint64 sourceIdx = 0; sourceIdx < NumSourceImages; ++sourceIdx)
+    {
+        DirectX::ScratchImage sourceImage;
+        DXCall(sourceImage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, sourceSize, sourceSize, 1, 1));
+
+        const DirectX::Image& image = *sourceImage.GetImage(0, 0, 0);
+        for(uint64 y = 0; y < sourceSize; ++y)
+        {
+            uint8* row = image.pixels + y * image.rowPitch;
+            for(uint64 x = 0; x < sourceSize; ++x)
+            {
+                const uint8 noise = uint8(random.RandomUint() % 16);
+                row[x * 4 + 0] = uint8((x + sourceIdx * 64) * 255 / sourceSize) ^ noise;
+                row[x * 4 + 1] = uint8(y * 255 / sourceSize) ^ noise;
+                row[x * 4 + 2] = uint8((x + y) * 127 / sourceSize);
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        DXCall(DirectX::SaveToWICMemory(image, DirectX::WIC_FLAGS_NONE, DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), sourceFiles[sourceIdx]));
+    }
+
+    auto decode = [&](uint64 textureIdx, DirectX::ScratchImage& image)
+    {
+        const DirectX::Blob& sourceFile = sourceFiles[textureIdx % NumSourceImages];
+        return DecodeTextureFile(sourceFile.GetBufferPointer(), sourceFile.GetBufferSize(), sourcePath, image);
+    };
+
+    // Serial: everything decoded and given mips on this thread, the way LoadTexture() does it
+    bool passed = true;
+    Array<DirectX::ScratchImage> serialImages(numTextures);
+    Timer timer;
+    for(uint64 i = 0; i < numTextures; ++i)
+        passed = SUCCEEDED(decode(i, serialImages[i])) && passed;
+    timer.Update();
+    const double serialTime = timer.ElapsedMillisecondsD();
+
+    // Batched: the same decode jobs that LoadTextures() kicks off for each batch
+    Array<DirectX::ScratchImage> batchedImages(numTextures);
+    Array<HRESULT> batchedResults(numTextures, S_OK);
+    timer = Timer();
+    for(uint64 batchStart = 0; batchStart < numTextures; batchStart += MaxTextureLoadBatchSize)
+    {
+        const uint64 batchSize = Min(numTextures - batchStart, MaxTextureLoadBatchSize);
+        Jobs::ParallelForRange(batchSize, 1, [&](uint64 start, uint64 end, uint32)
+        {
+            // WIC needs COM on the decoding thread
+            const HRESULT jobComResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+            for(uint64 i = batchStart + start; i < batchStart + end; ++i)
+                batchedResults[i] = decode(i, batchedImages[i]);
+
+            if(SUCCEEDED(jobComResult))
+                CoUninitialize();
+        });
+    }
+    timer.Update();
+    const double batchedTime = timer.ElapsedMillisecondsD();
+
+    // Both paths have to come up with exactly the same mip chains
+    for(uint64 i = 0; i < numTextures && passed; ++i)
+    {
+        const DirectX::ScratchImage& serialImage = serialImages[i];
+        const DirectX::ScratchImage& batchedImage = batchedImages[i];
+        passed = SUCCEEDED(batchedResults[i]) && serialImage.GetImageCount() == batchedImage.GetImageCount();
+        passed = passed && serialImage.GetMetadata().mipLevels == CalculateNumMips(uint32(sourceSize), uint32(sourceSize));
+        passed = passed && serialImage.GetPixelsSize() == batchedImage.GetPixelsSize();
+        passed = passed && memcmp(serialImage.GetPixels(), batchedImage.GetPixels(), serialImage.GetPixelsSize()) == 0;
+    }
+
+    WriteLog("Texture decode and mip generation for %llu %llux%llu PNGs: serial %.3fms, batched %.3fms (%.2fx) on %u threads",
+             numTextures, sourceSize, sourceSize, serialTime, batchedTime, serialTime / batchedTime, Jobs::NumThreads());
+
+    serialImages.Shutdown();
+    batchedImages.Shutdown();
+    for(DirectX::Blob& sourceFile : sourceFiles)
+        sourceFile.Release();
+
+    if(SUCCEEDED(comResult))
+        CoUninitialize();
+
+    WriteLog("Texture decode benchmark %s", passed ? "passed" : "FAILED");
+
+    return passed;
+}
+
+}
\ No newline at end of file